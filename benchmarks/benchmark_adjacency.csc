@@ -0,0 +1,53 @@
+// BFS over a million-node graph held as one small i32[] per node: the shape of
+// a real adjacency list, and what an array's fixed overhead costs at scale.
+//
+// benchmark_bfs keeps its graph small on purpose, so what it measures is the
+// traversal. This one is the other side: a million three-element arrays, where
+// the header every array carries outweighs the twelve bytes it holds.
+// run_benchmarks.sh reports peak RSS next to the time for this reason. While
+// every array carried a lane for each element type (136 bytes of header per
+// array) this peaked at 206 MB; with one lane per array it is 114 MB, against
+// Node's 315 MB.
+//
+// The checksum stays below 2^31 at every step, so both languages print the
+// same number without either one's integer semantics coming into it.
+
+let nodes: i32 = 1000000;
+
+// Three out-edges per node, the same shape as benchmark_bfs: the doubling pair
+// spreads the frontier, the +7 stride closes the cycles back up.
+let adjacency: i32[][] = [];
+for (let i: i32 = 0; i < nodes; i = i + 1) {
+    let neighbors: i32[] = [];
+    neighbors.push((i * 2 + 1) % nodes);
+    neighbors.push((i * 2 + 2) % nodes);
+    neighbors.push((i + 7) % nodes);
+    adjacency.push(neighbors);
+}
+
+println("Starting Cypescript adjacency benchmark (1,000,000 nodes)...");
+
+let visited: i32[] = [];
+visited[nodes - 1] = 0;
+let queue: i32[] = [];
+queue.push(0);
+visited[0] = 1;
+
+// Read by index rather than drained with shift(): Node's shift() copies a queue
+// this long on every call, and the subject here is the graph, not the queue
+let reached: i32 = 0;
+let checksum: i32 = 0;
+while (reached < queue.length) {
+    const node: i32 = queue[reached];
+    reached = reached + 1;
+    checksum = (checksum * 31 + node) % 1000003;
+    for (const next of adjacency[node]) {
+        if (visited[next] == 0) {
+            visited[next] = 1;
+            queue.push(next);
+        }
+    }
+}
+
+println("Reached: " + reached);
+println("Checksum: " + checksum);
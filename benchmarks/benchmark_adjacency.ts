@@ -0,0 +1,38 @@
+// The Node reference for benchmark_adjacency.csc. Keep the graph shape and the
+// sizes identical to the .csc — the checksum both files print is what proves
+// they did the same work.
+
+const nodes = 1000000;
+
+const adjacency = [];
+for (let i = 0; i < nodes; i = i + 1) {
+    const neighbors = [];
+    neighbors.push((i * 2 + 1) % nodes);
+    neighbors.push((i * 2 + 2) % nodes);
+    neighbors.push((i + 7) % nodes);
+    adjacency.push(neighbors);
+}
+
+console.log("Starting Node.js adjacency benchmark (1,000,000 nodes)...");
+
+const visited = new Array(nodes).fill(0);
+const queue = [];
+queue.push(0);
+visited[0] = 1;
+
+let reached = 0;
+let checksum = 0;
+while (reached < queue.length) {
+    const node = queue[reached];
+    reached = reached + 1;
+    checksum = (checksum * 31 + node) % 1000003;
+    for (const next of adjacency[node]) {
+        if (visited[next] === 0) {
+            visited[next] = 1;
+            queue.push(next);
+        }
+    }
+}
+
+console.log("Reached: " + reached);
+console.log("Checksum: " + checksum);
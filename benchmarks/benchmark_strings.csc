@@ -0,0 +1,32 @@
+// Reads every element of a 100,000-word string[] fifty times over: five million
+// string reads, with peak RSS reported by run_benchmarks.sh beside the time.
+//
+// Peak memory here should be the words themselves, whatever the number of
+// passes. It was not while a string array held std::strings: each read handed
+// back a fresh heap copy that nothing freed, so this climbed to 242 MB and kept
+// climbing with every pass. The array now holds the strings themselves, and a
+// read is a load: 11 MB, the same at one pass as at fifty.
+
+let words: string[] = [];
+for (let i: i32 = 0; i < 100000; i = i + 1) {
+    words.push("word" + i);
+}
+
+println("Starting Cypescript string array benchmark (100,000 words x50)...");
+
+let characters: i32 = 0;
+let matches: i32 = 0;
+for (let pass: i32 = 0; pass < 50; pass = pass + 1) {
+    for (const word of words) {
+        characters = characters + string_length(word);
+    }
+    // Indexed reads too, so both ways into the array are measured
+    for (let i: i32 = pass; i < words.length; i = i + 1000) {
+        if (words[i] == "word" + pass) {
+            matches = matches + 1;
+        }
+    }
+}
+
+println("Characters: " + characters);
+println("Matches: " + matches);
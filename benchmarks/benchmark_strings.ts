@@ -0,0 +1,32 @@
+// The Node reference for benchmark_strings.csc. Keep the words, the passes and
+// the reads identical to the .csc — the totals both files print are what prove
+// they did the same work.
+
+// The Cypescript builtin the .csc measures words with
+function string_length(s) {
+    return s.length;
+}
+
+const words = [];
+for (let i = 0; i < 100000; i = i + 1) {
+    words.push("word" + i);
+}
+
+console.log("Starting Node.js string array benchmark (100,000 words x50)...");
+
+let characters = 0;
+let matches = 0;
+for (let pass = 0; pass < 50; pass = pass + 1) {
+    for (const word of words) {
+        characters = characters + string_length(word);
+    }
+    // Indexed reads too, so both ways into the array are measured
+    for (let i = pass; i < words.length; i = i + 1000) {
+        if (words[i] === "word" + pass) {
+            matches = matches + 1;
+        }
+    }
+}
+
+console.log("Characters: " + characters);
+console.log("Matches: " + matches);
@@ -0,0 +1,82 @@
+#!/bin/bash
+# Generates the synthetic programs the compiler throughput benchmark compiles.
+#
+#   gen_programs.sh OUT_DIR [SCALE]
+#
+# SCALE (default 1) multiplies every program's size, so a quick smoke run can
+# use a fraction and a stress run a multiple. At scale 1:
+#   lines_50k.csc        ~50,000 lines: 3,125 small functions plus a main that
+#                        calls each one — the bulk of a large real program
+#   classes_2k.csc       2,000 classes in 100 inheritance chains 20 deep, every
+#                        level adding a field and overriding a method
+#   closures_nested.csc  300 functions each holding arrows nested 25 deep, every
+#                        level capturing the parameters of all levels above it
+set -e
+
+OUT_DIR=${1:?usage: gen_programs.sh OUT_DIR [SCALE]}
+SCALE=${2:-1}
+mkdir -p "$OUT_DIR"
+
+awk -v n="$(awk -v s="$SCALE" 'BEGIN { print int(3125 * s) }')" 'BEGIN {
+    for (i = 0; i < n; i++) {
+        printf "function work%d(n: i32): i32 {\n", i
+        printf "    let total: i32 = 0;\n"
+        printf "    for (let k: i32 = 0; k < n; k++) {\n"
+        printf "        if (k %% 3 == 0) {\n"
+        printf "            total = total + k * %d;\n", i % 7 + 1
+        printf "        } else {\n"
+        printf "            total = total - 1;\n"
+        printf "        }\n"
+        printf "    }\n"
+        printf "    let label: string = \"work%d\";\n", i
+        printf "    if (label == \"none\") {\n"
+        printf "        return 0;\n"
+        printf "    }\n"
+        printf "    return total;\n"
+        printf "}\n"
+    }
+    printf "let acc: i32 = 0;\n"
+    for (i = 0; i < n; i++) printf "acc = acc + work%d(%d);\n", i, i % 5
+    printf "println(acc);\n"
+}' > "$OUT_DIR/lines_50k.csc"
+
+awk -v chains="$(awk -v s="$SCALE" 'BEGIN { print int(100 * s) }')" -v depth=20 'BEGIN {
+    for (c = 0; c < chains; c++) {
+        printf "class C%d_0 {\n    f0: i32 = %d;\n    value(): i32 { return this.f0; }\n}\n", c, c
+        for (d = 1; d < depth; d++) {
+            printf "class C%d_%d extends C%d_%d {\n", c, d, c, d - 1
+            printf "    f%d: i32 = %d;\n", d, d
+            printf "    value(): i32 { return this.f%d + this.f0; }\n", d
+            printf "}\n"
+        }
+    }
+    printf "let sum: i32 = 0;\n"
+    for (c = 0; c < chains; c++) {
+        printf "let o%d: C%d_0 = new C%d_%d();\n", c, c, c, depth - 1
+        printf "sum = sum + o%d.value();\n", c
+    }
+    printf "println(sum);\n"
+}' > "$OUT_DIR/classes_2k.csc"
+
+awk -v n="$(awk -v s="$SCALE" 'BEGIN { print int(300 * s) }')" -v depth=25 'BEGIN {
+    for (i = 0; i < n; i++) {
+        printf "function nest%d(x: i32): i32 {\n", i
+        indent = "    "
+        for (d = 0; d < depth; d++) {
+            printf "%slet f%d = (a%d: i32): i32 => {\n", indent, d, d
+            indent = indent "    "
+        }
+        printf "%sreturn x", indent
+        for (d = 0; d < depth; d++) printf " + a%d", d
+        printf ";\n"
+        for (d = depth - 1; d >= 0; d--) {
+            indent = substr(indent, 5)
+            printf "%s};\n", indent
+            if (d > 0) printf "%sreturn f%d(a%d + 1);\n", indent, d, d - 1
+        }
+        printf "    return f0(x);\n}\n"
+    }
+    printf "let total: i32 = 0;\n"
+    for (i = 0; i < n; i++) printf "total = total + nest%d(%d);\n", i, i % 3
+    printf "println(total);\n"
+}' > "$OUT_DIR/closures_nested.csc"
@@ -0,0 +1,186 @@
+#!/bin/bash
+# Compiler throughput benchmark: how fast cscript itself handles large programs.
+#
+# The other suites time the code cscript generates; this one times cscript. It
+# generates the synthetic programs of gen_programs.sh, compiles each one with
+# --time-trace, and reports per-stage times, source lines per second and peak
+# memory. The run fails when a stage drops below the throughput floors in
+# thresholds.txt or, with --baseline, slows down past the tolerance against a
+# report saved earlier on the same machine.
+#
+#   run_compiler_benchmarks.sh [--runs N] [--scale S] [--report FILE]
+#                              [--baseline FILE] [--tolerance PCT]
+#
+# Lexing runs on demand inside the parser, so "parse" covers both. The backend
+# is timed too ("llvm", at -O0 by default; set CSCRIPT_FLAGS to change that) but
+# has no floor: it is LLVM's throughput, not ours.
+set +e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+BOLD='\033[1m'
+NC='\033[0m'
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(dirname "$(dirname "$SCRIPT_DIR")")"
+COMPILER="$ROOT_DIR/build/cscript"
+RUNS=3
+SCALE=1
+REPORT=""
+BASELINE=""
+TOLERANCE=25
+CSCRIPT_FLAGS=${CSCRIPT_FLAGS:--O0}
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --runs) RUNS=$2; shift 2 ;;
+        --scale) SCALE=$2; shift 2 ;;
+        --report) REPORT=$2; shift 2 ;;
+        --baseline) BASELINE=$2; shift 2 ;;
+        --tolerance) TOLERANCE=$2; shift 2 ;;
+        *) echo "usage: $0 [--runs N] [--scale S] [--report FILE] [--baseline FILE] [--tolerance PCT]"
+           exit 2 ;;
+    esac
+done
+
+if [[ ! -f "$COMPILER" ]]; then
+    echo -e "${RED}❌ Compiler not found. Run ./build.sh first${NC}"
+    exit 1
+fi
+if [[ -n "$BASELINE" && ! -f "$BASELINE" ]]; then
+    echo -e "${RED}❌ Baseline report $BASELINE not found${NC}"
+    exit 1
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+echo -e "${BOLD}============================================${NC}"
+echo -e "${BOLD}  Compiler throughput (cscript $CSCRIPT_FLAGS)${NC}"
+echo -e "${BOLD}  Best of $RUNS runs, scale $SCALE${NC}"
+echo -e "${BOLD}============================================${NC}"
+echo ""
+
+echo -e "${CYAN}Generating programs...${NC}"
+if ! "$SCRIPT_DIR/gen_programs.sh" "$WORK_DIR/src" "$SCALE"; then
+    echo -e "${RED}❌ Program generation failed${NC}"
+    exit 1
+fi
+echo ""
+
+# Total time of one trace event, in milliseconds (0 if it never ran)
+trace_ms() {
+    grep -o "\"dur\":[0-9]*,\"name\":\"Total $2\"" "$1" | head -1 |
+        sed 's/"dur":\([0-9]*\).*/\1/' | awk '{ printf "%.2f", $1 / 1000 } END { if (NR == 0) print "0" }'
+}
+
+# The smaller of two numbers
+min() { awk -v a="$1" -v b="$2" 'BEGIN { print (a + 0 < b + 0) ? a : b }'; }
+
+# Source lines per second for a stage that took $2 ms on $1 lines
+throughput() { awk -v l="$1" -v ms="$2" 'BEGIN { if (ms > 0) printf "%.0f", l * 1000 / ms; else print "inf" }'; }
+
+STAGES=("parse" "semantic" "codegen" "llvm")
+declare -A TRACE_NAME=(
+    [parse]="Parse"
+    [semantic]="Semantic analysis"
+    [codegen]="Code generation"
+    [llvm]="LLVM optimization"
+)
+
+FAILED=0
+fail() {
+    echo -e "  ${RED}❌ $1${NC}"
+    FAILED=1
+}
+
+REPORT_FILE="$WORK_DIR/report.tsv"
+printf "# program\tlines\tparse_ms\tsemantic_ms\tcodegen_ms\tllvm_ms\tpeak_kb\n" > "$REPORT_FILE"
+
+printf "${BOLD}%-18s %7s %10s %10s %10s %10s %10s${NC}\n" \
+    "Program" "Lines" "Parse" "Semantic" "Codegen" "LLVM" "Peak RSS"
+echo "--------------------------------------------------------------------------------"
+
+for source in "$WORK_DIR"/src/*.csc; do
+    name=$(basename "$source" .csc)
+    lines=$(wc -l < "$source" | tr -d ' ')
+    declare -A best=()
+    peak=""
+
+    for ((run = 0; run < RUNS; run++)); do
+        trace="$WORK_DIR/$name.json"
+        # Never served from, or filling, the developer's compile cache
+        output=$("$COMPILER" $CSCRIPT_FLAGS -v --no-cache --emit=bc -o "$WORK_DIR/$name.bc" \
+                 --time-trace="$trace" --time-trace-granularity=0 "$source" 2>&1)
+        if [[ $? -ne 0 ]]; then
+            fail "$name failed to compile:"
+            echo "$output" | tail -5 | sed 's/^/      /'
+            continue 2
+        fi
+        for stage in "${STAGES[@]}"; do
+            ms=$(trace_ms "$trace" "${TRACE_NAME[$stage]}")
+            best[$stage]=$(min "${best[$stage]:-$ms}" "$ms")
+        done
+        kb=$(echo "$output" | sed -n 's/^Peak memory: \([0-9]*\) KB$/\1/p')
+        peak=$(min "${peak:-${kb:-0}}" "${kb:-0}")
+    done
+
+    printf "%-18s %7s %8.1fms %8.1fms %8.1fms %8.1fms %8sMB\n" "$name" "$lines" \
+        "${best[parse]}" "${best[semantic]}" "${best[codegen]}" "${best[llvm]}" "$((peak / 1024))"
+    printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$name" "$lines" "${best[parse]}" "${best[semantic]}" \
+        "${best[codegen]}" "${best[llvm]}" "$peak" >> "$REPORT_FILE"
+
+    # Absolute floors: lines per second per front-end stage, memory per line
+    floors=$(awk -v n="$name" '$1 == n { print $2, $3, $4, $5 }' "$SCRIPT_DIR/thresholds.txt")
+    if [[ -n "$floors" ]]; then
+        read -r floor_parse floor_semantic floor_codegen rss_per_line <<< "$floors"
+        for stage in parse semantic codegen; do
+            floor_var="floor_$stage"
+            rate=$(throughput "$lines" "${best[$stage]}")
+            if [[ "$rate" != "inf" ]] && (( rate < ${!floor_var} )); then
+                fail "$name: $stage at $rate lines/s, below the floor of ${!floor_var}"
+            fi
+        done
+        if [[ -n "$peak" ]] && (( peak > 65536 + lines * rss_per_line )); then
+            fail "$name: peak memory ${peak} KB, above 64 MB + $rss_per_line KB per line"
+        fi
+    fi
+
+    # Relative check against a saved report from the same machine. Differences
+    # under 5ms are noise whatever the percentage.
+    if [[ -n "$BASELINE" ]]; then
+        row=$(awk -F'\t' -v n="$name" '$1 == n' "$BASELINE")
+        if [[ -z "$row" ]]; then
+            echo "  (no baseline for $name)"
+        else
+            IFS=$'\t' read -r _ base_lines base_parse base_semantic base_codegen base_llvm base_peak <<< "$row"
+            for stage in parse semantic codegen llvm; do
+                base_var="base_$stage"
+                verdict=$(awk -v now="${best[$stage]}" -v was="${!base_var}" -v tol="$TOLERANCE" \
+                    -v l="$lines" -v bl="$base_lines" 'BEGIN {
+                        was = was * l / bl    # baselines from another --scale
+                        if (now - was > 5 && now > was * (1 + tol / 100))
+                            printf "%.1fms against %.1fms", now, was
+                    }')
+                [[ -n "$verdict" ]] && fail "$name: $stage regressed, $verdict"
+            done
+            if awk -v now="$peak" -v was="$base_peak" -v tol="$TOLERANCE" \
+                   'BEGIN { exit !(now > was * (1 + tol / 100)) }'; then
+                fail "$name: peak memory regressed, ${peak} KB against ${base_peak} KB"
+            fi
+        fi
+    fi
+    unset best
+done
+
+[[ -n "$REPORT" ]] && cp "$REPORT_FILE" "$REPORT"
+
+echo ""
+if [[ $FAILED -ne 0 ]]; then
+    echo -e "${RED}❌ Compiler throughput regressed.${NC}"
+    exit 1
+fi
+echo -e "${GREEN}✅ Compiler throughput within limits.${NC}"
+[[ -n "$REPORT" ]] && echo "Report: $REPORT"
+exit 0
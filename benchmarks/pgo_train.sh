@@ -0,0 +1,104 @@
+#!/bin/bash
+# Profile-guided optimization, trained on the benchmark suite.
+#
+# For each benchmark: build it instrumented (--pgo-gen), run it once to record a
+# .profraw, merge that into a .profdata with llvm-profdata, rebuild it with
+# --pgo-use, and time the plain -O2 build against the profile-guided one.
+# The same three steps are the workflow for any program:
+#
+#   cscript --pgo-gen -o app app.csc && ./app     # writes default_*.profraw
+#   llvm-profdata merge -o app.profdata *.profraw
+#   cscript --pgo-use app.profdata -o app app.csc
+set +e
+
+CYAN='\033[0;36m'
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+BOLD='\033[1m'
+NC='\033[0m'
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(dirname "$SCRIPT_DIR")"
+COMPILER="$ROOT_DIR/build/cscript"
+RUNS=${1:-3}
+
+if [[ ! -f "$COMPILER" ]]; then
+    echo -e "${RED}❌ Compiler not found. Run ./build.sh first${NC}"
+    exit 1
+fi
+
+# llvm-profdata must understand the .profraw format of the LLVM cscript links,
+# so prefer the one installed beside it
+PROFDATA=""
+for candidate in "$(llvm-config --bindir 2>/dev/null)/llvm-profdata" \
+                 "$(command -v llvm-profdata)" "$(xcrun -f llvm-profdata 2>/dev/null)"; do
+    [[ -x "$candidate" ]] && PROFDATA="$candidate" && break
+done
+if [[ -z "$PROFDATA" ]]; then
+    echo -e "${RED}❌ llvm-profdata not found. Install the LLVM tools cscript was built with.${NC}"
+    exit 1
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+# Training and timing must not be served from, or fill, the developer's cache
+export XDG_CACHE_HOME="$WORK_DIR/cache"
+
+# Best user time of $RUNS runs, in seconds
+best_time() {
+    local best=999 t
+    for ((i=0; i<RUNS; i++)); do
+        t=$( { time "$1" > /dev/null 2>&1; } 2>&1 | grep user | sed 's/.*0m//' | sed 's/s//')
+        if (( $(echo "$t < $best" | bc -l) )); then best=$t; fi
+    done
+    echo "$best"
+}
+
+echo -e "${BOLD}============================================${NC}"
+echo -e "${BOLD}  PGO training run (-O2 vs --pgo-use)${NC}"
+echo -e "${BOLD}  Runs per benchmark: $RUNS${NC}"
+echo -e "${BOLD}============================================${NC}"
+echo ""
+printf "${BOLD}%-24s %12s %12s %10s${NC}\n" "Benchmark" "-O2" "PGO" "Speedup"
+echo "------------------------------------------------------------"
+
+for csc_file in "$SCRIPT_DIR"/bench_*.csc "$SCRIPT_DIR"/benchmark_*.csc; do
+    [[ -f "$csc_file" ]] || continue
+    name=$(basename "$csc_file" .csc)
+    dir="$WORK_DIR/$name"
+    mkdir -p "$dir"
+
+    # 1. Instrumented build, trained by one run of the benchmark itself
+    if ! "$COMPILER" --pgo-gen="$dir/$name-%p.profraw" -o "$dir/instrumented" \
+            "$csc_file" > /dev/null 2>&1; then
+        echo -e "  ${RED}⚠ Skipping $name (instrumented build failed)${NC}"
+        continue
+    fi
+    "$dir/instrumented" > /dev/null 2>&1
+    if ! "$PROFDATA" merge -o "$dir/$name.profdata" "$dir"/*.profraw 2>/dev/null; then
+        echo -e "  ${RED}⚠ Skipping $name (no profile recorded)${NC}"
+        continue
+    fi
+
+    # 2. The plain build and the profile-guided one, from the same source
+    "$COMPILER" -o "$dir/plain" "$csc_file" > /dev/null 2>&1 &&
+        "$COMPILER" --pgo-use "$dir/$name.profdata" -o "$dir/pgo" "$csc_file" > /dev/null 2>&1
+    if [[ ! -x "$dir/plain" || ! -x "$dir/pgo" ]]; then
+        echo -e "  ${RED}⚠ Skipping $name (build failed)${NC}"
+        continue
+    fi
+
+    # 3. A profile must never change what the program computes
+    if [[ "$("$dir/plain")" != "$("$dir/pgo")" ]]; then
+        echo -e "  ${RED}❌ $name: the PGO build printed different output${NC}"
+        exit 1
+    fi
+
+    plain=$(best_time "$dir/plain")
+    pgo=$(best_time "$dir/pgo")
+    speedup=$(awk -v p="$plain" -v g="$pgo" 'BEGIN { if (g > 0) printf "%.2fx", p / g; else print "∞" }')
+    printf "%-24s %11.3fs %11.3fs %10s\n" "$name" "$plain" "$pgo" "$speedup"
+done
+
+echo ""
+echo -e "${GREEN}✅ PGO training run complete.${NC}"
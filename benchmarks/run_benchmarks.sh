@@ -23,6 +23,14 @@ if ! command -v node &> /dev/null; then
     exit 1
 fi
 
+# Peak resident set size of one run of a command, in MB. bash's `time` has no
+# memory figure, and GNU time is not everywhere python3 is.
+peak_rss_mb() {
+    python3 -c 'import resource, subprocess, sys
+subprocess.run(sys.argv[1:], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+print(resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss // 1024)' "$@"
+}
+
 echo -e "${BOLD}============================================${NC}"
 echo -e "${BOLD}  Cypescript vs Node.js Benchmark Suite${NC}"
 echo -e "${BOLD}  Runs per benchmark: $RUNS${NC}"
@@ -57,10 +65,12 @@ declare -a BENCHMARKS=(
     "Matrix Mult (300^3):bench_matrix"
     "Prime Sieve (500K):bench_primes"
     "BFS (5K nodes x40):benchmark_bfs"
+    "Adjacency lists (1M):benchmark_adjacency"
+    "String array reads (5M):benchmark_strings"
 )
 
-printf "${BOLD}%-28s %15s %15s %10s${NC}\n" "Benchmark" "Cypescript" "Node.js" "Speedup"
-echo "----------------------------------------------------------------------"
+printf "${BOLD}%-28s %15s %15s %10s %20s${NC}\n" "Benchmark" "Cypescript" "Node.js" "Speedup" "Peak RSS (csc/node)"
+echo "-------------------------------------------------------------------------------------------"
 
 for bench in "${BENCHMARKS[@]}"; do
     IFS=':' read -r label name <<< "$bench"
@@ -95,7 +105,9 @@ for bench in "${BENCHMARKS[@]}"; do
         speedup_str="∞"
     fi
     
-    printf "%-28s %13.3fs %13.3fs %10s\n" "$label" "$best_csc" "$best_node" "$speedup_str"
+    rss_str="$(peak_rss_mb "$csc_bin")/$(peak_rss_mb node "$ts_file") MB"
+
+    printf "%-28s %13.3fs %13.3fs %10s %20s\n" "$label" "$best_csc" "$best_node" "$speedup_str" "$rss_str"
 done
 
 echo ""
@@ -35,6 +35,7 @@ echo "==> Staging cypescript ${VERSION} (${ARCH})"
 mkdir -p "$STAGE/usr/bin" "$STAGE/usr/lib" \
          "$STAGE/usr/share/doc/cypescript" "$STAGE/DEBIAN"
 install -m755 build/cscript          "$STAGE/usr/bin/cscript"
+install -m755 build/cscript-client   "$STAGE/usr/bin/cscript-client"
 install -m644 build/libcypescript.a  "$STAGE/usr/lib/libcypescript.a"
 install -m644 LICENSE                "$STAGE/usr/share/doc/cypescript/copyright"
 install -m644 README.md              "$STAGE/usr/share/doc/cypescript/README.md"
@@ -29,6 +29,7 @@ class Cypescript < Formula
     system "cmake", "--build", "build"
 
     bin.install "build/cscript"
+    bin.install "build/cscript-client"
     lib.install "build/libcypescript.a"
 
     # The game runtime, and the module of `declare` bindings that fronts it.
@@ -4,10 +4,16 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <memory>                     // For smart pointers
+#include <type_traits>
 #include <iostream>                   // For std::ostream
 #include <iomanip>                    // For std::setw, std::left (used by llvm::raw_ostream formatting)
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"      // For internTypeName
+#include "llvm/Support/Allocator.h"  // For ASTArena
 #include "llvm/Support/raw_ostream.h" // For llvm::outs()
+#include <mutex>
 
 // Forward Declarations
 class StringLiteralNode;
@@ -41,41 +47,151 @@ inline void printIndent(llvm::raw_ostream &os, int indent)
     }
 }
 
+// Every concrete node type, tagged on the node itself so the passes can
+// dispatch with a switch and test a node's type without RTTI
+enum class NodeKind : unsigned char
+{
+    // Statements
+    VariableDeclaration, TypeAlias, IfStatement, WhileStatement,
+    AssignmentStatement, ArrayAssignmentStatement, ForStatement, ForOfStatement,
+    DoWhileStatement, BreakStatement, ContinueStatement, SwitchStatement,
+    InterfaceDeclaration, ExternDeclaration, EnumDeclaration, LinkDirective,
+    ObjectPropertyAssignment, DestructuringDeclaration, ThrowStatement,
+    TryCatchStatement, ExpressionStatement, FunctionDeclaration, ReturnStatement,
+    ClassDeclaration,
+    // Expressions
+    StringLiteral, IntegerLiteral, BooleanLiteral, FloatLiteral, VariableExpression,
+    BinaryExpression, SuperExpression, NullLiteral, UnaryExpression,
+    UpdateExpression, ArrowFunction, FunctionCall, ArrayLiteral, ArrayAccess,
+    ObjectLiteral, ObjectAccess, MethodCall, NewExpression,
+    // The root
+    Program,
+};
+
+// Bump allocator for the nodes of one compilation. While an arena is active on
+// a thread, every node created there is carved out of it instead of getting a
+// heap allocation of its own, and the whole tree's storage is released at once
+// when the arena goes. Nodes are still owned through unique_ptr and still have
+// their destructors run (their strings and vectors live on the heap); deleting
+// one just leaves its bytes to the arena. The arena must outlive its nodes.
+class ASTArena
+{
+public:
+    ASTArena() : m_previous(active()) { active() = this; }
+    ~ASTArena() { active() = m_previous; }
+    ASTArena(const ASTArena &) = delete;
+    ASTArena &operator=(const ASTArena &) = delete;
+
+    void *allocate(size_t size) { return m_allocator.Allocate(size, alignof(std::max_align_t)); }
+    size_t bytesAllocated() const { return m_allocator.getBytesAllocated(); }
+
+    // The arena new nodes on this thread come from, or nullptr for the heap
+    static ASTArena *&active()
+    {
+        static thread_local ASTArena *arena = nullptr;
+        return arena;
+    }
+
+private:
+    llvm::BumpPtrAllocator m_allocator;
+    ASTArena *m_previous;
+};
+
+// Canonical type names, interned once per process. There are only as many as
+// the program names types, so an expression can carry its resolved type as a
+// StringRef that stays valid for as long as anything might read it.
+inline llvm::StringRef internTypeName(llvm::StringRef name)
+{
+    if (name.empty()) return {};
+    static std::mutex mutex;
+    static llvm::StringSet<> names;
+    std::lock_guard<std::mutex> lock(mutex);
+    return names.insert(name).first->getKey();
+}
+
 // --- Base Node Types ---
 
 class ASTNode
 {
 public:
+    const NodeKind nodeKind;
     int line = 0;   // 1-based source position; 0 = unknown
     int column = 0;
 
     virtual ~ASTNode() = default;
     // Pure virtual function for printing the node
     virtual void printNode(llvm::raw_ostream &os, int indent = 0) const = 0;
+
+    static void *operator new(size_t size) { return allocateNode(size); }
+    static void operator delete(void *node) { releaseNode(node); }
+
+protected:
+    explicit ASTNode(NodeKind kind) : nodeKind(kind) {}
+
+private:
+    static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+    // A small header in front of each node says whether it came from an
+    // arena, so nodes made with and without one are freed the same way. Kept
+    // out of line: inlined into `new T(...)`, GCC pairs the ::operator delete
+    // of the header's address with the offset pointer operator new returned
+    // and warns (-Wmismatched-new-delete) on every make_unique.
+    [[gnu::noinline]] static void *allocateNode(size_t size)
+    {
+        ASTArena *arena = ASTArena::active();
+        void *block = arena ? arena->allocate(size + kHeaderSize) : ::operator new(size + kHeaderSize);
+        *static_cast<ASTArena **>(block) = arena;
+        return static_cast<char *>(block) + kHeaderSize;
+    }
+    [[gnu::noinline]] static void releaseNode(void *node)
+    {
+        if (!node) return;
+        void *block = static_cast<char *>(node) - kHeaderSize;
+        if (!*static_cast<ASTArena **>(block)) ::operator delete(block);
+    }
 };
 
 class ExpressionNode : public ASTNode
 {
 public:
-    // Inherits printNode
+    // Static type resolved by semantic analysis, as an interned canonical type
+    // name. Empty when it is not confidently known, and on nodes created after
+    // the analysis ran (constant folding, for one).
+    llvm::StringRef resolvedType;
+    bool typeResolved = false; // analysis has visited this node
+
+protected:
+    explicit ExpressionNode(NodeKind kind) : ASTNode(kind) {}
 };
 
 class StatementNode : public ASTNode
 {
-public:
-    // Inherits printNode
+protected:
+    explicit StatementNode(NodeKind kind) : ASTNode(kind) {}
 };
 
+// Checked downcast by kind tag: the node as a T, or nullptr if it is null or a
+// node of some other type. Stands in for dynamic_cast, at the cost of one
+// byte compare.
+template <typename T, typename From>
+inline T *nodeCast(From *node)
+{
+    return node && node->nodeKind == std::remove_const_t<T>::ClassKind ? static_cast<T *>(node)
+                                                                       : nullptr;
+}
+
 class VariableDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::VariableDeclaration;
+
     std::string variableName;
     std::string typeName;
     std::unique_ptr<ExpressionNode> initializer;
     bool isConst;
 
     VariableDeclarationNode(std::string varName, std::string type, std::unique_ptr<ExpressionNode> init, bool isConstVal = false)
-        : variableName(std::move(varName)), typeName(std::move(type)), initializer(std::move(init)), isConst(isConstVal) {}
+        : StatementNode(ClassKind), variableName(std::move(varName)), typeName(std::move(type)), initializer(std::move(init)), isConst(isConstVal) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -96,12 +212,14 @@ public:
 class TypeAliasNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::TypeAlias;
+
     std::string aliasName;
     std::vector<std::string> genericParams;
     std::string targetType;
 
     TypeAliasNode(std::string name, std::string target)
-        : aliasName(std::move(name)), targetType(std::move(target)) {}
+        : StatementNode(ClassKind), aliasName(std::move(name)), targetType(std::move(target)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -124,8 +242,10 @@ public:
 class StringLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::StringLiteral;
+
     std::string value;
-    explicit StringLiteralNode(std::string val) : value(std::move(val)) {}
+    explicit StringLiteralNode(std::string val) : ExpressionNode(ClassKind), value(std::move(val)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -137,8 +257,10 @@ public:
 class IntegerLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::IntegerLiteral;
+
     long long value;
-    explicit IntegerLiteralNode(long long val) : value(val) {}
+    explicit IntegerLiteralNode(long long val) : ExpressionNode(ClassKind), value(val) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -150,8 +272,10 @@ public:
 class BooleanLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::BooleanLiteral;
+
     bool value;
-    explicit BooleanLiteralNode(bool val) : value(val) {}
+    explicit BooleanLiteralNode(bool val) : ExpressionNode(ClassKind), value(val) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -163,8 +287,10 @@ public:
 class FloatLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::FloatLiteral;
+
     double value;
-    explicit FloatLiteralNode(double val) : value(val) {}
+    explicit FloatLiteralNode(double val) : ExpressionNode(ClassKind), value(val) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -176,8 +302,10 @@ public:
 class VariableExpressionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::VariableExpression;
+
     std::string name;
-    explicit VariableExpressionNode(std::string varName) : name(std::move(varName)) {}
+    explicit VariableExpressionNode(std::string varName) : ExpressionNode(ClassKind), name(std::move(varName)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -190,6 +318,8 @@ public:
 class BinaryExpressionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::BinaryExpression;
+
     enum Operator {
         // Arithmetic operators
         ADD,        // +
@@ -225,7 +355,7 @@ public:
     BinaryExpressionNode(Operator operation, 
                         std::unique_ptr<ExpressionNode> leftExpr, 
                         std::unique_ptr<ExpressionNode> rightExpr)
-        : op(operation), left(std::move(leftExpr)), right(std::move(rightExpr)) {}
+        : ExpressionNode(ClassKind), op(operation), left(std::move(leftExpr)), right(std::move(rightExpr)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -276,6 +406,10 @@ private:
 class SuperExpressionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::SuperExpression;
+
+    SuperExpressionNode() : ExpressionNode(ClassKind) {}
+
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
@@ -288,6 +422,10 @@ public:
 class NullLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::NullLiteral;
+
+    NullLiteralNode() : ExpressionNode(ClassKind) {}
+
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
@@ -298,12 +436,14 @@ public:
 class UnaryExpressionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::UnaryExpression;
+
     enum Operator { NOT, MINUS, BIT_NOT };
     Operator op;
     std::unique_ptr<ExpressionNode> operand;
 
     UnaryExpressionNode(Operator op, std::unique_ptr<ExpressionNode> operand)
-        : op(op), operand(std::move(operand)) {}
+        : ExpressionNode(ClassKind), op(op), operand(std::move(operand)) {}
 
     const char* operatorToString(Operator op) const
     {
@@ -331,12 +471,14 @@ public:
 class UpdateExpressionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::UpdateExpression;
+
     std::unique_ptr<ExpressionNode> target;
     bool isIncrement;
     bool isPrefix;
 
     UpdateExpressionNode(std::unique_ptr<ExpressionNode> target, bool isIncrement, bool isPrefix)
-        : target(std::move(target)), isIncrement(isIncrement), isPrefix(isPrefix) {}
+        : ExpressionNode(ClassKind), target(std::move(target)), isIncrement(isIncrement), isPrefix(isPrefix) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -353,12 +495,14 @@ public:
 class IfStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::IfStatement;
+
     std::unique_ptr<ExpressionNode> condition;
     std::vector<std::unique_ptr<StatementNode>> thenStatements;
     std::vector<std::unique_ptr<StatementNode>> elseStatements; // Optional
     
     explicit IfStatementNode(std::unique_ptr<ExpressionNode> cond)
-        : condition(std::move(cond)) {}
+        : StatementNode(ClassKind), condition(std::move(cond)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -392,11 +536,13 @@ public:
 class WhileStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::WhileStatement;
+
     std::unique_ptr<ExpressionNode> condition;
     std::vector<std::unique_ptr<StatementNode>> bodyStatements;
     
     explicit WhileStatementNode(std::unique_ptr<ExpressionNode> cond)
-        : condition(std::move(cond)) {}
+        : StatementNode(ClassKind), condition(std::move(cond)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -421,11 +567,13 @@ public:
 class AssignmentStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::AssignmentStatement;
+
     std::string variableName;
     std::unique_ptr<ExpressionNode> value;
     
     AssignmentStatementNode(std::string varName, std::unique_ptr<ExpressionNode> val)
-        : variableName(std::move(varName)), value(std::move(val)) {}
+        : StatementNode(ClassKind), variableName(std::move(varName)), value(std::move(val)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -441,6 +589,8 @@ public:
 class ArrayAssignmentStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ArrayAssignmentStatement;
+
     std::unique_ptr<ExpressionNode> array;
     std::unique_ptr<ExpressionNode> index;
     std::unique_ptr<ExpressionNode> value;
@@ -453,7 +603,7 @@ public:
     ArrayAssignmentStatementNode(std::unique_ptr<ExpressionNode> arr, 
                                 std::unique_ptr<ExpressionNode> idx, 
                                 std::unique_ptr<ExpressionNode> val)
-        : array(std::move(arr)), index(std::move(idx)), value(std::move(val)) {}
+        : StatementNode(ClassKind), array(std::move(arr)), index(std::move(idx)), value(std::move(val)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -481,6 +631,8 @@ public:
 class ForStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ForStatement;
+
     std::unique_ptr<StatementNode> initialization; // let i: i32 = 0 or i = 0
     std::unique_ptr<ExpressionNode> condition;     // i < 10
     std::unique_ptr<StatementNode> increment;      // i = i + 1
@@ -489,7 +641,7 @@ public:
     ForStatementNode(std::unique_ptr<StatementNode> init,
                      std::unique_ptr<ExpressionNode> cond,
                      std::unique_ptr<StatementNode> incr)
-        : initialization(std::move(init)), condition(std::move(cond)), increment(std::move(incr)) {}
+        : StatementNode(ClassKind), initialization(std::move(init)), condition(std::move(cond)), increment(std::move(incr)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -524,13 +676,15 @@ public:
 class ForOfStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ForOfStatement;
+
     std::unique_ptr<VariableDeclarationNode> iteratorVariable;
     std::unique_ptr<ExpressionNode> iterable;
     std::vector<std::unique_ptr<StatementNode>> bodyStatements;
 
     ForOfStatementNode(std::unique_ptr<VariableDeclarationNode> itVar,
                        std::unique_ptr<ExpressionNode> iter)
-        : iteratorVariable(std::move(itVar)), iterable(std::move(iter)) {}
+        : StatementNode(ClassKind), iteratorVariable(std::move(itVar)), iterable(std::move(iter)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -560,11 +714,13 @@ public:
 class DoWhileStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::DoWhileStatement;
+
     std::vector<std::unique_ptr<StatementNode>> bodyStatements;
     std::unique_ptr<ExpressionNode> condition;
     
     explicit DoWhileStatementNode(std::unique_ptr<ExpressionNode> cond)
-        : condition(std::move(cond)) {}
+        : StatementNode(ClassKind), condition(std::move(cond)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -589,6 +745,10 @@ public:
 class BreakStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::BreakStatement;
+
+    BreakStatementNode() : StatementNode(ClassKind) {}
+
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
@@ -600,6 +760,10 @@ public:
 class ContinueStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ContinueStatement;
+
+    ContinueStatementNode() : StatementNode(ClassKind) {}
+
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
@@ -611,6 +775,8 @@ public:
 class SwitchStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::SwitchStatement;
+
     struct CaseClause {
         std::unique_ptr<ExpressionNode> value; // null => default clause
         std::vector<std::unique_ptr<StatementNode>> statements;
@@ -620,7 +786,7 @@ public:
     std::vector<CaseClause> cases;
 
     explicit SwitchStatementNode(std::unique_ptr<ExpressionNode> cond)
-        : condition(std::move(cond)) {}
+        : StatementNode(ClassKind), condition(std::move(cond)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -644,6 +810,8 @@ public:
 class InterfaceDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::InterfaceDeclaration;
+
     struct Member {
         std::string name;
         std::string type;
@@ -654,7 +822,7 @@ public:
     std::string parentInterface; // from "extends", empty if none
     std::vector<Member> members;
 
-    explicit InterfaceDeclarationNode(std::string name) : interfaceName(std::move(name)) {}
+    explicit InterfaceDeclarationNode(std::string name) : StatementNode(ClassKind), interfaceName(std::move(name)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -675,6 +843,8 @@ public:
 class ExternDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ExternDeclaration;
+
     struct Parameter {
         std::string name;
         std::string type;
@@ -689,7 +859,7 @@ public:
     std::string symbolName;
 
     ExternDeclarationNode(std::string name, std::string retType)
-        : functionName(std::move(name)), returnType(std::move(retType)),
+        : StatementNode(ClassKind), functionName(std::move(name)), returnType(std::move(retType)),
           symbolName(functionName) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
@@ -713,6 +883,8 @@ public:
 class EnumDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::EnumDeclaration;
+
     struct Member {
         std::string name;
         long long value;
@@ -722,7 +894,7 @@ public:
     std::string enumName;
     std::vector<Member> members;
 
-    explicit EnumDeclarationNode(std::string name) : enumName(std::move(name)) {}
+    explicit EnumDeclarationNode(std::string name) : StatementNode(ClassKind), enumName(std::move(name)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -748,6 +920,8 @@ public:
 class LinkDirectiveNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::LinkDirective;
+
     enum class Kind { Library, Framework, SearchPath, Source, IncludePath };
     enum class Platform { Any, MacOS, Linux, Windows };
 
@@ -756,7 +930,7 @@ public:
     std::string value;
 
     LinkDirectiveNode(Kind k, std::string v, Platform p = Platform::Any)
-        : kind(k), platform(p), value(std::move(v)) {}
+        : StatementNode(ClassKind), kind(k), platform(p), value(std::move(v)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -776,6 +950,8 @@ public:
 class ObjectPropertyAssignmentNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ObjectPropertyAssignment;
+
     std::unique_ptr<ExpressionNode> object;
     std::string property;
     std::unique_ptr<ExpressionNode> value;
@@ -785,7 +961,7 @@ public:
 
     ObjectPropertyAssignmentNode(std::unique_ptr<ExpressionNode> obj, std::string prop,
                                  std::unique_ptr<ExpressionNode> val)
-        : object(std::move(obj)), property(std::move(prop)), value(std::move(val)) {}
+        : StatementNode(ClassKind), object(std::move(obj)), property(std::move(prop)), value(std::move(val)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -804,13 +980,15 @@ public:
 class DestructuringDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::DestructuringDeclaration;
+
     std::vector<std::string> bindings;
     std::unique_ptr<ExpressionNode> initializer;
     bool isConst;
 
     DestructuringDeclarationNode(std::vector<std::string> names,
                                  std::unique_ptr<ExpressionNode> init, bool isConstVal)
-        : bindings(std::move(names)), initializer(std::move(init)), isConst(isConstVal) {}
+        : StatementNode(ClassKind), bindings(std::move(names)), initializer(std::move(init)), isConst(isConstVal) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -829,10 +1007,12 @@ public:
 class ThrowStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ThrowStatement;
+
     std::unique_ptr<ExpressionNode> expression;
 
     explicit ThrowStatementNode(std::unique_ptr<ExpressionNode> expr)
-        : expression(std::move(expr)) {}
+        : StatementNode(ClassKind), expression(std::move(expr)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -846,11 +1026,15 @@ public:
 class TryCatchStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::TryCatchStatement;
+
     std::vector<std::unique_ptr<StatementNode>> tryStatements;
     std::string errorVariable; // catch (e) — empty if no binding
     std::vector<std::unique_ptr<StatementNode>> catchStatements;
     std::vector<std::unique_ptr<StatementNode>> finallyStatements;
 
+    TryCatchStatementNode() : StatementNode(ClassKind) {}
+
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
@@ -873,8 +1057,10 @@ public:
 class ExpressionStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ExpressionStatement;
+
     std::unique_ptr<ExpressionNode> expression;
-    explicit ExpressionStatementNode(std::unique_ptr<ExpressionNode> expr) : expression(std::move(expr)) {}
+    explicit ExpressionStatementNode(std::unique_ptr<ExpressionNode> expr) : StatementNode(ClassKind), expression(std::move(expr)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -890,6 +1076,8 @@ public:
 class FunctionDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::FunctionDeclaration;
+
     struct Parameter {
         std::string name;
         std::string type;
@@ -901,14 +1089,17 @@ public:
     std::vector<Parameter> parameters;
     std::string returnType;
     std::vector<std::unique_ptr<StatementNode>> bodyStatements;
+    // `const function`: pure, so calls with constant arguments are evaluated
+    // by the compiler (ConstEval.h) and replaced by their result
+    bool isConst = false;
 
     FunctionDeclarationNode(std::string name, std::string retType)
-        : functionName(std::move(name)), returnType(std::move(retType)) {}
+        : StatementNode(ClassKind), functionName(std::move(name)), returnType(std::move(retType)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
-        os << "FunctionDeclarationNode: " << functionName;
+        os << "FunctionDeclarationNode: " << (isConst ? "const " : "") << functionName;
         if (!genericParams.empty()) {
             os << "<";
             for (size_t i = 0; i < genericParams.size(); ++i) {
@@ -938,10 +1129,12 @@ public:
 class ReturnStatementNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ReturnStatement;
+
     std::unique_ptr<ExpressionNode> expression; // Optional - can be null for void returns
     
     explicit ReturnStatementNode(std::unique_ptr<ExpressionNode> expr = nullptr) 
-        : expression(std::move(expr)) {}
+        : StatementNode(ClassKind), expression(std::move(expr)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -963,11 +1156,13 @@ public:
 class ArrowFunctionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ArrowFunction;
+
     std::vector<FunctionDeclarationNode::Parameter> parameters;
     std::string returnType; // "auto" = inferred
     std::vector<std::unique_ptr<StatementNode>> bodyStatements;
 
-    ArrowFunctionNode() : returnType("auto") {}
+    ArrowFunctionNode() : ExpressionNode(ClassKind), returnType("auto") {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -987,9 +1182,11 @@ public:
 class FunctionCallNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::FunctionCall;
+
     std::string functionName;
     std::vector<std::unique_ptr<ExpressionNode>> arguments;
-    explicit FunctionCallNode(std::string name) : functionName(std::move(name)) {}
+    explicit FunctionCallNode(std::string name) : ExpressionNode(ClassKind), functionName(std::move(name)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1016,10 +1213,12 @@ public:
 class ArrayLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ArrayLiteral;
+
     std::vector<std::unique_ptr<ExpressionNode>> elements;
     std::string elementType; // "i32", "string", etc.
     
-    explicit ArrayLiteralNode(std::string elemType) : elementType(std::move(elemType)) {}
+    explicit ArrayLiteralNode(std::string elemType) : ExpressionNode(ClassKind), elementType(std::move(elemType)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1039,11 +1238,13 @@ public:
 class ArrayAccessNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ArrayAccess;
+
     std::unique_ptr<ExpressionNode> array;
     std::unique_ptr<ExpressionNode> index;
     
     ArrayAccessNode(std::unique_ptr<ExpressionNode> arr, std::unique_ptr<ExpressionNode> idx)
-        : array(std::move(arr)), index(std::move(idx)) {}
+        : ExpressionNode(ClassKind), array(std::move(arr)), index(std::move(idx)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1066,6 +1267,8 @@ public:
 class ObjectLiteralNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ObjectLiteral;
+
     struct Property {
         std::string key;
         std::unique_ptr<ExpressionNode> value;
@@ -1082,6 +1285,8 @@ public:
 
     std::vector<Property> properties;
 
+    ObjectLiteralNode() : ExpressionNode(ClassKind) {}
+
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
         printIndent(os, indent);
@@ -1106,11 +1311,13 @@ public:
 class ObjectAccessNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ObjectAccess;
+
     std::unique_ptr<ExpressionNode> object;
     std::string property;
     
     ObjectAccessNode(std::unique_ptr<ExpressionNode> obj, std::string prop)
-        : object(std::move(obj)), property(std::move(prop)) {}
+        : ExpressionNode(ClassKind), object(std::move(obj)), property(std::move(prop)) {}
     
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1129,12 +1336,14 @@ public:
 class MethodCallNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::MethodCall;
+
     std::unique_ptr<ExpressionNode> object;
     std::string methodName;
     std::vector<std::unique_ptr<ExpressionNode>> arguments;
 
     MethodCallNode(std::unique_ptr<ExpressionNode> obj, std::string method)
-        : object(std::move(obj)), methodName(std::move(method)) {}
+        : ExpressionNode(ClassKind), object(std::move(obj)), methodName(std::move(method)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1160,11 +1369,16 @@ public:
 class NewExpressionNode : public ExpressionNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::NewExpression;
+
     std::string className;
     std::vector<std::string> genericTypes;
     std::vector<std::unique_ptr<ExpressionNode>> arguments;
+    // For a Buffer: literal initial elements, one per slot, when the buffer is
+    // the result of a compile-time evaluated call. Empty means zero-filled.
+    std::vector<std::unique_ptr<ExpressionNode>> contents;
 
-    NewExpressionNode(std::string name) : className(std::move(name)) {}
+    NewExpressionNode(std::string name) : ExpressionNode(ClassKind), className(std::move(name)) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1185,6 +1399,14 @@ public:
         {
             if (arg) arg->printNode(os, indent + 2);
         }
+        if (!contents.empty()) {
+            printIndent(os, indent + 1);
+            os << "Contents:\n";
+            for (const auto &element : contents)
+            {
+                if (element) element->printNode(os, indent + 2);
+            }
+        }
         printIndent(os, indent);
         os << ")\n";
     }
@@ -1196,6 +1418,8 @@ public:
 class ClassDeclarationNode : public StatementNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::ClassDeclaration;
+
     std::string className;
     std::string parentClass;                           // from `extends`, empty if none
     // From `implements A, B` — checked by the semantic pass. Interfaces stay
@@ -1212,7 +1436,7 @@ public:
     std::vector<const ObjectLiteralNode::Property*> inheritedProperties;
 
     explicit ClassDeclarationNode(std::string name)
-        : className(std::move(name)), objectTemplate(std::make_unique<ObjectLiteralNode>()) {}
+        : StatementNode(ClassKind), className(std::move(name)), objectTemplate(std::make_unique<ObjectLiteralNode>()) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
@@ -1232,7 +1456,16 @@ public:
 class ProgramNode : public ASTNode
 {
 public:
+    static constexpr NodeKind ClassKind = NodeKind::Program;
+
     std::vector<std::unique_ptr<StatementNode>> statements;
+    // Top-level statements marked `export`; they are also in `statements`
+    std::vector<const StatementNode *> exported;
+    // For a program linked from several modules (see ModuleGraph), the module
+    // each statement came from, parallel to `statements`. Empty otherwise.
+    std::vector<std::string> statementOrigins;
+
+    ProgramNode() : ASTNode(ClassKind) {}
 
     void printNode(llvm::raw_ostream &os, int indent = 0) const override
     {
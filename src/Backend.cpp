@@ -0,0 +1,447 @@
+// src/Backend.cpp - In-process LLVM optimization and native code emission
+#include "Backend.h"
+
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/PGOOptions.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/IPO/Internalize.h"
+
+// Host.h moved from Support to TargetParser in LLVM 17
+#if LLVM_VERSION_MAJOR >= 17
+#include "llvm/TargetParser/Host.h"
+#else
+#include "llvm/Support/Host.h"
+#endif
+
+// Up to LLVM 16 the pass managers trace every pass under --time-trace
+// themselves; from 17 on that is an instrumentation callback
+#if LLVM_VERSION_MAJOR >= 17
+#include "llvm/Passes/StandardInstrumentations.h"
+#endif
+
+#if LLVM_VERSION_MAJOR >= 16
+#include "llvm/Support/VirtualFileSystem.h"
+#include <optional>
+#endif
+
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// The codegen enums were renamed in LLVM 18 (CodeGenOpt::Level -> CodeGenOptLevel,
+// CGFT_* -> CodeGenFileType::*). Both spellings are pinned here so nothing else
+// in this file has to care which one it is compiled against.
+#if LLVM_VERSION_MAJOR >= 18
+using CodeGenLevel = llvm::CodeGenOptLevel;
+const CodeGenLevel kCodeGenLevels[] = {CodeGenLevel::None, CodeGenLevel::Less,
+                                       CodeGenLevel::Default, CodeGenLevel::Aggressive};
+const llvm::CodeGenFileType kObjectFileType = llvm::CodeGenFileType::ObjectFile;
+const llvm::CodeGenFileType kAssemblyFileType = llvm::CodeGenFileType::AssemblyFile;
+#else
+using CodeGenLevel = llvm::CodeGenOpt::Level;
+const CodeGenLevel kCodeGenLevels[] = {llvm::CodeGenOpt::None, llvm::CodeGenOpt::Less,
+                                       llvm::CodeGenOpt::Default, llvm::CodeGenOpt::Aggressive};
+const llvm::CodeGenFileType kObjectFileType = llvm::CGFT_ObjectFile;
+const llvm::CodeGenFileType kAssemblyFileType = llvm::CGFT_AssemblyFile;
+#endif
+
+llvm::OptimizationLevel passLevelFor(int optLevel)
+{
+    switch (optLevel) {
+        case 0: return llvm::OptimizationLevel::O0;
+        case 1: return llvm::OptimizationLevel::O1;
+        case 3: return llvm::OptimizationLevel::O3;
+        default: return llvm::OptimizationLevel::O2;
+    }
+}
+
+// PGOOptions grew a virtual file system in LLVM 16 and a memory-profile path in
+// LLVM 17, both ahead of the action. llvm::Optional became std::optional in 16.
+#if LLVM_VERSION_MAJOR >= 16
+using OptionalPGO = std::optional<llvm::PGOOptions>;
+#else
+using OptionalPGO = llvm::Optional<llvm::PGOOptions>;
+#endif
+
+OptionalPGO pgoOptionsFor(const Backend::Options &options)
+{
+    if (!options.pgoGenerate && !options.pgoUse) return OptionalPGO();
+    auto action = options.pgoGenerate ? llvm::PGOOptions::IRInstr : llvm::PGOOptions::IRUse;
+#if LLVM_VERSION_MAJOR >= 17
+    return llvm::PGOOptions(options.pgoProfile, "", "", "", llvm::vfs::getRealFileSystem(), action);
+#elif LLVM_VERSION_MAJOR >= 16
+    return llvm::PGOOptions(options.pgoProfile, "", "", llvm::vfs::getRealFileSystem(), action);
+#else
+    return llvm::PGOOptions(options.pgoProfile, "", "", action);
+#endif
+}
+
+// Reads a bitcode (or textual IR) file into `context`, retargeted to `triple`
+std::unique_ptr<llvm::Module> readBitcode(const std::string &path, llvm::LLVMContext &context,
+                                          const std::string &triple,
+                                          const llvm::DataLayout &dataLayout)
+{
+    llvm::SMDiagnostic diagnostic;
+    std::unique_ptr<llvm::Module> module = llvm::parseIRFile(path, diagnostic, context);
+    if (!module) {
+        std::string message;
+        llvm::raw_string_ostream stream(message);
+        diagnostic.print("cscript", stream, false);
+        // The usual cause: a clang newer than the LLVM cscript was built with
+        throw std::runtime_error("Could not read bitcode " + path + " (clang must not be newer "
+                                 "than LLVM " LLVM_VERSION_STRING "): " + stream.str());
+    }
+    // clang stamps its own triple and layout; the program's win when they
+    // differ only in spelling, and optimize() re-stamps both anyway
+#if LLVM_VERSION_MAJOR >= 21
+    module->setTargetTriple(llvm::Triple(triple));
+#else
+    module->setTargetTriple(triple);
+#endif
+    module->setDataLayout(dataLayout);
+    return module;
+}
+
+// Mutable data only the runtime's own translation unit can see: a copy inlined
+// into the program would be a second, separate instance of it
+bool isPrivateState(const llvm::GlobalValue &value)
+{
+    auto *variable = llvm::dyn_cast<llvm::GlobalVariable>(&value);
+    return variable && variable->hasLocalLinkage() && !variable->isConstant();
+}
+
+// Every global a function's body refers to, looking through constant
+// expressions and into the initializers of the runtime's private constants
+std::vector<const llvm::GlobalValue *> referencedGlobals(const llvm::Function &function)
+{
+    std::vector<const llvm::GlobalValue *> globals;
+    std::vector<const llvm::Value *> worklist;
+    std::set<const llvm::Value *> seen;
+    for (const llvm::BasicBlock &block : function) {
+        for (const llvm::Instruction &instruction : block) {
+            for (const llvm::Use &operand : instruction.operands()) worklist.push_back(operand.get());
+        }
+    }
+    while (!worklist.empty()) {
+        const llvm::Value *value = worklist.back();
+        worklist.pop_back();
+        if (!seen.insert(value).second) continue;
+        if (auto *global = llvm::dyn_cast<llvm::GlobalValue>(value)) {
+            globals.push_back(global);
+            auto *variable = llvm::dyn_cast<llvm::GlobalVariable>(global);
+            if (variable && variable->hasLocalLinkage() && variable->hasInitializer()) {
+                worklist.push_back(variable->getInitializer());
+            }
+        } else if (auto *constant = llvm::dyn_cast<llvm::Constant>(value)) {
+            for (const llvm::Use &operand : constant->operands()) worklist.push_back(operand.get());
+        }
+    }
+    return globals;
+}
+
+// The CPU clang picks when given no -march, so moving codegen in process does
+// not quietly change the instructions the benchmarks are measured with
+std::string defaultCPUFor(const std::string &triple)
+{
+    if (triple.rfind("arm64-apple", 0) == 0 || triple.rfind("aarch64-apple", 0) == 0) {
+        return "apple-m1";
+    }
+    if (triple.rfind("x86_64", 0) == 0) return "x86-64";
+    return "generic";
+}
+
+// The build machine's features as an LLVM feature string. The query filled in
+// an out-parameter until LLVM 19, which returns the map instead.
+std::string hostFeatures()
+{
+    std::string features;
+#if LLVM_VERSION_MAJOR >= 19
+    llvm::StringMap<bool> host = llvm::sys::getHostCPUFeatures();
+#else
+    llvm::StringMap<bool> host;
+    if (!llvm::sys::getHostCPUFeatures(host)) return features;
+#endif
+    for (const auto &feature : host) {
+        features += (features.empty() ? "" : ",") + std::string(feature.second ? "+" : "-") +
+                    feature.first().str();
+    }
+    return features;
+}
+
+} // namespace
+
+Backend::Backend(const Options &options) : m_options(options)
+{
+    if (m_options.optLevel < 0 || m_options.optLevel > 3) {
+        throw std::runtime_error("Optimization level must be 0-3, got " +
+                                 std::to_string(m_options.optLevel));
+    }
+    if (m_options.pgoGenerate && m_options.pgoUse) {
+        throw std::runtime_error("A build can generate a profile or use one, not both");
+    }
+    if (m_options.pgoUse && !std::filesystem::exists(m_options.pgoProfile)) {
+        throw std::runtime_error("Profile not found: " + m_options.pgoProfile +
+                                 " (merge .profraw files with `llvm-profdata merge -o " +
+                                 m_options.pgoProfile + " *.profraw`)");
+    }
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    m_triple = llvm::sys::getDefaultTargetTriple();
+    std::string error;
+
+    // LLVM 21 made the target triple a Triple object throughout; before that
+    // both the registry and the TargetMachine took it as a string.
+#if LLVM_VERSION_MAJOR >= 21
+    llvm::Triple triple(m_triple);
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, error);
+#else
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(m_triple, error);
+#endif
+    if (!target) {
+        throw std::runtime_error("No LLVM target for " + m_triple + ": " + error);
+    }
+
+    // "native" is the build machine exactly: its CPU and every feature it
+    // reports, so a CPU LLVM does not know by name still gets its extensions.
+    // Explicit features go last, so they override the host's.
+    m_cpu = m_options.cpu.empty() ? defaultCPUFor(m_triple) : m_options.cpu;
+    if (m_cpu == "native") {
+        m_cpu = llvm::sys::getHostCPUName().str();
+        m_features = hostFeatures();
+    }
+    if (!m_options.features.empty()) {
+        m_features += (m_features.empty() ? "" : ",") + m_options.features;
+    }
+
+    // LLVM only warns about an unknown CPU, then quietly generates baseline
+    // code; ask a neutral subtarget whether the name means anything first
+    std::unique_ptr<llvm::MCSubtargetInfo> subtarget(
+#if LLVM_VERSION_MAJOR >= 21
+        target->createMCSubtargetInfo(triple, "", ""));
+#else
+        target->createMCSubtargetInfo(m_triple, "", ""));
+#endif
+    if (subtarget && !subtarget->isCPUStringValid(m_cpu)) {
+        throw std::runtime_error("Unknown CPU '" + m_cpu + "' for " + m_triple);
+    }
+
+    // PIC, because every toolchain we link with defaults to PIE executables and
+    // rejects non-relocatable objects in them.
+    llvm::TargetOptions targetOptions;
+#if LLVM_VERSION_MAJOR >= 21
+    m_targetMachine.reset(target->createTargetMachine(
+        triple, m_cpu, m_features, targetOptions, llvm::Reloc::PIC_, {},
+        kCodeGenLevels[m_options.optLevel]));
+#else
+    m_targetMachine.reset(target->createTargetMachine(
+        m_triple, m_cpu, m_features, targetOptions, llvm::Reloc::PIC_, {},
+        kCodeGenLevels[m_options.optLevel]));
+#endif
+    if (!m_targetMachine) {
+        throw std::runtime_error("Could not create a target machine for " + m_triple);
+    }
+}
+
+Backend::~Backend() = default;
+
+void Backend::optimize(llvm::Module &module)
+{
+#if LLVM_VERSION_MAJOR >= 21
+    module.setTargetTriple(llvm::Triple(m_triple));
+#else
+    module.setTargetTriple(m_triple);
+#endif
+    module.setDataLayout(m_targetMachine->createDataLayout());
+
+    // Only the entry point has to stay visible to the linker. The runtime and
+    // -l libraries are still linked as native code, but none of them calls
+    // back into the program by name.
+    if (m_options.lto) {
+        llvm::TimeTraceScope scope("Internalize");
+        llvm::internalizeModule(module, [](const llvm::GlobalValue &value) {
+            return value.getName() == "main";
+        });
+    }
+
+    // The analysis managers must outlive every pass that queries them, and are
+    // cross-registered so a module pass can reach function-level analyses.
+    llvm::LoopAnalysisManager loopAnalyses;
+    llvm::FunctionAnalysisManager functionAnalyses;
+    llvm::CGSCCAnalysisManager cgsccAnalyses;
+    llvm::ModuleAnalysisManager moduleAnalyses;
+
+    llvm::PassInstrumentationCallbacks instrumentation;
+#if LLVM_VERSION_MAJOR >= 17
+    llvm::TimeProfilingPassesHandler passTracing;
+    if (llvm::timeTraceProfilerEnabled()) passTracing.registerCallbacks(instrumentation);
+#endif
+#if LLVM_VERSION_MAJOR < 15
+    // LLVM 14's loop access analysis asks a pointer for its element type when
+    // it plans runtime alias checks, and an opaque pointer has none: any loop
+    // that writes through one pointer and reads through another crashed the
+    // compiler. Skip the passes that run it; SLP vectorization still applies.
+    instrumentation.registerShouldRunOptionalPassCallback([](llvm::StringRef pass, llvm::Any) {
+        return pass != "LoopVectorizePass" && pass != "LoopLoadEliminationPass" &&
+               pass != "LoopDistributePass";
+    });
+#endif
+    llvm::PassBuilder passBuilder(m_targetMachine.get(), llvm::PipelineTuningOptions(),
+                                  pgoOptionsFor(m_options), &instrumentation);
+    passBuilder.registerModuleAnalyses(moduleAnalyses);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalyses);
+    passBuilder.registerFunctionAnalyses(functionAnalyses);
+    passBuilder.registerLoopAnalyses(loopAnalyses);
+    passBuilder.crossRegisterProxies(loopAnalyses, functionAnalyses, cgsccAnalyses,
+                                     moduleAnalyses);
+
+    llvm::OptimizationLevel level = passLevelFor(m_options.optLevel);
+    llvm::ModulePassManager pipeline =
+        m_options.optLevel == 0 ? passBuilder.buildO0DefaultPipeline(level)
+                                : passBuilder.buildPerModuleDefaultPipeline(level);
+    pipeline.run(module, moduleAnalyses);
+}
+
+void Backend::linkBitcode(llvm::Module &module, const std::string &path)
+{
+    llvm::TimeTraceScope scope("Link bitcode", path);
+    std::unique_ptr<llvm::Module> native =
+        readBitcode(path, module.getContext(), m_triple, m_targetMachine->createDataLayout());
+    if (llvm::Linker::linkModules(module, std::move(native))) {
+        throw std::runtime_error("Could not link bitcode " + path + " into the program "
+                                 "(a symbol is defined twice?)");
+    }
+}
+
+void Backend::linkRuntimeBitcode(llvm::Module &module, const std::string &path)
+{
+    llvm::TimeTraceScope scope("Link runtime bitcode", path);
+    std::unique_ptr<llvm::Module> runtime =
+        readBitcode(path, module.getContext(), m_triple, m_targetMachine->createDataLayout());
+
+    // The archive's copy already runs the runtime's static constructors
+    for (const char *name : {"llvm.global_ctors", "llvm.global_dtors", "llvm.used",
+                             "llvm.compiler.used"}) {
+        if (llvm::GlobalVariable *special = runtime->getNamedGlobal(name)) {
+            special->eraseFromParent();
+        }
+    }
+
+    // A function is unsafe to copy if it reaches private state, directly or
+    // through a file-local helper. Iterate until nothing new is found.
+    std::set<const llvm::Function *> unsafe;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const llvm::Function &function : *runtime) {
+            if (function.isDeclaration() || unsafe.count(&function)) continue;
+            for (const llvm::GlobalValue *global : referencedGlobals(function)) {
+                auto *callee = llvm::dyn_cast<llvm::Function>(global);
+                if (isPrivateState(*global) ||
+                    (callee && callee->hasLocalLinkage() && unsafe.count(callee))) {
+                    unsafe.insert(&function);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (llvm::Function &function : *runtime) {
+        if (function.isDeclaration() || function.hasLocalLinkage()) continue;
+        if (unsafe.count(&function)) {
+            function.deleteBody();
+            function.setComdat(nullptr);
+        } else if (function.hasExternalLinkage()) {
+            function.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+            function.setComdat(nullptr);
+        }
+    }
+    // Public data lives in the archive: constants may still fold, everything
+    // else is only referred to
+    for (llvm::GlobalVariable &variable : runtime->globals()) {
+        if (!variable.hasInitializer() || !variable.hasExternalLinkage()) continue;
+        if (variable.isConstant()) {
+            variable.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        } else {
+            variable.setInitializer(nullptr);
+        }
+        variable.setComdat(nullptr);
+    }
+
+    if (llvm::Linker::linkModules(module, std::move(runtime), llvm::Linker::Flags::LinkOnlyNeeded)) {
+        throw std::runtime_error("Could not link the runtime bitcode " + path + " into the program");
+    }
+}
+
+void Backend::emit(llvm::Module &module, EmitKind kind, const std::string &path)
+{
+    llvm::TimeTraceScope scope("Emit", path);
+    std::error_code ec;
+    llvm::sys::fs::OpenFlags flags =
+        (kind == EmitKind::IR || kind == EmitKind::Assembly) ? llvm::sys::fs::OF_Text
+                                                             : llvm::sys::fs::OF_None;
+    llvm::raw_fd_ostream out(path, ec, flags);
+    if (ec) {
+        throw std::runtime_error("Could not open output file '" + path + "': " + ec.message());
+    }
+
+    switch (kind) {
+        case EmitKind::IR:
+            module.print(out, nullptr);
+            break;
+        case EmitKind::Bitcode:
+            llvm::WriteBitcodeToFile(module, out);
+            break;
+        case EmitKind::Object:
+        case EmitKind::Assembly: {
+            // Machine-code emission is still driven by the legacy pass manager
+            llvm::legacy::PassManager codegenPasses;
+            llvm::CodeGenFileType fileType =
+                kind == EmitKind::Object ? kObjectFileType : kAssemblyFileType;
+            if (m_targetMachine->addPassesToEmitFile(codegenPasses, out, nullptr, fileType)) {
+                throw std::runtime_error("The " + m_triple + " target cannot emit this file type");
+            }
+            codegenPasses.run(module);
+            break;
+        }
+    }
+    out.flush();
+}
+
+bool Backend::parseEmitKind(const std::string &name, EmitKind &kind)
+{
+    if (name == "obj") kind = EmitKind::Object;
+    else if (name == "bc") kind = EmitKind::Bitcode;
+    else if (name == "ll") kind = EmitKind::IR;
+    else if (name == "asm") kind = EmitKind::Assembly;
+    else return false;
+    return true;
+}
+
+const char *Backend::extensionFor(EmitKind kind)
+{
+    switch (kind) {
+        case EmitKind::Object: return ".o";
+        case EmitKind::Bitcode: return ".bc";
+        case EmitKind::IR: return ".ll";
+        case EmitKind::Assembly: return ".s";
+    }
+    return ".o";
+}
@@ -0,0 +1,87 @@
+// src/Backend.h - In-process LLVM optimization and native code emission
+// Takes the module CodeGen produced, runs LLVM's new pass manager over it at the
+// requested -O level and writes the result through a TargetMachine. The driver
+// only has to call out to a linker afterwards, instead of handing textual IR to a
+// clang++ subprocess that re-parses it and re-runs the whole pipeline.
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include <memory>
+#include <string>
+
+class Backend
+{
+public:
+    // What to write. Object is what the executable path links; the others are
+    // for inspecting or post-processing the compiler's output.
+    enum class EmitKind { Object, Bitcode, IR, Assembly };
+
+    struct Options {
+        int optLevel = 2;   // 0-3, as -O0..-O3
+        // CPU to generate code for: empty for the conservative default clang
+        // also uses, "native" for the build machine's own CPU and features
+        std::string cpu;
+        // Extra subtarget features, LLVM-style: "+avx2,-avx512f"
+        std::string features;
+        // Whole-program mode (--lto): everything but `main` is internalized
+        // before the pipeline runs, so merged-in native code can be inlined
+        // and anything left unused deleted
+        bool lto = false;
+        // Profile-guided optimization. With `pgoGenerate` the pipeline adds
+        // IR instrumentation; the executable must then be linked with
+        // -fprofile-generate and writes a .profraw when it exits (to
+        // `pgoProfile` if set, else LLVM's default name). With `pgoUse`,
+        // `pgoProfile` is a merged .profdata the optimizer is guided by.
+        bool pgoGenerate = false;
+        bool pgoUse = false;
+        std::string pgoProfile;
+    };
+
+    // Initializes the native target and builds a TargetMachine for the host.
+    // Throws std::runtime_error if the host target is not available.
+    explicit Backend(const Options &options);
+    ~Backend();
+
+    // Stamps the module with the target triple and data layout, then runs the
+    // default per-module pipeline for the configured -O level
+    void optimize(llvm::Module &module);
+
+    // Merges an LLVM bitcode file (a `link source` file compiled with
+    // -emit-llvm) into the module, in the module's context. Throws
+    // std::runtime_error if it cannot be read or its symbols clash.
+    void linkBitcode(llvm::Module &module, const std::string &path);
+
+    // Merges the runtime's bitcode build (libcypescript.bc) into the module so
+    // calls like array_get_i32 can inline. Only what the module calls comes
+    // in, and only as available_externally bodies: the runtime archive is
+    // still linked and keeps the one real copy of every symbol and of the
+    // runtime's state. Functions touching the runtime's private state stay
+    // plain calls. Throws std::runtime_error if the file cannot be read.
+    void linkRuntimeBitcode(llvm::Module &module, const std::string &path);
+
+    // Writes the module to `path` in the requested form
+    void emit(llvm::Module &module, EmitKind kind, const std::string &path);
+
+    // The triple objects are emitted for (the host's)
+    const std::string &triple() const { return m_triple; }
+    // The CPU and feature string actually in use, after resolving "native"
+    const std::string &cpu() const { return m_cpu; }
+    const std::string &features() const { return m_features; }
+
+    // "obj" | "bc" | "ll" | "asm"; returns false for anything else
+    static bool parseEmitKind(const std::string &name, EmitKind &kind);
+    // The conventional file extension for an emit kind (".o", ".bc", ...)
+    static const char *extensionFor(EmitKind kind);
+
+private:
+    Options m_options;
+    std::string m_triple;
+    std::string m_cpu;
+    std::string m_features;
+    std::unique_ptr<llvm::TargetMachine> m_targetMachine;
+};
+
+#endif // BACKEND_H
@@ -11,6 +11,8 @@
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <iostream>
 #include <vector>
 #include <stdexcept>
@@ -82,17 +84,27 @@ llvm::Value *CodeGen::toStringValue(llvm::Value *val)
     if (type->isPointerTy()) {
         return val; // already a string pointer
     }
-    if (type->isDoubleTy()) {
+    if (type->isFloatingPointTy()) {
+        llvm::Type *doubleTy = llvm::Type::getDoubleTy(m_context);
         llvm::FunctionCallee toStr = m_module->getOrInsertFunction("cyps_f64_to_string",
-            charPtr, llvm::Type::getDoubleTy(m_context));
-        return m_builder.CreateCall(toStr, {val}, "f64_str");
+            charPtr, doubleTy);
+        return m_builder.CreateCall(toStr, {coerceValue(val, doubleTy)}, "f64_str");
+    }
+    if (type->isIntegerTy(64)) {
+        llvm::FunctionCallee toStr = m_module->getOrInsertFunction("cyps_i64_to_string",
+            charPtr, llvm::Type::getInt64Ty(m_context));
+        return m_builder.CreateCall(toStr, {val}, "i64_str");
     }
-    // Integers (including i1 booleans)
+    // Other integers widen to i32: i1 booleans as 0 or 1, bytes as println
+    // prints them
+    llvm::Type *i32Ty = llvm::Type::getInt32Ty(m_context);
     if (type->isIntegerTy(1)) {
-        val = m_builder.CreateZExt(val, llvm::Type::getInt32Ty(m_context), "bool_ext");
+        val = m_builder.CreateZExt(val, i32Ty, "bool_ext");
+    } else if (type->getIntegerBitWidth() < 32) {
+        val = m_builder.CreateSExt(val, i32Ty, "int_ext");
     }
     llvm::FunctionCallee toStr = m_module->getOrInsertFunction("cyps_i32_to_string",
-        charPtr, llvm::Type::getInt32Ty(m_context));
+        charPtr, i32Ty);
     return m_builder.CreateCall(toStr, {val}, "i32_str");
 }
 
@@ -287,6 +299,7 @@ void CodeGen::visit(ProgramNode *node)
     // Clear symbol table for each new program generation
     namedValues.clear();
     variableTypes.clear();
+    constVariables.clear();
     arraySizes.clear();
     declaredFunctions.clear();
     interfaces.clear();
@@ -312,56 +325,71 @@ void CodeGen::visit(ProgramNode *node)
 
     // Pass 0: Register interfaces, classes and foreign declarations so they are
     // usable everywhere, including above their point of declaration
-    for (const auto &stmt : node->statements)
     {
-        if (auto *interfaceNode = dynamic_cast<InterfaceDeclarationNode *>(stmt.get()))
-        {
-            interfaces[interfaceNode->interfaceName] = interfaceNode;
-        }
-        else if (auto *classNode = dynamic_cast<ClassDeclarationNode *>(stmt.get()))
-        {
-            classes[classNode->className] = classNode;
-        }
-        else if (auto *externNode = dynamic_cast<ExternDeclarationNode *>(stmt.get()))
-        {
-            externFunctions[externNode->functionName] = externNode;
-        }
-        else if (auto *enumNode = dynamic_cast<EnumDeclarationNode *>(stmt.get()))
+        llvm::TimeTraceScope scope("Register declarations");
+        for (const auto &stmt : node->statements)
         {
-            enumTypes.insert(enumNode->enumName);
+            if (auto *interfaceNode = nodeCast<InterfaceDeclarationNode>(stmt.get()))
+            {
+                interfaces[interfaceNode->interfaceName] = interfaceNode;
+            }
+            else if (auto *classNode = nodeCast<ClassDeclarationNode>(stmt.get()))
+            {
+                classes[classNode->className] = classNode;
+            }
+            else if (auto *externNode = nodeCast<ExternDeclarationNode>(stmt.get()))
+            {
+                externFunctions[externNode->functionName] = externNode;
+            }
+            else if (auto *enumNode = nodeCast<EnumDeclarationNode>(stmt.get()))
+            {
+                enumTypes.insert(enumNode->enumName);
+            }
         }
     }
 
     // Resolve `extends` first: a subclass lays its parent's members out ahead of
     // its own, so layouts must be built after the chain is known.
-    templateOwner.clear();
-    for (auto &entry : classes) {
-        std::set<std::string> visiting;
-        resolveClassInheritance(entry.second, visiting);
-        templateOwner[entry.second->objectTemplate.get()] = entry.second;
+    {
+        llvm::TimeTraceScope scope("Class inheritance");
+        templateOwner.clear();
+        for (auto &entry : classes) {
+            std::set<std::string> visiting;
+            resolveClassInheritance(entry.second, visiting);
+            templateOwner[entry.second->objectTemplate.get()] = entry.second;
+        }
     }
 
     // Which hierarchies need virtual dispatch — decided before layouts, because
     // a polymorphic class carries a hidden vtable pointer as its first field.
-    computeVirtualDispatch();
+    {
+        llvm::TimeTraceScope scope("Virtual dispatch");
+        computeVirtualDispatch();
+    }
 
     // Class struct layouts are computed from declared field types before any
     // code is generated, so a class-typed value knows its layout no matter
     // where it came from
-    for (auto &entry : classes) {
-        registerClassLayout(entry.second);
+    {
+        llvm::TimeTraceScope scope("Class layout");
+        for (auto &entry : classes) {
+            registerClassLayout(entry.second);
+        }
     }
 
     // First pass: declare every function's signature, but generate no bodies
     // yet. main is emitted before the bodies because it is what creates the
     // module-level globals those bodies may reference.
     std::vector<FunctionDeclarationNode *> functionDecls;
-    for (const auto &stmt : node->statements)
     {
-        if (auto *funcDeclNode = dynamic_cast<FunctionDeclarationNode *>(stmt.get()))
+        llvm::TimeTraceScope scope("Function signatures");
+        for (const auto &stmt : node->statements)
         {
-            declareFunctionSignature(funcDeclNode);
-            functionDecls.push_back(funcDeclNode);
+            if (auto *funcDeclNode = nodeCast<FunctionDeclarationNode>(stmt.get()))
+            {
+                declareFunctionSignature(funcDeclNode);
+                functionDecls.push_back(funcDeclNode);
+            }
         }
     }
 
@@ -369,12 +397,12 @@ void CodeGen::visit(ProgramNode *node)
     std::vector<StatementNode*> mainStatements;
     for (const auto &stmt : node->statements)
     {
-        if (!dynamic_cast<FunctionDeclarationNode *>(stmt.get()) &&
-            !dynamic_cast<InterfaceDeclarationNode *>(stmt.get()) &&
-            !dynamic_cast<ClassDeclarationNode *>(stmt.get()) &&
-            !dynamic_cast<ExternDeclarationNode *>(stmt.get()) &&
-            !dynamic_cast<EnumDeclarationNode *>(stmt.get()) &&
-            !dynamic_cast<LinkDirectiveNode *>(stmt.get()))
+        if (!nodeCast<FunctionDeclarationNode>(stmt.get()) &&
+            !nodeCast<InterfaceDeclarationNode>(stmt.get()) &&
+            !nodeCast<ClassDeclarationNode>(stmt.get()) &&
+            !nodeCast<ExternDeclarationNode>(stmt.get()) &&
+            !nodeCast<EnumDeclarationNode>(stmt.get()) &&
+            !nodeCast<LinkDirectiveNode>(stmt.get()))
         {
             mainStatements.push_back(stmt.get());
         }
@@ -383,6 +411,7 @@ void CodeGen::visit(ProgramNode *node)
     // Only create main function if there are non-function statements
     if (!mainStatements.empty())
     {
+        llvm::TimeTraceScope scope("Generate main");
         llvm::FunctionType *mainFuncType = llvm::FunctionType::get(llvm::Type::getInt32Ty(m_context), false);
         llvm::Function *mainFunc = llvm::Function::Create(
             mainFuncType, llvm::Function::ExternalLinkage, "main", m_module.get());
@@ -397,7 +426,7 @@ void CodeGen::visit(ProgramNode *node)
         // nested inside a block) are the ones eligible to become globals.
         for (StatementNode* stmt : mainStatements)
         {
-            atModuleLevel = dynamic_cast<VariableDeclarationNode *>(stmt) != nullptr;
+            atModuleLevel = nodeCast<VariableDeclarationNode>(stmt) != nullptr;
             visit(stmt);
         }
         atModuleLevel = false;
@@ -415,109 +444,89 @@ void CodeGen::visit(ProgramNode *node)
 
     // Third pass: generate the function bodies, now that module-level globals
     // exist and their recorded types are known
+    llvm::TimeTraceScope scope("Function bodies");
     for (FunctionDeclarationNode *funcDeclNode : functionDecls)
     {
+        llvm::TimeTraceScope functionScope("Function", funcDeclNode->functionName);
         visit(funcDeclNode);
     }
 }
 
 void CodeGen::visit(StatementNode *node)
 {
-    if (auto *declNode = dynamic_cast<VariableDeclarationNode *>(node))
-    {
-        visit(declNode);
-    }
-    else if (auto *funcDeclNode = dynamic_cast<FunctionDeclarationNode *>(node))
-    {
-        visit(funcDeclNode);
-    }
-    else if (auto *typeAliasNode = dynamic_cast<TypeAliasNode *>(node))
-    {
-        visit(typeAliasNode);
-    }
-    else if (auto *returnNode = dynamic_cast<ReturnStatementNode *>(node))
-    {
-        visit(returnNode);
-    }
-    else if (auto *exprStmtNode = dynamic_cast<ExpressionStatementNode *>(node))
-    {
-        visit(exprStmtNode);
-    }
-    else if (auto *ifNode = dynamic_cast<IfStatementNode *>(node))
-    {
-        visit(ifNode);
-    }
-    else if (auto *whileNode = dynamic_cast<WhileStatementNode *>(node))
-    {
-        visit(whileNode);
-    }
-    else if (auto *forNode = dynamic_cast<ForStatementNode *>(node))
-    {
-        visit(forNode);
-    }
-    else if (auto *forOfNode = dynamic_cast<ForOfStatementNode *>(node))
-    {
-        visit(forOfNode);
-    }
-    else if (auto *doWhileNode = dynamic_cast<DoWhileStatementNode *>(node))
-    {
-        visit(doWhileNode);
-    }
-    else if (auto *assignNode = dynamic_cast<AssignmentStatementNode *>(node))
-    {
-        visit(assignNode);
-    }
-    else if (auto *arrayAssignNode = dynamic_cast<ArrayAssignmentStatementNode *>(node))
-    {
-        visit(arrayAssignNode);
-    }
-    else if (auto *breakNode = dynamic_cast<BreakStatementNode *>(node))
-    {
-        visit(breakNode);
-    }
-    else if (auto *continueNode = dynamic_cast<ContinueStatementNode *>(node))
-    {
-        visit(continueNode);
-    }
-    else if (auto *switchNode = dynamic_cast<SwitchStatementNode *>(node))
-    {
-        visit(switchNode);
-    }
-    else if (auto *interfaceNode = dynamic_cast<InterfaceDeclarationNode *>(node))
-    {
-        visit(interfaceNode);
-    }
-    else if (auto *classNode = dynamic_cast<ClassDeclarationNode *>(node))
-    {
-        visit(classNode);
-    }
-    else if (auto *propAssignNode = dynamic_cast<ObjectPropertyAssignmentNode *>(node))
-    {
-        visit(propAssignNode);
-    }
-    else if (auto *destructNode = dynamic_cast<DestructuringDeclarationNode *>(node))
-    {
-        visit(destructNode);
-    }
-    else if (auto *tryNode = dynamic_cast<TryCatchStatementNode *>(node))
-    {
-        visit(tryNode);
-    }
-    else if (auto *throwNode = dynamic_cast<ThrowStatementNode *>(node))
-    {
-        visit(throwNode);
-    }
-    else if (dynamic_cast<ExternDeclarationNode *>(node) ||
-             dynamic_cast<EnumDeclarationNode *>(node) ||
-             dynamic_cast<LinkDirectiveNode *>(node))
-    {
-        // Declarations only: externs are registered in pass 0 and emitted lazily
-        // at their first call site; link directives are consumed by the driver.
-    }
-    else
-    {
-        std::cerr << "Codegen Error: Unsupported statement type.\n";
-        throw std::runtime_error("Unsupported statement type in codegen.");
+    switch (node->nodeKind) {
+        case NodeKind::VariableDeclaration:
+            visit(static_cast<VariableDeclarationNode *>(node));
+            return;
+        case NodeKind::FunctionDeclaration:
+            visit(static_cast<FunctionDeclarationNode *>(node));
+            return;
+        case NodeKind::TypeAlias:
+            visit(static_cast<TypeAliasNode *>(node));
+            return;
+        case NodeKind::ReturnStatement:
+            visit(static_cast<ReturnStatementNode *>(node));
+            return;
+        case NodeKind::ExpressionStatement:
+            visit(static_cast<ExpressionStatementNode *>(node));
+            return;
+        case NodeKind::IfStatement:
+            visit(static_cast<IfStatementNode *>(node));
+            return;
+        case NodeKind::WhileStatement:
+            visit(static_cast<WhileStatementNode *>(node));
+            return;
+        case NodeKind::ForStatement:
+            visit(static_cast<ForStatementNode *>(node));
+            return;
+        case NodeKind::ForOfStatement:
+            visit(static_cast<ForOfStatementNode *>(node));
+            return;
+        case NodeKind::DoWhileStatement:
+            visit(static_cast<DoWhileStatementNode *>(node));
+            return;
+        case NodeKind::AssignmentStatement:
+            visit(static_cast<AssignmentStatementNode *>(node));
+            return;
+        case NodeKind::ArrayAssignmentStatement:
+            visit(static_cast<ArrayAssignmentStatementNode *>(node));
+            return;
+        case NodeKind::BreakStatement:
+            visit(static_cast<BreakStatementNode *>(node));
+            return;
+        case NodeKind::ContinueStatement:
+            visit(static_cast<ContinueStatementNode *>(node));
+            return;
+        case NodeKind::SwitchStatement:
+            visit(static_cast<SwitchStatementNode *>(node));
+            return;
+        case NodeKind::InterfaceDeclaration:
+            visit(static_cast<InterfaceDeclarationNode *>(node));
+            return;
+        case NodeKind::ClassDeclaration:
+            visit(static_cast<ClassDeclarationNode *>(node));
+            return;
+        case NodeKind::ObjectPropertyAssignment:
+            visit(static_cast<ObjectPropertyAssignmentNode *>(node));
+            return;
+        case NodeKind::DestructuringDeclaration:
+            visit(static_cast<DestructuringDeclarationNode *>(node));
+            return;
+        case NodeKind::TryCatchStatement:
+            visit(static_cast<TryCatchStatementNode *>(node));
+            return;
+        case NodeKind::ThrowStatement:
+            visit(static_cast<ThrowStatementNode *>(node));
+            return;
+        case NodeKind::ExternDeclaration:
+        case NodeKind::EnumDeclaration:
+        case NodeKind::LinkDirective:
+            // Declarations only: externs are registered in pass 0 and emitted lazily
+            // at their first call site; link directives are consumed by the driver.
+            return;
+        default:
+            std::cerr << "Codegen Error: Unsupported statement type.\n";
+            throw std::runtime_error("Unsupported statement type in codegen.");
     }
 }
 
@@ -525,7 +534,7 @@ void CodeGen::visit(VariableDeclarationNode *node)
 {
     // Structural type check when declaring against an interface
     if (interfaces.count(node->typeName)) {
-        if (auto *objLit = dynamic_cast<ObjectLiteralNode*>(node->initializer.get())) {
+        if (auto *objLit = nodeCast<ObjectLiteralNode>(node->initializer.get())) {
             checkInterfaceConformance(node->typeName, objLit, node->variableName);
         }
     }
@@ -533,7 +542,7 @@ void CodeGen::visit(VariableDeclarationNode *node)
     // An explicit array annotation drives the literal's element type
     // (e.g. let a: f64[] = [1, 2] pushes doubles, not i32s)
     if (node->typeName.length() > 2 && node->typeName.substr(node->typeName.length() - 2) == "[]") {
-        if (auto *arrLit = dynamic_cast<ArrayLiteralNode*>(node->initializer.get())) {
+        if (auto *arrLit = nodeCast<ArrayLiteralNode>(node->initializer.get())) {
             arrLit->elementType = node->typeName.substr(0, node->typeName.length() - 2);
         }
     }
@@ -555,16 +564,16 @@ void CodeGen::visit(VariableDeclarationNode *node)
 
     // Determine the recorded type name for this variable
     std::string typeToStore = node->typeName;
-    if (auto *objLit = dynamic_cast<ObjectLiteralNode*>(node->initializer.get())) {
+    if (auto *objLit = nodeCast<ObjectLiteralNode>(node->initializer.get())) {
         // Native object: track the layout key regardless of the declared type
         typeToStore = "object";
         variableToObjectKey[node->variableName] =
             "opt_obj_" + std::to_string(reinterpret_cast<uintptr_t>(objLit));
-    } else if (auto *arrowLit = dynamic_cast<ArrowFunctionNode*>(node->initializer.get())) {
+    } else if (auto *arrowLit = nodeCast<ArrowFunctionNode>(node->initializer.get())) {
         // Closure: track the arrow node so calls through this variable bind statically
         typeToStore = "closure";
         variableToArrow[node->variableName] = arrowLit;
-    } else if (dynamic_cast<NewExpressionNode*>(node->initializer.get()) &&
+    } else if (nodeCast<NewExpressionNode>(node->initializer.get()) &&
                classes.count(static_cast<NewExpressionNode*>(node->initializer.get())->className)) {
         // Class instance: record the class as the variable's type, so its layout
         // can be found from the type alone, and keep the direct binding too
@@ -572,11 +581,11 @@ void CodeGen::visit(VariableDeclarationNode *node)
         typeToStore = newExpr->className;
         variableToObjectKey[node->variableName] = "opt_obj_" +
             std::to_string(reinterpret_cast<uintptr_t>(classes[newExpr->className]->objectTemplate.get()));
-    } else if (auto *arrLit = dynamic_cast<ArrayLiteralNode*>(node->initializer.get())) {
+    } else if (auto *arrLit = nodeCast<ArrayLiteralNode>(node->initializer.get())) {
         if (node->typeName == "auto") typeToStore = arrLit->elementType + "[]";
         arraySizes[node->variableName] = arrLit->elements.size();
     } else if (node->typeName == "auto") {
-        if (auto *callNode = dynamic_cast<FunctionCallNode*>(node->initializer.get())) {
+        if (auto *callNode = nodeCast<FunctionCallNode>(node->initializer.get())) {
             if (callNode->functionName == "JSON.parse") typeToStore = "json";
             else if (callNode->functionName == "JSON.stringify") typeToStore = "string";
             else {
@@ -593,10 +602,12 @@ void CodeGen::visit(VariableDeclarationNode *node)
                     if (typeToStore == "void") typeToStore = "";
                 }
             }
-        } else if (auto *newExpr = dynamic_cast<NewExpressionNode*>(node->initializer.get())) {
+        } else if (auto *newExpr = nodeCast<NewExpressionNode>(node->initializer.get())) {
             // e.g. new Map<string, string[]>() -> "Map<string,string[]>"
             typeToStore = newExpr->className;
-            if (!newExpr->genericTypes.empty()) {
+            if (newExpr->className == "Array" && newExpr->genericTypes.size() == 1) {
+                typeToStore = newExpr->genericTypes[0] + "[]";   // an array, not a class
+            } else if (!newExpr->genericTypes.empty()) {
                 typeToStore += "<";
                 for (size_t i = 0; i < newExpr->genericTypes.size(); ++i) {
                     if (i > 0) typeToStore += ",";
@@ -604,10 +615,10 @@ void CodeGen::visit(VariableDeclarationNode *node)
                 }
                 typeToStore += ">";
             }
-        } else if (auto *varRef = dynamic_cast<VariableExpressionNode*>(node->initializer.get())) {
+        } else if (auto *varRef = nodeCast<VariableExpressionNode>(node->initializer.get())) {
             // Aliasing another variable: copy its recorded type and object/closure binding
-            auto typeIt = variableTypes.find(varRef->name);
-            typeToStore = (typeIt != variableTypes.end()) ? typeIt->second : "";
+            const std::string *aliasType = variableTypes.lookup(varRef->name);
+            typeToStore = aliasType ? *aliasType : "";
             auto keyIt = variableToObjectKey.find(varRef->name);
             if (keyIt != variableToObjectKey.end()) {
                 variableToObjectKey[node->variableName] = keyIt->second;
@@ -616,24 +627,17 @@ void CodeGen::visit(VariableDeclarationNode *node)
             if (arrowIt != variableToArrow.end()) {
                 variableToArrow[node->variableName] = arrowIt->second;
             }
-        } else if (auto *methodCall = dynamic_cast<MethodCallNode*>(node->initializer.get())) {
+        } else if (auto *methodCall = nodeCast<MethodCallNode>(node->initializer.get())) {
             // e.g. numbers.map(...) -> i32[]/string[], arr.filter(...) -> source type
             typeToStore = inferMethodCallTypeName(methodCall);
-        } else if (auto *arrAccess = dynamic_cast<ArrayAccessNode*>(node->initializer.get())) {
+        } else if (auto *arrAccess = nodeCast<ArrayAccessNode>(node->initializer.get())) {
             // let e = entities[i]; takes the array's element type, so an object
-            // element keeps its layout
-            if (auto *arrVar = dynamic_cast<VariableExpressionNode*>(arrAccess->array.get())) {
-                auto arrTypeIt = variableTypes.find(arrVar->name);
-                if (arrTypeIt != variableTypes.end()) {
-                    const std::string &arrType = arrTypeIt->second;
-                    if (arrType.size() > 2 && arrType.substr(arrType.size() - 2) == "[]") {
-                        typeToStore = arrType.substr(0, arrType.size() - 2);
-                    }
-                }
-            }
+            // element keeps its layout — also through a field (bag.items[i])
+            typeToStore = arrayTypeOfExpression(arrAccess);
         } else {
             typeToStore = "";
         }
+        if (typeToStore.empty()) typeToStore = resolvedTypeOf(node->initializer.get());
         if (typeToStore.empty()) {
             // Fall back to the LLVM type of the generated value
             if (!initVal) typeToStore = "i32";
@@ -689,76 +693,46 @@ void CodeGen::visit(VariableDeclarationNode *node)
 
 llvm::Value *CodeGen::visit(ExpressionNode *node)
 {
-    if (auto *strNode = dynamic_cast<StringLiteralNode *>(node))
-    {
-        return visit(strNode);
-    }
-    else if (auto *intNode = dynamic_cast<IntegerLiteralNode *>(node))
-    {
-        return visit(intNode);
-    }
-    else if (auto *boolNode = dynamic_cast<BooleanLiteralNode *>(node))
-    {
-        return visit(boolNode);
-    }
-    else if (auto *floatNode = dynamic_cast<FloatLiteralNode *>(node))
-    {
-        return visit(floatNode);
-    }
-    else if (dynamic_cast<NullLiteralNode *>(node))
-    {
-        return llvm::ConstantPointerNull::get(
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-    }
-    else if (auto *varNode = dynamic_cast<VariableExpressionNode *>(node))
-    {
-        return visit(varNode);
-    }
-    else if (auto *binOpNode = dynamic_cast<BinaryExpressionNode *>(node))
-    {
-        return visit(binOpNode);
-    }
-    else if (auto *unaryOpNode = dynamic_cast<UnaryExpressionNode *>(node))
-    {
-        return visit(unaryOpNode);
-    }
-    else if (auto *updateNode = dynamic_cast<UpdateExpressionNode *>(node))
-    {
-        return visit(updateNode);
-    }
-    else if (auto *arrLitNode = dynamic_cast<ArrayLiteralNode *>(node))
-    {
-        return visit(arrLitNode);
-    }
-    else if (auto *objLitNode = dynamic_cast<ObjectLiteralNode *>(node))
-    {
-        return visit(objLitNode);
-    }
-    else if (auto *arrAccNode = dynamic_cast<ArrayAccessNode *>(node))
-    {
-        return visit(arrAccNode);
-    }
-    else if (auto *objAccNode = dynamic_cast<ObjectAccessNode *>(node))
-    {
-        return visit(objAccNode);
-    }
-    else if (auto *methodCallNode = dynamic_cast<MethodCallNode *>(node))
-    {
-        return visit(methodCallNode);
-    }
-    else if (auto *newNode = dynamic_cast<NewExpressionNode *>(node))
-    {
-        return visit(newNode);
-    }
-    else if (auto *arrowNode = dynamic_cast<ArrowFunctionNode *>(node))
-    {
-        return visit(arrowNode);
-    }
-    else if (auto *funcCallNode = dynamic_cast<FunctionCallNode *>(node))
-    {
-        return visit(funcCallNode);
+    switch (node->nodeKind) {
+        case NodeKind::StringLiteral:
+            return visit(static_cast<StringLiteralNode *>(node));
+        case NodeKind::IntegerLiteral:
+            return visit(static_cast<IntegerLiteralNode *>(node));
+        case NodeKind::BooleanLiteral:
+            return visit(static_cast<BooleanLiteralNode *>(node));
+        case NodeKind::FloatLiteral:
+            return visit(static_cast<FloatLiteralNode *>(node));
+        case NodeKind::NullLiteral:
+            return llvm::ConstantPointerNull::get(
+                llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
+        case NodeKind::VariableExpression:
+            return visit(static_cast<VariableExpressionNode *>(node));
+        case NodeKind::BinaryExpression:
+            return visit(static_cast<BinaryExpressionNode *>(node));
+        case NodeKind::UnaryExpression:
+            return visit(static_cast<UnaryExpressionNode *>(node));
+        case NodeKind::UpdateExpression:
+            return visit(static_cast<UpdateExpressionNode *>(node));
+        case NodeKind::ArrayLiteral:
+            return visit(static_cast<ArrayLiteralNode *>(node));
+        case NodeKind::ObjectLiteral:
+            return visit(static_cast<ObjectLiteralNode *>(node));
+        case NodeKind::ArrayAccess:
+            return visit(static_cast<ArrayAccessNode *>(node));
+        case NodeKind::ObjectAccess:
+            return visit(static_cast<ObjectAccessNode *>(node));
+        case NodeKind::MethodCall:
+            return visit(static_cast<MethodCallNode *>(node));
+        case NodeKind::NewExpression:
+            return visit(static_cast<NewExpressionNode *>(node));
+        case NodeKind::ArrowFunction:
+            return visit(static_cast<ArrowFunctionNode *>(node));
+        case NodeKind::FunctionCall:
+            return visit(static_cast<FunctionCallNode *>(node));
+        default:
+            break;
     }
-    
+
     std::cerr << "Codegen Error: Unsupported expression type in visit(ExpressionNode*).\n";
     throw std::runtime_error("Unsupported expression type in codegen.");
 }
@@ -798,12 +772,12 @@ void CodeGen::collectFunctionReferencedNames(ProgramNode *node)
         std::set<std::string> bound;
         std::set<std::string> free;
 
-        if (auto *funcDecl = dynamic_cast<FunctionDeclarationNode *>(stmt.get())) {
+        if (auto *funcDecl = nodeCast<FunctionDeclarationNode>(stmt.get())) {
             for (const auto &param : funcDecl->parameters) bound.insert(param.name);
             for (const auto &bodyStmt : funcDecl->bodyStatements) {
                 collectFreeVars(bodyStmt.get(), bound, free);
             }
-        } else if (auto *classDecl = dynamic_cast<ClassDeclarationNode *>(stmt.get())) {
+        } else if (auto *classDecl = nodeCast<ClassDeclarationNode>(stmt.get())) {
             for (const auto &prop : classDecl->objectTemplate->properties) {
                 if (!prop.method) continue;
                 std::set<std::string> methodBound;
@@ -823,12 +797,26 @@ void CodeGen::collectFunctionReferencedNames(ProgramNode *node)
     }
 }
 
+void CodeGen::pushScope(bool isolateLocals)
+{
+    namedValues.pushScope(isolateLocals);
+    variableTypes.pushScope();
+    constVariables.pushScope();
+}
+
+void CodeGen::popScope()
+{
+    namedValues.popScope();
+    variableTypes.popScope();
+    constVariables.popScope();
+}
+
 llvm::Value *CodeGen::variableStorage(const std::string &name, llvm::Type **outType)
 {
-    auto local = namedValues.find(name);
-    if (local != namedValues.end() && local->second) {
-        if (outType) *outType = local->second->getAllocatedType();
-        return local->second;
+    llvm::AllocaInst **local = namedValues.lookup(name);
+    if (local && *local) {
+        if (outType) *outType = (*local)->getAllocatedType();
+        return *local;
     }
     auto global = globalValues.find(name);
     if (global != globalValues.end() && global->second) {
@@ -909,7 +897,7 @@ llvm::Value *CodeGen::visit(UpdateExpressionNode *node)
     };
 
     // A plain variable: load, step, store back into the same slot
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode *>(node->target.get())) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(node->target.get())) {
         llvm::Type *storedType = nullptr;
         llvm::Value *slot = variableStorage(varExpr->name, &storedType);
         if (!slot) {
@@ -922,7 +910,7 @@ llvm::Value *CodeGen::visit(UpdateExpressionNode *node)
     }
 
     // An array or buffer element: evaluate the container and the index once
-    if (auto *access = dynamic_cast<ArrayAccessNode *>(node->target.get())) {
+    if (auto *access = nodeCast<ArrayAccessNode>(node->target.get())) {
         llvm::Value *arrayValue = visit(access->array.get());
         llvm::Value *indexValue = visit(access->index.get());
         if (!arrayValue || !indexValue) {
@@ -951,7 +939,7 @@ llvm::Value *CodeGen::visit(UpdateExpressionNode *node)
     }
 
     // An object or class property: resolve the struct pointer once
-    if (auto *access = dynamic_cast<ObjectAccessNode *>(node->target.get())) {
+    if (auto *access = nodeCast<ObjectAccessNode>(node->target.get())) {
         llvm::Value *structPtr = nullptr;
         const ObjectOptimizer::ObjectLayout *layout = nullptr;
         if (!resolveObjectProperty(access->object.get(), access->property, structPtr, layout)) {
@@ -1076,7 +1064,7 @@ llvm::Value *CodeGen::visit(BinaryExpressionNode *node)
     }
 
     // String concatenation: `+` where either side is a string.
-    // Non-string operands are converted with cyps_i32_to_string / cyps_f64_to_string.
+    // Non-string operands are converted by toStringValue.
     if (node->op == BinaryExpressionNode::ADD &&
         (leftVal->getType()->isPointerTy() || rightVal->getType()->isPointerTy())) {
         llvm::Value *leftStr = toStringValue(leftVal);
@@ -1440,8 +1428,8 @@ void CodeGen::visit(AssignmentStatementNode *node)
     }
 
     // Check if the variable is const
-    auto constIt = constVariables.find(node->variableName);
-    if (constIt != constVariables.end() && constIt->second) {
+    const bool *isConst = constVariables.lookup(node->variableName);
+    if (isConst && *isConst) {
         throw std::runtime_error("Codegen Error: Cannot reassign to const variable '" + node->variableName + "'");
     }
     // Generate code for the value expression
@@ -1455,60 +1443,302 @@ void CodeGen::visit(AssignmentStatementNode *node)
     m_builder.CreateStore(value, varAlloca);
 }
 
-// Loads one element from an already-evaluated array pointer and index.
-llvm::Value *CodeGen::emitArrayLoad(llvm::Value *arrayValue, llvm::Value *indexValue,
-                                    const std::string &elemType)
+// Per ArrayLane: the runtime entry points' suffix (array_push_<suffix> ...)
+// and the TBAA type name of its elements. boolean[] is stored as bytes, so it
+// shares the u8 entry points.
+static const char *const kLaneSuffixes[] = {"", "i32", "f64", "string", "object", "i64", "u8", "f32", "u8"};
+static const char *const kLaneElementTags[] = {"", "i32 element", "f64 element", "string element",
+                                               "object element", "i64 element", "u8 element",
+                                               "f32 element", "u8 element"};
+
+// The lane an element type is stored in. Every operation on one array has to
+// agree on this, so it is decided here and nowhere else.
+CodeGen::ArrayLane CodeGen::arrayLaneFor(const std::string &elemType)
 {
-    llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
-    llvm::Type *i32Ty = llvm::Type::getInt32Ty(m_context);
-    llvm::Value *index = coerceValue(indexValue, i32Ty);
+    if (isPointerElementType(elemType)) return ObjectLane;
+    if (elemType == "string" || isGenericElementType(elemType)) return StringLane;
+    if (elemType == "f64" || elemType == "number") return F64Lane;
+    if (elemType == "i64") return I64Lane;
+    if (elemType == "u8" || elemType == "i8") return U8Lane;
+    if (elemType == "f32") return F32Lane;
+    if (elemType == "boolean") return BoolLane;
+    return I32Lane;   // i32 and enums
+}
 
-    llvm::FunctionCallee getFunc;
-    if (isPointerElementType(elemType)) {
-        getFunc = m_module->getOrInsertFunction("array_get_object", charPtr, charPtr, i32Ty);
-    } else if (elemType == "string" || isGenericElementType(elemType)) {
-        getFunc = m_module->getOrInsertFunction("array_get_string", charPtr, charPtr, i32Ty);
-    } else if (elemType == "f64") {
-        getFunc = m_module->getOrInsertFunction("array_get_f64",
-            llvm::Type::getDoubleTy(m_context), charPtr, i32Ty);
-    } else {
-        getFunc = m_module->getOrInsertFunction("array_get_i32", i32Ty, charPtr, i32Ty);
+// How an element is stored
+llvm::Type *CodeGen::arrayLaneElementType(ArrayLane lane)
+{
+    switch (lane) {
+    case F64Lane: return llvm::Type::getDoubleTy(m_context);
+    case StringLane:
+    case ObjectLane: return llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
+    case I64Lane: return llvm::Type::getInt64Ty(m_context);
+    case U8Lane:
+    case BoolLane: return llvm::Type::getInt8Ty(m_context);
+    case F32Lane: return llvm::Type::getFloatTy(m_context);
+    case I32Lane: break;
+    }
+    return llvm::Type::getInt32Ty(m_context);
+}
+
+// An element as a value. Bytes, booleans among them, are read as an i32, as
+// elements were before arrays stored them narrow; the rest are what
+// getLLVMType gives their element type.
+llvm::Type *CodeGen::arrayLaneValueType(ArrayLane lane)
+{
+    return lane == BoolLane || lane == U8Lane ? llvm::Type::getInt32Ty(m_context)
+                                              : arrayLaneElementType(lane);
+}
+
+// A byte read from a lane, as an element value: an i8 element sign-extends,
+// a u8 element or a boolean (stored as 0 or 1) zero-extends
+llvm::Value *CodeGen::fromArrayLane(ArrayLane lane, const std::string &elemType, llvm::Value *stored)
+{
+    if (lane != U8Lane && lane != BoolLane) return stored;
+    llvm::Type *valueType = arrayLaneValueType(lane);
+    return elemType == "i8" ? m_builder.CreateSExt(stored, valueType, "arr_i8")
+                            : m_builder.CreateZExt(stored, valueType, "arr_u8");
+}
+
+// An element as the runtime's entry points pass it. Bytes travel as i32, so
+// no caller depends on how the other side extends a narrow argument.
+llvm::Type *CodeGen::arrayLaneRuntimeType(ArrayLane lane)
+{
+    return lane == U8Lane || lane == BoolLane ? llvm::Type::getInt32Ty(m_context)
+                                              : arrayLaneElementType(lane);
+}
+
+// A value as the lane stores it; a boolean is normalised to 0 or 1 first
+llvm::Value *CodeGen::toArrayLane(ArrayLane lane, llvm::Value *value)
+{
+    if (lane == BoolLane) {
+        return m_builder.CreateZExt(ensureI1(value), llvm::Type::getInt8Ty(m_context), "bool_byte");
     }
-    return m_builder.CreateCall(getFunc, {arrayValue, index}, "compound_load");
+    return coerceValue(value, arrayLaneElementType(lane));
+}
+
+// TypedArray<T> as the runtime lays it out; a static_assert there pins it.
+// The element pointer is opaque, so one struct serves every element type.
+llvm::StructType *CodeGen::arrayType()
+{
+    if (!arrayStructType) {
+        llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
+        llvm::Type *i64Ty = llvm::Type::getInt64Ty(m_context);
+        arrayStructType = llvm::StructType::create(
+            m_context, {charPtr, i64Ty, i64Ty, i64Ty, llvm::Type::getInt32Ty(m_context)}, "CypsArray");
+    }
+    return arrayStructType;
+}
+
+llvm::MDNode *CodeGen::arrayAccessTag(const std::string &what)
+{
+    // Metadata nodes are uniqued, so building the same tag again returns it
+    llvm::MDBuilder md(m_context);
+    llvm::MDNode *type = md.createTBAAScalarTypeNode(what, md.createTBAARoot("cscript arrays"));
+    return md.createTBAAStructTagNode(type, type, 0);
+}
+
+// Lane header fields, by LaneField: the value names and their TBAA type names
+static const char *const kLaneFieldNames[] = {"lane_data", "lane_length", "lane_capacity", "lane_head"};
+
+llvm::Value *CodeGen::arrayFieldAddress(llvm::Value *arrayValue, LaneField field)
+{
+    return m_builder.CreateConstInBoundsGEP2_32(arrayType(), arrayValue, 0, field);
+}
+
+llvm::Value *CodeGen::loadArrayField(llvm::Value *arrayValue, LaneField field)
+{
+    llvm::LoadInst *load = m_builder.CreateLoad(arrayType()->getElementType(field),
+                                                arrayFieldAddress(arrayValue, field), kLaneFieldNames[field]);
+    load->setMetadata(llvm::LLVMContext::MD_tbaa, arrayAccessTag(kLaneFieldNames[field]));
+    return load;
+}
+
+llvm::Value *CodeGen::arrayElementAddress(llvm::Value *arrayValue, ArrayLane lane, llvm::Value *position)
+{
+    llvm::Value *data = loadArrayField(arrayValue, LaneData);
+    llvm::Value *head = loadArrayField(arrayValue, LaneHead);
+    return m_builder.CreateInBoundsGEP(arrayLaneElementType(lane), data,
+                                       m_builder.CreateAdd(head, position, "", true, true), "arr_slot");
+}
+
+// Loads one element from an already-evaluated array pointer and index. Out of
+// range, or on a null array, it is 0 / null, as it always was from the runtime.
+llvm::Value *CodeGen::emitArrayLoad(llvm::Value *arrayValue, llvm::Value *indexValue,
+                                    const std::string &elemType)
+{
+    llvm::Value *index = coerceValue(indexValue, llvm::Type::getInt32Ty(m_context));
+
+    ArrayLane lane = arrayLaneFor(elemType);
+    llvm::Type *valueType = arrayLaneElementType(lane);
+    llvm::Function *function = m_builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock *entryBlock = m_builder.GetInsertBlock();
+    llvm::BasicBlock *checkBlock = llvm::BasicBlock::Create(m_context, "arr_get_check", function);
+    llvm::BasicBlock *hitBlock = llvm::BasicBlock::Create(m_context, "arr_get_hit", function);
+    llvm::BasicBlock *doneBlock = llvm::BasicBlock::Create(m_context, "arr_get_done", function);
+
+    m_builder.CreateCondBr(m_builder.CreateIsNotNull(arrayValue, "arr_nonnull"), checkBlock, doneBlock);
+
+    // A negative index is a huge unsigned one, so one compare covers both ends
+    m_builder.SetInsertPoint(checkBlock);
+    llvm::Value *position = m_builder.CreateSExt(index, llvm::Type::getInt64Ty(m_context), "arr_index");
+    llvm::Value *length = loadArrayField(arrayValue, LaneLength);
+    llvm::Value *inBounds = m_builder.CreateICmpULT(position, length, "arr_in_bounds");
+    m_builder.CreateCondBr(inBounds, hitBlock, doneBlock);
+
+    m_builder.SetInsertPoint(hitBlock);
+    llvm::LoadInst *element = m_builder.CreateLoad(
+        valueType, arrayElementAddress(arrayValue, lane, position), "arr_element");
+    element->setMetadata(llvm::LLVMContext::MD_tbaa, arrayAccessTag(kLaneElementTags[lane]));
+    m_builder.CreateBr(doneBlock);
+
+    m_builder.SetInsertPoint(doneBlock);
+    llvm::PHINode *result = m_builder.CreatePHI(valueType, 3, "array_element");
+    llvm::Constant *missing = llvm::Constant::getNullValue(valueType);
+    result->addIncoming(missing, entryBlock);
+    result->addIncoming(missing, checkBlock);
+    result->addIncoming(element, hitBlock);
+    return fromArrayLane(lane, elemType, result);
 }
 
 // Stores one element into an already-evaluated array pointer and index. Shared
 // by plain assignment, compound assignment and `a[i]++`, all of which have to
-// pick the same runtime setter for the element type.
+// pick the same runtime setter for the element type. In range it is a store;
+// past the end the runtime grows the array, as assignment always has.
 void CodeGen::emitArrayStore(llvm::Value *arrayValue, llvm::Value *indexValue,
                              const std::string &elemType, llvm::Value *value)
 {
     llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
     llvm::Type *voidTy = llvm::Type::getVoidTy(m_context);
     llvm::Type *i32Ty = llvm::Type::getInt32Ty(m_context);
-    llvm::Type *doubleTy = llvm::Type::getDoubleTy(m_context);
 
     if (!arrayValue->getType()->isPointerTy()) {
         throw std::runtime_error("Codegen Error: Array assignment requires a pointer type");
     }
 
-    if (isPointerElementType(elemType)) {
-        llvm::FunctionCallee setFunc =
-            m_module->getOrInsertFunction("array_set_object", voidTy, charPtr, i32Ty, charPtr);
-        m_builder.CreateCall(setFunc, {arrayValue, indexValue, value});
-    } else if (elemType == "string" || isGenericElementType(elemType)) {
-        llvm::FunctionCallee setFunc =
-            m_module->getOrInsertFunction("array_set_string", voidTy, charPtr, i32Ty, charPtr);
-        m_builder.CreateCall(setFunc, {arrayValue, indexValue, value});
-    } else if (elemType == "f64") {
-        llvm::FunctionCallee setFunc =
-            m_module->getOrInsertFunction("array_set_f64", voidTy, charPtr, i32Ty, doubleTy);
-        m_builder.CreateCall(setFunc, {arrayValue, indexValue, coerceValue(value, doubleTy)});
-    } else {
-        llvm::FunctionCallee setFunc =
-            m_module->getOrInsertFunction("array_set_i32", voidTy, charPtr, i32Ty, i32Ty);
-        m_builder.CreateCall(setFunc, {arrayValue, indexValue, coerceValue(value, i32Ty)});
-    }
+    ArrayLane lane = arrayLaneFor(elemType);
+    llvm::Type *runtimeType = arrayLaneRuntimeType(lane);
+    llvm::Value *index = coerceValue(indexValue, i32Ty);
+    value = toArrayLane(lane, value);
+    llvm::FunctionCallee setFunc = m_module->getOrInsertFunction(
+        std::string("array_set_") + kLaneSuffixes[lane], voidTy, charPtr, i32Ty, runtimeType);
+
+    llvm::Function *function = m_builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock *checkBlock = llvm::BasicBlock::Create(m_context, "arr_set_check", function);
+    llvm::BasicBlock *hitBlock = llvm::BasicBlock::Create(m_context, "arr_set_hit", function);
+    llvm::BasicBlock *growBlock = llvm::BasicBlock::Create(m_context, "arr_set_grow", function);
+    llvm::BasicBlock *doneBlock = llvm::BasicBlock::Create(m_context, "arr_set_done", function);
+
+    m_builder.CreateCondBr(m_builder.CreateIsNotNull(arrayValue, "arr_nonnull"), checkBlock, growBlock);
+
+    m_builder.SetInsertPoint(checkBlock);
+    llvm::Value *position = m_builder.CreateSExt(index, llvm::Type::getInt64Ty(m_context), "arr_index");
+    llvm::Value *length = loadArrayField(arrayValue, LaneLength);
+    llvm::Value *inBounds = m_builder.CreateICmpULT(position, length, "arr_in_bounds");
+    m_builder.CreateCondBr(inBounds, hitBlock, growBlock);
+
+    m_builder.SetInsertPoint(hitBlock);
+    llvm::StoreInst *store = m_builder.CreateStore(value, arrayElementAddress(arrayValue, lane, position));
+    store->setMetadata(llvm::LLVMContext::MD_tbaa, arrayAccessTag(kLaneElementTags[lane]));
+    m_builder.CreateBr(doneBlock);
+
+    m_builder.SetInsertPoint(growBlock);
+    m_builder.CreateCall(setFunc, {arrayValue, index, coerceValue(value, runtimeType)});
+    m_builder.CreateBr(doneBlock);
+
+    m_builder.SetInsertPoint(doneBlock);
+}
+
+// Appends one element: in place while the lane has room behind its last
+// element, through the runtime when it has to grow
+void CodeGen::emitArrayPush(llvm::Value *arrayValue, const std::string &elemType, llvm::Value *value)
+{
+    llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
+    llvm::Type *voidTy = llvm::Type::getVoidTy(m_context);
+
+    ArrayLane lane = arrayLaneFor(elemType);
+    // An element type this has no name for, holding text
+    if (lane == I32Lane && value->getType()->isPointerTy()) lane = StringLane;
+    llvm::Type *runtimeType = arrayLaneRuntimeType(lane);
+    value = toArrayLane(lane, value);
+    llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction(
+        std::string("array_push_") + kLaneSuffixes[lane], voidTy, charPtr, runtimeType);
+
+    llvm::Function *function = m_builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock *checkBlock = llvm::BasicBlock::Create(m_context, "arr_push_check", function);
+    llvm::BasicBlock *hitBlock = llvm::BasicBlock::Create(m_context, "arr_push_hit", function);
+    llvm::BasicBlock *growBlock = llvm::BasicBlock::Create(m_context, "arr_push_grow", function);
+    llvm::BasicBlock *doneBlock = llvm::BasicBlock::Create(m_context, "arr_push_done", function);
+
+    m_builder.CreateCondBr(m_builder.CreateIsNotNull(arrayValue, "arr_nonnull"), checkBlock, growBlock);
+
+    m_builder.SetInsertPoint(checkBlock);
+    llvm::Value *length = loadArrayField(arrayValue, LaneLength);
+    llvm::Value *end = m_builder.CreateAdd(loadArrayField(arrayValue, LaneHead), length,
+                                           "lane_end", true, true);
+    llvm::Value *capacity = loadArrayField(arrayValue, LaneCapacity);
+    llvm::Value *hasRoom = m_builder.CreateICmpSLT(end, capacity, "lane_has_room");
+    m_builder.CreateCondBr(hasRoom, hitBlock, growBlock);
+
+    m_builder.SetInsertPoint(hitBlock);
+    llvm::StoreInst *store = m_builder.CreateStore(value, arrayElementAddress(arrayValue, lane, length));
+    store->setMetadata(llvm::LLVMContext::MD_tbaa, arrayAccessTag(kLaneElementTags[lane]));
+    llvm::StoreInst *grown = m_builder.CreateStore(
+        m_builder.CreateAdd(length, llvm::ConstantInt::get(length->getType(), 1), "", true, true),
+        arrayFieldAddress(arrayValue, LaneLength));
+    grown->setMetadata(llvm::LLVMContext::MD_tbaa, arrayAccessTag(kLaneFieldNames[LaneLength]));
+    m_builder.CreateBr(doneBlock);
+
+    m_builder.SetInsertPoint(growBlock);
+    m_builder.CreateCall(pushFunc, {arrayValue, coerceValue(value, runtimeType)});
+    m_builder.CreateBr(doneBlock);
+
+    m_builder.SetInsertPoint(doneBlock);
+}
+
+// Removes and returns the last (`pop`) or first (`shift`) element, through
+// the runtime. 0 / null on an empty array.
+llvm::Value *CodeGen::emitArrayRemoveEnd(llvm::Value *arrayValue, const std::string &elemType, bool fromFront)
+{
+    llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
+    ArrayLane lane = arrayLaneFor(elemType);
+    llvm::FunctionCallee removeFunc = m_module->getOrInsertFunction(
+        std::string(fromFront ? "array_shift_" : "array_pop_") + kLaneSuffixes[lane],
+        arrayLaneRuntimeType(lane), charPtr);
+    llvm::Value *removed = m_builder.CreateCall(removeFunc, {arrayValue}, "removed_val");
+    return fromArrayLane(lane, elemType, coerceValue(removed, arrayLaneElementType(lane)));
+}
+
+// The live length; 0 for a null array. Every kind of array keeps it at the
+// same place, so this needs no element type.
+llvm::Value *CodeGen::emitArrayLength(llvm::Value *arrayValue)
+{
+    llvm::Type *i32Ty = llvm::Type::getInt32Ty(m_context);
+    llvm::Function *function = m_builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock *entryBlock = m_builder.GetInsertBlock();
+    llvm::BasicBlock *loadBlock = llvm::BasicBlock::Create(m_context, "arr_len_load", function);
+    llvm::BasicBlock *doneBlock = llvm::BasicBlock::Create(m_context, "arr_len_done", function);
+    m_builder.CreateCondBr(m_builder.CreateIsNotNull(arrayValue, "arr_nonnull"), loadBlock, doneBlock);
+
+    m_builder.SetInsertPoint(loadBlock);
+    llvm::Value *length = m_builder.CreateTrunc(loadArrayField(arrayValue, LaneLength), i32Ty);
+    m_builder.CreateBr(doneBlock);
+
+    m_builder.SetInsertPoint(doneBlock);
+    llvm::PHINode *result = m_builder.CreatePHI(i32Ty, 2, "array_len");
+    result->addIncoming(llvm::ConstantInt::get(i32Ty, 0), entryBlock);
+    result->addIncoming(length, loadBlock);
+    return result;
+}
+
+// A new, empty array of `elemType` elements. Everything later done to it has
+// to agree on that type, which arrayLaneFor guarantees.
+llvm::Value *CodeGen::emitArrayCreate(const std::string &elemType)
+{
+    llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
+    llvm::FunctionCallee createFunc = m_module->getOrInsertFunction(
+        std::string("array_create_") + kLaneSuffixes[arrayLaneFor(elemType)], charPtr);
+    return m_builder.CreateCall(createFunc, {}, "array_ptr");
 }
 
 // Applies a binary operator to two already-generated values. Used by compound
@@ -1688,13 +1918,10 @@ void CodeGen::visit(ForOfStatementNode *node)
 
     // 2. Determine element type of the iterable
     std::string elemType = "i32"; // default
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(node->iterable.get())) {
-        auto typeIt = variableTypes.find(varExpr->name);
-        if (typeIt != variableTypes.end()) {
-            std::string varType = typeIt->second;
-            if (varType.length() > 2 && varType.substr(varType.length() - 2) == "[]") {
-                elemType = varType.substr(0, varType.length() - 2);
-            }
+    {
+        std::string iterableType = arrayTypeOfExpression(node->iterable.get());
+        if (iterableType.length() > 2 && iterableType.substr(iterableType.length() - 2) == "[]") {
+            elemType = iterableType.substr(0, iterableType.length() - 2);
         }
     }
 
@@ -1710,10 +1937,7 @@ void CodeGen::visit(ForOfStatementNode *node)
     m_builder.CreateStore(llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_context), 0), indexAlloca);
     
     // 5. Get array length
-    llvm::FunctionCallee lenFunc = m_module->getOrInsertFunction("array_length",
-        llvm::Type::getInt32Ty(m_context),
-        llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-    llvm::Value *len = m_builder.CreateCall(lenFunc, {arrPtr}, "arr_len");
+    llvm::Value *len = emitArrayLength(arrPtr);
 
     m_builder.CreateBr(condBlock);
 
@@ -1726,41 +1950,16 @@ void CodeGen::visit(ForOfStatementNode *node)
     // 7. Body block
     m_builder.SetInsertPoint(bodyBlock);
     
-    // Save current symbol table for loop scope
-    auto oldNamedValues = namedValues;
-    auto oldVariableTypes = variableTypes;
-    auto oldConstVariables = constVariables;
+    // The iterator variable lives in the loop's own scope
+    pushScope();
 
     // Load current element from dynamic array
-    llvm::Value *element;
-    if (isPointerElementType(elemType)) {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_object",
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0), llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0), llvm::Type::getInt32Ty(m_context));
-        element = m_builder.CreateCall(getFunc, {arrPtr, currentIndex}, "iter_element");
-    } else if (elemType == "f64") {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_f64",
-            llvm::Type::getDoubleTy(m_context),
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::Type::getInt32Ty(m_context));
-        element = m_builder.CreateCall(getFunc, {arrPtr, currentIndex}, "iter_element");
-    } else if (elemType == "string" || isGenericElementType(elemType)) {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_string",
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::Type::getInt32Ty(m_context));
-        element = m_builder.CreateCall(getFunc, {arrPtr, currentIndex}, "iter_element");
-    } else {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_i32",
-            llvm::Type::getInt32Ty(m_context),
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::Type::getInt32Ty(m_context));
-        element = m_builder.CreateCall(getFunc, {arrPtr, currentIndex}, "iter_element");
-    }
+    llvm::Value *element = emitArrayLoad(arrPtr, currentIndex, elemType);
 
     // Allocate memory for the iterator variable and store the loaded element
     llvm::Type *varType = getLLVMType(elemType);
     llvm::AllocaInst *varAlloca = m_builder.CreateAlloca(varType, nullptr, node->iteratorVariable->variableName);
-    m_builder.CreateStore(element, varAlloca);
+    m_builder.CreateStore(coerceValue(element, varType), varAlloca);
     
     // Register iterator variable in local scope
     namedValues[node->iteratorVariable->variableName] = varAlloca;
@@ -1776,10 +1975,7 @@ void CodeGen::visit(ForOfStatementNode *node)
     loopTargets.pop_back();
     loopTargetTryDepths.pop_back();
 
-    // Restore scope
-    namedValues = oldNamedValues;
-    variableTypes = oldVariableTypes;
-    constVariables = oldConstVariables;
+    popScope();
 
     if (!m_builder.GetInsertBlock()->getTerminator()) {
         m_builder.CreateBr(incrBlock);
@@ -1886,7 +2082,7 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
 
     // Closure call through a variable: let f = (x) => ...; f(5);
     auto arrowVarIt = variableToArrow.find(node->functionName);
-    if (arrowVarIt != variableToArrow.end() && namedValues.count(node->functionName)) {
+    if (arrowVarIt != variableToArrow.end() && namedValues.contains(node->functionName)) {
         ArrowFunctionNode *arrowNode = arrowVarIt->second;
         auto fnIt = arrowFunctions.find(arrowNode);
         if (fnIt == arrowFunctions.end()) {
@@ -1929,13 +2125,13 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
     // Closure call through a closure-typed variable/parameter, e.g.
     //   function apply(f: (i32) => i32, x: i32): i32 { return f(x); }
     // The call is indirect via the closure's stored function pointer.
-    auto varTypeIt = variableTypes.find(node->functionName);
-    if (varTypeIt != variableTypes.end() && varTypeIt->second.rfind("closure(", 0) == 0 &&
-        namedValues.count(node->functionName)) {
+    const std::string *varType = variableTypes.lookup(node->functionName);
+    if (varType && varType->rfind("closure(", 0) == 0 &&
+        namedValues.contains(node->functionName)) {
         std::vector<std::string> argTypeNames;
         std::string retTypeName;
-        if (!parseClosureSignature(varTypeIt->second, argTypeNames, retTypeName)) {
-            throw std::runtime_error("Codegen Error: Malformed function type '" + varTypeIt->second + "'");
+        if (!parseClosureSignature(*varType, argTypeNames, retTypeName)) {
+            throw std::runtime_error("Codegen Error: Malformed function type '" + *varType + "'");
         }
 
         llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
@@ -1994,7 +2190,7 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
         
         bool isObject = false;
         std::string objectKey;
-        if (auto* varExpr = dynamic_cast<VariableExpressionNode*>(node->arguments[0].get())) {
+        if (auto* varExpr = nodeCast<VariableExpressionNode>(node->arguments[0].get())) {
             auto objKeyIt = variableToObjectKey.find(varExpr->name);
             if (objKeyIt != variableToObjectKey.end()) {
                 isObject = true;
@@ -2007,7 +2203,7 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
             if (layoutIt != objectLayouts.end()) {
                 const ObjectOptimizer::ObjectLayout& layout = layoutIt->second;
                 
-                llvm::Value* storageSlot = variableStorage(dynamic_cast<VariableExpressionNode*>(node->arguments[0].get())->name);
+                llvm::Value* storageSlot = variableStorage(nodeCast<VariableExpressionNode>(node->arguments[0].get())->name);
                 if (storageSlot != nullptr) {
                     llvm::Value* objectPtrAlloca = storageSlot;
                     llvm::Value* objectPtr = m_builder.CreateLoad(
@@ -2119,7 +2315,7 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
         // CHECK FOR OBJECT
         bool isObject = false;
         std::string objectKey;
-        if (auto* varExpr = dynamic_cast<VariableExpressionNode*>(node->arguments[0].get())) {
+        if (auto* varExpr = nodeCast<VariableExpressionNode>(node->arguments[0].get())) {
             auto objKeyIt = variableToObjectKey.find(varExpr->name);
             if (objKeyIt != variableToObjectKey.end()) {
                 isObject = true;
@@ -2132,7 +2328,7 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
             if (layoutIt != objectLayouts.end()) {
                 const ObjectOptimizer::ObjectLayout& layout = layoutIt->second;
                 
-                llvm::Value* storageSlot = variableStorage(dynamic_cast<VariableExpressionNode*>(node->arguments[0].get())->name);
+                llvm::Value* storageSlot = variableStorage(nodeCast<VariableExpressionNode>(node->arguments[0].get())->name);
                 if (storageSlot != nullptr) {
                     llvm::Value* objectPtrAlloca = storageSlot;
                     llvm::Value* objectPtr = m_builder.CreateLoad(
@@ -2270,13 +2466,15 @@ llvm::Value *CodeGen::visit(FunctionCallNode *node)
         }
         else if (argType->isIntegerTy())
         {
-            // Argument is an integer (i1 booleans widened to i32)
-            if (!argType->isIntegerTy(32)) {
+            // Argument is an integer (i1 booleans widened to i32, i64 printed whole)
+            bool wide = argType->isIntegerTy(64);
+            if (!wide && !argType->isIntegerTy(32)) {
                 argValue = coerceValue(argValue, llvm::Type::getInt32Ty(m_context));
             }
             llvm::FunctionCallee printfFunc = getOrDeclarePrintf();
             // Create format string with or without newline
-            std::string formatString = addNewline ? "%d\n" : "%d";
+            std::string formatString = wide ? "%lld" : "%d";
+            if (addNewline) formatString += "\n";
             llvm::Value *formatStr = m_builder.CreateGlobalString(formatString, ".format_int");
             std::vector<llvm::Value *> printfArgs = {formatStr, argValue};
             m_builder.CreateCall(printfFunc, printfArgs, "printfCall");
@@ -2349,45 +2547,41 @@ llvm::Value *CodeGen::visit(ArrayLiteralNode *node)
     std::string elemType = node->elementType;
     
     llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
-    llvm::FunctionCallee createFunc;
-    if (isPointerElementType(elemType)) {
-        createFunc = m_module->getOrInsertFunction("array_create_object", charPtr);
-    } else if (elemType == "string" || isGenericElementType(elemType)) {
-        // Only tags the handle — the runtime dispatches on which vector is
-        // written, never on this — but leaving it saying I32 for an array the
-        // rest of the compiler treats as strings is how the load sites came to
-        // disagree in the first place.
-        createFunc = m_module->getOrInsertFunction("array_create_string", charPtr);
-    } else if (elemType == "f64") {
-        createFunc = m_module->getOrInsertFunction("array_create_f64", charPtr);
-    } else {
-        // Default to i32
-        createFunc = m_module->getOrInsertFunction("array_create_i32", charPtr);
-    }
-
-    // Create the dynamic array
-    llvm::Value* arrPtr = m_builder.CreateCall(createFunc, {}, "array_ptr");
 
-    // Initialize array elements
+    // Numbers known at compile time (a literal table, or the result of a const
+    // function) are copied out of a constant image in one call instead of
+    // being pushed one at a time
+    ArrayLane lane = arrayLaneFor(elemType);
+    if (lane != StringLane && lane != ObjectLane) {
+        // The image is laid out as the lane stores it; a boolean one only when
+        // every element already is the 0 or 1 a store would make of it
+        std::string imageType = kLaneSuffixes[lane];
+        if (lane == BoolLane) {
+            for (const auto &element : node->elements) {
+                auto *intLit = nodeCast<IntegerLiteralNode>(element.get());
+                if (!nodeCast<BooleanLiteralNode>(element.get()) &&
+                    !(intLit && (intLit->value == 0 || intLit->value == 1))) {
+                    imageType.clear();
+                    break;
+                }
+            }
+        }
+        llvm::GlobalVariable *image = imageType.empty() ? nullptr : constantImage(imageType, node->elements);
+        if (image) {
+            llvm::Type *i32Ty = llvm::Type::getInt32Ty(m_context);
+            llvm::FunctionCallee fromFunc = m_module->getOrInsertFunction(
+                std::string("array_from_") + kLaneSuffixes[lane], charPtr, charPtr, i32Ty);
+            return m_builder.CreateCall(
+                fromFunc, {image, llvm::ConstantInt::get(i32Ty, node->elements.size())}, "array_ptr");
+        }
+    }
+    llvm::Value *arrPtr = emitArrayCreate(elemType);
     for (size_t i = 0; i < node->elements.size(); ++i) {
         llvm::Value *elementValue = visit(node->elements[i].get());
         if (!elementValue) {
             throw std::runtime_error("Codegen Error: Failed to generate array element " + std::to_string(i));
         }
-
-        if (elemType == "f64") {
-            llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_f64",
-                llvm::Type::getVoidTy(m_context), charPtr, llvm::Type::getDoubleTy(m_context));
-            m_builder.CreateCall(pushFunc, {arrPtr, coerceValue(elementValue, llvm::Type::getDoubleTy(m_context))});
-        } else if (elemType == "string" || elementValue->getType()->isPointerTy()) {
-            llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_string",
-                llvm::Type::getVoidTy(m_context), charPtr, charPtr);
-            m_builder.CreateCall(pushFunc, {arrPtr, elementValue});
-        } else {
-            llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_i32",
-                llvm::Type::getVoidTy(m_context), charPtr, llvm::Type::getInt32Ty(m_context));
-            m_builder.CreateCall(pushFunc, {arrPtr, coerceValue(elementValue, llvm::Type::getInt32Ty(m_context))});
-        }
+        emitArrayPush(arrPtr, elemType, elementValue);
     }
 
     return arrPtr;
@@ -2433,30 +2627,7 @@ llvm::Value *CodeGen::visit(ArrayAccessNode *node)
         }
     }
 
-    // Call the appropriate C++ dynamic array function
-    if (isPointerElementType(elemType)) {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_object",
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0), llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0), llvm::Type::getInt32Ty(m_context));
-        return m_builder.CreateCall(getFunc, {arrayValue, indexValue}, "array_element");
-    } else if (elemType == "string" || isGenericElementType(elemType)) {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_string",
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::Type::getInt32Ty(m_context));
-        return m_builder.CreateCall(getFunc, {arrayValue, indexValue}, "array_element");
-    } else if (elemType == "f64") {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_f64",
-            llvm::Type::getDoubleTy(m_context),
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::Type::getInt32Ty(m_context));
-        return m_builder.CreateCall(getFunc, {arrayValue, indexValue}, "array_element");
-    } else {
-        llvm::FunctionCallee getFunc = m_module->getOrInsertFunction("array_get_i32",
-            llvm::Type::getInt32Ty(m_context),
-            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-            llvm::Type::getInt32Ty(m_context));
-        return m_builder.CreateCall(getFunc, {arrayValue, indexValue}, "array_element");
-    }
+    return emitArrayLoad(arrayValue, indexValue, elemType);
 }
 
 // Object literal implementation - basic version
@@ -2517,7 +2688,7 @@ llvm::Value *CodeGen::createObjectWithProperties(ObjectLiteralNode *node)
         llvm::Value* propValue = visit(prop.value.get());
         
         if (propValue) {
-            if (auto* strLit = dynamic_cast<StringLiteralNode*>(prop.value.get())) {
+            if (auto* strLit = nodeCast<StringLiteralNode>(prop.value.get())) {
                 // Handle string properties
                 llvm::Constant* strConstant = llvm::ConstantDataArray::getString(m_context, strLit->value, true);
                 llvm::GlobalVariable* globalStr = new llvm::GlobalVariable(
@@ -2531,7 +2702,7 @@ llvm::Value *CodeGen::createObjectWithProperties(ObjectLiteralNode *node)
                 properties[prop.key] = globalStr;
                 propertyTypes[prop.key] = "string";
             }
-            else if (auto* intLit = dynamic_cast<IntegerLiteralNode*>(prop.value.get())) {
+            else if (auto* intLit = nodeCast<IntegerLiteralNode>(prop.value.get())) {
                 // Handle integer properties
                 llvm::Constant* intConstant = llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_context), intLit->value);
                 llvm::GlobalVariable* globalInt = new llvm::GlobalVariable(
@@ -2545,7 +2716,7 @@ llvm::Value *CodeGen::createObjectWithProperties(ObjectLiteralNode *node)
                 properties[prop.key] = globalInt;
                 propertyTypes[prop.key] = "i32";
             }
-            else if (auto* boolLit = dynamic_cast<BooleanLiteralNode*>(prop.value.get())) {
+            else if (auto* boolLit = nodeCast<BooleanLiteralNode>(prop.value.get())) {
                 // Handle boolean properties
                 llvm::Constant* boolConstant = llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_context), boolLit->value ? 1 : 0);
                 llvm::GlobalVariable* globalBool = new llvm::GlobalVariable(
@@ -2575,11 +2746,11 @@ bool CodeGen::isObjectTypeName(const std::string &typeName) {
 
 std::string CodeGen::arrayTypeOfExpression(ExpressionNode *expr) {
     if (!expr) return "";
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
-        auto typeIt = variableTypes.find(varExpr->name);
-        return typeIt != variableTypes.end() ? typeIt->second : "";
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
+        const std::string *type = variableTypes.lookup(varExpr->name);
+        return type ? *type : "";
     }
-    if (auto *arrAccess = dynamic_cast<ArrayAccessNode*>(expr)) {
+    if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr)) {
         // The element type of the outer array is this expression's own type
         std::string outer = arrayTypeOfExpression(arrAccess->array.get());
         if (outer.size() > 2 && outer.compare(outer.size() - 2, 2, "[]") == 0) {
@@ -2587,11 +2758,15 @@ std::string CodeGen::arrayTypeOfExpression(ExpressionNode *expr) {
         }
         return "";
     }
-    if (auto *call = dynamic_cast<FunctionCallNode*>(expr)) {
-        auto retIt = functionReturnTypes.find(call->functionName);
-        return retIt != functionReturnTypes.end() ? retIt->second : "";
-    }
-    return "";
+    // Calls, fields, method results: whatever semantic analysis resolved
+    return resolvedTypeOf(expr);
+}
+
+std::string CodeGen::resolvedTypeOf(const ExpressionNode *expr) {
+    if (!expr) return "";
+    llvm::StringRef type = expr->resolvedType;
+    if (type.empty() || type == "null" || type == "void" || type == "auto") return "";
+    return type.str();
 }
 
 bool CodeGen::isUnionType(const std::string &typeName) {
@@ -2633,6 +2808,45 @@ llvm::Value *CodeGen::bufferElementAddress(llvm::Value *bufferPtr, llvm::Value *
     return m_builder.CreateGEP(valueType, data, offset, "buf_elem");
 }
 
+llvm::GlobalVariable *CodeGen::constantImage(const std::string &elemType,
+                                             const std::vector<std::unique_ptr<ExpressionNode>> &elements)
+{
+    if (elements.empty()) return nullptr;
+    llvm::Type *valueType = getLLVMType(elemType);
+    if (!valueType->isIntegerTy() && !valueType->isFloatingPointTy()) return nullptr;
+
+    std::vector<llvm::Constant *> values;
+    values.reserve(elements.size());
+    for (const auto &element : elements) {
+        if (auto *intLit = nodeCast<IntegerLiteralNode>(element.get())) {
+            if (valueType->isIntegerTy()) {
+                values.push_back(llvm::ConstantInt::get(valueType, intLit->value, true));
+            } else if (intLit->value == static_cast<int32_t>(intLit->value)) {
+                // Literals are i32 values, so only one that is exactly an i32
+                // converts the same way
+                values.push_back(llvm::ConstantFP::get(valueType, static_cast<double>(intLit->value)));
+            } else {
+                return nullptr;
+            }
+        } else if (auto *floatLit = nodeCast<FloatLiteralNode>(element.get())) {
+            if (!valueType->isFloatingPointTy()) return nullptr;
+            values.push_back(llvm::ConstantFP::get(valueType, floatLit->value));
+        } else if (auto *boolLit = nodeCast<BooleanLiteralNode>(element.get())) {
+            if (!valueType->isIntegerTy()) return nullptr;
+            values.push_back(llvm::ConstantInt::get(valueType, boolLit->value ? 1 : 0));
+        } else {
+            return nullptr;
+        }
+    }
+
+    auto *imageType = llvm::ArrayType::get(valueType, values.size());
+    auto *image = new llvm::GlobalVariable(*m_module, imageType, /*isConstant=*/true,
+                                           llvm::GlobalValue::PrivateLinkage,
+                                           llvm::ConstantArray::get(imageType, values), "const_image");
+    image->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    return image;
+}
+
 bool CodeGen::isPointerElementType(const std::string &elemType) {
     if (isObjectTypeName(elemType)) return true;
     if (elemType == "ptr") return true;
@@ -2655,29 +2869,28 @@ bool CodeGen::isGenericElementType(const std::string &elemType) {
 // strcmp would read them as strings.
 bool CodeGen::isNonStringPointer(ExpressionNode *expr) {
     if (!expr) return false;
-    if (dynamic_cast<NullLiteralNode*>(expr)) return true;
-    if (dynamic_cast<NewExpressionNode*>(expr)) return true;
+    if (nodeCast<NullLiteralNode>(expr)) return true;
+    if (nodeCast<NewExpressionNode>(expr)) return true;
 
     auto isHandleType = [&](const std::string &t) {
         return t == "ptr" || t == "object" || isObjectTypeName(t);
     };
 
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
-        auto typeIt = variableTypes.find(varExpr->name);
-        if (typeIt != variableTypes.end() && isHandleType(typeIt->second)) return true;
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
+        const std::string *type = variableTypes.lookup(varExpr->name);
+        if (type && isHandleType(*type)) return true;
         return variableToObjectKey.count(varExpr->name) > 0;
     }
-    if (auto *call = dynamic_cast<FunctionCallNode*>(expr)) {
+    if (auto *call = nodeCast<FunctionCallNode>(expr)) {
         auto externIt = externFunctions.find(call->functionName);
         if (externIt != externFunctions.end()) return isHandleType(externIt->second->returnType);
         auto retIt = functionReturnTypes.find(call->functionName);
         if (retIt != functionReturnTypes.end()) return isHandleType(retIt->second);
     }
-    if (auto *arrAccess = dynamic_cast<ArrayAccessNode*>(expr)) {
-        if (auto *arrVar = dynamic_cast<VariableExpressionNode*>(arrAccess->array.get())) {
-            auto typeIt = variableTypes.find(arrVar->name);
-            if (typeIt != variableTypes.end()) {
-                const std::string &arrType = typeIt->second;
+    if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr)) {
+        if (auto *arrVar = nodeCast<VariableExpressionNode>(arrAccess->array.get())) {
+            if (const std::string *knownType = variableTypes.lookup(arrVar->name)) {
+                const std::string &arrType = *knownType;
                 if (arrType.size() > 2 && arrType.substr(arrType.size() - 2) == "[]") {
                     return isHandleType(arrType.substr(0, arrType.size() - 2));
                 }
@@ -2709,7 +2922,7 @@ std::string CodeGen::objectKeyForTypeName(const std::string &typeName) {
 }
 
 std::string CodeGen::getExpressionObjectKey(ExpressionNode* expr) {
-    if (auto* varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
+    if (auto* varExpr = nodeCast<VariableExpressionNode>(expr)) {
         if (varExpr->name == "this" && !currentThisObjectKey.empty()) {
             return currentThisObjectKey;
         }
@@ -2718,25 +2931,24 @@ std::string CodeGen::getExpressionObjectKey(ExpressionNode* expr) {
         // Fall back to the variable's recorded type: a class-typed value knows
         // its layout even when it was never bound to an object literal here
         // (a parameter, or a value returned from another function).
-        auto typeIt = variableTypes.find(varExpr->name);
-        if (typeIt != variableTypes.end()) {
-            std::string key = objectKeyForTypeName(typeIt->second);
+        if (const std::string *knownType = variableTypes.lookup(varExpr->name)) {
+            std::string key = objectKeyForTypeName(*knownType);
             if (!key.empty()) return key;
         }
-    } else if (auto* newExpr = dynamic_cast<NewExpressionNode*>(expr)) {
+    } else if (auto* newExpr = nodeCast<NewExpressionNode>(expr)) {
         return objectKeyForTypeName(newExpr->className);
-    } else if (auto* call = dynamic_cast<FunctionCallNode*>(expr)) {
+    } else if (auto* call = nodeCast<FunctionCallNode>(expr)) {
         // A function declared to return a class hands back that layout
         auto retIt = functionReturnTypes.find(call->functionName);
         if (retIt != functionReturnTypes.end()) return objectKeyForTypeName(retIt->second);
-    } else if (auto* arrAccess = dynamic_cast<ArrayAccessNode*>(expr)) {
+    } else if (auto* arrAccess = nodeCast<ArrayAccessNode>(expr)) {
         // Element of an object array: rocks[i].x, and cells[0][0].v through a
         // nested one — the array's static type is resolved through the chain
         std::string arrType = arrayTypeOfExpression(arrAccess->array.get());
         if (arrType.size() > 2 && arrType.compare(arrType.size() - 2, 2, "[]") == 0) {
             return objectKeyForTypeName(arrType.substr(0, arrType.size() - 2));
         }
-    } else if (auto* objAccess = dynamic_cast<ObjectAccessNode*>(expr)) {
+    } else if (auto* objAccess = nodeCast<ObjectAccessNode>(expr)) {
         std::string parentKey = getExpressionObjectKey(objAccess->object.get());
         if (!parentKey.empty()) {
             auto layoutIt = objectLayouts.find(parentKey);
@@ -2978,10 +3190,10 @@ void CodeGen::registerClassLayout(ClassDeclarationNode *cls)
         if (propertyType == "number") propertyType = "f64";
         if (propertyType.empty() || (propertyType != "string" && propertyType != "i32" &&
                                      propertyType != "f64" && propertyType != "boolean")) {
-            if (dynamic_cast<StringLiteralNode*>(prop.value.get())) propertyType = "string";
-            else if (dynamic_cast<FloatLiteralNode*>(prop.value.get())) propertyType = "f64";
-            else if (dynamic_cast<BooleanLiteralNode*>(prop.value.get())) propertyType = "boolean";
-            else if (dynamic_cast<IntegerLiteralNode*>(prop.value.get())) propertyType = "i32";
+            if (nodeCast<StringLiteralNode>(prop.value.get())) propertyType = "string";
+            else if (nodeCast<FloatLiteralNode>(prop.value.get())) propertyType = "f64";
+            else if (nodeCast<BooleanLiteralNode>(prop.value.get())) propertyType = "boolean";
+            else if (nodeCast<IntegerLiteralNode>(prop.value.get())) propertyType = "i32";
             else if (!prop.declaredType.empty()) {
                 // Class-, interface- or array-typed field: an opaque pointer,
                 // which the layout represents the same way it does a string
@@ -3045,7 +3257,7 @@ llvm::Value *CodeGen::createOptimizedObjectWithProperties(ObjectLiteralNode *nod
         }
 
         // Determine property type and generate value
-        if (auto* strLit = dynamic_cast<StringLiteralNode*>(prop.value.get())) {
+        if (auto* strLit = nodeCast<StringLiteralNode>(prop.value.get())) {
             propertyType = "string";
             // Create string constant
             llvm::Constant* strConstant = llvm::ConstantDataArray::getString(m_context, strLit->value, true);
@@ -3059,19 +3271,19 @@ llvm::Value *CodeGen::createOptimizedObjectWithProperties(ObjectLiteralNode *nod
             );
             propValue = m_builder.CreateBitCast(globalStr, llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
         }
-        else if (auto* intLit = dynamic_cast<IntegerLiteralNode*>(prop.value.get())) {
+        else if (auto* intLit = nodeCast<IntegerLiteralNode>(prop.value.get())) {
             propertyType = "i32";
             propValue = llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_context), intLit->value);
         }
-        else if (auto* boolLit = dynamic_cast<BooleanLiteralNode*>(prop.value.get())) {
+        else if (auto* boolLit = nodeCast<BooleanLiteralNode>(prop.value.get())) {
             propertyType = "boolean";
             propValue = llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_context), boolLit->value ? 1 : 0);
         }
-        else if (auto* floatLit = dynamic_cast<FloatLiteralNode*>(prop.value.get())) {
+        else if (auto* floatLit = nodeCast<FloatLiteralNode>(prop.value.get())) {
             propertyType = "f64";
             propValue = llvm::ConstantFP::get(llvm::Type::getDoubleTy(m_context), floatLit->value);
         }
-        else if (auto* objLit = dynamic_cast<ObjectLiteralNode*>(prop.value.get())) {
+        else if (auto* objLit = nodeCast<ObjectLiteralNode>(prop.value.get())) {
             propValue = visit(objLit);
             std::string childKey = "opt_obj_" + std::to_string(reinterpret_cast<uintptr_t>(objLit));
             propertyType = "object:" + childKey;
@@ -3142,11 +3354,10 @@ llvm::Value *CodeGen::visit(ObjectAccessNode *node)
             return coerceValue(length, llvm::Type::getInt32Ty(m_context));
         }
         // Check if the base is a variable that refers to an array
-        if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(node->object.get())) {
+        if (auto *varExpr = nodeCast<VariableExpressionNode>(node->object.get())) {
             // Look up the variable type
-            auto typeIt = variableTypes.find(varExpr->name);
-            if (typeIt != variableTypes.end()) {
-                std::string varType = typeIt->second;
+            if (const std::string *knownType = variableTypes.lookup(varExpr->name)) {
+                std::string varType = *knownType;
                 // Check if it's an array type
                 if (varType.length() > 2 && varType.substr(varType.length() - 2) == "[]") {
                     llvm::Value* storageSlot = variableStorage(varExpr->name);
@@ -3158,10 +3369,7 @@ llvm::Value *CodeGen::visit(ObjectAccessNode *node)
                             "arr_ptr_load"
                         );
                         
-                        llvm::FunctionCallee lenFunc = m_module->getOrInsertFunction("array_length",
-                            llvm::Type::getInt32Ty(m_context),
-                            llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                        return m_builder.CreateCall(lenFunc, {arrPtr}, "array_len");
+                        return emitArrayLength(arrPtr);
                     } else {
                         throw std::runtime_error("Codegen Error: Array size not found for variable '" + varExpr->name + "'");
                     }
@@ -3173,13 +3381,10 @@ llvm::Value *CodeGen::visit(ObjectAccessNode *node)
             }
         } else {
             // .length on a non-variable expression (e.g. arr.filter(f).length):
-            // evaluate it and call array_length on the resulting pointer
+            // evaluate it and read the length off the resulting array
             llvm::Value *value = visit(node->object.get());
             if (value && value->getType()->isPointerTy()) {
-                llvm::FunctionCallee lenFunc = m_module->getOrInsertFunction("array_length",
-                    llvm::Type::getInt32Ty(m_context),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(lenFunc, {value}, "array_len");
+                return emitArrayLength(value);
             }
             throw std::runtime_error("Codegen Error: .length is only supported on arrays");
         }
@@ -3196,7 +3401,7 @@ llvm::Value *CodeGen::visit(ObjectAccessNode *node)
             
             llvm::Value* objectPtr = nullptr;
             
-            if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(node->object.get())) {
+            if (auto *varExpr = nodeCast<VariableExpressionNode>(node->object.get())) {
                 llvm::Value* storageSlot = variableStorage(varExpr->name);
                 if (storageSlot != nullptr) {
                     llvm::Value* objectPtrAlloca = storageSlot;
@@ -3236,7 +3441,7 @@ llvm::Value *CodeGen::visit(ObjectAccessNode *node)
     }
     
     // FALLBACK: Legacy object property access (for compatibility)
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(node->object.get())) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(node->object.get())) {
         auto objectKeyIt = variableToObjectKey.find(varExpr->name);
         
         if (objectKeyIt != variableToObjectKey.end()) {
@@ -3281,9 +3486,8 @@ llvm::Value *CodeGen::visit(ObjectAccessNode *node)
             }
         } else {
             // Check if it's a regular variable (not an object)
-            auto typeIt = variableTypes.find(varExpr->name);
-            if (typeIt != variableTypes.end()) {
-                std::string varType = typeIt->second;
+            if (const std::string *knownType = variableTypes.lookup(varExpr->name)) {
+                std::string varType = *knownType;
                 
                 if (varType == "json") {
                     llvm::Value* storageSlot = variableStorage(varExpr->name);
@@ -3323,10 +3527,9 @@ llvm::Value *CodeGen::visit(MethodCallNode *node)
     llvm::Value *objectValue = nullptr;
     std::string varType = "";
 
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(node->object.get())) {
-        auto typeIt = variableTypes.find(varExpr->name);
-        if (typeIt != variableTypes.end()) {
-            varType = typeIt->second;
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(node->object.get())) {
+        if (const std::string *knownType = variableTypes.lookup(varExpr->name)) {
+            varType = *knownType;
         }
         llvm::Value* storageSlot = variableStorage(varExpr->name);
         if (storageSlot != nullptr) {
@@ -3337,7 +3540,7 @@ llvm::Value *CodeGen::visit(MethodCallNode *node)
                 "obj_ptr_load"
             );
         }
-    } else if (dynamic_cast<SuperExpressionNode*>(node->object.get())) {
+    } else if (nodeCast<SuperExpressionNode>(node->object.get())) {
         // `super.m(...)` / `super(...)`: call the parent's implementation directly.
         // Dispatching this virtually would re-enter the override that is asking
         // for it, so this is deliberately never a vtable call.
@@ -3401,6 +3604,8 @@ llvm::Value *CodeGen::visit(MethodCallNode *node)
         return m_builder.CreateCall(parentFn, superArgs, "super_call");
     } else {
         objectValue = visit(node->object.get());
+        // `this.items.push(x)`, `grid[0].pop()`: the receiver's static type
+        varType = arrayTypeOfExpression(node->object.get());
     }
 
     if (!objectValue) {
@@ -3494,31 +3699,8 @@ llvm::Value *CodeGen::visit(MethodCallNode *node)
         if (node->methodName == "push") {
             if (node->arguments.size() != 1) throw std::runtime_error("push() expects 1 argument");
             llvm::Value *argValue = visit(node->arguments[0].get());
-
-            if (isPointerElementType(elemType)) {
-                llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_object",
-                    llvm::Type::getVoidTy(m_context), llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0), llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(pushFunc, {objectValue, argValue});
-            } else if (elemType == "f64") {
-                llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_f64",
-                    llvm::Type::getVoidTy(m_context),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-                    llvm::Type::getDoubleTy(m_context));
-                return m_builder.CreateCall(pushFunc,
-                    {objectValue, coerceValue(argValue, llvm::Type::getDoubleTy(m_context))});
-            } else if (elemType == "string" || argValue->getType()->isPointerTy()) {
-                llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_string",
-                    llvm::Type::getVoidTy(m_context),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(pushFunc, {objectValue, argValue});
-            } else {
-                llvm::FunctionCallee pushFunc = m_module->getOrInsertFunction("array_push_i32",
-                    llvm::Type::getVoidTy(m_context),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-                    llvm::Type::getInt32Ty(m_context));
-                return m_builder.CreateCall(pushFunc, {objectValue, argValue});
-            }
+            emitArrayPush(objectValue, elemType, argValue);
+            return nullptr;
         } else if (node->methodName == "clear") {
             if (node->arguments.size() != 0) throw std::runtime_error("clear() expects 0 arguments");
             llvm::FunctionCallee clearFunc = m_module->getOrInsertFunction("array_clear",
@@ -3535,31 +3717,26 @@ llvm::Value *CodeGen::visit(MethodCallNode *node)
                 llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
                 llvm::Type::getInt32Ty(m_context));
             return m_builder.CreateCall(removeFunc, {objectValue, indexValue});
+        } else if (node->methodName == "reserve") {
+            // Room for that many elements up front, so filling it never reallocates
+            if (node->arguments.size() != 1) throw std::runtime_error("reserve() expects 1 argument");
+            llvm::Value *countValue = coerceValue(visit(node->arguments[0].get()),
+                                                  llvm::Type::getInt32Ty(m_context));
+            llvm::FunctionCallee reserveFunc = m_module->getOrInsertFunction("array_reserve",
+                llvm::Type::getVoidTy(m_context),
+                llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
+                llvm::Type::getInt32Ty(m_context));
+            return m_builder.CreateCall(reserveFunc, {objectValue, countValue});
+        } else if (node->methodName == "shrinkToFit") {
+            if (node->arguments.size() != 0) throw std::runtime_error("shrinkToFit() expects 0 arguments");
+            llvm::FunctionCallee shrinkFunc = m_module->getOrInsertFunction("array_shrink_to_fit",
+                llvm::Type::getVoidTy(m_context),
+                llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
+            return m_builder.CreateCall(shrinkFunc, {objectValue});
         } else if (node->methodName == "shift" || node->methodName == "pop") {
             if (node->arguments.size() != 0) throw std::runtime_error("shift/pop expects 0 arguments");
 
-            std::string runtimeName = (node->methodName == "pop") ? "array_pop" : "array_shift";
-            if (isPointerElementType(elemType)) {
-                llvm::FunctionCallee popFunc = m_module->getOrInsertFunction(runtimeName + "_object",
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(popFunc, {objectValue}, "removed_val");
-            } else if (elemType == "f64") {
-                llvm::FunctionCallee popFunc = m_module->getOrInsertFunction(runtimeName + "_f64",
-                    llvm::Type::getDoubleTy(m_context),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(popFunc, {objectValue}, "removed_val");
-            } else if (elemType == "string" || isGenericElementType(elemType)) {
-                llvm::FunctionCallee popFunc = m_module->getOrInsertFunction(runtimeName + "_string",
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(popFunc, {objectValue}, "removed_val");
-            } else {
-                llvm::FunctionCallee popFunc = m_module->getOrInsertFunction(runtimeName + "_i32",
-                    llvm::Type::getInt32Ty(m_context),
-                    llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0));
-                return m_builder.CreateCall(popFunc, {objectValue}, "removed_val");
-            }
+            return emitArrayRemoveEnd(objectValue, elemType, node->methodName == "shift");
         }
     }
     
@@ -3708,9 +3885,44 @@ llvm::Value *CodeGen::visit(NewExpressionNode *node)
             callocFn, {llvm::ConstantInt::get(i64Ty, 1), bytes}, "buffer");
 
         m_builder.CreateStore(count, raw);   // length lives in the header
+
+        // Contents computed at compile time (a const function's result)
+        if (!node->contents.empty()) {
+            llvm::Value *data = m_builder.CreateGEP(
+                i8Ty, raw, llvm::ConstantInt::get(i64Ty, 16), "buf_data");
+            if (llvm::GlobalVariable *image = constantImage(elemType, node->contents)) {
+                m_builder.CreateMemCpy(data, llvm::MaybeAlign(16), image, llvm::MaybeAlign(),
+                                       elemSize * node->contents.size());
+            } else {
+                llvm::Type *valueType = getLLVMType(elemType);
+                for (size_t i = 0; i < node->contents.size(); ++i) {
+                    llvm::Value *slot = m_builder.CreateGEP(
+                        valueType, data, llvm::ConstantInt::get(i64Ty, i), "buf_elem");
+                    m_builder.CreateStore(coerceValue(visit(node->contents[i].get()), valueType), slot);
+                }
+            }
+        }
         return raw;
     }
 
+    // Array<T>(n): a T[] already n elements long, all 0 / null, in one allocation
+    if (node->className == "Array") {
+        if (node->genericTypes.size() != 1) {
+            throw std::runtime_error("Codegen Error: 'new Array' needs an element type, as in new Array<i32>(n)");
+        }
+        if (node->arguments.size() > 1) throw std::runtime_error("new Array<T>() expects 0 or 1 arguments");
+        llvm::Value *arrPtr = emitArrayCreate(node->genericTypes[0]);
+        if (!node->arguments.empty()) {
+            llvm::Value *count = coerceValue(visit(node->arguments[0].get()), llvm::Type::getInt32Ty(m_context));
+            llvm::FunctionCallee resizeFunc = m_module->getOrInsertFunction("array_resize",
+                llvm::Type::getVoidTy(m_context),
+                llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0),
+                llvm::Type::getInt32Ty(m_context));
+            m_builder.CreateCall(resizeFunc, {arrPtr, count});
+        }
+        return arrPtr;
+    }
+
     if (node->className == "Set") {
         std::string elemType = !node->genericTypes.empty() ? node->genericTypes[0] : "string";
         
@@ -4133,13 +4345,9 @@ void CodeGen::visit(FunctionDeclarationNode *node)
     llvm::Function* prevFunction = currentFunction;
     currentFunction = function;
     
-    // Save current symbol table (for nested scopes later)
-    auto prevNamedValues = namedValues;
-    auto prevVariableTypes = variableTypes;
-
     // A function body sees its parameters and module-level globals, never the
     // caller's locals — those allocas belong to a different LLVM function.
-    namedValues.clear();
+    pushScope(/*isolateLocals=*/true);
 
     // Create allocas for parameters
     auto argIt = function->arg_begin();
@@ -4180,8 +4388,7 @@ void CodeGen::visit(FunctionDeclarationNode *node)
     
     // Restore previous context
     currentFunction = prevFunction;
-    namedValues = prevNamedValues;
-    variableTypes = prevVariableTypes;
+    popScope();
 }
 
 // Return Statement Visitor
@@ -4296,19 +4503,19 @@ void CodeGen::checkInterfaceConformance(const std::string& interfaceName, Object
         }
         bool ok = true;
         if (member.type == "string") {
-            if (dynamic_cast<IntegerLiteralNode*>(value) || dynamic_cast<BooleanLiteralNode*>(value) ||
-                dynamic_cast<FloatLiteralNode*>(value) || dynamic_cast<ObjectLiteralNode*>(value)) ok = false;
+            if (nodeCast<IntegerLiteralNode>(value) || nodeCast<BooleanLiteralNode>(value) ||
+                nodeCast<FloatLiteralNode>(value) || nodeCast<ObjectLiteralNode>(value)) ok = false;
         } else if (member.type == "i32" || member.type == "number") {
-            if (dynamic_cast<StringLiteralNode*>(value) || dynamic_cast<BooleanLiteralNode*>(value) ||
-                dynamic_cast<ObjectLiteralNode*>(value)) ok = false;
+            if (nodeCast<StringLiteralNode>(value) || nodeCast<BooleanLiteralNode>(value) ||
+                nodeCast<ObjectLiteralNode>(value)) ok = false;
         } else if (member.type == "boolean") {
-            if (dynamic_cast<StringLiteralNode*>(value) || dynamic_cast<ObjectLiteralNode*>(value) ||
-                dynamic_cast<FloatLiteralNode*>(value)) ok = false;
+            if (nodeCast<StringLiteralNode>(value) || nodeCast<ObjectLiteralNode>(value) ||
+                nodeCast<FloatLiteralNode>(value)) ok = false;
         } else if (member.type == "f64") {
-            if (dynamic_cast<StringLiteralNode*>(value) || dynamic_cast<BooleanLiteralNode*>(value) ||
-                dynamic_cast<ObjectLiteralNode*>(value)) ok = false;
+            if (nodeCast<StringLiteralNode>(value) || nodeCast<BooleanLiteralNode>(value) ||
+                nodeCast<ObjectLiteralNode>(value)) ok = false;
         } else if (interfaces.count(member.type)) {
-            if (auto* nested = dynamic_cast<ObjectLiteralNode*>(value)) {
+            if (auto* nested = nodeCast<ObjectLiteralNode>(value)) {
                 checkInterfaceConformance(member.type, nested, variableName + "." + member.name);
             } else {
                 ok = false;
@@ -4348,9 +4555,7 @@ llvm::Function *CodeGen::getOrCreateMethodFunction(const std::string& objectKey,
     // Save the entire generation context: methods are generated lazily at first call site
     llvm::IRBuilderBase::InsertPoint savedIP = m_builder.saveIP();
     llvm::Function *prevFunction = currentFunction;
-    auto prevNamedValues = namedValues;
-    auto prevVariableTypes = variableTypes;
-    auto prevConstVariables = constVariables;
+    pushScope();
     auto prevVariableToObjectKey = variableToObjectKey;
     std::string prevThisKey = currentThisObjectKey;
 
@@ -4399,9 +4604,7 @@ llvm::Function *CodeGen::getOrCreateMethodFunction(const std::string& objectKey,
 
     // Restore the caller's context
     currentFunction = prevFunction;
-    namedValues = prevNamedValues;
-    variableTypes = prevVariableTypes;
-    constVariables = prevConstVariables;
+    popScope();
     variableToObjectKey = prevVariableToObjectKey;
     currentThisObjectKey = prevThisKey;
     tryDepth = prevTryDepth;
@@ -4428,38 +4631,38 @@ void CodeGen::collectFreeVarsExpr(ExpressionNode *expr, std::set<std::string> &b
 {
     if (!expr) return;
 
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
         if (!bound.count(varExpr->name)) free.insert(varExpr->name);
-    } else if (auto *binOp = dynamic_cast<BinaryExpressionNode*>(expr)) {
+    } else if (auto *binOp = nodeCast<BinaryExpressionNode>(expr)) {
         collectFreeVarsExpr(binOp->left.get(), bound, free);
         collectFreeVarsExpr(binOp->right.get(), bound, free);
-    } else if (auto *unaryOp = dynamic_cast<UnaryExpressionNode*>(expr)) {
+    } else if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr)) {
         collectFreeVarsExpr(unaryOp->operand.get(), bound, free);
-    } else if (auto *update = dynamic_cast<UpdateExpressionNode*>(expr)) {
+    } else if (auto *update = nodeCast<UpdateExpressionNode>(expr)) {
         collectFreeVarsExpr(update->target.get(), bound, free);
-    } else if (auto *call = dynamic_cast<FunctionCallNode*>(expr)) {
+    } else if (auto *call = nodeCast<FunctionCallNode>(expr)) {
         // A call target that is not a declared function may be a captured closure
         if (!declaredFunctions.count(call->functionName) && !bound.count(call->functionName)) {
             free.insert(call->functionName);
         }
         for (auto &arg : call->arguments) collectFreeVarsExpr(arg.get(), bound, free);
-    } else if (auto *method = dynamic_cast<MethodCallNode*>(expr)) {
+    } else if (auto *method = nodeCast<MethodCallNode>(expr)) {
         collectFreeVarsExpr(method->object.get(), bound, free);
         for (auto &arg : method->arguments) collectFreeVarsExpr(arg.get(), bound, free);
-    } else if (auto *arrAccess = dynamic_cast<ArrayAccessNode*>(expr)) {
+    } else if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr)) {
         collectFreeVarsExpr(arrAccess->array.get(), bound, free);
         collectFreeVarsExpr(arrAccess->index.get(), bound, free);
-    } else if (auto *objAccess = dynamic_cast<ObjectAccessNode*>(expr)) {
+    } else if (auto *objAccess = nodeCast<ObjectAccessNode>(expr)) {
         collectFreeVarsExpr(objAccess->object.get(), bound, free);
-    } else if (auto *arrLit = dynamic_cast<ArrayLiteralNode*>(expr)) {
+    } else if (auto *arrLit = nodeCast<ArrayLiteralNode>(expr)) {
         for (auto &element : arrLit->elements) collectFreeVarsExpr(element.get(), bound, free);
-    } else if (auto *objLit = dynamic_cast<ObjectLiteralNode*>(expr)) {
+    } else if (auto *objLit = nodeCast<ObjectLiteralNode>(expr)) {
         for (auto &prop : objLit->properties) {
             if (prop.value) collectFreeVarsExpr(prop.value.get(), bound, free);
         }
-    } else if (auto *newExpr = dynamic_cast<NewExpressionNode*>(expr)) {
+    } else if (auto *newExpr = nodeCast<NewExpressionNode>(expr)) {
         for (auto &arg : newExpr->arguments) collectFreeVarsExpr(arg.get(), bound, free);
-    } else if (auto *nested = dynamic_cast<ArrowFunctionNode*>(expr)) {
+    } else if (auto *nested = nodeCast<ArrowFunctionNode>(expr)) {
         // Names free in a nested arrow (minus its params) are free here too
         std::set<std::string> nestedBound = bound;
         for (const auto &param : nested->parameters) nestedBound.insert(param.name);
@@ -4472,58 +4675,58 @@ void CodeGen::collectFreeVars(StatementNode *stmt, std::set<std::string> &bound,
 {
     if (!stmt) return;
 
-    if (auto *varDecl = dynamic_cast<VariableDeclarationNode*>(stmt)) {
+    if (auto *varDecl = nodeCast<VariableDeclarationNode>(stmt)) {
         collectFreeVarsExpr(varDecl->initializer.get(), bound, free);
         bound.insert(varDecl->variableName);
-    } else if (auto *destruct = dynamic_cast<DestructuringDeclarationNode*>(stmt)) {
+    } else if (auto *destruct = nodeCast<DestructuringDeclarationNode>(stmt)) {
         collectFreeVarsExpr(destruct->initializer.get(), bound, free);
         for (const auto &name : destruct->bindings) bound.insert(name);
-    } else if (auto *assign = dynamic_cast<AssignmentStatementNode*>(stmt)) {
+    } else if (auto *assign = nodeCast<AssignmentStatementNode>(stmt)) {
         // Assigning to an outer variable still requires capturing it
         if (!bound.count(assign->variableName)) free.insert(assign->variableName);
         collectFreeVarsExpr(assign->value.get(), bound, free);
-    } else if (auto *arrAssign = dynamic_cast<ArrayAssignmentStatementNode*>(stmt)) {
+    } else if (auto *arrAssign = nodeCast<ArrayAssignmentStatementNode>(stmt)) {
         collectFreeVarsExpr(arrAssign->array.get(), bound, free);
         collectFreeVarsExpr(arrAssign->index.get(), bound, free);
         collectFreeVarsExpr(arrAssign->value.get(), bound, free);
-    } else if (auto *propAssign = dynamic_cast<ObjectPropertyAssignmentNode*>(stmt)) {
+    } else if (auto *propAssign = nodeCast<ObjectPropertyAssignmentNode>(stmt)) {
         collectFreeVarsExpr(propAssign->object.get(), bound, free);
         collectFreeVarsExpr(propAssign->value.get(), bound, free);
-    } else if (auto *exprStmt = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+    } else if (auto *exprStmt = nodeCast<ExpressionStatementNode>(stmt)) {
         collectFreeVarsExpr(exprStmt->expression.get(), bound, free);
-    } else if (auto *ifStmt = dynamic_cast<IfStatementNode*>(stmt)) {
+    } else if (auto *ifStmt = nodeCast<IfStatementNode>(stmt)) {
         collectFreeVarsExpr(ifStmt->condition.get(), bound, free);
         for (auto &s : ifStmt->thenStatements) collectFreeVars(s.get(), bound, free);
         for (auto &s : ifStmt->elseStatements) collectFreeVars(s.get(), bound, free);
-    } else if (auto *whileStmt = dynamic_cast<WhileStatementNode*>(stmt)) {
+    } else if (auto *whileStmt = nodeCast<WhileStatementNode>(stmt)) {
         collectFreeVarsExpr(whileStmt->condition.get(), bound, free);
         for (auto &s : whileStmt->bodyStatements) collectFreeVars(s.get(), bound, free);
-    } else if (auto *doWhile = dynamic_cast<DoWhileStatementNode*>(stmt)) {
+    } else if (auto *doWhile = nodeCast<DoWhileStatementNode>(stmt)) {
         for (auto &s : doWhile->bodyStatements) collectFreeVars(s.get(), bound, free);
         collectFreeVarsExpr(doWhile->condition.get(), bound, free);
-    } else if (auto *forStmt = dynamic_cast<ForStatementNode*>(stmt)) {
+    } else if (auto *forStmt = nodeCast<ForStatementNode>(stmt)) {
         if (forStmt->initialization) collectFreeVars(forStmt->initialization.get(), bound, free);
         collectFreeVarsExpr(forStmt->condition.get(), bound, free);
         if (forStmt->increment) collectFreeVars(forStmt->increment.get(), bound, free);
         for (auto &s : forStmt->bodyStatements) collectFreeVars(s.get(), bound, free);
-    } else if (auto *forOf = dynamic_cast<ForOfStatementNode*>(stmt)) {
+    } else if (auto *forOf = nodeCast<ForOfStatementNode>(stmt)) {
         collectFreeVarsExpr(forOf->iterable.get(), bound, free);
         bound.insert(forOf->iteratorVariable->variableName);
         for (auto &s : forOf->bodyStatements) collectFreeVars(s.get(), bound, free);
-    } else if (auto *switchStmt = dynamic_cast<SwitchStatementNode*>(stmt)) {
+    } else if (auto *switchStmt = nodeCast<SwitchStatementNode>(stmt)) {
         collectFreeVarsExpr(switchStmt->condition.get(), bound, free);
         for (auto &clause : switchStmt->cases) {
             collectFreeVarsExpr(clause.value.get(), bound, free);
             for (auto &s : clause.statements) collectFreeVars(s.get(), bound, free);
         }
-    } else if (auto *tryStmt = dynamic_cast<TryCatchStatementNode*>(stmt)) {
+    } else if (auto *tryStmt = nodeCast<TryCatchStatementNode>(stmt)) {
         for (auto &s : tryStmt->tryStatements) collectFreeVars(s.get(), bound, free);
         if (!tryStmt->errorVariable.empty()) bound.insert(tryStmt->errorVariable);
         for (auto &s : tryStmt->catchStatements) collectFreeVars(s.get(), bound, free);
         for (auto &s : tryStmt->finallyStatements) collectFreeVars(s.get(), bound, free);
-    } else if (auto *retStmt = dynamic_cast<ReturnStatementNode*>(stmt)) {
+    } else if (auto *retStmt = nodeCast<ReturnStatementNode>(stmt)) {
         collectFreeVarsExpr(retStmt->expression.get(), bound, free);
-    } else if (auto *throwStmt = dynamic_cast<ThrowStatementNode*>(stmt)) {
+    } else if (auto *throwStmt = nodeCast<ThrowStatementNode>(stmt)) {
         collectFreeVarsExpr(throwStmt->expression.get(), bound, free);
     }
 }
@@ -4535,26 +4738,29 @@ llvm::Type *CodeGen::inferExpressionLLVMType(ExpressionNode *expr,
     llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
     if (!expr) return i32Ty;
 
-    if (dynamic_cast<StringLiteralNode*>(expr)) return charPtr;
-    if (dynamic_cast<FloatLiteralNode*>(expr)) return llvm::Type::getDoubleTy(m_context);
-    if (dynamic_cast<IntegerLiteralNode*>(expr) || dynamic_cast<BooleanLiteralNode*>(expr)) return i32Ty;
-    if (dynamic_cast<ArrowFunctionNode*>(expr)) return charPtr;
+    if (nodeCast<StringLiteralNode>(expr)) return charPtr;
+    if (nodeCast<FloatLiteralNode>(expr)) return llvm::Type::getDoubleTy(m_context);
+    if (nodeCast<IntegerLiteralNode>(expr) || nodeCast<BooleanLiteralNode>(expr)) return i32Ty;
+    if (nodeCast<ArrowFunctionNode>(expr)) return charPtr;
 
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
         auto paramIt = paramTypes.find(varExpr->name);
         if (paramIt != paramTypes.end()) return getLLVMType(paramIt->second);
-        auto typeIt = variableTypes.find(varExpr->name);
-        if (typeIt != variableTypes.end()) return getLLVMType(typeIt->second);
+        if (const std::string *type = variableTypes.lookup(varExpr->name)) return getLLVMType(*type);
         return i32Ty;
     }
-    if (auto *unaryOp = dynamic_cast<UnaryExpressionNode*>(expr)) {
+    std::string resolved = resolvedTypeOf(expr);
+    if (!resolved.empty()) return getLLVMType(resolved);
+
+    // Not resolved by semantic analysis (an untyped arrow parameter is involved)
+    if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr)) {
         if (unaryOp->op == UnaryExpressionNode::NOT) return i32Ty;
         return inferExpressionLLVMType(unaryOp->operand.get(), paramTypes);
     }
-    if (auto *update = dynamic_cast<UpdateExpressionNode*>(expr)) {
+    if (auto *update = nodeCast<UpdateExpressionNode>(expr)) {
         return inferExpressionLLVMType(update->target.get(), paramTypes);
     }
-    if (auto *binOp = dynamic_cast<BinaryExpressionNode*>(expr)) {
+    if (auto *binOp = nodeCast<BinaryExpressionNode>(expr)) {
         switch (binOp->op) {
             case BinaryExpressionNode::EQUAL:
             case BinaryExpressionNode::NOT_EQUAL:
@@ -4574,7 +4780,7 @@ llvm::Type *CodeGen::inferExpressionLLVMType(ExpressionNode *expr,
         if (left->isDoubleTy() || right->isDoubleTy()) return llvm::Type::getDoubleTy(m_context);
         return i32Ty;
     }
-    if (auto *call = dynamic_cast<FunctionCallNode*>(expr)) {
+    if (auto *call = nodeCast<FunctionCallNode>(expr)) {
         auto fnIt = declaredFunctions.find(call->functionName);
         if (fnIt != declaredFunctions.end()) return fnIt->second->getReturnType();
         if (call->functionName == "JSON.stringify" || call->functionName == "JSON.parse") return charPtr;
@@ -4588,7 +4794,7 @@ llvm::Type *CodeGen::inferArrowReturnType(ArrowFunctionNode *node,
 {
     // Use the first top-level return statement's expression as the signal
     for (const auto &stmt : node->bodyStatements) {
-        if (auto *retStmt = dynamic_cast<ReturnStatementNode*>(stmt.get())) {
+        if (auto *retStmt = nodeCast<ReturnStatementNode>(stmt.get())) {
             if (!retStmt->expression) return llvm::Type::getVoidTy(m_context);
             return inferExpressionLLVMType(retStmt->expression.get(), paramTypes);
         }
@@ -4625,9 +4831,7 @@ llvm::Function *CodeGen::getOrCreateArrowFunction(ArrowFunctionNode *node)
     // Save generation context (arrows can be created mid-statement anywhere)
     llvm::IRBuilderBase::InsertPoint savedIP = m_builder.saveIP();
     llvm::Function *prevFunction = currentFunction;
-    auto prevNamedValues = namedValues;
-    auto prevVariableTypes = variableTypes;
-    auto prevConstVariables = constVariables;
+    pushScope();
     auto prevLoopTargets = loopTargets;
     auto prevLoopTryDepths = loopTargetTryDepths;
     int prevTryDepth = tryDepth;
@@ -4688,9 +4892,7 @@ llvm::Function *CodeGen::getOrCreateArrowFunction(ArrowFunctionNode *node)
 
     // Restore context
     currentFunction = prevFunction;
-    namedValues = prevNamedValues;
-    variableTypes = prevVariableTypes;
-    constVariables = prevConstVariables;
+    popScope();
     loopTargets = prevLoopTargets;
     loopTargetTryDepths = prevLoopTryDepths;
     tryDepth = prevTryDepth;
@@ -4713,18 +4915,15 @@ llvm::Value *CodeGen::visit(ArrowFunctionNode *node)
 
         std::vector<std::pair<std::string, std::string>> captures;
         for (const auto &name : freeNames) {
-            auto nv = namedValues.find(name);
-            if (nv == namedValues.end()) continue; // e.g. builtin function names
+            if (!namedValues.contains(name)) continue; // e.g. builtin function names
             std::string typeName = "i32";
-            auto typeIt = variableTypes.find(name);
-            if (typeIt != variableTypes.end()) typeName = typeIt->second;
+            if (const std::string *type = variableTypes.lookup(name)) typeName = *type;
             captures.push_back({name, typeName});
         }
 
         std::vector<llvm::Type*> envFields;
         for (const auto &capture : captures) {
-            auto nv = namedValues.find(capture.first);
-            envFields.push_back(nv->second->getAllocatedType());
+            envFields.push_back((*namedValues.lookup(capture.first))->getAllocatedType());
         }
         arrowCaptures[node] = std::move(captures);
         arrowEnvTypes[node] = llvm::StructType::create(m_context, envFields, "ArrowEnv");
@@ -4770,8 +4969,8 @@ llvm::Value *CodeGen::visit(ArrowFunctionNode *node)
 
 ArrowFunctionNode *CodeGen::resolveArrowArgument(ExpressionNode *expr)
 {
-    if (auto *arrowLit = dynamic_cast<ArrowFunctionNode*>(expr)) return arrowLit;
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
+    if (auto *arrowLit = nodeCast<ArrowFunctionNode>(expr)) return arrowLit;
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
         auto it = variableToArrow.find(varExpr->name);
         if (it != variableToArrow.end()) return it->second;
     }
@@ -4799,15 +4998,17 @@ std::pair<llvm::Function*, llvm::Value*> CodeGen::materializeCallback(Expression
 
 std::string CodeGen::inferMethodCallTypeName(MethodCallNode *node)
 {
+    std::string resolved = resolvedTypeOf(node);
+    if (!resolved.empty()) return resolved;
+
     std::string varType;
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(node->object.get())) {
-        auto typeIt = variableTypes.find(varExpr->name);
-        if (typeIt != variableTypes.end()) varType = typeIt->second;
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(node->object.get())) {
+        if (const std::string *type = variableTypes.lookup(varExpr->name)) varType = *type;
     }
     if (varType.length() < 3 || varType.substr(varType.length() - 2) != "[]") return "";
     std::string elemType = varType.substr(0, varType.length() - 2);
 
-    // Type name produced by the callback's return type: "string" / "f64" / "i32"
+    // Type name produced by the callback's return type: "string" / "f64" / "i32" ...
     auto arrowReturnTypeName = [&](ExpressionNode *cb) -> std::string {
         ArrowFunctionNode *arrowNode = resolveArrowArgument(cb);
         if (!arrowNode) return "i32";
@@ -4824,6 +5025,9 @@ std::string CodeGen::inferMethodCallTypeName(MethodCallNode *node)
         }
         if (retType->isPointerTy()) return "string";
         if (retType->isDoubleTy()) return "f64";
+        if (retType->isFloatTy()) return "f32";
+        if (retType->isIntegerTy(64)) return "i64";
+        if (retType->isIntegerTy(8)) return "u8";
         return "i32";
     };
 
@@ -4832,7 +5036,10 @@ std::string CodeGen::inferMethodCallTypeName(MethodCallNode *node)
     }
     if (node->methodName == "filter") return varType;
     if (node->methodName == "find" || node->methodName == "shift" || node->methodName == "pop") {
-        if (elemType == "string" || elemType == "f64") return elemType;
+        if (elemType == "string" || elemType == "f64" || elemType == "f32" || elemType == "i64" ||
+            elemType == "u8" || elemType == "i8") {
+            return elemType;
+        }
         return "i32";
     }
     if (node->methodName == "reduce" && !node->arguments.empty()) {
@@ -4844,7 +5051,6 @@ std::string CodeGen::inferMethodCallTypeName(MethodCallNode *node)
 llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Value *arrayPtr,
                                                   const std::string &elemType)
 {
-    llvm::Type *charPtr = llvm::PointerType::get(llvm::Type::getInt8Ty(m_context), 0);
     llvm::Type *i32Ty = llvm::Type::getInt32Ty(m_context);
     const std::string &method = node->methodName;
 
@@ -4854,34 +5060,17 @@ llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Va
 
     auto [callback, envPtr] = materializeCallback(node->arguments[0].get());
 
-    llvm::Type *f64Ty = llvm::Type::getDoubleTy(m_context);
-    bool stringElems = (elemType == "string");
-    bool f64Elems = (elemType == "f64");
-    llvm::Type *elemLLVMType = stringElems ? charPtr : (f64Elems ? f64Ty : i32Ty);
-
-    llvm::FunctionCallee getFn = stringElems
-        ? m_module->getOrInsertFunction("array_get_string", charPtr, charPtr, i32Ty)
-        : (f64Elems
-            ? m_module->getOrInsertFunction("array_get_f64", f64Ty, charPtr, i32Ty)
-            : m_module->getOrInsertFunction("array_get_i32", i32Ty, charPtr, i32Ty));
-    llvm::FunctionCallee lenFn = m_module->getOrInsertFunction("array_length", i32Ty, charPtr);
-
-    // Selects create/push functions for a given element LLVM type
-    auto createFnFor = [&](llvm::Type *t) {
-        if (t->isPointerTy()) return m_module->getOrInsertFunction("array_create_string", charPtr);
-        if (t->isDoubleTy()) return m_module->getOrInsertFunction("array_create_f64", charPtr);
-        return m_module->getOrInsertFunction("array_create_i32", charPtr);
-    };
-    auto pushFnFor = [&](llvm::Type *t) {
-        if (t->isPointerTy()) return m_module->getOrInsertFunction("array_push_string",
-            llvm::Type::getVoidTy(m_context), charPtr, charPtr);
-        if (t->isDoubleTy()) return m_module->getOrInsertFunction("array_push_f64",
-            llvm::Type::getVoidTy(m_context), charPtr, f64Ty);
-        return m_module->getOrInsertFunction("array_push_i32",
-            llvm::Type::getVoidTy(m_context), charPtr, i32Ty);
+    llvm::Type *elemLLVMType = arrayLaneValueType(arrayLaneFor(elemType));
+    // map's results are stored by what the callback returns
+    auto resultElementType = [](llvm::Type *t) -> std::string {
+        if (t->isPointerTy()) return "string";
+        if (t->isFloatTy()) return "f32";
+        if (t->isIntegerTy(64)) return "i64";
+        if (t->isIntegerTy(8)) return "u8";
+        return t->isDoubleTy() ? "f64" : "i32";
     };
 
-    llvm::Value *length = m_builder.CreateCall(lenFn, {arrayPtr}, "cb_len");
+    llvm::Value *length = emitArrayLength(arrayPtr);
     llvm::Function *fn = m_builder.GetInsertBlock()->getParent();
 
     // Shared loop skeleton
@@ -4899,9 +5088,9 @@ llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Va
     llvm::Type *cbRetType = callback->getReturnType();
 
     if (method == "map") {
-        resultArray = m_builder.CreateCall(createFnFor(cbRetType), {}, "map_result");
+        resultArray = emitArrayCreate(resultElementType(cbRetType));
     } else if (method == "filter") {
-        resultArray = m_builder.CreateCall(createFnFor(elemLLVMType), {}, "filter_result");
+        resultArray = emitArrayCreate(elemType);
     } else if (method == "reduce") {
         if (node->arguments.size() < 2) {
             throw std::runtime_error("Codegen Error: .reduce() requires (callback, initialValue)");
@@ -4912,11 +5101,7 @@ llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Va
         m_builder.CreateStore(initial, accAlloca);
     } else if (method == "find") {
         foundAlloca = m_builder.CreateAlloca(elemLLVMType, nullptr, "find_result");
-        llvm::Value *zero;
-        if (stringElems) zero = llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(charPtr));
-        else if (f64Elems) zero = llvm::ConstantFP::get(f64Ty, 0.0);
-        else zero = llvm::ConstantInt::get(i32Ty, 0);
-        m_builder.CreateStore(zero, foundAlloca);
+        m_builder.CreateStore(llvm::Constant::getNullValue(elemLLVMType), foundAlloca);
     } else if (method != "forEach") {
         throw std::runtime_error("Codegen Error: Unsupported callback method '" + method + "'");
     }
@@ -4928,7 +5113,7 @@ llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Va
     m_builder.CreateCondBr(inRange, bodyBlock, exitBlock);
 
     m_builder.SetInsertPoint(bodyBlock);
-    llvm::Value *element = m_builder.CreateCall(getFn, {arrayPtr, index}, "cb_elem");
+    llvm::Value *element = emitArrayLoad(arrayPtr, index, elemType);
 
     auto nextIteration = [&]() {
         llvm::Value *next = m_builder.CreateAdd(
@@ -4944,7 +5129,7 @@ llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Va
 
     if (method == "map") {
         llvm::Value *mapped = m_builder.CreateCall(callback, {envPtr, coerceElem(1)}, "mapped");
-        m_builder.CreateCall(pushFnFor(cbRetType), {resultArray, mapped});
+        emitArrayPush(resultArray, resultElementType(cbRetType), mapped);
         nextIteration();
     } else if (method == "filter") {
         llvm::Value *keep = ensureI1(m_builder.CreateCall(callback, {envPtr, coerceElem(1)}, "keep"));
@@ -4952,7 +5137,7 @@ llvm::Value *CodeGen::generateArrayCallbackMethod(MethodCallNode *node, llvm::Va
         llvm::BasicBlock *skipBlock = llvm::BasicBlock::Create(m_context, "filter_skip", fn);
         m_builder.CreateCondBr(keep, pushBlock, skipBlock);
         m_builder.SetInsertPoint(pushBlock);
-        m_builder.CreateCall(pushFnFor(elemLLVMType), {resultArray, element});
+        emitArrayPush(resultArray, elemType, element);
         m_builder.CreateBr(skipBlock);
         m_builder.SetInsertPoint(skipBlock);
         nextIteration();
@@ -5005,7 +5190,7 @@ bool CodeGen::resolveObjectProperty(ExpressionNode *objectExpr, const std::strin
     }
 
     llvm::Value *objectPtr = nullptr;
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(objectExpr)) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(objectExpr)) {
         llvm::Value* storageSlot = variableStorage(varExpr->name);
         if (storageSlot != nullptr) {
             objectPtr = m_builder.CreateLoad(
@@ -5058,7 +5243,7 @@ void CodeGen::visit(ObjectPropertyAssignmentNode *node)
 
 void CodeGen::visit(DestructuringDeclarationNode *node)
 {
-    auto *varRef = dynamic_cast<VariableExpressionNode*>(node->initializer.get());
+    auto *varRef = nodeCast<VariableExpressionNode>(node->initializer.get());
     if (!varRef) {
         throw std::runtime_error("Codegen Error: Destructuring currently requires an object variable "
                                  "on the right-hand side (e.g. let { a, b } = user;)");
@@ -5170,9 +5355,7 @@ void CodeGen::visit(TryCatchStatementNode *node)
 
     // Catch body (cyps_throw already popped the recovery point)
     m_builder.SetInsertPoint(catchBlock);
-    auto savedNamedValues = namedValues;
-    auto savedVariableTypes = variableTypes;
-    auto savedConstVariables = constVariables;
+    pushScope();
     if (!node->errorVariable.empty()) {
         llvm::Value *errMsg = m_builder.CreateCall(errFn, {}, "err_msg");
         llvm::AllocaInst *errAlloca = m_builder.CreateAlloca(charPtr, nullptr, node->errorVariable);
@@ -5184,9 +5367,7 @@ void CodeGen::visit(TryCatchStatementNode *node)
     for (const auto& stmt : node->catchStatements) {
         visit(stmt.get());
     }
-    namedValues = savedNamedValues;
-    variableTypes = savedVariableTypes;
-    constVariables = savedConstVariables;
+    popScope();
     if (!m_builder.GetInsertBlock()->getTerminator()) {
         m_builder.CreateBr(contBlock);
     }
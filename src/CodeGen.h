@@ -4,6 +4,7 @@
 
 #include "AST.h"
 #include "ObjectOptimizer.h"  // NEW: Include optimizer
+#include "SymbolTable.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/IRBuilder.h"
@@ -48,9 +49,9 @@ private:
     std::unique_ptr<llvm::Module> m_module;
     llvm::IRBuilder<> m_builder;
 
-    // Symbol Table: Maps variable names to their allocated memory location (AllocaInst)
-    // This will need to be enhanced for scopes later.
-    std::map<std::string, llvm::AllocaInst *> namedValues;
+    // Symbol Table: Maps variable names to their allocated memory location (AllocaInst).
+    // It, variableTypes and constVariables are scoped together by pushScope/popScope.
+    ScopedSymbolTable<llvm::AllocaInst *> namedValues;
 
     // Module-level variables promoted to LLVM globals so that functions can see
     // them. Only variables actually referenced by some function body are
@@ -71,10 +72,15 @@ private:
     
     // Type tracking: Maps variable names to their type information
     // For arrays, stores the element type (e.g., "i32" for i32[], "string" for string[])
-    std::map<std::string, std::string> variableTypes;
+    ScopedSymbolTable<std::string> variableTypes;
 
     // Const tracking: Maps variable names to boolean (true if const)
-    std::map<std::string, bool> constVariables;
+    ScopedSymbolTable<bool> constVariables;
+
+    // Opens and closes a lexical scope in all three tables above. A function
+    // body isolates its locals: the caller's allocas belong to another function.
+    void pushScope(bool isolateLocals = false);
+    void popScope();
 
     // Array size tracking: Maps array variable names to their sizes
     std::map<std::string, size_t> arraySizes;
@@ -125,6 +131,11 @@ private:
     // fell back to i32 and read a pointer array as integers.
     std::string arrayTypeOfExpression(ExpressionNode *expr);
 
+    // The type semantic analysis resolved for an expression, or "" if it has
+    // none that has a representation here (unknown, null, void). Codegen's own
+    // tables still win for variables: they also know what an initializer built.
+    static std::string resolvedTypeOf(const ExpressionNode *expr);
+
     // --- Typed buffers ---
     // `Buffer<T>` is a flat, fixed-size block: an i64 length followed by the
     // elements. Indexing compiles to a GEP and a load/store rather than a call
@@ -143,6 +154,11 @@ private:
     // Address of element `index` within a buffer
     llvm::Value *bufferElementAddress(llvm::Value *bufferPtr, llvm::Value *index,
                                       const std::string &elemType);
+    // A private constant global holding `elements` as an array of `elemType`,
+    // when every element is a number literal that converts to it exactly as
+    // its generated value would; null otherwise
+    llvm::GlobalVariable *constantImage(const std::string &elemType,
+                                        const std::vector<std::unique_ptr<ExpressionNode>> &elements);
 
     // True for a pointer that isn't text (class instance, `ptr`, `null`), which
     // must be compared by address rather than with strcmp
@@ -249,6 +265,46 @@ private:
     // Stores one element into an already-evaluated array pointer and index
     void emitArrayStore(llvm::Value *arrayValue, llvm::Value *indexValue,
                         const std::string &elemType, llvm::Value *value);
+    // A new, empty array for `elemType` elements
+    llvm::Value *emitArrayCreate(const std::string &elemType);
+    // Appends one element
+    void emitArrayPush(llvm::Value *arrayValue, const std::string &elemType, llvm::Value *value);
+    // Removes and returns the last element, or the first with `fromFront`
+    llvm::Value *emitArrayRemoveEnd(llvm::Value *arrayValue, const std::string &elemType, bool fromFront);
+    // Number of elements, as an i32, whatever their type
+    llvm::Value *emitArrayLength(llvm::Value *arrayValue);
+
+    // --- Dynamic arrays ---
+    // `T[]` is a pointer to the runtime's TypedArray<T> (cypescript_stdlib.cpp):
+    // one lane header {data, length, capacity, head}, whose element i is
+    // data[head + i], then a kind tag. Each array holds one element type, the
+    // one its creator was called for, at its own width: i32, i64, f32, f64, a
+    // byte for u8/i8/boolean, or a string or object pointer. Elements are
+    // loaded and stored in place behind a bounds check, and pushed in
+    // place while there is room; the runtime is called to grow the lane and
+    // for a write out of range.
+    enum ArrayLane {
+        I32Lane = 1, F64Lane = 2, StringLane = 3, ObjectLane = 4,
+        I64Lane = 5, U8Lane = 6, F32Lane = 7, BoolLane = 8
+    };
+    enum LaneField { LaneData = 0, LaneLength = 1, LaneCapacity = 2, LaneHead = 3 };
+    ArrayLane arrayLaneFor(const std::string &elemType);
+    llvm::Type *arrayLaneElementType(ArrayLane lane);
+    llvm::Type *arrayLaneValueType(ArrayLane lane);
+    llvm::Type *arrayLaneRuntimeType(ArrayLane lane);
+    llvm::Value *toArrayLane(ArrayLane lane, llvm::Value *value);
+    llvm::Value *fromArrayLane(ArrayLane lane, const std::string &elemType, llvm::Value *stored);
+    llvm::StructType *arrayType();
+    llvm::StructType *arrayStructType = nullptr;
+    llvm::Value *arrayFieldAddress(llvm::Value *arrayValue, LaneField field);
+    // Loads one field of the lane header
+    llvm::Value *loadArrayField(llvm::Value *arrayValue, LaneField field);
+    // Address of the element at live position `position` (an i64)
+    llvm::Value *arrayElementAddress(llvm::Value *arrayValue, ArrayLane lane, llvm::Value *position);
+    // Type-based alias tag for a header field or a lane's elements. Header
+    // fields and elements never share memory, and saying so is what lets a
+    // loop keep the header in registers while it stores elements.
+    llvm::MDNode *arrayAccessTag(const std::string &what);
     // Resolves `obj.prop` to the struct pointer and layout, evaluating `obj` once.
     // Returns false if the expression is not a known native object.
     bool resolveObjectProperty(ExpressionNode *objectExpr, const std::string &property,
@@ -362,6 +418,9 @@ private:
 public:
     CodeGen(llvm::LLVMContext &context);
     llvm::Module *generate(ProgramNode *astRoot);
+    // Hands ownership of the generated module to the caller (the JIT keeps it
+    // alive for as long as the program runs)
+    std::unique_ptr<llvm::Module> takeModule() { return std::move(m_module); }
 };
 
 #endif // CODEGEN_H
@@ -0,0 +1,119 @@
+// src/CompileCache.cpp - Content-addressed cache of compiled objects
+#include "CompileCache.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SHA256.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+CompileCache::Key &CompileCache::Key::add(const std::string &label, const std::string &value)
+{
+    m_material += label;
+    m_material += '\0';
+    m_material += std::to_string(value.size());
+    m_material += '\0';
+    m_material += value;
+    return *this;
+}
+
+CompileCache::Key &CompileCache::Key::addFile(const std::string &label, const fs::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return add(label, "<absent>");
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return add(label, contents.str());
+}
+
+std::string CompileCache::Key::digest() const
+{
+    auto hash = llvm::SHA256::hash(llvm::ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t *>(m_material.data()), m_material.size()));
+    return llvm::toHex(hash, /*LowerCase=*/true);
+}
+
+CompileCache::CompileCache(fs::path directory, bool enabled)
+    : m_directory(std::move(directory)), m_enabled(enabled && !m_directory.empty())
+{
+}
+
+fs::path CompileCache::defaultDirectory()
+{
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return fs::path(xdg) / "cypescript";
+    }
+#ifdef _WIN32
+    if (const char *local = std::getenv("LOCALAPPDATA"); local && *local) {
+        return fs::path(local) / "cypescript";
+    }
+#endif
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".cache" / "cypescript";
+    }
+    return fs::path();
+}
+
+fs::path CompileCache::pathFor(const std::string &digest) const
+{
+    return m_directory / (digest + ".o");
+}
+
+bool CompileCache::lookup(const std::string &digest, std::string &objectPath)
+{
+    if (!m_enabled) return false;
+    std::error_code ec;
+    fs::path cached = pathFor(digest);
+    bool hit = fs::is_regular_file(cached, ec);
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        ++(hit ? m_stats.hits : m_stats.misses);
+    }
+    if (hit) objectPath = cached.string();
+    return hit;
+}
+
+CompileCache::Stats CompileCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+std::string CompileCache::store(const std::string &digest, const std::string &object)
+{
+    if (!m_enabled) return object;
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    if (ec) return object;
+
+    // Copy under a unique name first, then rename over the final one: rename is
+    // atomic within a directory, and the copy works across filesystems (the
+    // object usually starts out in the temp directory)
+    fs::path target = pathFor(digest);
+    llvm::SmallString<256> staging;
+    llvm::sys::fs::createUniquePath(target.string() + ".tmp-%%%%%%%%", staging,
+                                    /*MakeAbsolute=*/false);
+    fs::path stagingPath(staging.str().str());
+    if (!fs::copy_file(object, stagingPath, ec) || ec) {
+        fs::remove(stagingPath, ec);
+        return object;
+    }
+    fs::rename(stagingPath, target, ec);
+    if (ec) {
+        fs::remove(stagingPath, ec);
+        return object;
+    }
+    fs::remove(object, ec);
+    return target.string();
+}
+
+bool CompileCache::owns(const std::string &path) const
+{
+    return m_enabled && fs::path(path).parent_path() == m_directory;
+}
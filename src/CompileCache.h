@@ -0,0 +1,73 @@
+// src/CompileCache.h - Content-addressed cache of compiled objects
+// Recompiling a program nobody touched is wasted work: the object for a given
+// resolved source, compiler build and set of flags is always the same bytes.
+// Objects are stored under $XDG_CACHE_HOME/cypescript (~/.cache/cypescript when
+// unset, %LOCALAPPDATA%\cypescript on Windows), named by the SHA-256 of
+// everything that went into them. A hit hands back the stored object and the
+// driver skips straight to linking (or loading, under --jit).
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+class CompileCache
+{
+public:
+    struct Stats {
+        int hits = 0;
+        int misses = 0;
+    };
+
+    // Collects everything an object depends on. Each piece is labelled and
+    // length-prefixed, so ("ab", "c") and ("a", "bc") never hash the same.
+    class Key
+    {
+    public:
+        Key &add(const std::string &label, const std::string &value);
+        // A file's contents; a missing or unreadable file hashes as absent
+        Key &addFile(const std::string &label, const std::filesystem::path &path);
+        // Hex SHA-256 of everything added so far
+        std::string digest() const;
+
+    private:
+        std::string m_material;
+    };
+
+    // A disabled cache misses every lookup and stores nothing, so callers do
+    // not need a separate code path for --no-cache. Lookups and stores may come
+    // from several threads at once (parallel `link source` compiles).
+    CompileCache(std::filesystem::path directory, bool enabled);
+
+    // $XDG_CACHE_HOME/cypescript and its per-platform fallbacks; empty if no
+    // home directory can be determined either
+    static std::filesystem::path defaultDirectory();
+
+    bool enabled() const { return m_enabled; }
+    const std::filesystem::path &directory() const { return m_directory; }
+    Stats stats() const;
+
+    // Sets `objectPath` and returns true if an object is stored for `digest`.
+    // Counts as a hit or a miss.
+    bool lookup(const std::string &digest, std::string &objectPath);
+
+    // Moves a freshly built object into the cache and returns its new path.
+    // The store is atomic (a concurrent build sees the whole file or none of
+    // it); if it fails the object is left where it was and `object` returned.
+    std::string store(const std::string &digest, const std::string &object);
+
+    // True for paths handed out by lookup()/store(). Those are owned by the
+    // cache: callers link or load them, but never delete them.
+    bool owns(const std::string &path) const;
+
+private:
+    std::filesystem::path pathFor(const std::string &digest) const;
+
+    std::filesystem::path m_directory;
+    bool m_enabled;
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+};
+
+#endif // COMPILE_CACHE_H
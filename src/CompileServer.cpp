@@ -0,0 +1,416 @@
+// src/CompileServer.cpp - `cscript --server`: a compile daemon on a Unix socket
+// Deliberately free of LLVM: cscript-client links this file and nothing else.
+#include "CompileServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace CompileServer
+{
+
+#ifndef _WIN32
+namespace
+{
+
+// Sent first, in the same message as the client's three descriptors. The
+// strings follow it, each NUL-terminated: the working directory, then the
+// arguments, then the environment.
+struct Header {
+    char magic[4];
+    uint32_t argCount;
+    uint32_t envCount;
+    uint32_t payloadSize;
+};
+constexpr char kMagic[4] = {'C', 'S', 'C', '1'};
+constexpr int kPassedDescriptors = 3;             // stdin, stdout, stderr
+constexpr uint32_t kMaxPayload = 16 * 1024 * 1024;
+
+volatile sig_atomic_t s_stopRequested = 0;
+
+void requestStop(int) { s_stopRequested = 1; }
+void noteChildExit(int) {}   // installed only so that accept() returns to reap it
+
+sockaddr_un socketAddress(const std::string &path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Server socket path must be 1 to " +
+                                 std::to_string(sizeof(address.sun_path) - 1) +
+                                 " bytes long: '" + path + "'");
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// A socket connected to the server at `path`, or -1 if nothing answers there
+int connectTo(const std::string &path)
+{
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// The user on the other end of a connected socket, or -1 if it cannot be told
+long peerUser(int fd)
+{
+#ifdef SO_PEERCRED
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) return -1;
+    return static_cast<long>(credentials.uid);
+#else
+    uid_t user;
+    gid_t group;
+    if (getpeereid(fd, &user, &group) != 0) return -1;
+    return static_cast<long>(user);
+#endif
+}
+
+bool writeAll(int fd, const void *data, size_t size)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, void *data, size_t size)
+{
+    char *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t count = read(fd, bytes, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        bytes += count;
+        size -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+// Reads one request. The descriptors that came with it become this process's
+// stdin, stdout and stderr.
+bool receiveRequest(int connection, Request &request)
+{
+    Header header;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kPassedDescriptors)];
+    iovec io{&header, sizeof(header)};
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(connection, &message, 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return false;
+
+    int descriptors[kPassedDescriptors];
+    size_t descriptorCount = 0;
+    for (cmsghdr *part = CMSG_FIRSTHDR(&message); part; part = CMSG_NXTHDR(&message, part)) {
+        if (part->cmsg_level != SOL_SOCKET || part->cmsg_type != SCM_RIGHTS) continue;
+        descriptorCount = (part->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        std::memcpy(descriptors, CMSG_DATA(part),
+                    sizeof(int) * std::min<size_t>(descriptorCount, kPassedDescriptors));
+    }
+    if (descriptorCount != kPassedDescriptors) return false;
+    for (int i = 0; i < kPassedDescriptors; ++i) {
+        dup2(descriptors[i], i);
+        if (descriptors[i] >= kPassedDescriptors) close(descriptors[i]);
+    }
+
+    size_t headerRead = static_cast<size_t>(received);
+    if (headerRead < sizeof(header) &&
+        !readAll(connection, reinterpret_cast<char *>(&header) + headerRead,
+                 sizeof(header) - headerRead)) {
+        return false;
+    }
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.payloadSize > kMaxPayload) {
+        return false;
+    }
+
+    std::string payload(header.payloadSize, '\0');
+    if (!readAll(connection, payload.data(), payload.size())) return false;
+    std::vector<std::string> strings;
+    for (size_t start = 0; start < payload.size();) {
+        size_t end = payload.find('\0', start);
+        if (end == std::string::npos) return false;
+        strings.push_back(payload.substr(start, end - start));
+        start = end + 1;
+    }
+    if (strings.size() != 1 + size_t(header.argCount) + header.envCount) return false;
+
+    request.workingDirectory = strings[0];
+    request.args.assign(strings.begin() + 1, strings.begin() + 1 + header.argCount);
+    request.environment.assign(strings.begin() + 1 + header.argCount, strings.end());
+    return true;
+}
+
+// The client's environment, in place of the server's
+void replaceEnvironment(const std::vector<std::string> &environment)
+{
+    std::vector<std::string> names;
+    for (char **entry = environ; entry && *entry; ++entry) {
+        if (const char *equals = std::strchr(*entry, '=')) names.emplace_back(static_cast<const char *>(*entry), equals);
+    }
+    for (const std::string &name : names) unsetenv(name.c_str());
+    for (const std::string &entry : environment) {
+        size_t equals = entry.find('=');
+        if (equals == 0 || equals == std::string::npos) continue;
+        setenv(entry.substr(0, equals).c_str(), entry.c_str() + equals + 1, 1);
+    }
+}
+
+// One request, in the forked child. Returns the exit status it sent back.
+int serveRequest(int connection, const std::function<int(const Request &)> &compile, bool verbose)
+{
+    auto started = std::chrono::steady_clock::now();
+    int log = verbose ? dup(STDERR_FILENO) : -1;
+
+    Request request;
+    if (!receiveRequest(connection, request)) {
+        if (log >= 0) dprintf(log, "[%d] malformed request dropped\n", int(getpid()));
+        return 1;
+    }
+
+    int status = 1;
+    if (chdir(request.workingDirectory.c_str()) != 0) {
+        std::fprintf(stderr, "cscript: cannot enter %s: %s\n", request.workingDirectory.c_str(),
+                     std::strerror(errno));
+    } else {
+        replaceEnvironment(request.environment);
+        try {
+            status = compile(request);
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "cscript: %s\n", e.what());
+        }
+    }
+    std::fflush(nullptr);
+
+    int32_t reply = status;
+    writeAll(connection, &reply, sizeof(reply));
+
+    if (log >= 0) {
+        std::string command = "cscript";
+        for (const std::string &arg : request.args) command += " " + arg;
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+        dprintf(log, "[%d] %s -> %d (%.1fms)\n", int(getpid()), command.c_str(), status,
+                elapsed.count() / 1000.0);
+    }
+    return status;
+}
+
+void reapChildren()
+{
+    while (waitpid(-1, nullptr, WNOHANG) > 0) {
+    }
+}
+
+} // namespace
+
+std::string defaultSocketPath()
+{
+    if (const char *path = std::getenv("CSCRIPT_SERVER"); path && *path) return path;
+    if (const char *runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime) {
+        return std::string(runtime) + "/cscript.sock";
+    }
+    return "/tmp/cscript-" + std::to_string(getuid()) + ".sock";
+}
+
+int serve(const std::string &socketPath, const std::function<void()> &prepare,
+          const std::function<int(const Request &)> &compile, bool verbose)
+{
+    // A socket nobody answers on was left behind by a server that died; one
+    // that answers belongs to a live server, which keeps it
+    if (int existing = connectTo(socketPath); existing >= 0) {
+        close(existing);
+        throw std::runtime_error("A compile server is already listening on " + socketPath);
+    }
+    unlink(socketPath.c_str());
+
+    sockaddr_un address = socketAddress(socketPath);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error("Cannot create the server socket: " + std::string(std::strerror(errno)));
+    }
+    fcntl(listener, F_SETFD, FD_CLOEXEC);
+    // Requests run with the server's privileges, so the socket's permissions
+    // are the access check: created owner-only, never briefly wider
+    mode_t previousMask = umask(077);
+    bool listening = bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0 &&
+                     listen(listener, SOMAXCONN) == 0;
+    umask(previousMask);
+    if (!listening) {
+        std::string reason = std::strerror(errno);
+        close(listener);
+        throw std::runtime_error("Cannot listen on " + socketPath + ": " + reason);
+    }
+
+    // No SA_RESTART: a signal has to get the loop out of accept()
+    struct sigaction action {};
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    action.sa_handler = noteChildExit;
+    action.sa_flags = SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &action, nullptr);
+
+    while (!s_stopRequested) {
+        int connection = accept(listener, nullptr, nullptr);
+        int acceptError = errno;
+        reapChildren();
+        if (connection < 0) {
+            if (acceptError == EINTR || acceptError == ECONNABORTED) continue;
+            std::string reason = std::strerror(acceptError);
+            close(listener);
+            unlink(socketPath.c_str());
+            throw std::runtime_error("Compile server stopped: " + reason);
+        }
+
+        prepare();
+        pid_t child = fork();
+        if (child == 0) {
+            close(listener);
+            signal(SIGINT, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            // std::system() and pclose() wait for their own children
+            signal(SIGCHLD, SIG_DFL);
+            // Static destructors belong to the server, not to one request
+            _exit(serveRequest(connection, compile, verbose));
+        }
+        if (child < 0) {
+            std::fprintf(stderr, "cscript --server: fork failed: %s\n", std::strerror(errno));
+        }
+        close(connection);
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+    // Compiles already under way still answer their clients
+    for (;;) {
+        if (waitpid(-1, nullptr, 0) > 0 || errno == EINTR) continue;
+        break;
+    }
+    return 0;
+}
+
+int forward(const std::string &socketPath, int argc, char **argv)
+{
+    int connection = connectTo(socketPath);
+    if (connection < 0) return -1;
+    // The request hands over our descriptors and environment, and /tmp is
+    // shared: anyone could have bound the fallback path first. Only a server
+    // run by this same user gets them.
+    if (long owner = peerUser(connection); owner != static_cast<long>(getuid())) {
+        close(connection);
+        std::fprintf(stderr, "cscript: ignoring the compile server on %s: it is not run by this user\n",
+                     socketPath.c_str());
+        return -1;
+    }
+
+    char *workingDirectory = getcwd(nullptr, 0);
+    std::string payload = workingDirectory ? workingDirectory : ".";
+    std::free(workingDirectory);
+    payload += '\0';
+    for (int i = 1; i < argc; ++i) {
+        payload += argv[i];
+        payload += '\0';
+    }
+    uint32_t envCount = 0;
+    for (char **entry = environ; entry && *entry; ++entry, ++envCount) {
+        payload += *entry;
+        payload += '\0';
+    }
+
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.argCount = static_cast<uint32_t>(argc > 0 ? argc - 1 : 0);
+    header.envCount = envCount;
+    header.payloadSize = static_cast<uint32_t>(payload.size());
+
+    int descriptors[kPassedDescriptors] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(descriptors))] = {};
+    iovec io{&header, sizeof(header)};
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr *part = CMSG_FIRSTHDR(&message);
+    part->cmsg_level = SOL_SOCKET;
+    part->cmsg_type = SCM_RIGHTS;
+    part->cmsg_len = CMSG_LEN(sizeof(descriptors));
+    std::memcpy(CMSG_DATA(part), descriptors, sizeof(descriptors));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(connection, &message, 0);
+    } while (sent < 0 && errno == EINTR);
+    bool delivered = sent >= 0 &&
+                     writeAll(connection, reinterpret_cast<char *>(&header) + sent,
+                              sizeof(header) - static_cast<size_t>(sent)) &&
+                     writeAll(connection, payload.data(), payload.size());
+    if (!delivered) {
+        std::string reason = std::strerror(errno);
+        close(connection);
+        throw std::runtime_error("Could not send the request to " + socketPath + ": " + reason);
+    }
+
+    int32_t status;
+    bool answered = readAll(connection, &status, sizeof(status));
+    close(connection);
+    if (!answered) {
+        throw std::runtime_error("The compile server on " + socketPath +
+                                 " closed the connection without a result");
+    }
+    return status;
+}
+
+#else // _WIN32
+
+std::string defaultSocketPath() { return ""; }
+
+int serve(const std::string &, const std::function<void()> &,
+          const std::function<int(const Request &)> &, bool)
+{
+    throw std::runtime_error("--server needs Unix domain sockets, which this platform lacks");
+}
+
+int forward(const std::string &, int, char **) { return -1; }
+
+#endif
+
+} // namespace CompileServer
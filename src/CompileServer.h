@@ -0,0 +1,57 @@
+// src/CompileServer.h - `cscript --server`: a compile daemon on a Unix socket
+// Every cscript run pays for process startup, LLVM target setup and parsing of
+// the bundled modules before it reaches the program it was asked to compile.
+// Editors and CI matrices make thousands of such runs. The server pays for all
+// of that once, then forks one child per request: each compile starts from the
+// warm state, and whatever it does to that state (the AST passes rewrite nodes
+// in place) is thrown away with the child.
+//
+// A request carries the client's arguments, working directory and environment,
+// plus its stdin, stdout and stderr themselves (passed as SCM_RIGHTS), so
+// diagnostics and the output of --run and --jit reach the client's terminal
+// exactly as if cscript had run there. The reply is the exit status.
+// cscript-client (src/cscript_client.cpp) is the thin client: it links nothing
+// of LLVM, so it starts in about a millisecond.
+//
+// Unix only; on Windows serve() and forward() throw std::runtime_error.
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace CompileServer
+{
+
+struct Request {
+    std::vector<std::string> args;          // the client's argv, minus argv[0]
+    std::string workingDirectory;
+    std::vector<std::string> environment;   // "NAME=value"
+};
+
+// $CSCRIPT_SERVER, else $XDG_RUNTIME_DIR/cscript.sock, else
+// /tmp/cscript-<uid>.sock. Client and server agree on it without being told.
+std::string defaultSocketPath();
+
+// Listens on `socketPath` until SIGINT or SIGTERM, then removes it. The socket
+// is only accessible to the current user. Before each fork `prepare` runs in
+// the server itself, to refresh anything that has gone stale; `compile` runs in
+// the child with the request's descriptors, directory and environment already
+// installed, and returns the exit status sent back. With `verbose`, one line
+// per request goes to the server's own stderr.
+// Throws std::runtime_error if the socket cannot be set up, or if another
+// server is already listening on it.
+int serve(const std::string &socketPath, const std::function<void()> &prepare,
+          const std::function<int(const Request &)> &compile, bool verbose);
+
+// Hands this process's arguments, directory, environment and standard
+// descriptors to the server on `socketPath` and waits for the compile. Returns
+// its exit status, or -1 if no server is listening there or the one listening
+// is run by another user (nothing was sent, so the caller can compile by
+// itself instead).
+int forward(const std::string &socketPath, int argc, char **argv);
+
+} // namespace CompileServer
+
+#endif // COMPILE_SERVER_H
@@ -0,0 +1,833 @@
+// src/ConstEval.cpp - AST interpreter for compile-time `const function` calls
+#include "ConstEval.h"
+#include "SymbolTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// Work one call may do before evaluation is abandoned, and the total for a
+// whole program. A step is one statement or expression evaluated.
+constexpr long kMaxStepsPerCall = 10000000;
+constexpr long kMaxStepsPerProgram = 50000000;
+// Array and buffer elements one call may allocate
+constexpr size_t kMaxElements = size_t(1) << 22;
+// Elements a result may hold: each one becomes a literal node in the AST
+constexpr size_t kMaxResultElements = size_t(1) << 16;
+constexpr int kMaxCallDepth = 256;
+
+// Thrown to abandon an evaluation; the call is then compiled as a call
+struct GiveUp {};
+
+[[noreturn]] void giveUp() { throw GiveUp(); }
+
+struct Aggregate;
+
+struct Value {
+    enum class Kind { Int, Float, Array, Buffer };
+    Kind kind = Kind::Int;
+    unsigned bits = 32; // Int: 1 (a comparison), 8, 32 or 64. Float: 32 or 64
+    int64_t i = 0;
+    double f = 0.0;
+    std::shared_ptr<Aggregate> aggregate; // shared, as the runtime's handles are
+
+    bool isScalar() const { return kind == Kind::Int || kind == Kind::Float; }
+};
+
+struct Aggregate {
+    std::string elementType;
+    std::vector<Value> elements;
+};
+
+// Truncates to `bits` and sign-extends back, as the LLVM integer type would
+int64_t wrap(int64_t value, unsigned bits)
+{
+    switch (bits) {
+        case 1: return value & 1;
+        case 8: return static_cast<int8_t>(static_cast<uint8_t>(value));
+        case 32: return static_cast<int32_t>(static_cast<uint32_t>(value));
+        default: return value;
+    }
+}
+
+Value intValue(int64_t value, unsigned bits)
+{
+    Value result;
+    result.kind = Value::Kind::Int;
+    result.bits = bits;
+    result.i = wrap(value, bits);
+    return result;
+}
+
+Value floatValue(double value, unsigned bits)
+{
+    Value result;
+    result.kind = Value::Kind::Float;
+    result.bits = bits;
+    result.f = bits == 32 ? static_cast<double>(static_cast<float>(value)) : value;
+    return result;
+}
+
+// The representation getLLVMType gives a scalar type; false for anything else
+bool scalarShape(const std::string &type, Value::Kind &kind, unsigned &bits)
+{
+    kind = Value::Kind::Int;
+    if (type == "i32" || type == "boolean") bits = 32;
+    else if (type == "i64") bits = 64;
+    else if (type == "i8" || type == "u8") bits = 8;
+    else {
+        kind = Value::Kind::Float;
+        if (type == "f64" || type == "number") bits = 64;
+        else if (type == "f32") bits = 32;
+        else return false;
+    }
+    return true;
+}
+
+// Element types a dynamic array can hold here: those with a numeric lane
+bool isArrayElementType(const std::string &type)
+{
+    return type == "i32" || type == "boolean" || type == "f64" || type == "number" || type == "i64" ||
+           type == "u8" || type == "i8" || type == "f32";
+}
+
+std::string arrayElementType(const std::string &type)
+{
+    if (type.size() <= 2 || type.compare(type.size() - 2, 2, "[]") != 0) return "";
+    std::string element = type.substr(0, type.size() - 2);
+    return isArrayElementType(element) ? element : "";
+}
+
+std::string typeNameOf(const Value &value)
+{
+    switch (value.kind) {
+        case Value::Kind::Array: return value.aggregate->elementType + "[]";
+        case Value::Kind::Buffer: return "Buffer<" + value.aggregate->elementType + ">";
+        case Value::Kind::Float: return value.bits == 32 ? "f32" : "f64";
+        case Value::Kind::Int: break;
+    }
+    if (value.bits == 64) return "i64";
+    if (value.bits == 8) return "i8";
+    return value.bits == 1 ? "boolean" : "i32";
+}
+
+// coerceValue's conversions between scalar representations
+Value convert(const Value &value, Value::Kind kind, unsigned bits)
+{
+    if (!value.isScalar()) giveUp();
+    if (value.kind == kind && value.bits == bits) return value;
+    if (kind == Value::Kind::Int) {
+        if (value.kind == Value::Kind::Int) {
+            // An i1 holds 0 or 1, so its zero extension is this too
+            return bits == 1 ? intValue(value.i != 0, 1) : intValue(value.i, bits);
+        }
+        // fptosi: poison unless the truncated value fits
+        if (bits == 1 || std::isnan(value.f)) giveUp();
+        double truncated = std::trunc(value.f);
+        double limit = std::ldexp(1.0, static_cast<int>(bits) - 1);
+        if (truncated < -limit || truncated >= limit) giveUp();
+        return intValue(static_cast<int64_t>(truncated), bits);
+    }
+    if (value.kind == Value::Kind::Int) {
+        // sitofp reads an i1 as signed: true converts to -1
+        int64_t number = value.bits == 1 && value.i ? -1 : value.i;
+        return floatValue(static_cast<double>(number), bits);
+    }
+    return floatValue(value.f, bits);
+}
+
+// A value as stored into a slot of `type`: a variable, parameter, return
+// value or buffer element. An array or buffer must already be that type.
+Value convertTo(const Value &value, const std::string &type)
+{
+    Value::Kind kind;
+    unsigned bits;
+    if (scalarShape(type, kind, bits)) return convert(value, kind, bits);
+    if (value.isScalar() || typeNameOf(value) != type) giveUp();
+    return value;
+}
+
+// A value as a dynamic array of `elementType` stores it and reads it back
+// (CodeGen::toArrayLane): at the element's own width, and a boolean as the
+// 0 or 1 its byte holds
+Value toLane(const Value &value, const std::string &elementType)
+{
+    if (elementType == "boolean") {
+        if (value.kind != Value::Kind::Int) giveUp();
+        return intValue(value.i != 0, 32);
+    }
+    Value::Kind kind;
+    unsigned bits;
+    if (!scalarShape(elementType, kind, bits)) giveUp();
+    return convert(value, kind, bits);
+}
+
+Value zeroOf(const std::string &type)
+{
+    Value::Kind kind;
+    unsigned bits;
+    if (!scalarShape(type, kind, bits)) giveUp();
+    return kind == Value::Kind::Int ? intValue(0, bits) : floatValue(0.0, bits);
+}
+
+// ensureI1: how a condition is tested
+bool truthy(const Value &value)
+{
+    if (!value.isScalar()) return true; // a handle is never null here
+    if (value.kind == Value::Kind::Int) return value.i != 0;
+    if (value.bits != 64) giveUp();
+    return !std::isnan(value.f) && value.f != 0.0; // fcmp one
+}
+
+// Integer arithmetic in `bits`, wrapping; division that would trap or be
+// poison gives up instead
+Value intArithmetic(BinaryExpressionNode::Operator op, int64_t left, int64_t right, unsigned bits)
+{
+    if (bits == 1) giveUp();
+    uint64_t l = static_cast<uint64_t>(left), r = static_cast<uint64_t>(right);
+    switch (op) {
+        case BinaryExpressionNode::ADD: return intValue(static_cast<int64_t>(l + r), bits);
+        case BinaryExpressionNode::SUBTRACT: return intValue(static_cast<int64_t>(l - r), bits);
+        case BinaryExpressionNode::MULTIPLY: return intValue(static_cast<int64_t>(l * r), bits);
+        case BinaryExpressionNode::DIVIDE:
+        case BinaryExpressionNode::MODULO: {
+            int64_t minimum = bits == 64 ? INT64_MIN : -(int64_t(1) << (bits - 1));
+            if (right == 0 || (right == -1 && left == minimum)) giveUp();
+            return intValue(op == BinaryExpressionNode::DIVIDE ? left / right : left % right, bits);
+        }
+        default: giveUp();
+    }
+}
+
+Value floatArithmetic(BinaryExpressionNode::Operator op, double left, double right)
+{
+    switch (op) {
+        case BinaryExpressionNode::ADD: return floatValue(left + right, 64);
+        case BinaryExpressionNode::SUBTRACT: return floatValue(left - right, 64);
+        case BinaryExpressionNode::MULTIPLY: return floatValue(left * right, 64);
+        case BinaryExpressionNode::DIVIDE: return floatValue(left / right, 64);
+        case BinaryExpressionNode::MODULO: return floatValue(std::fmod(left, right), 64);
+        default: giveUp();
+    }
+}
+
+// emitBinaryOp, which `a[i] op= v` uses: f64 if either side is, else i32
+Value compoundArithmetic(BinaryExpressionNode::Operator op, const Value &left, const Value &right)
+{
+    if (!left.isScalar() || !right.isScalar()) giveUp();
+    if ((left.kind == Value::Kind::Float && left.bits != 64) ||
+        (right.kind == Value::Kind::Float && right.bits != 64)) {
+        giveUp();
+    }
+    if (left.kind == Value::Kind::Float || right.kind == Value::Kind::Float) {
+        return floatArithmetic(op, convert(left, Value::Kind::Float, 64).f,
+                               convert(right, Value::Kind::Float, 64).f);
+    }
+    return intArithmetic(op, convert(left, Value::Kind::Int, 32).i,
+                         convert(right, Value::Kind::Int, 32).i, 32);
+}
+
+// A literal, or an array or buffer built only of literals: something an
+// argument can be for the call to be evaluated
+bool isConstant(const ExpressionNode *expr)
+{
+    if (nodeCast<const IntegerLiteralNode>(expr) || nodeCast<const FloatLiteralNode>(expr) ||
+        nodeCast<const BooleanLiteralNode>(expr)) {
+        return true;
+    }
+    if (auto *arrLit = nodeCast<const ArrayLiteralNode>(expr)) {
+        return std::all_of(arrLit->elements.begin(), arrLit->elements.end(),
+                           [](const auto &element) { return isConstant(element.get()); });
+    }
+    if (auto *newExpr = nodeCast<const NewExpressionNode>(expr)) {
+        return newExpr->className == "Buffer" && newExpr->arguments.size() == 1 &&
+               nodeCast<const IntegerLiteralNode>(newExpr->arguments[0].get()) &&
+               std::all_of(newExpr->contents.begin(), newExpr->contents.end(),
+                           [](const auto &element) { return isConstant(element.get()); });
+    }
+    return false;
+}
+
+std::unique_ptr<ExpressionNode> literalOf(const Value &value)
+{
+    if (value.kind == Value::Kind::Float) return std::make_unique<FloatLiteralNode>(value.f);
+    return std::make_unique<IntegerLiteralNode>(value.i);
+}
+
+class Interpreter
+{
+public:
+    Interpreter(const std::map<std::string, FunctionDeclarationNode *> &functions, long steps)
+        : m_functions(functions), m_stepsLeft(steps) {}
+
+    long stepsLeft() const { return m_stepsLeft; }
+
+    Value invoke(const FunctionDeclarationNode *func, std::vector<Value> args);
+    Value eval(const ExpressionNode *expr);
+
+private:
+    enum class Flow { Normal, Break, Continue, Return };
+
+    struct Slot {
+        Value value;
+        std::string type;
+        bool initialized = false;
+    };
+
+    const std::map<std::string, FunctionDeclarationNode *> &m_functions;
+    ScopedSymbolTable<Slot> m_scopes;
+    long m_stepsLeft;
+    size_t m_elements = 0;
+    int m_depth = 0;
+    Value m_returned;
+
+    void step()
+    {
+        if (--m_stepsLeft < 0) giveUp();
+    }
+    void allocate(size_t count)
+    {
+        m_elements += count;
+        if (m_elements > kMaxElements) giveUp();
+    }
+
+    void declare(const std::string &name, const std::string &type, const Value *value);
+    Slot &variable(const std::string &name);
+
+    Flow run(const std::vector<std::unique_ptr<StatementNode>> &stmts);
+    Flow runBlock(const std::vector<std::unique_ptr<StatementNode>> &stmts);
+    Flow run(const StatementNode *stmt);
+
+    Value binary(const BinaryExpressionNode *node);
+    Value unary(const UnaryExpressionNode *node);
+    Value update(const UpdateExpressionNode *node);
+    Value call(const FunctionCallNode *node);
+    Value arrayLiteral(const ArrayLiteralNode *node, const std::string &elementType);
+    Value newBuffer(const NewExpressionNode *node);
+    Value element(const Value &container, const Value &index);
+    void storeElement(const Value &container, const Value &index, const Value &value);
+};
+
+void Interpreter::declare(const std::string &name, const std::string &type, const Value *value)
+{
+    Slot &slot = m_scopes[name];
+    slot.type = type;
+    slot.initialized = value != nullptr;
+    if (value) slot.value = convertTo(*value, type);
+}
+
+Interpreter::Slot &Interpreter::variable(const std::string &name)
+{
+    // Anything but a local is module-level state, which is not constant
+    Slot *slot = m_scopes.lookup(name);
+    if (!slot || !slot->initialized) giveUp();
+    return *slot;
+}
+
+Value Interpreter::invoke(const FunctionDeclarationNode *func, std::vector<Value> args)
+{
+    if (!func->genericParams.empty() || args.size() != func->parameters.size() ||
+        m_depth >= kMaxCallDepth) {
+        giveUp();
+    }
+    m_depth++;
+    m_scopes.pushScope(/*isolated=*/true);
+    for (size_t i = 0; i < args.size(); ++i) {
+        declare(func->parameters[i].name, func->parameters[i].type, &args[i]);
+    }
+    Flow flow = run(func->bodyStatements);
+    m_scopes.popScope();
+    m_depth--;
+    // Falling off the end returns whatever the compiled function does there
+    if (flow != Flow::Return) giveUp();
+    return convertTo(m_returned, func->returnType);
+}
+
+Interpreter::Flow Interpreter::run(const std::vector<std::unique_ptr<StatementNode>> &stmts)
+{
+    for (const auto &stmt : stmts) {
+        Flow flow = run(stmt.get());
+        if (flow != Flow::Normal) return flow;
+    }
+    return Flow::Normal;
+}
+
+Interpreter::Flow Interpreter::runBlock(const std::vector<std::unique_ptr<StatementNode>> &stmts)
+{
+    m_scopes.pushScope();
+    Flow flow = run(stmts);
+    m_scopes.popScope();
+    return flow;
+}
+
+Interpreter::Flow Interpreter::run(const StatementNode *stmt)
+{
+    step();
+    if (auto *varDecl = nodeCast<const VariableDeclarationNode>(stmt)) {
+        std::string type = varDecl->typeName;
+        if (!varDecl->initializer) {
+            if (type.empty() || type == "auto") giveUp();
+            declare(varDecl->variableName, type, nullptr);
+            return Flow::Normal;
+        }
+        // An array annotation decides the literal's element type, as in CodeGen
+        Value value;
+        auto *arrLit = nodeCast<const ArrayLiteralNode>(varDecl->initializer.get());
+        std::string annotatedElement = arrayElementType(type);
+        if (arrLit && !annotatedElement.empty()) {
+            value = arrayLiteral(arrLit, annotatedElement);
+        } else {
+            value = eval(varDecl->initializer.get());
+        }
+        if (type.empty() || type == "auto") {
+            const ExpressionNode *init = varDecl->initializer.get();
+            Value::Kind kind;
+            unsigned bits;
+            if (!value.isScalar()) type = typeNameOf(value);
+            else if (init->typeResolved && scalarShape(init->resolvedType.str(), kind, bits)) {
+                type = init->resolvedType.str();
+            } else {
+                type = value.kind == Value::Kind::Float && value.bits == 64 ? "f64"
+                     : value.bits == 1 ? "boolean" : "i32";
+            }
+        }
+        declare(varDecl->variableName, type, &value);
+        return Flow::Normal;
+    }
+    if (auto *assign = nodeCast<const AssignmentStatementNode>(stmt)) {
+        Value value = eval(assign->value.get());
+        Slot *slot = m_scopes.lookup(assign->variableName);
+        if (!slot) giveUp();
+        slot->value = convertTo(value, slot->type);
+        slot->initialized = true;
+        return Flow::Normal;
+    }
+    if (auto *arrAssign = nodeCast<const ArrayAssignmentStatementNode>(stmt)) {
+        Value container = eval(arrAssign->array.get());
+        Value index = eval(arrAssign->index.get());
+        Value value = eval(arrAssign->value.get());
+        if (arrAssign->isCompound) {
+            value = compoundArithmetic(arrAssign->compoundOp, element(container, index), value);
+        }
+        storeElement(container, index, value);
+        return Flow::Normal;
+    }
+    if (auto *exprStmt = nodeCast<const ExpressionStatementNode>(stmt)) {
+        // `push` is a statement: its value is never used
+        if (auto *methodCall = nodeCast<const MethodCallNode>(exprStmt->expression.get())) {
+            if (methodCall->methodName != "push" || methodCall->arguments.size() != 1) giveUp();
+            Value array = eval(methodCall->object.get());
+            if (array.kind != Value::Kind::Array) giveUp();
+            Value value = toLane(eval(methodCall->arguments[0].get()), array.aggregate->elementType);
+            allocate(1);
+            array.aggregate->elements.push_back(value);
+            return Flow::Normal;
+        }
+        eval(exprStmt->expression.get());
+        return Flow::Normal;
+    }
+    if (auto *ifStmt = nodeCast<const IfStatementNode>(stmt)) {
+        bool condition = truthy(eval(ifStmt->condition.get()));
+        return runBlock(condition ? ifStmt->thenStatements : ifStmt->elseStatements);
+    }
+    if (auto *whileStmt = nodeCast<const WhileStatementNode>(stmt)) {
+        while (truthy(eval(whileStmt->condition.get()))) {
+            Flow flow = runBlock(whileStmt->bodyStatements);
+            if (flow == Flow::Break) break;
+            if (flow == Flow::Return) return flow;
+        }
+        return Flow::Normal;
+    }
+    if (auto *doWhileStmt = nodeCast<const DoWhileStatementNode>(stmt)) {
+        do {
+            Flow flow = runBlock(doWhileStmt->bodyStatements);
+            if (flow == Flow::Break) break;
+            if (flow == Flow::Return) return flow;
+        } while (truthy(eval(doWhileStmt->condition.get())));
+        return Flow::Normal;
+    }
+    if (auto *forStmt = nodeCast<const ForStatementNode>(stmt)) {
+        m_scopes.pushScope();
+        if (forStmt->initialization) run(forStmt->initialization.get());
+        Flow result = Flow::Normal;
+        while (!forStmt->condition || truthy(eval(forStmt->condition.get()))) {
+            Flow flow = runBlock(forStmt->bodyStatements);
+            if (flow == Flow::Break) break;
+            if (flow == Flow::Return) {
+                result = flow;
+                break;
+            }
+            if (forStmt->increment) run(forStmt->increment.get());
+        }
+        m_scopes.popScope();
+        return result;
+    }
+    if (auto *forOfStmt = nodeCast<const ForOfStatementNode>(stmt)) {
+        // CodeGen types the elements from the iterable variable's type, so
+        // only a variable is iterated the same way here
+        if (!nodeCast<const VariableExpressionNode>(forOfStmt->iterable.get())) giveUp();
+        Value array = eval(forOfStmt->iterable.get());
+        if (array.kind != Value::Kind::Array) giveUp();
+        // The length is read once, before the first iteration
+        size_t length = array.aggregate->elements.size();
+        for (size_t i = 0; i < length; ++i) {
+            Value item = element(array, intValue(static_cast<int64_t>(i), 32));
+            m_scopes.pushScope();
+            declare(forOfStmt->iteratorVariable->variableName, array.aggregate->elementType, &item);
+            Flow flow = run(forOfStmt->bodyStatements);
+            m_scopes.popScope();
+            if (flow == Flow::Break) break;
+            if (flow == Flow::Return) return flow;
+        }
+        return Flow::Normal;
+    }
+    if (nodeCast<const BreakStatementNode>(stmt)) return Flow::Break;
+    if (nodeCast<const ContinueStatementNode>(stmt)) return Flow::Continue;
+    if (auto *retStmt = nodeCast<const ReturnStatementNode>(stmt)) {
+        if (!retStmt->expression) giveUp();
+        m_returned = eval(retStmt->expression.get());
+        return Flow::Return;
+    }
+    giveUp();
+}
+
+Value Interpreter::eval(const ExpressionNode *expr)
+{
+    step();
+    if (auto *intLit = nodeCast<const IntegerLiteralNode>(expr)) return intValue(intLit->value, 32);
+    if (auto *floatLit = nodeCast<const FloatLiteralNode>(expr)) return floatValue(floatLit->value, 64);
+    if (auto *boolLit = nodeCast<const BooleanLiteralNode>(expr)) return intValue(boolLit->value, 32);
+    if (auto *varExpr = nodeCast<const VariableExpressionNode>(expr)) return variable(varExpr->name).value;
+    if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) return binary(binOp);
+    if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) return unary(unaryOp);
+    if (auto *updateExpr = nodeCast<const UpdateExpressionNode>(expr)) return update(updateExpr);
+    if (auto *funcCall = nodeCast<const FunctionCallNode>(expr)) return call(funcCall);
+    if (auto *arrLit = nodeCast<const ArrayLiteralNode>(expr)) return arrayLiteral(arrLit, arrLit->elementType);
+    if (auto *newExpr = nodeCast<const NewExpressionNode>(expr)) return newBuffer(newExpr);
+    if (auto *arrAccess = nodeCast<const ArrayAccessNode>(expr)) {
+        Value container = eval(arrAccess->array.get());
+        return element(container, eval(arrAccess->index.get()));
+    }
+    if (auto *objAccess = nodeCast<const ObjectAccessNode>(expr)) {
+        Value container = eval(objAccess->object.get());
+        if (objAccess->property != "length" || container.isScalar()) giveUp();
+        return intValue(static_cast<int64_t>(container.aggregate->elements.size()), 32);
+    }
+    giveUp();
+}
+
+Value Interpreter::binary(const BinaryExpressionNode *node)
+{
+    using Op = BinaryExpressionNode;
+
+    // Short-circuiting: the phi CodeGen builds widens the side taken to the
+    // wider of the two integer types, and an i1 to i32
+    if (node->op == Op::LOGICAL_AND || node->op == Op::LOGICAL_OR) {
+        Value left = eval(node->left.get());
+        if (left.kind != Value::Kind::Int || left.bits == 8) giveUp();
+        bool takeLeft = (node->op == Op::LOGICAL_OR) == (left.i != 0);
+        if (takeLeft) return intValue(left.i, std::max(left.bits, 32u));
+        Value right = eval(node->right.get());
+        if (right.kind != Value::Kind::Int) giveUp();
+        unsigned wide = std::max({left.bits, right.bits, 32u});
+        return convert(right, Value::Kind::Int, wide);
+    }
+
+    Value left = eval(node->left.get());
+    Value right = eval(node->right.get());
+    if (!left.isScalar() || !right.isScalar()) giveUp();
+
+    switch (node->op) {
+        case Op::BIT_AND:
+        case Op::BIT_OR:
+        case Op::BIT_XOR:
+        case Op::SHIFT_LEFT:
+        case Op::SHIFT_RIGHT: {
+            if (left.kind != Value::Kind::Int || right.kind != Value::Kind::Int) giveUp();
+            unsigned wide = std::max({left.bits, right.bits, 32u});
+            int64_t l = convert(left, Value::Kind::Int, wide).i;
+            int64_t r = convert(right, Value::Kind::Int, wide).i;
+            if (node->op == Op::BIT_AND) return intValue(l & r, wide);
+            if (node->op == Op::BIT_OR) return intValue(l | r, wide);
+            if (node->op == Op::BIT_XOR) return intValue(l ^ r, wide);
+            // A shift by the width or more is poison
+            if (r < 0 || r >= static_cast<int64_t>(wide)) giveUp();
+            if (node->op == Op::SHIFT_LEFT) return intValue(static_cast<int64_t>(static_cast<uint64_t>(l) << r), wide);
+            return intValue(l >> r, wide);
+        }
+        default:
+            break;
+    }
+
+    bool leftDouble = left.kind == Value::Kind::Float && left.bits == 64;
+    bool rightDouble = right.kind == Value::Kind::Float && right.bits == 64;
+    if (leftDouble || rightDouble) {
+        double l = convert(left, Value::Kind::Float, 64).f;
+        double r = convert(right, Value::Kind::Float, 64).f;
+        bool unordered = std::isnan(l) || std::isnan(r);
+        switch (node->op) {
+            case Op::EQUAL: return intValue(l == r, 1);
+            case Op::NOT_EQUAL: return intValue(!unordered && l != r, 1);
+            case Op::LESS_THAN: return intValue(l < r, 1);
+            case Op::LESS_EQUAL: return intValue(l <= r, 1);
+            case Op::GREATER_THAN: return intValue(l > r, 1);
+            case Op::GREATER_EQUAL: return intValue(l >= r, 1);
+            default: return floatArithmetic(node->op, l, r);
+        }
+    }
+    // f32 only mixes with f64 in compiled code
+    if (left.kind == Value::Kind::Float || right.kind == Value::Kind::Float) giveUp();
+
+    // Mixed widths meet at i32
+    unsigned bits = left.bits;
+    if (left.bits != right.bits) {
+        bits = 32;
+        left = convert(left, Value::Kind::Int, 32);
+        right = convert(right, Value::Kind::Int, 32);
+    }
+    switch (node->op) {
+        case Op::EQUAL: return intValue(left.i == right.i, 1);
+        case Op::NOT_EQUAL: return intValue(left.i != right.i, 1);
+        default: break;
+    }
+    // Signed comparisons read an i1 true as -1; nothing needs that
+    if (bits == 1) giveUp();
+    switch (node->op) {
+        case Op::LESS_THAN: return intValue(left.i < right.i, 1);
+        case Op::LESS_EQUAL: return intValue(left.i <= right.i, 1);
+        case Op::GREATER_THAN: return intValue(left.i > right.i, 1);
+        case Op::GREATER_EQUAL: return intValue(left.i >= right.i, 1);
+        default: return intArithmetic(node->op, left.i, right.i, bits);
+    }
+}
+
+Value Interpreter::unary(const UnaryExpressionNode *node)
+{
+    Value operand = eval(node->operand.get());
+    switch (node->op) {
+        case UnaryExpressionNode::NOT:
+            if (!operand.isScalar()) return intValue(0, 32);
+            if (operand.kind != Value::Kind::Int) giveUp();
+            return intValue(operand.i == 0, 32);
+        case UnaryExpressionNode::MINUS:
+            if (operand.kind == Value::Kind::Float && operand.bits == 64) return floatValue(-operand.f, 64);
+            if (operand.kind != Value::Kind::Int) giveUp();
+            return intValue(static_cast<int64_t>(0 - static_cast<uint64_t>(operand.i)), operand.bits);
+        case UnaryExpressionNode::BIT_NOT:
+            if (operand.kind != Value::Kind::Int) giveUp();
+            return intValue(~convert(operand, Value::Kind::Int, 32).i, 32);
+    }
+    giveUp();
+}
+
+Value Interpreter::update(const UpdateExpressionNode *node)
+{
+    // Steps in the type the target was loaded as
+    auto stepped = [&](const Value &value) {
+        if (value.kind == Value::Kind::Float && value.bits == 64) {
+            return floatValue(value.f + (node->isIncrement ? 1.0 : -1.0), 64);
+        }
+        if (value.kind != Value::Kind::Int || value.bits == 1) giveUp();
+        return intArithmetic(node->isIncrement ? BinaryExpressionNode::ADD : BinaryExpressionNode::SUBTRACT,
+                             value.i, 1, value.bits);
+    };
+
+    Value before, after;
+    if (auto *varExpr = nodeCast<const VariableExpressionNode>(node->target.get())) {
+        Slot &slot = variable(varExpr->name);
+        before = slot.value;
+        after = stepped(before);
+        slot.value = after;
+    } else if (auto *access = nodeCast<const ArrayAccessNode>(node->target.get())) {
+        Value container = eval(access->array.get());
+        Value index = eval(access->index.get());
+        before = element(container, index);
+        after = stepped(before);
+        storeElement(container, index, after);
+    } else {
+        giveUp();
+    }
+    return node->isPrefix ? after : before;
+}
+
+Value Interpreter::call(const FunctionCallNode *node)
+{
+    std::vector<Value> args;
+    for (const auto &arg : node->arguments) args.push_back(eval(arg.get()));
+
+    auto function = m_functions.find(node->functionName);
+    if (function != m_functions.end()) return invoke(function->second, std::move(args));
+
+    // Math, with the runtime's definitions (cypescript_stdlib.cpp)
+    const std::string &name = node->functionName;
+    if (name == "math_abs_i32" && args.size() == 1) {
+        int64_t x = convert(args[0], Value::Kind::Int, 32).i;
+        if (x == INT32_MIN) giveUp();
+        return intValue(x < 0 ? -x : x, 32);
+    }
+    std::vector<double> x;
+    for (const Value &arg : args) x.push_back(convert(arg, Value::Kind::Float, 64).f);
+    if (x.size() == 1) {
+        if (name == "math_sqrt") return floatValue(std::sqrt(x[0]), 64);
+        if (name == "math_abs_f64") return floatValue(std::abs(x[0]), 64);
+        if (name == "math_floor") return floatValue(std::floor(x[0]), 64);
+        if (name == "math_ceil") return floatValue(std::ceil(x[0]), 64);
+        if (name == "math_round") return floatValue(std::round(x[0]), 64);
+        if (name == "math_sin") return floatValue(std::sin(x[0]), 64);
+        if (name == "math_cos") return floatValue(std::cos(x[0]), 64);
+        if (name == "math_tan") return floatValue(std::tan(x[0]), 64);
+        if (name == "math_log") return floatValue(std::log(x[0]), 64);
+        if (name == "math_exp") return floatValue(std::exp(x[0]), 64);
+    } else if (x.size() == 2) {
+        if (name == "math_pow") return floatValue(std::pow(x[0], x[1]), 64);
+        if (name == "math_min") return floatValue(x[0] < x[1] ? x[0] : x[1], 64);
+        if (name == "math_max") return floatValue(x[0] > x[1] ? x[0] : x[1], 64);
+        if (name == "math_atan2") return floatValue(std::atan2(x[0], x[1]), 64);
+    }
+    giveUp();
+}
+
+Value Interpreter::arrayLiteral(const ArrayLiteralNode *node, const std::string &elementType)
+{
+    if (!isArrayElementType(elementType)) giveUp();
+    Value array;
+    array.kind = Value::Kind::Array;
+    array.aggregate = std::make_shared<Aggregate>();
+    array.aggregate->elementType = elementType;
+    allocate(node->elements.size());
+    for (const auto &element : node->elements) {
+        array.aggregate->elements.push_back(toLane(eval(element.get()), elementType));
+    }
+    return array;
+}
+
+Value Interpreter::newBuffer(const NewExpressionNode *node)
+{
+    if (node->className != "Buffer" || node->genericTypes.size() != 1 || node->arguments.size() > 1) {
+        giveUp();
+    }
+    const std::string &elementType = node->genericTypes[0];
+    Value zero = zeroOf(elementType);
+    int64_t count = 0;
+    if (!node->arguments.empty()) {
+        Value length = eval(node->arguments[0].get());
+        if (length.kind != Value::Kind::Int) giveUp();
+        count = convert(length, Value::Kind::Int, 64).i;
+    }
+    if (count < 0 || static_cast<uint64_t>(count) > kMaxElements) giveUp();
+    allocate(static_cast<size_t>(count));
+
+    Value buffer;
+    buffer.kind = Value::Kind::Buffer;
+    buffer.aggregate = std::make_shared<Aggregate>();
+    buffer.aggregate->elementType = elementType;
+    buffer.aggregate->elements.assign(static_cast<size_t>(count), zero);
+    if (!node->contents.empty()) {
+        if (node->contents.size() != static_cast<size_t>(count)) giveUp();
+        for (size_t i = 0; i < node->contents.size(); ++i) {
+            buffer.aggregate->elements[i] = convertTo(eval(node->contents[i].get()), elementType);
+        }
+    }
+    return buffer;
+}
+
+Value Interpreter::element(const Value &container, const Value &index)
+{
+    if (container.isScalar() || index.kind != Value::Kind::Int) giveUp();
+    const auto &elements = container.aggregate->elements;
+    if (container.kind == Value::Kind::Buffer) {
+        // Buffers are not bounds-checked: reading outside one is undefined
+        int64_t i = convert(index, Value::Kind::Int, 64).i;
+        if (i < 0 || static_cast<uint64_t>(i) >= elements.size()) giveUp();
+        return elements[static_cast<size_t>(i)];
+    }
+    // Out-of-range array reads return zero, as array_get_* do
+    int64_t i = convert(index, Value::Kind::Int, 32).i;
+    if (i < 0 || static_cast<uint64_t>(i) >= elements.size()) {
+        return toLane(intValue(0, 32), container.aggregate->elementType);
+    }
+    return elements[static_cast<size_t>(i)];
+}
+
+void Interpreter::storeElement(const Value &container, const Value &index, const Value &value)
+{
+    if (container.isScalar() || index.kind != Value::Kind::Int) giveUp();
+    auto &elements = container.aggregate->elements;
+    const std::string &elementType = container.aggregate->elementType;
+    if (container.kind == Value::Kind::Buffer) {
+        int64_t i = convert(index, Value::Kind::Int, 64).i;
+        if (i < 0 || static_cast<uint64_t>(i) >= elements.size()) giveUp();
+        elements[static_cast<size_t>(i)] = convertTo(value, elementType);
+        return;
+    }
+    // array_set_* ignores a negative index and grows the array past its end
+    int64_t i = convert(index, Value::Kind::Int, 32).i;
+    if (i < 0) return;
+    Value stored = toLane(value, elementType);
+    if (static_cast<uint64_t>(i) >= elements.size()) {
+        allocate(static_cast<size_t>(i) + 1 - elements.size());
+        elements.resize(static_cast<size_t>(i) + 1, toLane(intValue(0, 32), elementType));
+    }
+    elements[static_cast<size_t>(i)] = stored;
+}
+
+} // namespace
+
+ConstEvaluator::ConstEvaluator(const std::map<std::string, FunctionDeclarationNode *> &constFunctions)
+    : m_functions(constFunctions), m_stepsLeft(kMaxStepsPerProgram) {}
+
+std::unique_ptr<ExpressionNode> ConstEvaluator::evaluateCall(const FunctionCallNode *call)
+{
+    auto function = m_functions.find(call->functionName);
+    if (function == m_functions.end() || m_stepsLeft <= 0) return nullptr;
+    const FunctionDeclarationNode *func = function->second;
+    for (const auto &arg : call->arguments) {
+        if (!isConstant(arg.get())) return nullptr;
+    }
+
+    long budget = std::min(m_stepsLeft, kMaxStepsPerCall);
+    Interpreter interpreter(m_functions, budget);
+    Value result;
+    try {
+        std::vector<Value> args;
+        for (const auto &arg : call->arguments) args.push_back(interpreter.eval(arg.get()));
+        result = interpreter.invoke(func, std::move(args));
+    } catch (const GiveUp &) {
+        m_stepsLeft -= budget - std::max(interpreter.stepsLeft(), 0L);
+        return nullptr;
+    }
+    m_stepsLeft -= budget - interpreter.stepsLeft();
+
+    // Only what a literal can stand for without changing its type: an i32
+    // literal compiles to an i32, so an i64 or u8 result stays a call
+    const std::string &type = func->returnType;
+    std::unique_ptr<ExpressionNode> replacement;
+    if (type == "i32" || type == "f64" || type == "number") {
+        replacement = literalOf(result);
+    } else if (type == "boolean") {
+        replacement = std::make_unique<BooleanLiteralNode>(result.i != 0);
+    } else if (!result.isScalar() && result.aggregate->elements.size() <= kMaxResultElements) {
+        const auto &elements = result.aggregate->elements;
+        if (result.kind == Value::Kind::Array) {
+            auto array = std::make_unique<ArrayLiteralNode>(result.aggregate->elementType);
+            for (const Value &element : elements) array->elements.push_back(literalOf(element));
+            replacement = std::move(array);
+        } else {
+            auto buffer = std::make_unique<NewExpressionNode>("Buffer");
+            buffer->genericTypes.push_back(result.aggregate->elementType);
+            buffer->arguments.push_back(
+                std::make_unique<IntegerLiteralNode>(static_cast<long long>(elements.size())));
+            for (const Value &element : elements) buffer->contents.push_back(literalOf(element));
+            replacement = std::move(buffer);
+        }
+    }
+    if (!replacement) return nullptr;
+    replacement->line = call->line;
+    replacement->column = call->column;
+    replacement->resolvedType = internTypeName(type);
+    replacement->typeResolved = true;
+    return replacement;
+}
@@ -0,0 +1,48 @@
+// src/ConstEval.h - Compile-time evaluation of `const function` calls
+// A `const function` is pure by construction (semantic analysis rejects I/O,
+// calls to anything but other const functions and Math, and reads of
+// module-level state), so a call whose arguments are all constants has one
+// possible result. The AST optimizer asks for it here and replaces the call
+// with that result: lookup tables a program used to build with loops at
+// startup (sine tables, CRC tables, tile maps) arrive already filled in, as
+// constant images CodeGen copies out of read-only globals.
+//
+// The evaluator is an interpreter over the AST that follows CodeGen's rules
+// for every operation it runs: i32 arithmetic wraps, integer division
+// truncates, mixed int/f64 arithmetic is done in f64, stores convert to the
+// slot's type. Wherever the compiled program's behaviour would not be
+// defined (division by zero, an out-of-range shift or buffer index) or the
+// work would be too large to do at compile time, it gives up and the call is
+// left to run as compiled code, so evaluating never changes what a program
+// prints.
+#ifndef CONST_EVAL_H
+#define CONST_EVAL_H
+
+#include "AST.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+class ConstEvaluator
+{
+public:
+    // `constFunctions`: every const function of the program, by name. Must
+    // outlive the evaluator.
+    explicit ConstEvaluator(const std::map<std::string, FunctionDeclarationNode *> &constFunctions);
+
+    // The value of `call` as an expression of the callee's return type: a
+    // number or boolean literal, an array literal, or a `new Buffer` carrying
+    // its contents. Null when the call cannot be evaluated: the callee is not
+    // a const function, an argument is not a constant, or evaluation gave up.
+    std::unique_ptr<ExpressionNode> evaluateCall(const FunctionCallNode *call);
+
+private:
+    const std::map<std::string, FunctionDeclarationNode *> &m_functions;
+    // Interpreter steps left for the whole program: each call is capped too,
+    // but a const function that never finishes, called from many places, must
+    // not multiply into a compile that never finishes either
+    long m_stepsLeft;
+};
+
+#endif // CONST_EVAL_H
@@ -0,0 +1,391 @@
+// src/IncrementalParser.cpp - Reparsing only the declarations an edit touched
+#include "IncrementalParser.h"
+
+#include "Lexer.h"
+#include "Parser.h"
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+// Kept declarations outlive any one compilation, so their nodes come from the
+// heap even when the caller has an arena active
+class HeapNodes
+{
+public:
+    HeapNodes() : m_arena(ASTArena::active()) { ASTArena::active() = nullptr; }
+    ~HeapNodes() { ASTArena::active() = m_arena; }
+
+private:
+    ASTArena *m_arena;
+};
+
+size_t enumsDigest(const IncrementalParser::EnumTable &enums)
+{
+    llvm::hash_code hash = llvm::hash_value(enums.size());
+    for (const auto &[name, members] : enums) {
+        hash = llvm::hash_combine(hash, name, members.size());
+        for (const auto &[member, value] : members) hash = llvm::hash_combine(hash, member, value);
+    }
+    return hash;
+}
+
+// What a statement is looked up by: its column, and its text up to the end
+// of the line, the first `;` or `{`, or 80 bytes, whichever comes first. A
+// kept statement always reaches one of them, so a text it starts hashes the
+// same, and a trailing comment after `let x = 1;` does not get in the way.
+size_t headKey(llvm::StringRef text, int column)
+{
+    llvm::StringRef head = text.take_until([](char c) { return c == '\n' || c == ';' || c == '{'; });
+    return llvm::hash_combine(head.take_front(80), column);
+}
+
+// Declarations, and the simple statements between them, that end at a `;`
+// or `}` of their own: the parser stops there whatever follows, so the same
+// text always parses to the same tree. (An `if` looks past its `}` for an
+// `else`.) Enums are left out because the statements after them fold their
+// members.
+bool isReusable(const StatementNode *stmt)
+{
+    switch (stmt->nodeKind) {
+        case NodeKind::FunctionDeclaration:
+        case NodeKind::ClassDeclaration:
+        case NodeKind::InterfaceDeclaration:
+        case NodeKind::TypeAlias:
+        case NodeKind::VariableDeclaration:
+        case NodeKind::DestructuringDeclaration:
+        case NodeKind::ExternDeclaration:
+        case NodeKind::ExpressionStatement:
+        case NodeKind::AssignmentStatement:
+        case NodeKind::ArrayAssignmentStatement:
+        case NodeKind::ObjectPropertyAssignment:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Moves a reused tree `lineDelta` lines and forgets the types analysis gave it
+void rebase(StatementNode *stmt, int lineDelta);
+void rebase(ExpressionNode *expr, int lineDelta);
+
+void rebasePosition(ASTNode *node, int lineDelta)
+{
+    if (node->line > 0) node->line += lineDelta;
+}
+
+void rebase(std::vector<std::unique_ptr<StatementNode>> &stmts, int lineDelta)
+{
+    for (auto &stmt : stmts) rebase(stmt.get(), lineDelta);
+}
+
+void rebase(std::vector<std::unique_ptr<ExpressionNode>> &exprs, int lineDelta)
+{
+    for (auto &expr : exprs) rebase(expr.get(), lineDelta);
+}
+
+void rebase(ExpressionNode *expr, int lineDelta)
+{
+    if (!expr) return;
+    rebasePosition(expr, lineDelta);
+    expr->resolvedType = {};
+    expr->typeResolved = false;
+
+    switch (expr->nodeKind) {
+        case NodeKind::BinaryExpression: {
+            auto *binOp = nodeCast<BinaryExpressionNode>(expr);
+            rebase(binOp->left.get(), lineDelta);
+            rebase(binOp->right.get(), lineDelta);
+            break;
+        }
+        case NodeKind::UnaryExpression:
+            rebase(nodeCast<UnaryExpressionNode>(expr)->operand.get(), lineDelta);
+            break;
+        case NodeKind::UpdateExpression:
+            rebase(nodeCast<UpdateExpressionNode>(expr)->target.get(), lineDelta);
+            break;
+        case NodeKind::ArrowFunction:
+            rebase(nodeCast<ArrowFunctionNode>(expr)->bodyStatements, lineDelta);
+            break;
+        case NodeKind::FunctionCall:
+            rebase(nodeCast<FunctionCallNode>(expr)->arguments, lineDelta);
+            break;
+        case NodeKind::ArrayLiteral:
+            rebase(nodeCast<ArrayLiteralNode>(expr)->elements, lineDelta);
+            break;
+        case NodeKind::ArrayAccess: {
+            auto *access = nodeCast<ArrayAccessNode>(expr);
+            rebase(access->array.get(), lineDelta);
+            rebase(access->index.get(), lineDelta);
+            break;
+        }
+        case NodeKind::ObjectLiteral:
+            for (auto &property : nodeCast<ObjectLiteralNode>(expr)->properties) {
+                rebase(property.value.get(), lineDelta);
+                if (property.method) rebase(property.method.get(), lineDelta);
+            }
+            break;
+        case NodeKind::ObjectAccess:
+            rebase(nodeCast<ObjectAccessNode>(expr)->object.get(), lineDelta);
+            break;
+        case NodeKind::MethodCall: {
+            auto *call = nodeCast<MethodCallNode>(expr);
+            rebase(call->object.get(), lineDelta);
+            rebase(call->arguments, lineDelta);
+            break;
+        }
+        case NodeKind::NewExpression: {
+            auto *newExpr = nodeCast<NewExpressionNode>(expr);
+            rebase(newExpr->arguments, lineDelta);
+            rebase(newExpr->contents, lineDelta);
+            break;
+        }
+        default:
+            break;   // literals and names have nothing below them
+    }
+}
+
+void rebase(StatementNode *stmt, int lineDelta)
+{
+    if (!stmt) return;
+    rebasePosition(stmt, lineDelta);
+
+    switch (stmt->nodeKind) {
+        case NodeKind::VariableDeclaration:
+            rebase(nodeCast<VariableDeclarationNode>(stmt)->initializer.get(), lineDelta);
+            break;
+        case NodeKind::IfStatement: {
+            auto *ifStmt = nodeCast<IfStatementNode>(stmt);
+            rebase(ifStmt->condition.get(), lineDelta);
+            rebase(ifStmt->thenStatements, lineDelta);
+            rebase(ifStmt->elseStatements, lineDelta);
+            break;
+        }
+        case NodeKind::WhileStatement: {
+            auto *whileStmt = nodeCast<WhileStatementNode>(stmt);
+            rebase(whileStmt->condition.get(), lineDelta);
+            rebase(whileStmt->bodyStatements, lineDelta);
+            break;
+        }
+        case NodeKind::AssignmentStatement:
+            rebase(nodeCast<AssignmentStatementNode>(stmt)->value.get(), lineDelta);
+            break;
+        case NodeKind::ArrayAssignmentStatement: {
+            auto *assign = nodeCast<ArrayAssignmentStatementNode>(stmt);
+            rebase(assign->array.get(), lineDelta);
+            rebase(assign->index.get(), lineDelta);
+            rebase(assign->value.get(), lineDelta);
+            break;
+        }
+        case NodeKind::ForStatement: {
+            auto *forStmt = nodeCast<ForStatementNode>(stmt);
+            rebase(forStmt->initialization.get(), lineDelta);
+            rebase(forStmt->condition.get(), lineDelta);
+            rebase(forStmt->increment.get(), lineDelta);
+            rebase(forStmt->bodyStatements, lineDelta);
+            break;
+        }
+        case NodeKind::ForOfStatement: {
+            auto *forOf = nodeCast<ForOfStatementNode>(stmt);
+            rebase(forOf->iteratorVariable.get(), lineDelta);
+            rebase(forOf->iterable.get(), lineDelta);
+            rebase(forOf->bodyStatements, lineDelta);
+            break;
+        }
+        case NodeKind::DoWhileStatement: {
+            auto *doWhile = nodeCast<DoWhileStatementNode>(stmt);
+            rebase(doWhile->bodyStatements, lineDelta);
+            rebase(doWhile->condition.get(), lineDelta);
+            break;
+        }
+        case NodeKind::SwitchStatement: {
+            auto *switchStmt = nodeCast<SwitchStatementNode>(stmt);
+            rebase(switchStmt->condition.get(), lineDelta);
+            for (auto &clause : switchStmt->cases) {
+                rebase(clause.value.get(), lineDelta);
+                rebase(clause.statements, lineDelta);
+            }
+            break;
+        }
+        case NodeKind::ObjectPropertyAssignment: {
+            auto *assign = nodeCast<ObjectPropertyAssignmentNode>(stmt);
+            rebase(assign->object.get(), lineDelta);
+            rebase(assign->value.get(), lineDelta);
+            break;
+        }
+        case NodeKind::DestructuringDeclaration:
+            rebase(nodeCast<DestructuringDeclarationNode>(stmt)->initializer.get(), lineDelta);
+            break;
+        case NodeKind::ThrowStatement:
+            rebase(nodeCast<ThrowStatementNode>(stmt)->expression.get(), lineDelta);
+            break;
+        case NodeKind::TryCatchStatement: {
+            auto *tryStmt = nodeCast<TryCatchStatementNode>(stmt);
+            rebase(tryStmt->tryStatements, lineDelta);
+            rebase(tryStmt->catchStatements, lineDelta);
+            rebase(tryStmt->finallyStatements, lineDelta);
+            break;
+        }
+        case NodeKind::ExpressionStatement:
+            rebase(nodeCast<ExpressionStatementNode>(stmt)->expression.get(), lineDelta);
+            break;
+        case NodeKind::FunctionDeclaration:
+            rebase(nodeCast<FunctionDeclarationNode>(stmt)->bodyStatements, lineDelta);
+            break;
+        case NodeKind::ReturnStatement:
+            rebase(nodeCast<ReturnStatementNode>(stmt)->expression.get(), lineDelta);
+            break;
+        case NodeKind::ClassDeclaration:
+            rebase(nodeCast<ClassDeclarationNode>(stmt)->objectTemplate.get(), lineDelta);
+            break;
+        default:
+            break;   // declarations of names and types only
+    }
+}
+
+} // namespace
+
+std::unique_ptr<ProgramNode> IncrementalParser::parse(const std::string &source, const EnumTable &enums)
+{
+    HeapNodes heap;
+    m_error.clear();
+    m_stats = Stats();
+    m_lent.clear();   // never reclaimed: its statements went with its program
+
+    std::vector<size_t> lineStarts{0};
+    for (size_t i = source.find('\n'); i != std::string::npos; i = source.find('\n', i + 1)) {
+        lineStarts.push_back(i + 1);
+    }
+    auto offsetOf = [&](const Token &token) {
+        return lineStarts[token.line - 1] + static_cast<size_t>(token.column - 1);
+    };
+
+    m_enums = enums;
+    size_t digest = enumsDigest(m_enums);
+    auto program = std::make_unique<ProgramNode>();
+    std::vector<std::pair<Declaration *, size_t>> taken;   // to put back on a syntax error
+    std::vector<Declaration> lent;
+
+    // Each run of statements that are not reused gets its own lexer, started
+    // where the run starts, so reused text is never lexed
+    size_t offset = 0;
+    int line = 1;
+    int column = 1;
+    try {
+        for (bool resume = true; resume;) {
+            resume = false;
+            Lexer lexer(std::string_view(source).substr(offset), line, column);
+            Parser parser(lexer);
+            parser.addKnownEnums(m_enums);
+            while (!parser.atEnd()) {
+                const Token &first = parser.nextToken();
+                int startLine = first.line;
+                int startColumn = first.column;
+                size_t start = offsetOf(first);
+
+                if (Declaration *kept = findReusable(source, start, startColumn, digest)) {
+                    rebase(kept->node.get(), startLine - kept->line);
+                    Declaration entry;
+                    entry.text = std::move(kept->text);
+                    entry.line = startLine;
+                    entry.column = startColumn;
+                    entry.enumsDigest = digest;
+                    entry.exported = kept->exported;
+                    if (entry.exported) program->exported.push_back(kept->node.get());
+                    program->statements.push_back(std::move(kept->node));
+                    taken.emplace_back(kept, lent.size());
+                    offset = start + entry.text.size();
+                    lent.push_back(std::move(entry));
+                    ++m_stats.reused;
+
+                    auto after = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+                    line = static_cast<int>(after - lineStarts.begin());
+                    column = static_cast<int>(offset - lineStarts[line - 1]) + 1;
+                    resume = true;
+                    break;
+                }
+
+                bool exported = false;
+                std::unique_ptr<StatementNode> stmt = parser.parseNextStatement(exported);
+                ++m_stats.parsed;
+                Declaration entry;
+                entry.line = startLine;
+                entry.column = startColumn;
+                entry.enumsDigest = digest;
+                entry.exported = exported;
+                const Token &last = parser.previousToken();
+                if (isReusable(stmt.get()) && (last.type == TOK_SEMICOLON || last.type == TOK_RBRACE)) {
+                    entry.text = source.substr(start, offsetOf(last) + 1 - start);
+                }
+                if (stmt->nodeKind == NodeKind::EnumDeclaration) {
+                    m_enums = parser.knownEnums();
+                    digest = enumsDigest(m_enums);
+                }
+                if (exported) program->exported.push_back(stmt.get());
+                program->statements.push_back(std::move(stmt));
+                lent.push_back(std::move(entry));
+            }
+            m_stats.tokens += parser.tokenCount();
+        }
+    } catch (const std::runtime_error &e) {
+        for (auto &[kept, index] : taken) {
+            kept->text = std::move(lent[index].text);
+            kept->node = std::move(program->statements[index]);
+            rebase(kept->node.get(), kept->line - lent[index].line);
+        }
+        m_error = e.what();
+        return nullptr;
+    }
+
+    m_lent = std::move(lent);
+    return program;
+}
+
+void IncrementalParser::reclaim(ProgramNode &program)
+{
+    std::vector<std::unique_ptr<StatementNode>> &stmts = program.statements;
+    if (m_lent.size() > stmts.size()) {
+        m_lent.clear();
+        return;
+    }
+    size_t first = stmts.size() - m_lent.size();
+    std::vector<Declaration> kept;
+    for (size_t i = 0; i < m_lent.size(); ++i) {
+        if (m_lent[i].text.empty()) continue;   // not reusable: goes with the program
+        m_lent[i].node = std::move(stmts[first + i]);
+        kept.push_back(std::move(m_lent[i]));
+    }
+    m_lent.clear();
+    stmts.erase(stmts.begin() + static_cast<std::ptrdiff_t>(first), stmts.end());
+    program.exported.clear();
+
+    m_declarations = std::move(kept);
+    index();
+}
+
+IncrementalParser::Declaration *IncrementalParser::findReusable(const std::string &source, size_t offset,
+                                                                int column, size_t enumsDigest)
+{
+    if (m_byHead.empty()) return nullptr;
+    llvm::StringRef rest(source.data() + offset, source.size() - offset);
+    auto candidates = m_byHead.equal_range(headKey(rest, column));
+    for (auto it = candidates.first; it != candidates.second; ++it) {
+        Declaration &kept = m_declarations[it->second];
+        if (kept.node && kept.enumsDigest == enumsDigest && rest.startswith(kept.text)) return &kept;
+    }
+    return nullptr;
+}
+
+void IncrementalParser::index()
+{
+    m_byHead.clear();
+    for (size_t i = 0; i < m_declarations.size(); ++i) {
+        const Declaration &kept = m_declarations[i];
+        m_byHead.emplace(headKey(kept.text, kept.column), i);
+    }
+}
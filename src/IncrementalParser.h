@@ -0,0 +1,85 @@
+// src/IncrementalParser.h - Reparsing only the declarations an edit touched
+// An editor asks for diagnostics after every edit, and each check lexed and
+// parsed the whole file again, so the wait grew with the file. An
+// IncrementalParser keeps one file's top-level declarations from its last
+// parse, keyed by a hash of the text each one starts with. The next parse
+// walks the new text statement by statement; wherever a kept declaration's
+// source text appears again at a statement boundary, at the same column and
+// with the same enums in scope, it is taken as it is instead of being lexed
+// and parsed. Only what the edit touched, and the few kinds of top-level
+// statement whose end depends on what follows them, are parsed again.
+//
+// A reused declaration has its line numbers moved to where it now sits and
+// the types analysis recorded on it cleared, since what it refers to may have
+// changed. Enum declarations are always parsed, because later statements fold
+// their members. The result is the tree a full parse would have produced.
+//
+// The statements are lent to the program, not copied: reclaim() takes them
+// back once analysis is done. Nothing may rewrite them in between, and the
+// AST optimizer and code generation do, so this is for checking only
+// (cscript --lsp).
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include "AST.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class IncrementalParser
+{
+public:
+    using EnumTable = std::map<std::string, std::map<std::string, long long>>;
+
+    struct Stats {
+        size_t reused = 0;   // declarations taken from the previous parse
+        size_t parsed = 0;   // statements lexed and parsed
+        size_t tokens = 0;   // tokens lexed doing so
+    };
+
+    // Parses `source`, one module's text, after modules that declared `enums`.
+    // Returns null after a syntax error, which error() then describes; the
+    // declarations kept from before stay for the next attempt.
+    std::unique_ptr<ProgramNode> parse(const std::string &source, const EnumTable &enums);
+    const std::string &error() const { return m_error; }
+    // `enums` plus those this module declares
+    const EnumTable &knownEnums() const { return m_enums; }
+    const Stats &stats() const { return m_stats; }
+
+    // Takes back the statements the last parse returned. They must be the
+    // last statements of `program`, in order, as they are when the module
+    // is the entry point of a linked program. Call once nothing reads them.
+    void reclaim(ProgramNode &program);
+
+private:
+    // A top-level declaration and where its text was
+    struct Declaration {
+        std::string text;            // first token to last, as written
+        int line = 0;                // of its first token
+        int column = 0;
+        size_t enumsDigest = 0;      // the enums in scope when it was parsed
+        bool exported = false;
+        std::unique_ptr<StatementNode> node;   // null while lent out
+    };
+
+    std::vector<Declaration> m_declarations;
+    std::unordered_multimap<size_t, size_t> m_byHead;   // head hash -> index
+    // What the program returned by the last parse holds, statement by
+    // statement: a declaration to keep once reclaimed, or one (with no text)
+    // to let go of
+    std::vector<Declaration> m_lent;
+    EnumTable m_enums;
+    std::string m_error;
+    Stats m_stats;
+
+    // A kept declaration whose text starts `source` at `offset`, if any
+    Declaration *findReusable(const std::string &source, size_t offset, int column,
+                              size_t enumsDigest);
+    void index();
+};
+
+#endif // INCREMENTAL_PARSER_H
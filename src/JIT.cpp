@@ -0,0 +1,148 @@
+// src/JIT.cpp - In-process execution for `cscript --jit`
+#include "JIT.h"
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ORC reports failures as llvm::Error; the driver reports them as exceptions
+[[noreturn]] void throwLLVMError(const std::string &context, llvm::Error error)
+{
+    throw std::runtime_error(context + ": " + llvm::toString(std::move(error)));
+}
+
+template <typename T>
+T unwrap(llvm::Expected<T> value, const std::string &context)
+{
+    if (!value) throwLLVMError(context, value.takeError());
+    return std::move(*value);
+}
+
+} // namespace
+
+JITRunner::JITRunner()
+{
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    m_jit = unwrap(llvm::orc::LLJITBuilder().create(), "Could not create the JIT");
+
+    // Anything the JIT'd code needs that isn't defined by it or a library we
+    // add — printf, malloc, operator new, the C++ runtime behind libcypescript —
+    // is already loaded into cscript itself.
+    char prefix = m_jit->getDataLayout().getGlobalPrefix();
+    m_jit->getMainJITDylib().addGenerator(unwrap(
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(prefix),
+        "Could not expose process symbols to the JIT"));
+}
+
+JITRunner::~JITRunner() = default;
+
+void JITRunner::addStaticLibrary(const std::string &path)
+{
+    m_jit->getMainJITDylib().addGenerator(unwrap(
+        llvm::orc::StaticLibraryDefinitionGenerator::Load(m_jit->getObjLinkingLayer(),
+                                                          path.c_str()),
+        "Could not load " + path));
+}
+
+void JITRunner::addSharedLibrary(const std::string &path)
+{
+    char prefix = m_jit->getDataLayout().getGlobalPrefix();
+    m_jit->getMainJITDylib().addGenerator(unwrap(
+        llvm::orc::DynamicLibrarySearchGenerator::Load(path.c_str(), prefix),
+        "Could not load " + path));
+}
+
+void JITRunner::addObjectFile(const std::string &path)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        throw std::runtime_error("Could not read " + path + ": " + buffer.getError().message());
+    }
+    if (llvm::Error error = m_jit->addObjectFile(std::move(*buffer))) {
+        throwLLVMError("Could not add " + path + " to the JIT", std::move(error));
+    }
+}
+
+bool JITRunner::addLibraryByName(const std::string &name,
+                                 const std::vector<std::string> &searchDirs)
+{
+#if defined(__APPLE__)
+    const char *sharedSuffix = ".dylib";
+#elif defined(_WIN32)
+    const char *sharedSuffix = ".dll";
+#else
+    const char *sharedSuffix = ".so";
+#endif
+    // Same preference as a static link line: the first directory that has
+    // either form wins, and within it the shared library wins
+    for (const std::string &dir : searchDirs) {
+        std::error_code ec;
+        fs::path shared = fs::path(dir) / ("lib" + name + sharedSuffix);
+        if (fs::exists(shared, ec)) {
+            addSharedLibrary(shared.string());
+            return true;
+        }
+        fs::path archive = fs::path(dir) / ("lib" + name + ".a");
+        if (fs::exists(archive, ec)) {
+            addStaticLibrary(archive.string());
+            return true;
+        }
+    }
+
+    // Not in any explicit directory: let the dynamic loader search its own path
+    std::string soname = "lib" + name + sharedSuffix;
+    char prefix = m_jit->getDataLayout().getGlobalPrefix();
+    auto generator = llvm::orc::DynamicLibrarySearchGenerator::Load(soname.c_str(), prefix);
+    if (!generator) {
+        llvm::consumeError(generator.takeError());
+        return false;
+    }
+    m_jit->getMainJITDylib().addGenerator(std::move(*generator));
+    return true;
+}
+
+int JITRunner::runMain(std::unique_ptr<llvm::LLVMContext> context,
+                       std::unique_ptr<llvm::Module> module)
+{
+    if (module) {
+        llvm::orc::ThreadSafeModule threadSafeModule(
+            std::move(module), llvm::orc::ThreadSafeContext(std::move(context)));
+        if (llvm::Error error = m_jit->addIRModule(std::move(threadSafeModule))) {
+            throwLLVMError("Could not add the program to the JIT", std::move(error));
+        }
+    }
+
+    auto symbol = unwrap(m_jit->lookup("main"), "The program has no main to run");
+    // lookup() returns an ExecutorAddr from LLVM 15 on, a JITEvaluatedSymbol before
+#if LLVM_VERSION_MAJOR >= 15
+    auto *entry = symbol.toPtr<int (*)()>();
+#else
+    auto *entry = reinterpret_cast<int (*)()>(static_cast<uintptr_t>(symbol.getAddress()));
+#endif
+
+    if (llvm::Error error = m_jit->initialize(m_jit->getMainJITDylib())) {
+        throwLLVMError("Static initialization failed", std::move(error));
+    }
+    int status = entry();
+    // The program printed through this process's stdio; make sure it lands
+    // before anything cscript prints afterwards
+    std::fflush(stdout);
+    if (llvm::Error error = m_jit->deinitialize(m_jit->getMainJITDylib())) {
+        throwLLVMError("Static finalization failed", std::move(error));
+    }
+    return status;
+}
@@ -0,0 +1,50 @@
+// src/JIT.h - In-process execution for `cscript --jit`
+// Hands the optimized module to an ORC LLJIT instance and calls its `main`
+// directly. The runtime archive, `link source` objects and `link` libraries are
+// resolved inside this process, so a run writes no executable, no object files
+// and no IR to disk — it starts as soon as codegen is done.
+#ifndef JIT_H
+#define JIT_H
+
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class JITRunner
+{
+public:
+    // Builds the JIT for the host and makes every symbol already in this
+    // process (libc, the C++ runtime) visible to JIT'd code.
+    // Throws std::runtime_error on failure, like every other stage.
+    JITRunner();
+    ~JITRunner();
+
+    // libcypescript.a, or any other static archive: members are linked lazily,
+    // only when something refers to a symbol they define
+    void addStaticLibrary(const std::string &path);
+    // A shared library, made visible for symbol resolution (dlopen semantics)
+    void addSharedLibrary(const std::string &path);
+    // A relocatable object, read into memory; the file itself can be deleted
+    // as soon as this returns
+    void addObjectFile(const std::string &path);
+
+    // Resolves a `-l<name>` against `searchDirs` the way the linker would —
+    // static archive or shared library — falling back to the loader's own
+    // search path. Returns false if nothing could be found.
+    bool addLibraryByName(const std::string &name, const std::vector<std::string> &searchDirs);
+
+    // Takes ownership of the module (and the context it lives in), runs static
+    // initializers, calls `main` and returns its exit status. `module` may be
+    // null when the program was already added as an object (a cache hit).
+    int runMain(std::unique_ptr<llvm::LLVMContext> context,
+                std::unique_ptr<llvm::Module> module);
+
+private:
+    std::unique_ptr<llvm::orc::LLJIT> m_jit;
+};
+
+#endif // JIT_H
@@ -0,0 +1,188 @@
+// src/LanguageServer.cpp - `cscript --lsp`: diagnostics over the Language Server Protocol
+#include "LanguageServer.h"
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cctype>
+#include <map>
+#include <string>
+
+namespace LanguageServer
+{
+
+namespace {
+
+// JSON-RPC error codes used here
+constexpr int64_t kParseError = -32700;
+constexpr int64_t kInvalidRequest = -32600;
+constexpr int64_t kMethodNotFound = -32601;
+
+// One message: `Content-Length: N` and any other headers, a blank line, then
+// N bytes of JSON. False at end of input or on a malformed header.
+bool readMessage(std::istream &in, std::string &body)
+{
+    size_t length = 0;
+    bool haveLength = false;
+    std::string header;
+    while (std::getline(in, header)) {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+        if (header.empty()) {
+            if (!haveLength) continue;   // stray blank line between messages
+            body.assign(length, '\0');
+            return static_cast<bool>(in.read(&body[0], static_cast<std::streamsize>(length)));
+        }
+        static const std::string kContentLength = "Content-Length:";
+        if (header.compare(0, kContentLength.size(), kContentLength) == 0) {
+            try {
+                length = std::stoul(header.substr(kContentLength.size()));
+            } catch (const std::exception &) {
+                return false;
+            }
+            haveLength = true;
+        }
+    }
+    return false;
+}
+
+void writeMessage(std::ostream &out, llvm::json::Value message)
+{
+    std::string body;
+    llvm::raw_string_ostream(body) << message;
+    out << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+    out.flush();
+}
+
+void respond(std::ostream &out, const llvm::json::Value &id, llvm::json::Value result)
+{
+    writeMessage(out, llvm::json::Object{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+}
+
+void respondError(std::ostream &out, const llvm::json::Value &id, int64_t code, const std::string &message)
+{
+    writeMessage(out, llvm::json::Object{
+                          {"jsonrpc", "2.0"},
+                          {"id", id},
+                          {"error", llvm::json::Object{{"code", code}, {"message", message}}},
+                      });
+}
+
+void publish(std::ostream &out, const std::string &uri, const std::vector<Diagnostic> &diagnostics)
+{
+    llvm::json::Array items;
+    for (const Diagnostic &diagnostic : diagnostics) {
+        // LSP positions are 0-based; a message without one goes on the first line
+        int64_t line = diagnostic.line > 0 ? diagnostic.line - 1 : 0;
+        int64_t column = diagnostic.column > 0 ? diagnostic.column - 1 : 0;
+        llvm::json::Object position{{"line", line}, {"character", column}};
+        llvm::json::Object end{{"line", line}, {"character", column + 1}};
+        items.push_back(llvm::json::Object{
+            {"range", llvm::json::Object{{"start", std::move(position)}, {"end", std::move(end)}}},
+            {"severity", 1},
+            {"source", "cscript"},
+            {"message", diagnostic.message},
+        });
+    }
+    writeMessage(out, llvm::json::Object{
+                          {"jsonrpc", "2.0"},
+                          {"method", "textDocument/publishDiagnostics"},
+                          {"params", llvm::json::Object{{"uri", uri}, {"diagnostics", std::move(items)}}},
+                      });
+}
+
+} // namespace
+
+std::string pathFromUri(const std::string &uri)
+{
+    static const std::string kScheme = "file://";
+    if (uri.compare(0, kScheme.size(), kScheme) != 0) return "";
+    std::string path;
+    for (size_t i = kScheme.size(); i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+            path += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            path += uri[i];
+        }
+    }
+#ifdef _WIN32
+    // file:///C:/dir -> C:/dir
+    if (path.size() > 2 && path[0] == '/' && path[2] == ':') path.erase(0, 1);
+#endif
+    return path;
+}
+
+int serve(std::istream &in, std::ostream &out, const Checker &check,
+          const std::function<void(const std::string &path)> &closed)
+{
+    std::map<std::string, std::string> documents;   // uri -> path
+    bool shutdownRequested = false;
+
+    auto checkDocument = [&](const std::string &uri, const std::string &text) {
+        auto document = documents.find(uri);
+        if (document == documents.end() || document->second.empty()) return;
+        publish(out, uri, check(document->second, text));
+    };
+
+    std::string body;
+    while (readMessage(in, body)) {
+        llvm::Expected<llvm::json::Value> parsed = llvm::json::parse(body);
+        if (!parsed) {
+            respondError(out, nullptr, kParseError, llvm::toString(parsed.takeError()));
+            continue;
+        }
+        const llvm::json::Object *message = parsed->getAsObject();
+        if (!message) {
+            respondError(out, nullptr, kInvalidRequest, "Expected a JSON-RPC message object");
+            continue;
+        }
+        llvm::StringRef method = message->getString("method").getValueOr("");
+        const llvm::json::Value *id = message->get("id");
+        llvm::json::Value requestId = id ? *id : llvm::json::Value(nullptr);
+        const llvm::json::Object *params = message->getObject("params");
+        const llvm::json::Object *textDocument = params ? params->getObject("textDocument") : nullptr;
+        std::string uri = textDocument ? textDocument->getString("uri").getValueOr("").str() : "";
+
+        if (method == "initialize") {
+            respond(out, requestId, llvm::json::Object{
+                                  {"capabilities", llvm::json::Object{
+                                                       {"textDocumentSync", llvm::json::Object{
+                                                                                {"openClose", true},
+                                                                                {"change", 1},   // full text
+                                                                            }},
+                                                   }},
+                                  {"serverInfo", llvm::json::Object{{"name", "cscript"}}},
+                              });
+        } else if (method == "shutdown") {
+            shutdownRequested = true;
+            respond(out, requestId, nullptr);
+        } else if (method == "exit") {
+            return shutdownRequested ? 0 : 1;
+        } else if (method == "textDocument/didOpen" && !uri.empty()) {
+            documents[uri] = pathFromUri(uri);
+            checkDocument(uri, textDocument->getString("text").getValueOr("").str());
+        } else if (method == "textDocument/didChange" && !uri.empty()) {
+            // Full sync: the last change holds the whole text
+            const llvm::json::Array *changes = params->getArray("contentChanges");
+            if (changes && !changes->empty()) {
+                const llvm::json::Object *change = changes->back().getAsObject();
+                if (change) checkDocument(uri, change->getString("text").getValueOr("").str());
+            }
+        } else if (method == "textDocument/didClose" && !uri.empty()) {
+            auto document = documents.find(uri);
+            if (document != documents.end()) {
+                if (!document->second.empty()) closed(document->second);
+                documents.erase(document);
+            }
+            publish(out, uri, {});
+        } else if (id) {
+            respondError(out, requestId, shutdownRequested ? kInvalidRequest : kMethodNotFound,
+                         shutdownRequested ? "The server is shutting down"
+                                           : "Unsupported method: " + method.str());
+        }
+    }
+    return 1;   // input closed without an exit
+}
+
+} // namespace LanguageServer
@@ -0,0 +1,42 @@
+// src/LanguageServer.h - `cscript --lsp`: diagnostics over the Language Server Protocol
+// An editor with an LSP client starts `cscript --lsp` and speaks JSON-RPC to it
+// on stdin and stdout. The server holds the text of every open document, as
+// the editor has it rather than as it was last saved, checks it again after
+// each change and publishes the result as the document's diagnostics.
+//
+// Only what diagnostics need is implemented: initialize/shutdown/exit and
+// full-text document sync (didOpen, didChange, didClose). Other requests are
+// answered with MethodNotFound, other notifications ignored.
+#ifndef LANGUAGE_SERVER_H
+#define LANGUAGE_SERVER_H
+
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace LanguageServer
+{
+
+struct Diagnostic {
+    int line = 0;     // 1-based; 0 when the message names no position
+    int column = 0;
+    std::string message;
+};
+
+// Checks the document at `path` whose current text is `text`
+using Checker = std::function<std::vector<Diagnostic>(const std::string &path, const std::string &text)>;
+
+// Serves the client on `in` and `out` until it sends `exit` or closes `in`.
+// `closed` is told when a document is closed. Returns 0 if the client asked
+// for shutdown before exiting, 1 otherwise, as the protocol specifies.
+int serve(std::istream &in, std::ostream &out, const Checker &check,
+          const std::function<void(const std::string &path)> &closed);
+
+// `file:///a%20b.csc` -> `/a b.csc`; empty for any other scheme
+std::string pathFromUri(const std::string &uri);
+
+} // namespace LanguageServer
+
+#endif // LANGUAGE_SERVER_H
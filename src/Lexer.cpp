@@ -9,6 +9,9 @@
 // Constructor
 Lexer::Lexer(std::string_view source) : m_source(source), m_currentPos(0) {}
 
+Lexer::Lexer(std::string_view source, int line, int column)
+    : m_source(source), m_currentPos(0), m_line(line), m_col(column) {}
+
 // --- Private Helper Methods ---
 
 bool Lexer::isAtEnd() const {
@@ -130,10 +133,10 @@ Token Lexer::makeIdentifier() {
     
     auto it = keywords.find(value);
     if (it != keywords.end()) {
-        return Token(it->second, std::string(value));
+        return Token(it->second, value);
     }
     
-    return Token(TOK_IDENTIFIER, std::string(value));
+    return Token(TOK_IDENTIFIER, value);
 }
 
 Token Lexer::makeStringLiteral() {
@@ -141,17 +144,19 @@ Token Lexer::makeStringLiteral() {
     
     const size_t startPos = m_currentPos;
     std::string result;
+    bool escaped = false;
     
     while (peek() != '"' && !isAtEnd()) {
         if (peek() == '\\') {
+            escaped = true;
             advance(); // consume backslash
             if (isAtEnd()) {
                 return errorToken("Unterminated string literal");
             }
             
             // Handle escape sequences
-            char escaped = peek();
-            switch (escaped) {
+            char sequence = peek();
+            switch (sequence) {
                 case 'n': result += '\n'; break;
                 case 't': result += '\t'; break;
                 case 'r': result += '\r'; break;
@@ -159,7 +164,7 @@ Token Lexer::makeStringLiteral() {
                 case '"': result += '"'; break;
                 case '0': result += '\0'; break;
                 default:
-                    result += escaped; // Keep unknown escapes as-is
+                    result += sequence; // Keep unknown escapes as-is
                     break;
             }
             advance();
@@ -173,8 +178,11 @@ Token Lexer::makeStringLiteral() {
         return errorToken("Unterminated string literal");
     }
     
+    // Without escapes the literal's text is exactly its slice of the source
+    std::string_view text = escaped ? own(std::move(result))
+                                    : m_source.substr(startPos, m_currentPos - startPos);
     advance(); // consume closing quote
-    return Token(TOK_STRING_LITERAL, result);
+    return Token(TOK_STRING_LITERAL, text);
 }
 
 Token Lexer::makeTemplateLiteral() {
@@ -248,15 +256,16 @@ Token Lexer::makeTemplateLiteral() {
         first = false;
         if (piece.isExpr) {
             expansion.emplace_back(TOK_LPAREN, "(");
-            Lexer subLexer(piece.text);
+            Lexer subLexer(own(piece.text));
             Token sub;
             while ((sub = subLexer.getNextToken()).type != TOK_EOF) {
                 if (sub.type == TOK_UNKNOWN) return errorToken("Invalid expression in template literal");
                 expansion.push_back(sub);
             }
+            m_ownedText.splice(m_ownedText.end(), subLexer.m_ownedText);
             expansion.emplace_back(TOK_RPAREN, ")");
         } else {
-            expansion.emplace_back(TOK_STRING_LITERAL, piece.text);
+            expansion.emplace_back(TOK_STRING_LITERAL, own(piece.text));
         }
     }
     if (first) {
@@ -328,20 +337,25 @@ Token Lexer::makeIntegerLiteral() {
             }
             
             std::string_view value = m_source.substr(startPos, m_currentPos - startPos);
-            return Token(TOK_FLOAT_LITERAL, std::string(value));
+            return Token(TOK_FLOAT_LITERAL, value);
         }
     }
     
     std::string_view value = m_source.substr(startPos, m_currentPos - startPos);
-    return Token(TOK_INT_LITERAL, std::string(value));
+    return Token(TOK_INT_LITERAL, value);
 }
 
 Token Lexer::makeToken(TokenType type, const char* start, size_t length) {
-    return Token(type, std::string(start, length));
+    return Token(type, std::string_view(start, length));
 }
 
 Token Lexer::errorToken(const char* message) {
-    return Token(TOK_UNKNOWN, std::string("Error: ") + message);
+    return Token(TOK_UNKNOWN, own(std::string("Error: ") + message));
+}
+
+std::string_view Lexer::own(std::string text) {
+    m_ownedText.push_back(std::move(text));
+    return m_ownedText.back();
 }
 
 // --- Public Method ---
@@ -482,7 +496,7 @@ Token Lexer::scanToken() {
     
     // Single-character tokens
     TokenType type = TOK_UNKNOWN;
-    std::string value(1, c);
+    std::string_view value = m_source.substr(m_currentPos, 1);
     
     switch (c) {
         case '(': type = TOK_LPAREN; break;
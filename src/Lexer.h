@@ -6,12 +6,16 @@
 #include <string>
 #include <string_view>
 #include <deque>
+#include <list>
 
 class Lexer {
 private:
     std::string_view m_source; // View into the source code string
     size_t m_currentPos = 0;   // Current position in the source string
     std::deque<Token> m_pending; // Tokens queued by multi-token constructs (template literals)
+    // Token text that is not a slice of m_source. A list, so that adding to it
+    // (or splicing a sub-lexer's into it) never moves a string a token views.
+    std::list<std::string> m_ownedText;
     int m_line = 1;            // Current line (1-based)
     int m_col = 1;             // Current column (1-based)
 
@@ -29,11 +33,15 @@ private:
     Token makeTemplateLiteral(); // Desugars `a ${x} b` into ("a" + (x) + " b")
     Token makeToken(TokenType type, const char* start, size_t length);
     Token errorToken(const char* message);
+    std::string_view own(std::string text); // Keeps text alive as long as the lexer
 
 
 public:
     // Constructor takes the source code as input
     explicit Lexer(std::string_view source);
+    // Lexes text that starts part-way into a file, at the given 1-based line
+    // and column, so token positions are still the file's
+    Lexer(std::string_view source, int line, int column);
 
     // The main method to get the next token from the stream
     Token getNextToken();
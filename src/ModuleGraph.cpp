@@ -0,0 +1,306 @@
+// src/ModuleGraph.cpp - The program's modules and the imports between them
+#include "ModuleGraph.h"
+
+#include "CompileCache.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+#include "llvm/Support/TimeProfiler.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef CYPESCRIPT_VERSION
+#define CYPESCRIPT_VERSION "dev"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool startsWith(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string trim(const std::string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// `import { a, b } from "./m";` -> names {a, b}, specifier "./m"
+ModuleGraph::Import parseImportLine(const std::string &line, int lineNumber)
+{
+    size_t firstQuote = line.find('"');
+    size_t lastQuote = line.rfind('"');
+    if (firstQuote == std::string::npos || lastQuote <= firstQuote) {
+        throw std::runtime_error("Malformed import statement: " + line);
+    }
+    ModuleGraph::Import import;
+    import.requestedAs = line.substr(firstQuote + 1, lastQuote - firstQuote - 1);
+    import.line = lineNumber;
+
+    size_t open = line.find('{');
+    size_t close = line.find('}');
+    if (open != std::string::npos && close != std::string::npos && open < close &&
+        close < firstQuote) {
+        std::stringstream list(line.substr(open + 1, close - open - 1));
+        std::string name;
+        while (std::getline(list, name, ',')) {
+            name = trim(name);
+            if (name.empty()) continue;
+            if (name.find_first_of(" \t") != std::string::npos) {
+                throw std::runtime_error("Malformed import statement: " + line);
+            }
+            import.names.push_back(name);
+        }
+    }
+    return import;
+}
+
+// The names a top-level statement introduces
+void collectDeclaredNames(const StatementNode *stmt, std::set<std::string> &names)
+{
+    if (auto *fn = nodeCast<const FunctionDeclarationNode>(stmt)) {
+        names.insert(fn->functionName);
+    } else if (auto *var = nodeCast<const VariableDeclarationNode>(stmt)) {
+        names.insert(var->variableName);
+    } else if (auto *destruct = nodeCast<const DestructuringDeclarationNode>(stmt)) {
+        names.insert(destruct->bindings.begin(), destruct->bindings.end());
+    } else if (auto *cls = nodeCast<const ClassDeclarationNode>(stmt)) {
+        names.insert(cls->className);
+    } else if (auto *iface = nodeCast<const InterfaceDeclarationNode>(stmt)) {
+        names.insert(iface->interfaceName);
+    } else if (auto *enumNode = nodeCast<const EnumDeclarationNode>(stmt)) {
+        names.insert(enumNode->enumName);
+    } else if (auto *ext = nodeCast<const ExternDeclarationNode>(stmt)) {
+        names.insert(ext->functionName);
+    } else if (auto *alias = nodeCast<const TypeAliasNode>(stmt)) {
+        names.insert(alias->aliasName);
+    }
+}
+
+// A parsed module's declarations and exports
+void collectModuleNames(ModuleGraph::Module &module)
+{
+    for (const auto &stmt : module.ast->statements) {
+        collectDeclaredNames(stmt.get(), module.declarations);
+    }
+    for (const StatementNode *stmt : module.ast->exported) {
+        collectDeclaredNames(stmt, module.exports);
+    }
+}
+
+} // namespace
+
+ModuleGraph::ModuleGraph(fs::path bundledModules) : m_bundledModules(std::move(bundledModules))
+{
+}
+
+void ModuleGraph::load(const std::string &entryFile,
+                       const std::function<void(const Token &)> &onToken)
+{
+    m_onToken = onToken;
+    if (!fs::exists(entryFile) && !m_overlays.count(fs::weakly_canonical(entryFile).string())) {
+        throw std::runtime_error("File does not exist: " + entryFile);
+    }
+    loadModule(entryFile, "");
+    for (const auto &module : m_modules) checkImports(*module);
+}
+
+fs::path ModuleGraph::resolveImport(const fs::path &importerDir,
+                                    const std::string &specifier) const
+{
+    // A bare name like "game" resolves against the modules bundled with the
+    // compiler; anything relative or absolute resolves as written
+    bool isRelative = startsWith(specifier, "./") || startsWith(specifier, "../") ||
+                      startsWith(specifier, "/");
+    fs::path resolved = importerDir / specifier;
+    if (!isRelative && !m_bundledModules.empty() && !fs::exists(resolved) &&
+        !fs::exists(resolved.string() + ".csc")) {
+        resolved = m_bundledModules / specifier;
+    }
+    if (resolved.extension().empty()) resolved += ".csc";
+    return resolved.lexically_normal();
+}
+
+ModuleGraph::Module &ModuleGraph::loadModule(const fs::path &file, const std::string &requestedAs)
+{
+    // Canonical for a file on disk; an editor's buffer that was never saved
+    // has no file to resolve, so what exists of its path is resolved instead
+    std::string canonical = fs::weakly_canonical(file).string();
+    auto overlaid = m_overlays.find(canonical);
+    if (overlaid == m_overlays.end() && !fs::exists(file)) {
+        std::string message = "Imported module not found: " + file.string();
+        // A bare name like "game" is meant to come from the compiler's own
+        // bundled modules. Say where we looked — the usual cause is a cscript
+        // on PATH that is older than the modules the program expects.
+        if (!requestedAs.empty() && requestedAs.find('/') == std::string::npos) {
+            message += "\n  '" + requestedAs + "' looks like a bundled module. Searched: ";
+            message += m_bundledModules.empty()
+                ? "(no bundled module directory found next to this compiler)"
+                : m_bundledModules.string();
+            message += "\n  This cscript is " + std::string(CYPESCRIPT_VERSION) +
+                       ". If it predates the module you want, rebuild or reinstall it.";
+        }
+        throw std::runtime_error(message);
+    }
+
+    auto known = m_byPath.find(canonical);
+    if (known != m_byPath.end()) {
+        return *known->second; // already loaded, or an import cycle back to it
+    }
+
+    auto module = std::make_unique<Module>();
+    module->path = canonical;
+    module->displayName = file.string();
+    m_byPath[canonical] = module.get();
+
+    std::ifstream fileStream;
+    std::istringstream overlayStream;
+    if (overlaid != m_overlays.end()) {
+        overlayStream.str(overlaid->second);
+    } else {
+        fileStream.open(file);
+        if (!fileStream) {
+            throw std::runtime_error("Could not open module: " + file.string());
+        }
+    }
+    std::istream &in = overlaid != m_overlays.end() ? static_cast<std::istream &>(overlayStream)
+                                                    : fileStream;
+    bool isEntry = m_byPath.size() == 1;
+
+    // Import lines become blank lines: the module's own text keeps every
+    // position, and the imported modules are loaded (and parsed) first
+    std::stringstream text;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::string trimmed = trim(line);
+        if (startsWith(trimmed, "import ") || startsWith(trimmed, "import{")) {
+            Import import = parseImportLine(line, lineNumber);
+            Module &target = loadModule(resolveImport(file.parent_path(), import.requestedAs),
+                                        import.requestedAs);
+            import.target = target.path;
+            module->imports.push_back(std::move(import));
+            text << "\n";
+        } else {
+            text << line << "\n";
+        }
+    }
+    module->source = text.str();
+
+    auto reusable = m_onToken ? m_reusable.end() : m_reusable.find(canonical);
+    if (reusable != m_reusable.end() && reusable->second->source == module->source &&
+        reusable->second->ast) {
+        Module &prepared = *reusable->second;
+        module->ast = std::move(prepared.ast);
+        module->exports = std::move(prepared.exports);
+        module->declarations = std::move(prepared.declarations);
+        module->tokenCount = prepared.tokenCount;
+        module->enums = std::move(prepared.enums);
+        m_enums.insert(module->enums.begin(), module->enums.end());
+        m_reusable.erase(reusable);
+    } else if (isEntry && m_entryParser && !m_onToken) {
+        parseIncrementally(*module);
+    } else {
+        parse(*module);
+    }
+    m_modules.push_back(std::move(module));
+    return *m_modules.back();
+}
+
+void ModuleGraph::parse(Module &module)
+{
+    // The lexer runs on demand, one token ahead of the parser, so the module's
+    // tokens are never all held at once
+    llvm::TimeTraceScope scope("Parse", module.displayName);
+    Lexer lexer(module.source);
+    Parser parser(lexer, m_onToken);
+    parser.addKnownEnums(m_enums);
+    module.ast = parser.parse();
+    module.tokenCount = parser.tokenCount();
+    if (!module.ast) {
+        throw std::runtime_error(module.displayName + ": " + parser.error());
+    }
+    m_enums = parser.knownEnums();
+    module.enums = m_enums;
+    collectModuleNames(module);
+}
+
+void ModuleGraph::parseIncrementally(Module &module)
+{
+    llvm::TimeTraceScope scope("Parse", module.displayName);
+    module.ast = m_entryParser->parse(module.source, m_enums);
+    if (!module.ast) {
+        throw std::runtime_error(module.displayName + ": " + m_entryParser->error());
+    }
+    module.tokenCount = m_entryParser->stats().tokens;
+    m_enums = m_entryParser->knownEnums();
+    module.enums = m_enums;
+    collectModuleNames(module);
+}
+
+void ModuleGraph::overlay(const std::string &file, std::string text)
+{
+    m_overlays[fs::weakly_canonical(file).string()] = std::move(text);
+}
+
+void ModuleGraph::reuseParsed(ModuleGraph &prepared)
+{
+    for (auto &module : prepared.m_modules) {
+        if (module->ast) m_reusable[module->path] = std::move(module);
+    }
+    prepared.m_modules.clear();
+    prepared.m_byPath.clear();
+}
+
+void ModuleGraph::checkImports(const Module &module) const
+{
+    for (const Import &import : module.imports) {
+        const Module &target = *m_byPath.at(import.target);
+        const std::set<std::string> &visible =
+            target.exports.empty() ? target.declarations : target.exports;
+        for (const std::string &name : import.names) {
+            if (visible.count(name)) continue;
+            std::string message = "Import Error: \"" + import.requestedAs + "\" has no export named '" +
+                                  name + "' at line " + std::to_string(import.line) + " of " +
+                                  module.displayName;
+            if (target.declarations.count(name)) {
+                message += " (it is declared there, but not marked `export`)";
+            }
+            throw std::runtime_error(message);
+        }
+    }
+}
+
+std::string ModuleGraph::digest() const
+{
+    CompileCache::Key key;
+    for (const auto &module : m_modules) key.add(module->path, module->source);
+    return key.digest();
+}
+
+std::unique_ptr<ProgramNode> ModuleGraph::link()
+{
+    auto program = std::make_unique<ProgramNode>();
+    bool recordOrigins = m_modules.size() > 1;
+    for (const auto &module : m_modules) {
+        if (!module->ast) {
+            throw std::runtime_error("Module " + module->displayName + " was already linked");
+        }
+        for (auto &stmt : module->ast->statements) {
+            program->statements.push_back(std::move(stmt));
+            if (recordOrigins) program->statementOrigins.push_back(module->displayName);
+        }
+        program->exported.insert(program->exported.end(), module->ast->exported.begin(),
+                                 module->ast->exported.end());
+        module->ast.reset();
+    }
+    return program;
+}
@@ -0,0 +1,111 @@
+// src/ModuleGraph.h - The program's modules and the imports between them
+// Every `.csc` file reachable from the entry point is read and parsed exactly
+// once, into its own AST, with source positions that match its own file. Each
+// module keeps an export table (its `export` declarations) against which the
+// names in `import { a, b } from "./m";` are checked. link() then joins the
+// modules into the single program the later stages work on, dependencies first.
+//
+//   import { square } from "./math";   // relative to the importing file
+//   import { } from "game";            // bare name: the compiler's own lib/
+//
+// A module that exports nothing explicitly (lib/game.csc is one) exposes every
+// top-level declaration, the way a header does.
+#ifndef MODULE_GRAPH_H
+#define MODULE_GRAPH_H
+
+#include "AST.h"
+#include "IncrementalParser.h"
+#include "Token.h"
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class ModuleGraph
+{
+public:
+    struct Import {
+        std::vector<std::string> names;   // empty for `import { } from ...`
+        std::string requestedAs;          // the specifier as written
+        std::string target;               // canonical path of the imported module
+        int line = 0;
+    };
+
+    struct Module {
+        std::string path;          // canonical; what identifies the module
+        std::string displayName;   // the path as the user would write it
+        // The file's text with its import lines blanked, so every line and
+        // column the lexer reports is still right for the file on disk
+        std::string source;
+        std::vector<Import> imports;
+        std::unique_ptr<ProgramNode> ast;  // moved out by link()
+        std::set<std::string> exports;
+        std::set<std::string> declarations;
+        // Every enum the parser knew once this module was parsed
+        std::map<std::string, std::map<std::string, long long>> enums;
+        size_t tokenCount = 0;
+    };
+
+    // `bundledModules` is where bare imports like "game" are looked up
+    explicit ModuleGraph(std::filesystem::path bundledModules);
+
+    // Loads the entry file and, recursively, everything it imports. Modules are
+    // parsed dependencies first; each module sees the enums of those parsed
+    // before it. `onToken`, if set, is shown every token in that order.
+    // Throws std::runtime_error for a missing module, a parse error, or an
+    // import of a name its module does not export.
+    void load(const std::string &entryFile,
+              const std::function<void(const Token &)> &onToken = {});
+
+    // Takes over the modules `prepared` has parsed (the compile server parses
+    // the bundled ones ahead of time). A later load that finds one of them with
+    // the same text uses its AST instead of parsing it again; one whose file has
+    // changed since is parsed as usual. Not used while tokens are being shown.
+    void reuseParsed(ModuleGraph &prepared);
+
+    // Reads `file` from `text` instead of from disk: an editor's unsaved
+    // buffer. The file need not exist yet; its imports are resolved as usual,
+    // relative to the directory it would be in.
+    void overlay(const std::string &file, std::string text);
+
+    // Parses the entry file with `parser`, which keeps what it parsed of that
+    // file last time (IncrementalParser.h). The caller reclaims the entry
+    // file's statements from the linked program once it is done with them.
+    void parseEntryWith(IncrementalParser &parser) { m_entryParser = &parser; }
+
+    // Dependencies first, the entry file last
+    const std::vector<std::unique_ptr<Module>> &modules() const { return m_modules; }
+
+    // SHA-256 over every module's path and contents: equal digests mean the
+    // same program
+    std::string digest() const;
+
+    // Moves every module's statements into one program, in dependency order,
+    // recording in ProgramNode::statementOrigins where each came from when
+    // there is more than one module. Call once, after load().
+    std::unique_ptr<ProgramNode> link();
+
+private:
+    Module &loadModule(const std::filesystem::path &file, const std::string &requestedAs);
+    std::filesystem::path resolveImport(const std::filesystem::path &importerDir,
+                                        const std::string &specifier) const;
+    void parse(Module &module);
+    void parseIncrementally(Module &module);
+    void checkImports(const Module &module) const;
+
+    std::filesystem::path m_bundledModules;
+    std::vector<std::unique_ptr<Module>> m_modules;
+    std::map<std::string, Module *> m_byPath;
+    std::set<std::string> m_parsed;
+    std::map<std::string, std::map<std::string, long long>> m_enums;
+    std::map<std::string, std::unique_ptr<Module>> m_reusable;   // by canonical path
+    std::map<std::string, std::string> m_overlays;               // by canonical path
+    IncrementalParser *m_entryParser = nullptr;
+    std::function<void(const Token &)> m_onToken;
+};
+
+#endif // MODULE_GRAPH_H
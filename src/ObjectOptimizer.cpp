@@ -21,7 +21,8 @@ ObjectOptimizer::ObjectLayout ObjectOptimizer::createObjectLayout(
         info.typeName = prop.second;
         
         // Determine LLVM type and size
-        if (prop.second == "string") {
+        if (prop.second == "string" || prop.second == "ptr") {
+            // "ptr" is the hidden vtable pointer of a polymorphic class
             info.type = llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0);
             currentOffset += sizeof(void*); // Pointer size
         } else if (prop.second.substr(0, 7) == "object:") {
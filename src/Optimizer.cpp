@@ -1,9 +1,12 @@
-// src/Optimizer.cpp - AST-level constant folding and dead-branch elimination
+// src/Optimizer.cpp - AST-level constant folding, dead-branch elimination,
+// const propagation, inlining, loop-invariant hoisting and evaluation of
+// const function calls
 #include "Optimizer.h"
 
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <iterator>
 #include <string>
 
 namespace {
@@ -18,17 +21,17 @@ std::string formatDouble(double value)
 
 bool isNumericLiteral(ExpressionNode *expr, double &out, bool &isFloat)
 {
-    if (auto *intLit = dynamic_cast<IntegerLiteralNode *>(expr)) {
+    if (auto *intLit = nodeCast<IntegerLiteralNode>(expr)) {
         out = static_cast<double>(intLit->value);
         isFloat = false;
         return true;
     }
-    if (auto *floatLit = dynamic_cast<FloatLiteralNode *>(expr)) {
+    if (auto *floatLit = nodeCast<FloatLiteralNode>(expr)) {
         out = floatLit->value;
         isFloat = true;
         return true;
     }
-    if (auto *boolLit = dynamic_cast<BooleanLiteralNode *>(expr)) {
+    if (auto *boolLit = nodeCast<BooleanLiteralNode>(expr)) {
         out = boolLit->value ? 1.0 : 0.0;
         isFloat = false;
         return true;
@@ -39,42 +42,351 @@ bool isNumericLiteral(ExpressionNode *expr, double &out, bool &isFloat)
 // Renders a literal as it would appear after string concatenation at runtime
 bool literalAsString(ExpressionNode *expr, std::string &out)
 {
-    if (auto *strLit = dynamic_cast<StringLiteralNode *>(expr)) {
+    if (auto *strLit = nodeCast<StringLiteralNode>(expr)) {
         out = strLit->value;
         return true;
     }
-    if (auto *intLit = dynamic_cast<IntegerLiteralNode *>(expr)) {
+    if (auto *intLit = nodeCast<IntegerLiteralNode>(expr)) {
         out = std::to_string(intLit->value);
         return true;
     }
-    if (auto *floatLit = dynamic_cast<FloatLiteralNode *>(expr)) {
+    if (auto *floatLit = nodeCast<FloatLiteralNode>(expr)) {
         out = formatDouble(floatLit->value);
         return true;
     }
-    if (auto *boolLit = dynamic_cast<BooleanLiteralNode *>(expr)) {
+    if (auto *boolLit = nodeCast<BooleanLiteralNode>(expr)) {
         out = boolLit->value ? "1" : "0";
         return true;
     }
     return false;
 }
 
+// The type semantic analysis gives a literal; empty for anything else
+std::string literalType(const ExpressionNode *expr)
+{
+    if (nodeCast<const IntegerLiteralNode>(expr)) return "i32";
+    if (nodeCast<const FloatLiteralNode>(expr)) return "f64";
+    if (nodeCast<const BooleanLiteralNode>(expr)) return "boolean";
+    if (nodeCast<const StringLiteralNode>(expr)) return "string";
+    return "";
+}
+
+void setType(ExpressionNode *expr, const std::string &type)
+{
+    expr->resolvedType = internTypeName(type);
+    expr->typeResolved = true;
+}
+
+// The type of `left op right` for an arithmetic operator, as semantic
+// analysis and CodeGen agree on it; empty when it is not a plain number
+std::string arithmeticType(const std::string &left, const std::string &right)
+{
+    if (left == right && (left == "i32" || left == "i64" || left == "f64")) return left;
+    if ((left == "f64" && right == "i32") || (left == "i32" && right == "f64")) return "f64";
+    return "";
+}
+
+bool isArithmetic(BinaryExpressionNode::Operator op)
+{
+    switch (op) {
+        case BinaryExpressionNode::ADD:
+        case BinaryExpressionNode::SUBTRACT:
+        case BinaryExpressionNode::MULTIPLY:
+        case BinaryExpressionNode::DIVIDE:
+        case BinaryExpressionNode::MODULO:
+        case BinaryExpressionNode::BIT_AND:
+        case BinaryExpressionNode::BIT_OR:
+        case BinaryExpressionNode::BIT_XOR:
+        case BinaryExpressionNode::SHIFT_LEFT:
+        case BinaryExpressionNode::SHIFT_RIGHT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// A copy of a literal, variable, unary or binary expression tree, with each
+// read of a name in `substitutions` replaced by a copy of its expression.
+// Null if the tree holds anything else.
+std::unique_ptr<ExpressionNode> cloneExpression(
+    const ExpressionNode *expr,
+    const std::map<std::string, const ExpressionNode *> *substitutions = nullptr)
+{
+    std::unique_ptr<ExpressionNode> copy;
+    if (auto *intLit = nodeCast<const IntegerLiteralNode>(expr)) {
+        copy = std::make_unique<IntegerLiteralNode>(intLit->value);
+    } else if (auto *floatLit = nodeCast<const FloatLiteralNode>(expr)) {
+        copy = std::make_unique<FloatLiteralNode>(floatLit->value);
+    } else if (auto *boolLit = nodeCast<const BooleanLiteralNode>(expr)) {
+        copy = std::make_unique<BooleanLiteralNode>(boolLit->value);
+    } else if (auto *strLit = nodeCast<const StringLiteralNode>(expr)) {
+        copy = std::make_unique<StringLiteralNode>(strLit->value);
+    } else if (auto *varExpr = nodeCast<const VariableExpressionNode>(expr)) {
+        if (substitutions) {
+            auto it = substitutions->find(varExpr->name);
+            if (it != substitutions->end()) return cloneExpression(it->second);
+        }
+        copy = std::make_unique<VariableExpressionNode>(varExpr->name);
+    } else if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) {
+        auto operand = cloneExpression(unaryOp->operand.get(), substitutions);
+        if (!operand) return nullptr;
+        copy = std::make_unique<UnaryExpressionNode>(unaryOp->op, std::move(operand));
+    } else if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) {
+        auto left = cloneExpression(binOp->left.get(), substitutions);
+        auto right = cloneExpression(binOp->right.get(), substitutions);
+        if (!left || !right) return nullptr;
+        copy = std::make_unique<BinaryExpressionNode>(binOp->op, std::move(left), std::move(right));
+    } else {
+        return nullptr;
+    }
+    copy->line = expr->line;
+    copy->column = expr->column;
+    copy->resolvedType = expr->resolvedType;
+    copy->typeResolved = expr->typeResolved;
+    return copy;
+}
+
+// Literals and reads, combined by operators that cannot trap: evaluating one
+// any number of times, or not at all, is unobservable
+bool isPure(const ExpressionNode *expr)
+{
+    if (!literalType(expr).empty() || nodeCast<const VariableExpressionNode>(expr)) return true;
+    if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) return isPure(unaryOp->operand.get());
+    if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) {
+        if (binOp->op == BinaryExpressionNode::DIVIDE || binOp->op == BinaryExpressionNode::MODULO) {
+            return false;
+        }
+        return isPure(binOp->left.get()) && isPure(binOp->right.get());
+    }
+    return false;
+}
+
+// An inlinable function body: operators over literals and the parameters only
+bool isInlinableBody(const ExpressionNode *expr, const std::set<std::string> &params)
+{
+    if (!literalType(expr).empty()) return true;
+    if (auto *varExpr = nodeCast<const VariableExpressionNode>(expr)) return params.count(varExpr->name) > 0;
+    if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) {
+        return isInlinableBody(unaryOp->operand.get(), params);
+    }
+    if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) {
+        return isInlinableBody(binOp->left.get(), params) && isInlinableBody(binOp->right.get(), params);
+    }
+    return false;
+}
+
+int countReads(const ExpressionNode *expr, const std::string &name)
+{
+    if (auto *varExpr = nodeCast<const VariableExpressionNode>(expr)) return varExpr->name == name;
+    if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) return countReads(unaryOp->operand.get(), name);
+    if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) {
+        return countReads(binOp->left.get(), name) + countReads(binOp->right.get(), name);
+    }
+    return 0;
+}
+
+bool readsVariable(const ExpressionNode *expr)
+{
+    if (nodeCast<const VariableExpressionNode>(expr)) return true;
+    if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) return readsVariable(unaryOp->operand.get());
+    if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) {
+        return readsVariable(binOp->left.get()) || readsVariable(binOp->right.get());
+    }
+    return false;
+}
+
+// Whether splicing a block's statements into the enclosing list would move
+// declarations into the enclosing scope
+bool declaresNames(const std::vector<std::unique_ptr<StatementNode>> &stmts)
+{
+    for (const auto &stmt : stmts) {
+        if (nodeCast<VariableDeclarationNode>(stmt.get()) || nodeCast<DestructuringDeclarationNode>(stmt.get()) ||
+            nodeCast<FunctionDeclarationNode>(stmt.get()) || nodeCast<ClassDeclarationNode>(stmt.get())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Calls `visit` on each expression slot directly inside `expr`. Function bodies
+// written inside it (arrows, object-literal methods) are not entered.
+template <typename Visit>
+void forEachOperand(ExpressionNode *expr, Visit &&visit)
+{
+    if (auto *binOp = nodeCast<BinaryExpressionNode>(expr)) {
+        visit(binOp->left);
+        visit(binOp->right);
+    } else if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr)) {
+        visit(unaryOp->operand);
+    } else if (auto *update = nodeCast<UpdateExpressionNode>(expr)) {
+        visit(update->target);
+    } else if (auto *funcCall = nodeCast<FunctionCallNode>(expr)) {
+        for (auto &arg : funcCall->arguments) visit(arg);
+    } else if (auto *methodCall = nodeCast<MethodCallNode>(expr)) {
+        visit(methodCall->object);
+        for (auto &arg : methodCall->arguments) visit(arg);
+    } else if (auto *newExpr = nodeCast<NewExpressionNode>(expr)) {
+        for (auto &arg : newExpr->arguments) visit(arg);
+    } else if (auto *arrLit = nodeCast<ArrayLiteralNode>(expr)) {
+        for (auto &element : arrLit->elements) visit(element);
+    } else if (auto *objLit = nodeCast<ObjectLiteralNode>(expr)) {
+        for (auto &prop : objLit->properties) {
+            if (prop.value) visit(prop.value);
+        }
+    } else if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr)) {
+        visit(arrAccess->array);
+        visit(arrAccess->index);
+    } else if (auto *objAccess = nodeCast<ObjectAccessNode>(expr)) {
+        visit(objAccess->object);
+    }
+}
+
+// Calls `onExpression` on each expression slot of `stmt` and `onStatement` on
+// each statement nested directly in it. Function and class bodies are not
+// entered: they run where they are called, not where they are written.
+template <typename OnExpression, typename OnStatement>
+void forEachPart(StatementNode *stmt, OnExpression &&onExpression, OnStatement &&onStatement)
+{
+    auto list = [&](std::vector<std::unique_ptr<StatementNode>> &stmts) {
+        for (auto &nested : stmts) onStatement(nested.get());
+    };
+    if (auto *varDecl = nodeCast<VariableDeclarationNode>(stmt)) {
+        onExpression(varDecl->initializer);
+    } else if (auto *assign = nodeCast<AssignmentStatementNode>(stmt)) {
+        onExpression(assign->value);
+    } else if (auto *arrAssign = nodeCast<ArrayAssignmentStatementNode>(stmt)) {
+        onExpression(arrAssign->array);
+        onExpression(arrAssign->index);
+        onExpression(arrAssign->value);
+    } else if (auto *propAssign = nodeCast<ObjectPropertyAssignmentNode>(stmt)) {
+        onExpression(propAssign->object);
+        onExpression(propAssign->value);
+    } else if (auto *exprStmt = nodeCast<ExpressionStatementNode>(stmt)) {
+        onExpression(exprStmt->expression);
+    } else if (auto *ifStmt = nodeCast<IfStatementNode>(stmt)) {
+        onExpression(ifStmt->condition);
+        list(ifStmt->thenStatements);
+        list(ifStmt->elseStatements);
+    } else if (auto *whileStmt = nodeCast<WhileStatementNode>(stmt)) {
+        onExpression(whileStmt->condition);
+        list(whileStmt->bodyStatements);
+    } else if (auto *doWhileStmt = nodeCast<DoWhileStatementNode>(stmt)) {
+        list(doWhileStmt->bodyStatements);
+        onExpression(doWhileStmt->condition);
+    } else if (auto *forStmt = nodeCast<ForStatementNode>(stmt)) {
+        if (forStmt->initialization) onStatement(forStmt->initialization.get());
+        onExpression(forStmt->condition);
+        if (forStmt->increment) onStatement(forStmt->increment.get());
+        list(forStmt->bodyStatements);
+    } else if (auto *forOfStmt = nodeCast<ForOfStatementNode>(stmt)) {
+        onExpression(forOfStmt->iterable);
+        list(forOfStmt->bodyStatements);
+    } else if (auto *switchStmt = nodeCast<SwitchStatementNode>(stmt)) {
+        onExpression(switchStmt->condition);
+        for (auto &clause : switchStmt->cases) {
+            onExpression(clause.value);
+            list(clause.statements);
+        }
+    } else if (auto *tryStmt = nodeCast<TryCatchStatementNode>(stmt)) {
+        list(tryStmt->tryStatements);
+        list(tryStmt->catchStatements);
+        list(tryStmt->finallyStatements);
+    } else if (auto *retStmt = nodeCast<ReturnStatementNode>(stmt)) {
+        onExpression(retStmt->expression);
+    } else if (auto *throwStmt = nodeCast<ThrowStatementNode>(stmt)) {
+        onExpression(throwStmt->expression);
+    } else if (auto *destruct = nodeCast<DestructuringDeclarationNode>(stmt)) {
+        onExpression(destruct->initializer);
+    }
+}
+
 } // namespace
 
+void ASTOptimizer::pushScope(bool isolated)
+{
+    m_scopes.pushScope(isolated);
+    m_depth++;
+}
+
+void ASTOptimizer::popScope()
+{
+    m_scopes.popScope();
+    m_depth--;
+}
+
+void ASTOptimizer::declare(const std::string &name, Binding binding)
+{
+    binding.global = m_functionDepth == 0;
+    if (m_depth == 0) m_globals[name] = binding;
+    m_scopes[name] = std::move(binding);
+}
+
+const ASTOptimizer::Binding *ASTOptimizer::lookup(const std::string &name)
+{
+    if (const Binding *local = m_scopes.lookup(name)) return local;
+    // Module-level names remain in scope inside functions, once declared
+    auto global = m_globals.find(name);
+    return global != m_globals.end() ? &global->second : nullptr;
+}
+
+std::string ASTOptimizer::staticType(ExpressionNode *expr)
+{
+    if (!expr) return "";
+    std::string literal = literalType(expr);
+    if (!literal.empty()) return literal;
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
+        if (const Binding *binding = lookup(varExpr->name)) return binding->type;
+    } else if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr)) {
+        if (unaryOp->op == UnaryExpressionNode::NOT) return "boolean";
+        return staticType(unaryOp->operand.get());
+    } else if (auto *binOp = nodeCast<BinaryExpressionNode>(expr)) {
+        switch (binOp->op) {
+            case BinaryExpressionNode::EQUAL:
+            case BinaryExpressionNode::NOT_EQUAL:
+            case BinaryExpressionNode::LESS_THAN:
+            case BinaryExpressionNode::LESS_EQUAL:
+            case BinaryExpressionNode::GREATER_THAN:
+            case BinaryExpressionNode::GREATER_EQUAL:
+                return "boolean";
+            case BinaryExpressionNode::LOGICAL_AND:
+            case BinaryExpressionNode::LOGICAL_OR:
+                return "";
+            case BinaryExpressionNode::BIT_AND:
+            case BinaryExpressionNode::BIT_OR:
+            case BinaryExpressionNode::BIT_XOR:
+            case BinaryExpressionNode::SHIFT_LEFT:
+            case BinaryExpressionNode::SHIFT_RIGHT:
+                return staticType(binOp->left.get()) == "i32" && staticType(binOp->right.get()) == "i32"
+                    ? "i32" : "";
+            default: break;
+        }
+        std::string left = staticType(binOp->left.get());
+        std::string right = staticType(binOp->right.get());
+        if (binOp->op == BinaryExpressionNode::ADD && (left == "string" || right == "string")) {
+            return "string";
+        }
+        return arithmeticType(left, right);
+    }
+    // Calls, fields, array elements: whatever semantic analysis resolved
+    if (!expr->typeResolved || expr->resolvedType == "null" || expr->resolvedType == "auto") return "";
+    return expr->resolvedType.str();
+}
+
 bool ASTOptimizer::literalTruthiness(ExpressionNode *expr, bool &value)
 {
-    if (auto *boolLit = dynamic_cast<BooleanLiteralNode *>(expr)) {
+    if (auto *boolLit = nodeCast<BooleanLiteralNode>(expr)) {
         value = boolLit->value;
         return true;
     }
-    if (auto *intLit = dynamic_cast<IntegerLiteralNode *>(expr)) {
+    if (auto *intLit = nodeCast<IntegerLiteralNode>(expr)) {
         value = intLit->value != 0;
         return true;
     }
-    if (auto *floatLit = dynamic_cast<FloatLiteralNode *>(expr)) {
+    if (auto *floatLit = nodeCast<FloatLiteralNode>(expr)) {
         value = floatLit->value != 0.0;
         return true;
     }
-    if (dynamic_cast<StringLiteralNode *>(expr)) {
+    if (nodeCast<StringLiteralNode>(expr)) {
         value = true; // non-null pointer
         return true;
     }
@@ -85,7 +397,21 @@ void ASTOptimizer::optimizeExpression(std::unique_ptr<ExpressionNode> &expr)
 {
     if (!expr) return;
 
-    if (auto *binOp = dynamic_cast<BinaryExpressionNode *>(expr.get())) {
+    // Const propagation: the read becomes the literal the const was bound to
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr.get())) {
+        const Binding *binding = lookup(varExpr->name);
+        if (binding && binding->constant) {
+            auto literal = cloneExpression(binding->constant);
+            literal->line = varExpr->line;
+            literal->column = varExpr->column;
+            setType(literal.get(), binding->type);
+            expr = std::move(literal);
+            m_stats.propagatedConstants++;
+        }
+        return;
+    }
+
+    if (auto *binOp = nodeCast<BinaryExpressionNode>(expr.get())) {
         optimizeExpression(binOp->left);
         optimizeExpression(binOp->right);
 
@@ -106,7 +432,7 @@ void ASTOptimizer::optimizeExpression(std::unique_ptr<ExpressionNode> &expr)
 
         // String concatenation folding
         if (binOp->op == BinaryExpressionNode::ADD &&
-            (dynamic_cast<StringLiteralNode *>(left) || dynamic_cast<StringLiteralNode *>(right))) {
+            (nodeCast<StringLiteralNode>(left) || nodeCast<StringLiteralNode>(right))) {
             std::string lhs, rhs;
             if (literalAsString(left, lhs) && literalAsString(right, rhs)) {
                 expr = std::make_unique<StringLiteralNode>(lhs + rhs);
@@ -160,14 +486,14 @@ void ASTOptimizer::optimizeExpression(std::unique_ptr<ExpressionNode> &expr)
         return;
     }
 
-    if (auto *unaryOp = dynamic_cast<UnaryExpressionNode *>(expr.get())) {
+    if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr.get())) {
         optimizeExpression(unaryOp->operand);
         ExpressionNode *operand = unaryOp->operand.get();
         if (unaryOp->op == UnaryExpressionNode::MINUS) {
-            if (auto *intLit = dynamic_cast<IntegerLiteralNode *>(operand)) {
+            if (auto *intLit = nodeCast<IntegerLiteralNode>(operand)) {
                 expr = std::make_unique<IntegerLiteralNode>(-intLit->value);
                 m_stats.foldedExpressions++;
-            } else if (auto *floatLit = dynamic_cast<FloatLiteralNode *>(operand)) {
+            } else if (auto *floatLit = nodeCast<FloatLiteralNode>(operand)) {
                 expr = std::make_unique<FloatLiteralNode>(-floatLit->value);
                 m_stats.foldedExpressions++;
             }
@@ -181,98 +507,156 @@ void ASTOptimizer::optimizeExpression(std::unique_ptr<ExpressionNode> &expr)
         return;
     }
 
-    if (auto *funcCall = dynamic_cast<FunctionCallNode *>(expr.get())) {
+    if (auto *funcCall = nodeCast<FunctionCallNode>(expr.get())) {
         for (auto &arg : funcCall->arguments) optimizeExpression(arg);
+        if (!evaluateCall(expr)) inlineCall(expr);
         return;
     }
-    if (auto *methodCall = dynamic_cast<MethodCallNode *>(expr.get())) {
-        optimizeExpression(methodCall->object);
+    // A receiver stays a variable even when it is a const: CodeGen resolves
+    // methods, fields and elements through the variable's recorded type
+    if (auto *methodCall = nodeCast<MethodCallNode>(expr.get())) {
+        if (!nodeCast<VariableExpressionNode>(methodCall->object.get())) optimizeExpression(methodCall->object);
         for (auto &arg : methodCall->arguments) optimizeExpression(arg);
         return;
     }
-    if (auto *newExpr = dynamic_cast<NewExpressionNode *>(expr.get())) {
+    if (auto *newExpr = nodeCast<NewExpressionNode>(expr.get())) {
         for (auto &arg : newExpr->arguments) optimizeExpression(arg);
         return;
     }
-    if (auto *arrLit = dynamic_cast<ArrayLiteralNode *>(expr.get())) {
+    if (auto *arrLit = nodeCast<ArrayLiteralNode>(expr.get())) {
         for (auto &element : arrLit->elements) optimizeExpression(element);
         return;
     }
-    if (auto *objLit = dynamic_cast<ObjectLiteralNode *>(expr.get())) {
+    if (auto *objLit = nodeCast<ObjectLiteralNode>(expr.get())) {
         for (auto &prop : objLit->properties) {
             if (prop.value) optimizeExpression(prop.value);
-            if (prop.method) optimizeStatementList(prop.method->bodyStatements);
+            if (prop.method) optimizeFunctionBody(prop.method->parameters, prop.method->bodyStatements, true);
         }
         return;
     }
-    if (auto *arrAccess = dynamic_cast<ArrayAccessNode *>(expr.get())) {
-        optimizeExpression(arrAccess->array);
+    if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr.get())) {
+        if (!nodeCast<VariableExpressionNode>(arrAccess->array.get())) optimizeExpression(arrAccess->array);
         optimizeExpression(arrAccess->index);
         return;
     }
-    if (auto *objAccess = dynamic_cast<ObjectAccessNode *>(expr.get())) {
-        optimizeExpression(objAccess->object);
+    if (auto *objAccess = nodeCast<ObjectAccessNode>(expr.get())) {
+        if (!nodeCast<VariableExpressionNode>(objAccess->object.get())) optimizeExpression(objAccess->object);
         return;
     }
-    if (auto *arrowFn = dynamic_cast<ArrowFunctionNode *>(expr.get())) {
-        optimizeStatementList(arrowFn->bodyStatements);
+    if (auto *arrowFn = nodeCast<ArrowFunctionNode>(expr.get())) {
+        optimizeFunctionBody(arrowFn->parameters, arrowFn->bodyStatements, false);
         return;
     }
 }
 
+void ASTOptimizer::optimizeFunctionBody(const std::vector<FunctionDeclarationNode::Parameter> &params,
+                                        std::vector<std::unique_ptr<StatementNode>> &body, bool isolated)
+{
+    m_functionDepth++;
+    pushScope(isolated);
+    for (const auto &param : params) {
+        Binding binding;
+        binding.type = param.type == "auto" ? "" : param.type;
+        declare(param.name, binding);
+    }
+    optimizeStatementList(body);
+    popScope();
+    m_functionDepth--;
+}
+
 void ASTOptimizer::optimizeStatement(StatementNode *stmt)
 {
     if (!stmt) return;
 
-    if (auto *varDecl = dynamic_cast<VariableDeclarationNode *>(stmt)) {
+    if (auto *varDecl = nodeCast<VariableDeclarationNode>(stmt)) {
         optimizeExpression(varDecl->initializer);
-    } else if (auto *assign = dynamic_cast<AssignmentStatementNode *>(stmt)) {
+        Binding binding;
+        binding.isConst = varDecl->isConst;
+        bool annotated = !varDecl->typeName.empty() && varDecl->typeName != "auto";
+        binding.type = annotated ? varDecl->typeName : staticType(varDecl->initializer.get());
+        // Only a literal of exactly the declared type: `const x: f64 = 1` must
+        // not turn the reads of x into the integer 1
+        std::string literal = literalType(varDecl->initializer.get());
+        if (varDecl->isConst && literal != "string" && !literal.empty() && literal == binding.type) {
+            binding.constant = varDecl->initializer.get();
+        }
+        declare(varDecl->variableName, binding);
+    } else if (auto *assign = nodeCast<AssignmentStatementNode>(stmt)) {
         optimizeExpression(assign->value);
-    } else if (auto *arrAssign = dynamic_cast<ArrayAssignmentStatementNode *>(stmt)) {
-        optimizeExpression(arrAssign->array);
+    } else if (auto *arrAssign = nodeCast<ArrayAssignmentStatementNode>(stmt)) {
+        if (!nodeCast<VariableExpressionNode>(arrAssign->array.get())) optimizeExpression(arrAssign->array);
         optimizeExpression(arrAssign->index);
         optimizeExpression(arrAssign->value);
-    } else if (auto *propAssign = dynamic_cast<ObjectPropertyAssignmentNode *>(stmt)) {
-        optimizeExpression(propAssign->object);
+    } else if (auto *propAssign = nodeCast<ObjectPropertyAssignmentNode>(stmt)) {
+        if (!nodeCast<VariableExpressionNode>(propAssign->object.get())) optimizeExpression(propAssign->object);
         optimizeExpression(propAssign->value);
-    } else if (auto *exprStmt = dynamic_cast<ExpressionStatementNode *>(stmt)) {
+    } else if (auto *exprStmt = nodeCast<ExpressionStatementNode>(stmt)) {
         optimizeExpression(exprStmt->expression);
-    } else if (auto *ifStmt = dynamic_cast<IfStatementNode *>(stmt)) {
+    } else if (auto *ifStmt = nodeCast<IfStatementNode>(stmt)) {
         optimizeExpression(ifStmt->condition);
+        pushScope();
         optimizeStatementList(ifStmt->thenStatements);
+        popScope();
+        pushScope();
         optimizeStatementList(ifStmt->elseStatements);
-    } else if (auto *whileStmt = dynamic_cast<WhileStatementNode *>(stmt)) {
+        popScope();
+    } else if (auto *whileStmt = nodeCast<WhileStatementNode>(stmt)) {
         optimizeExpression(whileStmt->condition);
+        pushScope();
         optimizeStatementList(whileStmt->bodyStatements);
-    } else if (auto *forStmt = dynamic_cast<ForStatementNode *>(stmt)) {
+        popScope();
+    } else if (auto *forStmt = nodeCast<ForStatementNode>(stmt)) {
+        pushScope();
         if (forStmt->initialization) optimizeStatement(forStmt->initialization.get());
         optimizeExpression(forStmt->condition);
         if (forStmt->increment) optimizeStatement(forStmt->increment.get());
         optimizeStatementList(forStmt->bodyStatements);
-    } else if (auto *forOfStmt = dynamic_cast<ForOfStatementNode *>(stmt)) {
+        popScope();
+    } else if (auto *forOfStmt = nodeCast<ForOfStatementNode>(stmt)) {
         optimizeExpression(forOfStmt->iterable);
+        pushScope();
+        declare(forOfStmt->iteratorVariable->variableName, Binding());
         optimizeStatementList(forOfStmt->bodyStatements);
-    } else if (auto *doWhileStmt = dynamic_cast<DoWhileStatementNode *>(stmt)) {
-        optimizeExpression(doWhileStmt->condition);
+        popScope();
+    } else if (auto *doWhileStmt = nodeCast<DoWhileStatementNode>(stmt)) {
+        pushScope();
         optimizeStatementList(doWhileStmt->bodyStatements);
-    } else if (auto *funcDecl = dynamic_cast<FunctionDeclarationNode *>(stmt)) {
-        optimizeStatementList(funcDecl->bodyStatements);
-    } else if (auto *retStmt = dynamic_cast<ReturnStatementNode *>(stmt)) {
+        popScope();
+        optimizeExpression(doWhileStmt->condition);
+    } else if (auto *funcDecl = nodeCast<FunctionDeclarationNode>(stmt)) {
+        optimizeFunctionBody(funcDecl->parameters, funcDecl->bodyStatements, true);
+        if (m_depth == 0) considerInlining(funcDecl);
+    } else if (auto *classDecl = nodeCast<ClassDeclarationNode>(stmt)) {
+        for (auto &prop : classDecl->objectTemplate->properties) {
+            if (prop.method) optimizeFunctionBody(prop.method->parameters, prop.method->bodyStatements, true);
+            else if (prop.value) optimizeExpression(prop.value);
+        }
+    } else if (auto *retStmt = nodeCast<ReturnStatementNode>(stmt)) {
         optimizeExpression(retStmt->expression);
-    } else if (auto *throwStmt = dynamic_cast<ThrowStatementNode *>(stmt)) {
+    } else if (auto *throwStmt = nodeCast<ThrowStatementNode>(stmt)) {
         optimizeExpression(throwStmt->expression);
-    } else if (auto *tryStmt = dynamic_cast<TryCatchStatementNode *>(stmt)) {
+    } else if (auto *tryStmt = nodeCast<TryCatchStatementNode>(stmt)) {
+        pushScope();
         optimizeStatementList(tryStmt->tryStatements);
+        popScope();
+        pushScope();
+        if (!tryStmt->errorVariable.empty()) declare(tryStmt->errorVariable, Binding());
         optimizeStatementList(tryStmt->catchStatements);
+        popScope();
+        pushScope();
         optimizeStatementList(tryStmt->finallyStatements);
-    } else if (auto *switchStmt = dynamic_cast<SwitchStatementNode *>(stmt)) {
+        popScope();
+    } else if (auto *switchStmt = nodeCast<SwitchStatementNode>(stmt)) {
         optimizeExpression(switchStmt->condition);
+        pushScope();
         for (auto &clause : switchStmt->cases) {
             optimizeExpression(clause.value);
             optimizeStatementList(clause.statements);
         }
-    } else if (auto *destruct = dynamic_cast<DestructuringDeclarationNode *>(stmt)) {
+        popScope();
+    } else if (auto *destruct = nodeCast<DestructuringDeclarationNode>(stmt)) {
         optimizeExpression(destruct->initializer);
+        for (const auto &name : destruct->bindings) declare(name, Binding());
     }
 }
 
@@ -281,10 +665,12 @@ void ASTOptimizer::optimizeStatementList(std::vector<std::unique_ptr<StatementNo
     for (size_t i = 0; i < stmts.size(); ++i) {
         optimizeStatement(stmts[i].get());
 
-        // Dead-branch elimination: if (constant) { ... } else { ... }
-        if (auto *ifStmt = dynamic_cast<IfStatementNode *>(stmts[i].get())) {
+        // Dead-branch elimination: if (constant) { ... } else { ... }. A live
+        // branch that declares names keeps its block, so they stay scoped to it.
+        if (auto *ifStmt = nodeCast<IfStatementNode>(stmts[i].get())) {
             bool condValue;
-            if (ifStmt->condition && literalTruthiness(ifStmt->condition.get(), condValue)) {
+            if (ifStmt->condition && literalTruthiness(ifStmt->condition.get(), condValue) &&
+                !declaresNames(condValue ? ifStmt->thenStatements : ifStmt->elseStatements)) {
                 auto &liveBranch = condValue ? ifStmt->thenStatements : ifStmt->elseStatements;
                 std::vector<std::unique_ptr<StatementNode>> replacement = std::move(liveBranch);
                 stmts.erase(stmts.begin() + i);
@@ -298,7 +684,7 @@ void ASTOptimizer::optimizeStatementList(std::vector<std::unique_ptr<StatementNo
         }
 
         // while (false) { ... } never runs
-        if (auto *whileStmt = dynamic_cast<WhileStatementNode *>(stmts[i].get())) {
+        if (auto *whileStmt = nodeCast<WhileStatementNode>(stmts[i].get())) {
             bool condValue;
             if (whileStmt->condition && literalTruthiness(whileStmt->condition.get(), condValue) && !condValue) {
                 stmts.erase(stmts.begin() + i);
@@ -307,14 +693,291 @@ void ASTOptimizer::optimizeStatementList(std::vector<std::unique_ptr<StatementNo
                 continue;
             }
         }
+
+        i += hoistLoopInvariants(stmts, i);
     }
 }
 
+// --- Inlining ------------------------------------------------------------------
+
+void ASTOptimizer::considerInlining(FunctionDeclarationNode *func)
+{
+    // A top-level function, declared once, whose whole body is one `return` of
+    // operators over its parameters and literals: no calls, so no recursion,
+    // and nothing but the arguments can change its result
+    if (!func->genericParams.empty() || m_ambiguousFunctions.count(func->functionName) ||
+        func->bodyStatements.size() != 1) {
+        return;
+    }
+    auto *ret = nodeCast<ReturnStatementNode>(func->bodyStatements[0].get());
+    if (!ret || !ret->expression) return;
+    std::set<std::string> params;
+    for (const auto &param : func->parameters) {
+        if (!params.insert(param.name).second) return;
+    }
+    if (!isInlinableBody(ret->expression.get(), params)) return;
+
+    // The body's own type must be the return type: a call converts its result
+    // to the declared type, and inlined arithmetic would not
+    pushScope(true);
+    for (const auto &param : func->parameters) {
+        Binding binding;
+        binding.type = param.type;
+        declare(param.name, binding);
+    }
+    std::string bodyType = staticType(ret->expression.get());
+    popScope();
+    if (bodyType.empty() || bodyType != func->returnType) return;
+
+    m_inlinable[func->functionName] = func;
+}
+
+bool ASTOptimizer::inlineCall(std::unique_ptr<ExpressionNode> &expr)
+{
+    auto *call = nodeCast<FunctionCallNode>(expr.get());
+    auto it = m_inlinable.find(call->functionName);
+    if (it == m_inlinable.end() || lookup(call->functionName)) return false;
+    FunctionDeclarationNode *func = it->second;
+    if (call->arguments.size() != func->parameters.size()) return false;
+    auto *body = nodeCast<ReturnStatementNode>(func->bodyStatements[0].get())->expression.get();
+
+    // Arguments are substituted for the parameters, so each must already have
+    // the parameter's exact type (no conversion happens), must not trap, and
+    // unless it is a literal or a plain read may be used at most once
+    std::map<std::string, const ExpressionNode *> substitutions;
+    for (size_t i = 0; i < call->arguments.size(); ++i) {
+        ExpressionNode *arg = call->arguments[i].get();
+        const auto &param = func->parameters[i];
+        if (!isPure(arg) || staticType(arg) != param.type) return false;
+        bool trivial = !literalType(arg).empty() || nodeCast<VariableExpressionNode>(arg);
+        if (!trivial && countReads(body, param.name) > 1) return false;
+        substitutions[param.name] = arg;
+    }
+
+    auto inlined = cloneExpression(body, &substitutions);
+    if (!inlined) return false;
+    inlined->line = call->line;
+    inlined->column = call->column;
+    setType(inlined.get(), func->returnType);
+    expr = std::move(inlined);
+    m_stats.inlinedCalls++;
+    optimizeExpression(expr); // fold whatever the arguments made constant
+    return true;
+}
+
+bool ASTOptimizer::evaluateCall(std::unique_ptr<ExpressionNode> &expr)
+{
+    auto *call = nodeCast<FunctionCallNode>(expr.get());
+    // A local of the same name (a closure) shadows the function
+    if (!m_evaluator || !m_constFunctions.count(call->functionName) || lookup(call->functionName)) {
+        return false;
+    }
+    auto value = m_evaluator->evaluateCall(call);
+    if (!value) return false;
+    expr = std::move(value);
+    m_stats.evaluatedCalls++;
+    return true;
+}
+
+// --- Loop-invariant hoisting -----------------------------------------------------
+
+void ASTOptimizer::collectLoopEffects(StatementNode *stmt, LoopEffects &effects)
+{
+    if (!stmt) return;
+    if (auto *varDecl = nodeCast<VariableDeclarationNode>(stmt)) {
+        effects.written.insert(varDecl->variableName);
+    } else if (auto *assign = nodeCast<AssignmentStatementNode>(stmt)) {
+        effects.written.insert(assign->variableName);
+    } else if (auto *destruct = nodeCast<DestructuringDeclarationNode>(stmt)) {
+        effects.written.insert(destruct->bindings.begin(), destruct->bindings.end());
+    } else if (auto *forOfStmt = nodeCast<ForOfStatementNode>(stmt)) {
+        effects.written.insert(forOfStmt->iteratorVariable->variableName);
+    } else if (auto *tryStmt = nodeCast<TryCatchStatementNode>(stmt)) {
+        if (!tryStmt->errorVariable.empty()) effects.written.insert(tryStmt->errorVariable);
+    }
+    forEachPart(stmt, [&](std::unique_ptr<ExpressionNode> &expr) { collectLoopEffects(expr.get(), effects); },
+                [&](StatementNode *nested) { collectLoopEffects(nested, effects); });
+}
+
+void ASTOptimizer::collectLoopEffects(ExpressionNode *expr, LoopEffects &effects)
+{
+    if (!expr) return;
+    if (auto *update = nodeCast<UpdateExpressionNode>(expr)) {
+        if (auto *target = nodeCast<VariableExpressionNode>(update->target.get())) {
+            effects.written.insert(target->name);
+        }
+    } else if (auto *funcCall = nodeCast<FunctionCallNode>(expr)) {
+        // Any function may assign a module-level variable; printing cannot
+        if (funcCall->functionName != "print" && funcCall->functionName != "println") {
+            effects.hasCalls = true;
+        }
+    } else if (nodeCast<MethodCallNode>(expr) || nodeCast<NewExpressionNode>(expr)) {
+        effects.hasCalls = true;
+    }
+    // An arrow's body runs only when it is called, and closures capture by
+    // value, so it can change nothing here except through a call
+    forEachOperand(expr, [&](std::unique_ptr<ExpressionNode> &operand) {
+        collectLoopEffects(operand.get(), effects);
+    });
+}
+
+bool ASTOptimizer::isLoopInvariant(ExpressionNode *expr, const LoopEffects &effects, std::string &type)
+{
+    if (nodeCast<IntegerLiteralNode>(expr) || nodeCast<FloatLiteralNode>(expr)) {
+        type = literalType(expr);
+        return true;
+    }
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
+        if (effects.written.count(varExpr->name)) return false;
+        const Binding *binding = lookup(varExpr->name);
+        if (!binding || (binding->global && !binding->isConst && effects.hasCalls)) return false;
+        type = binding->type;
+        return type == "i32" || type == "i64" || type == "f64";
+    }
+    if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr)) {
+        if (unaryOp->op == UnaryExpressionNode::NOT) return false;
+        if (!isLoopInvariant(unaryOp->operand.get(), effects, type)) return false;
+        return unaryOp->op == UnaryExpressionNode::MINUS || type != "f64";
+    }
+    auto *binOp = nodeCast<BinaryExpressionNode>(expr);
+    if (!binOp || !isArithmetic(binOp->op)) return false;
+    std::string left, right;
+    if (!isLoopInvariant(binOp->left.get(), effects, left) ||
+        !isLoopInvariant(binOp->right.get(), effects, right)) {
+        return false;
+    }
+    switch (binOp->op) {
+        case BinaryExpressionNode::ADD:
+        case BinaryExpressionNode::SUBTRACT:
+        case BinaryExpressionNode::MULTIPLY:
+            type = arithmeticType(left, right);
+            return !type.empty();
+        case BinaryExpressionNode::DIVIDE:
+        case BinaryExpressionNode::MODULO: {
+            // Computed ahead of the loop it would run even when the loop does
+            // not, so integer division only by a known non-zero divisor
+            type = arithmeticType(left, right);
+            if (type.empty()) return false;
+            if (type == "f64") return true;
+            auto *divisor = nodeCast<IntegerLiteralNode>(binOp->right.get());
+            return divisor && divisor->value != 0;
+        }
+        default:
+            type = "i32";
+            return left == "i32" && right == "i32";
+    }
+}
+
+void ASTOptimizer::hoistFrom(std::unique_ptr<ExpressionNode> &expr, const LoopEffects &effects,
+                             std::vector<std::unique_ptr<StatementNode>> &hoisted)
+{
+    if (!expr || nodeCast<ArrowFunctionNode>(expr.get()) || nodeCast<UpdateExpressionNode>(expr.get())) return;
+
+    std::string type;
+    if (nodeCast<BinaryExpressionNode>(expr.get()) && readsVariable(expr.get()) &&
+        isLoopInvariant(expr.get(), effects, type)) {
+        // `$` cannot start an identifier, so the name is free in any program
+        std::string name = "$invariant" + std::to_string(m_stats.hoistedInvariants++);
+        auto read = std::make_unique<VariableExpressionNode>(name);
+        read->line = expr->line;
+        read->column = expr->column;
+        setType(read.get(), type);
+        auto decl = std::make_unique<VariableDeclarationNode>(name, type, std::move(expr), true);
+        decl->line = read->line;
+        decl->column = read->column;
+        hoisted.push_back(std::move(decl));
+        expr = std::move(read);
+        return;
+    }
+    forEachOperand(expr.get(), [&](std::unique_ptr<ExpressionNode> &operand) {
+        hoistFrom(operand, effects, hoisted);
+    });
+}
+
+void ASTOptimizer::hoistFrom(StatementNode *stmt, const LoopEffects &effects,
+                             std::vector<std::unique_ptr<StatementNode>> &hoisted)
+{
+    if (!stmt) return;
+    forEachPart(stmt, [&](std::unique_ptr<ExpressionNode> &expr) { hoistFrom(expr, effects, hoisted); },
+                [&](StatementNode *nested) { hoistFrom(nested, effects, hoisted); });
+}
+
+size_t ASTOptimizer::hoistLoopInvariants(std::vector<std::unique_ptr<StatementNode>> &stmts, size_t index)
+{
+    StatementNode *loop = stmts[index].get();
+    std::vector<std::unique_ptr<StatementNode>> hoisted;
+    LoopEffects effects;
+    collectLoopEffects(loop, effects);
+
+    // Everything evaluated once per iteration; a for's initialization and a
+    // for-of's iterable already run only once
+    auto body = [&](std::vector<std::unique_ptr<StatementNode>> &stmts) {
+        for (auto &stmt : stmts) hoistFrom(stmt.get(), effects, hoisted);
+    };
+    if (auto *whileStmt = nodeCast<WhileStatementNode>(loop)) {
+        hoistFrom(whileStmt->condition, effects, hoisted);
+        body(whileStmt->bodyStatements);
+    } else if (auto *doWhileStmt = nodeCast<DoWhileStatementNode>(loop)) {
+        body(doWhileStmt->bodyStatements);
+        hoistFrom(doWhileStmt->condition, effects, hoisted);
+    } else if (auto *forStmt = nodeCast<ForStatementNode>(loop)) {
+        hoistFrom(forStmt->condition, effects, hoisted);
+        hoistFrom(forStmt->increment.get(), effects, hoisted);
+        body(forStmt->bodyStatements);
+    } else if (auto *forOfStmt = nodeCast<ForOfStatementNode>(loop)) {
+        body(forOfStmt->bodyStatements);
+    } else {
+        return 0;
+    }
+
+    for (const auto &stmt : hoisted) {
+        auto *decl = static_cast<VariableDeclarationNode *>(stmt.get());
+        Binding binding;
+        binding.type = decl->typeName;
+        binding.isConst = true;
+        declare(decl->variableName, binding);
+    }
+    size_t count = hoisted.size();
+    stmts.insert(stmts.begin() + index, std::make_move_iterator(hoisted.begin()),
+                 std::make_move_iterator(hoisted.end()));
+    return count;
+}
+
 ASTOptimizer::Stats ASTOptimizer::optimize(ProgramNode *program)
 {
     m_stats = Stats();
+    m_scopes.clear();
+    m_globals.clear();
+    m_depth = 0;
+    m_functionDepth = 0;
+    m_inlinable.clear();
+    m_ambiguousFunctions.clear();
+    m_constFunctions.clear();
     if (program) {
+        std::set<std::string> functionNames;
+        for (const auto &stmt : program->statements) {
+            if (auto *funcDecl = nodeCast<FunctionDeclarationNode>(stmt.get())) {
+                if (!functionNames.insert(funcDecl->functionName).second) {
+                    m_ambiguousFunctions.insert(funcDecl->functionName);
+                }
+            } else if (auto *externDecl = nodeCast<ExternDeclarationNode>(stmt.get())) {
+                m_ambiguousFunctions.insert(externDecl->functionName);
+            }
+        }
+        for (const auto &stmt : program->statements) {
+            auto *funcDecl = nodeCast<FunctionDeclarationNode>(stmt.get());
+            if (funcDecl && funcDecl->isConst && !m_ambiguousFunctions.count(funcDecl->functionName)) {
+                m_constFunctions[funcDecl->functionName] = funcDecl;
+            }
+        }
+        m_evaluator = std::make_unique<ConstEvaluator>(m_constFunctions);
+        m_scopes.pushScope(); // module level
         optimizeStatementList(program->statements);
+        m_scopes.clear();
+        m_globals.clear();
+        m_inlinable.clear();
+        m_evaluator.reset();
+        m_constFunctions.clear();
     }
     return m_stats;
 }
@@ -1,11 +1,33 @@
 // src/Optimizer.h - AST-level optimizations (Phase 3 roadmap)
 // Constant folding and dead-branch elimination run before LLVM codegen,
-// complementing the -O2 passes applied at native compile time.
+// complementing the -O2 passes applied at native compile time. On top of
+// folding, the pass works across the whole linked program:
+//
+//   - const propagation: a `const` bound to a numeric or boolean literal is
+//     replaced by that literal at every read it reaches, so it folds further
+//     (`const DEBUG = false; if (DEBUG) ...` disappears entirely);
+//   - inlining: a call to a top-level function whose body is a single
+//     `return` of arithmetic over its parameters becomes that arithmetic;
+//   - loop-invariant hoisting: arithmetic inside a loop that only reads
+//     variables the loop never writes is computed once, into a const declared
+//     just before the loop;
+//   - compile-time evaluation: a call to a `const function` whose arguments
+//     are all constants is replaced by its result (ConstEval.h).
+//
+// Everything runs after semantic analysis, on a program already known to be
+// valid, and never changes what the program prints; --no-fold turns it off.
 #ifndef OPTIMIZER_H
 #define OPTIMIZER_H
 
 #include "AST.h"
+#include "ConstEval.h"
+#include "SymbolTable.h"
+
+#include "llvm/ADT/StringMap.h"
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
 class ASTOptimizer
@@ -14,23 +36,84 @@ public:
     struct Stats {
         int foldedExpressions = 0;
         int eliminatedBranches = 0;
+        int propagatedConstants = 0;
+        int inlinedCalls = 0;
+        int hoistedInvariants = 0;
+        int evaluatedCalls = 0;
     };
 
     // Runs all AST optimizations in place and returns what was done
     Stats optimize(ProgramNode *program);
 
 private:
+    // What the pass knows about a name at the point it is read
+    struct Binding {
+        ExpressionNode *constant = nullptr; // literal value of a const, copied into reads
+        std::string type;                   // declared or inferred; empty if unknown
+        bool isConst = false;
+        bool global = false;                // module-level: any call may reassign it
+    };
+
+    // Names a loop (re)binds anywhere inside it, and whether it calls out
+    struct LoopEffects {
+        std::set<std::string> written;
+        bool hasCalls = false;
+    };
+
     Stats m_stats;
+    ScopedSymbolTable<Binding> m_scopes;
+    llvm::StringMap<Binding> m_globals;   // module-level names, visible inside functions
+    int m_depth = 0;                      // scopes open above the module level
+    int m_functionDepth = 0;
+    std::map<std::string, FunctionDeclarationNode *> m_inlinable;
+    std::set<std::string> m_ambiguousFunctions; // declared more than once, or extern
+    std::map<std::string, FunctionDeclarationNode *> m_constFunctions;
+    std::unique_ptr<ConstEvaluator> m_evaluator;
 
     // Recursively folds constants inside an expression; may replace the node
     void optimizeExpression(std::unique_ptr<ExpressionNode> &expr);
     // Recurses into a statement's expressions and nested statement lists
     void optimizeStatement(StatementNode *stmt);
-    // Optimizes a statement list, eliminating dead if/while branches
+    // Optimizes a statement list, eliminating dead if/while branches and
+    // hoisting loop invariants in front of the loops
     void optimizeStatementList(std::vector<std::unique_ptr<StatementNode>> &stmts);
+    // Optimizes a function, method or arrow body with its parameters in scope.
+    // Functions and methods do not see the locals around them; arrows do.
+    void optimizeFunctionBody(const std::vector<FunctionDeclarationNode::Parameter> &params,
+                              std::vector<std::unique_ptr<StatementNode>> &body, bool isolated);
 
     // Returns true and sets `value` if the expression is a literal with a known truthiness
     bool literalTruthiness(ExpressionNode *expr, bool &value);
+
+    void pushScope(bool isolated = false);
+    void popScope();
+    void declare(const std::string &name, Binding binding);
+    const Binding *lookup(const std::string &name);
+    // The static type of an expression, following semantic analysis's rules;
+    // empty when it is not known
+    std::string staticType(ExpressionNode *expr);
+
+    // Records `func` as inlinable if its body qualifies (see Optimizer.cpp)
+    void considerInlining(FunctionDeclarationNode *func);
+    // Replaces a call to an inlinable function with its body; false if the
+    // call's arguments rule that out
+    bool inlineCall(std::unique_ptr<ExpressionNode> &expr);
+    // Replaces a call to a const function with its value; false if the
+    // arguments are not constants or evaluation gave up
+    bool evaluateCall(std::unique_ptr<ExpressionNode> &expr);
+
+    void collectLoopEffects(StatementNode *stmt, LoopEffects &effects);
+    void collectLoopEffects(ExpressionNode *expr, LoopEffects &effects);
+    // True if `expr` is arithmetic whose value cannot change while the loop
+    // runs; sets `type` to its numeric type
+    bool isLoopInvariant(ExpressionNode *expr, const LoopEffects &effects, std::string &type);
+    // Moves the invariant arithmetic of the loop at stmts[index] into consts
+    // declared in front of it; returns how many declarations were inserted
+    size_t hoistLoopInvariants(std::vector<std::unique_ptr<StatementNode>> &stmts, size_t index);
+    void hoistFrom(std::unique_ptr<ExpressionNode> &expr, const LoopEffects &effects,
+                   std::vector<std::unique_ptr<StatementNode>> &hoisted);
+    void hoistFrom(StatementNode *stmt, const LoopEffects &effects,
+                   std::vector<std::unique_ptr<StatementNode>> &hoisted);
 };
 
 #endif // OPTIMIZER_H
@@ -8,7 +8,13 @@
 #include <iostream>
 
 // --- Constructor ---
-Parser::Parser(const std::vector<Token> &tokens) : m_tokens(tokens), m_currentPos(0) {}
+Parser::Parser(Lexer &lexer, std::function<void(const Token &)> onToken)
+    : m_lexer(lexer), m_onToken(std::move(onToken)) {}
+
+void Parser::addKnownEnums(const std::map<std::string, std::map<std::string, long long>> &enums)
+{
+    for (const auto &entry : enums) m_enums[entry.first].insert(entry.second.begin(), entry.second.end());
+}
 
 // --- Private Helper Methods ---
 
@@ -16,11 +22,26 @@ const Token &Parser::peek(int offset) const
 {
     static Token eofToken(TOK_EOF, "");
     size_t index = m_currentPos + offset;
-    if (index >= m_tokens.size())
+    while (index >= m_windowStart + m_window.size() && !m_lexedEof)
+    {
+        m_window.push_back(m_lexer.getNextToken());
+        if (m_onToken) m_onToken(m_window.back());
+        m_lexedEof = m_window.back().type == TOK_EOF;
+    }
+    if (index < m_windowStart || index >= m_windowStart + m_window.size())
     {
         return eofToken;
     }
-    return m_tokens[index];
+    return m_window[index - m_windowStart];
+}
+
+void Parser::releaseConsumedTokens()
+{
+    while (m_windowStart + 1 < m_currentPos && !m_window.empty())
+    {
+        m_window.pop_front();
+        ++m_windowStart;
+    }
 }
 
 const Token &Parser::advance()
@@ -61,9 +82,8 @@ const Token &Parser::consume(TokenType expectedType, const std::string &errorMes
         return advance();
     }
     std::string errorMsg = "Parse Error: " + errorMessage + ". Found " +
-                           tokenTypeToString(peek().type) + " ('" + peek().value + "') instead" +
+                           tokenTypeToString(peek().type) + " ('" + std::string(peek().value) + "') instead" +
                            tokenPosition(peek()) + ".";
-    std::cerr << errorMsg << std::endl;
     throw std::runtime_error(errorMsg);
 }
 
@@ -76,11 +96,22 @@ std::unique_ptr<ProgramNode> Parser::parseProgram()
     auto programNode = std::make_unique<ProgramNode>();
     while (!isAtEnd())
     {
+        releaseConsumedTokens();
         programNode->statements.push_back(parseStatement());
     }
+    programNode->exported = std::move(m_exported);
     return programNode;
 }
 
+std::unique_ptr<StatementNode> Parser::parseNextStatement(bool &exported)
+{
+    releaseConsumedTokens();
+    size_t exportedBefore = m_exported.size();
+    auto stmt = parseStatement();
+    exported = m_exported.size() > exportedBefore;
+    return stmt;
+}
+
 std::unique_ptr<StatementNode> Parser::parseStatement()
 {
     int line = peek().line;
@@ -95,7 +126,15 @@ std::unique_ptr<StatementNode> Parser::parseStatement()
 
 std::unique_ptr<StatementNode> Parser::parseStatementInner()
 {
-    if (peek().type == TOK_LET || peek().type == TOK_CONST)
+    if (peek().type == TOK_CONST && peek(1).type == TOK_FUNCTION)
+    {
+        // `const function`: evaluated at compile time wherever its arguments are
+        advance();
+        auto function = parseFunctionDeclaration();
+        function->isConst = true;
+        return function;
+    }
+    else if (peek().type == TOK_LET || peek().type == TOK_CONST)
     {
         if (peek(1).type == TOK_LBRACE)
         {
@@ -105,14 +144,17 @@ std::unique_ptr<StatementNode> Parser::parseStatementInner()
     }
     else if (peek().type == TOK_EXPORT)
     {
-        // Modules are inlined at compile time; `export` just marks the declaration
+        // `export` marks the declaration for the module's export table; the
+        // declaration itself compiles the same either way
         advance();
-        return parseStatement();
+        auto declaration = parseStatement();
+        m_exported.push_back(declaration.get());
+        return declaration;
     }
     else if (peek().type == TOK_IMPORT)
     {
         throw std::runtime_error("Parse Error: import statements are resolved by the compiler driver. "
-                                 "Compile the importing file with cscript so imports are inlined.");
+                                 "Compile the importing file with cscript so its imports are loaded.");
     }
     else if (peek().type == TOK_FUNCTION)
     {
@@ -193,9 +235,8 @@ std::unique_ptr<StatementNode> Parser::parseStatementInner()
     else
     {
         std::string errorMsg = std::string("Parsing failed: Unexpected token at start of statement: ") +
-                               tokenTypeToString(peek().type) + " ('" + peek().value + "')" +
+                               tokenTypeToString(peek().type) + " ('" + std::string(peek().value) + "')" +
                                tokenPosition(peek());
-        std::cerr << errorMsg << std::endl;
         throw std::runtime_error(errorMsg);
     }
 }
@@ -203,17 +244,17 @@ std::unique_ptr<StatementNode> Parser::parseStatementInner()
 std::unique_ptr<StatementNode> Parser::makeAssignmentStatement(std::unique_ptr<ExpressionNode> target,
                                                                std::unique_ptr<ExpressionNode> value)
 {
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(target.get())) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(target.get())) {
         return std::make_unique<AssignmentStatementNode>(varExpr->name, std::move(value));
     }
-    if (dynamic_cast<ArrayAccessNode*>(target.get())) {
+    if (nodeCast<ArrayAccessNode>(target.get())) {
         auto *arrAccess = static_cast<ArrayAccessNode*>(target.release());
         std::unique_ptr<ArrayAccessNode> owned(arrAccess);
         return std::make_unique<ArrayAssignmentStatementNode>(std::move(owned->array),
                                                               std::move(owned->index),
                                                               std::move(value));
     }
-    if (dynamic_cast<ObjectAccessNode*>(target.get())) {
+    if (nodeCast<ObjectAccessNode>(target.get())) {
         auto *objAccess = static_cast<ObjectAccessNode*>(target.release());
         std::unique_ptr<ObjectAccessNode> owned(objAccess);
         return std::make_unique<ObjectPropertyAssignmentNode>(std::move(owned->object),
@@ -235,7 +276,7 @@ std::unique_ptr<StatementNode> Parser::makeCompoundAssignmentStatement(
     std::unique_ptr<ExpressionNode> target, BinaryExpressionNode::Operator op,
     std::unique_ptr<ExpressionNode> rhs, size_t targetStart)
 {
-    if (dynamic_cast<ArrayAccessNode*>(target.get())) {
+    if (nodeCast<ArrayAccessNode>(target.get())) {
         auto *access = static_cast<ArrayAccessNode*>(target.release());
         std::unique_ptr<ArrayAccessNode> owned(access);
         auto node = std::make_unique<ArrayAssignmentStatementNode>(
@@ -244,7 +285,7 @@ std::unique_ptr<StatementNode> Parser::makeCompoundAssignmentStatement(
         node->compoundOp = op;
         return node;
     }
-    if (dynamic_cast<ObjectAccessNode*>(target.get())) {
+    if (nodeCast<ObjectAccessNode>(target.get())) {
         auto *access = static_cast<ObjectAccessNode*>(target.release());
         std::unique_ptr<ObjectAccessNode> owned(access);
         auto node = std::make_unique<ObjectPropertyAssignmentNode>(
@@ -307,7 +348,7 @@ std::unique_ptr<StatementNode> Parser::parseDestructuringDeclaration()
     consume(TOK_LBRACE, "Expected '{' in destructuring declaration");
     std::vector<std::string> names;
     while (peek().type != TOK_RBRACE && !isAtEnd()) {
-        names.push_back(consume(TOK_IDENTIFIER, "Expected binding name in destructuring").value);
+        names.push_back(std::string(consume(TOK_IDENTIFIER, "Expected binding name in destructuring").value));
         if (peek().type == TOK_COMMA) advance();
         else break;
     }
@@ -355,7 +396,7 @@ std::unique_ptr<StatementNode> Parser::parseInterfaceDeclaration()
 {
     consume(TOK_INTERFACE, "Expected 'interface'");
     const Token &nameToken = consume(TOK_IDENTIFIER, "Expected interface name");
-    auto interfaceNode = std::make_unique<InterfaceDeclarationNode>(nameToken.value);
+    auto interfaceNode = std::make_unique<InterfaceDeclarationNode>(std::string(nameToken.value));
     if (peek().type == TOK_EXTENDS) {
         advance();
         interfaceNode->parentInterface = consume(TOK_IDENTIFIER, "Expected parent interface name").value;
@@ -370,10 +411,10 @@ std::unique_ptr<StatementNode> Parser::parseInterfaceDeclaration()
             consume(TOK_RPAREN, "Expected ')' in interface method signature");
             std::string retType = "void";
             if (peek().type == TOK_COLON) { advance(); retType = parseType(); }
-            interfaceNode->members.emplace_back(memberName.value, "method:" + retType);
+            interfaceNode->members.emplace_back(std::string(memberName.value), "method:" + retType);
         } else {
             consume(TOK_COLON, "Expected ':' after interface member name");
-            interfaceNode->members.emplace_back(memberName.value, parseType());
+            interfaceNode->members.emplace_back(std::string(memberName.value), parseType());
         }
         if (peek().type == TOK_SEMICOLON || peek().type == TOK_COMMA) advance();
     }
@@ -385,7 +426,7 @@ std::unique_ptr<StatementNode> Parser::parseClassDeclaration()
 {
     consume(TOK_CLASS, "Expected 'class'");
     const Token &nameToken = consume(TOK_IDENTIFIER, "Expected class name");
-    auto classNode = std::make_unique<ClassDeclarationNode>(nameToken.value);
+    auto classNode = std::make_unique<ClassDeclarationNode>(std::string(nameToken.value));
     if (peek().type == TOK_EXTENDS) {
         advance();
         classNode->parentClass = consume(TOK_IDENTIFIER, "Expected parent class name").value;
@@ -395,7 +436,7 @@ std::unique_ptr<StatementNode> Parser::parseClassDeclaration()
         advance();
         do {
             classNode->implementsInterfaces.push_back(
-                consume(TOK_IDENTIFIER, "Expected interface name after 'implements'").value);
+                std::string(consume(TOK_IDENTIFIER, "Expected interface name after 'implements'").value));
             if (peek().type == TOK_COMMA) advance();
             else break;
         } while (!isAtEnd());
@@ -442,7 +483,7 @@ std::unique_ptr<StatementNode> Parser::parseEnumDeclaration()
 {
     consume(TOK_ENUM, "Expected 'enum'");
     const Token &nameToken = consume(TOK_IDENTIFIER, "Expected enum name");
-    auto enumNode = std::make_unique<EnumDeclarationNode>(nameToken.value);
+    auto enumNode = std::make_unique<EnumDeclarationNode>(std::string(nameToken.value));
     consume(TOK_LBRACE, "Expected '{' after enum name");
 
     long long nextValue = 0;
@@ -454,10 +495,10 @@ std::unique_ptr<StatementNode> Parser::parseEnumDeclaration()
             if (peek().type == TOK_MINUS) { advance(); negative = true; }
             const Token &valueToken = consume(TOK_INT_LITERAL,
                 "Enum members must be integer constants");
-            long long value = parseIntegerLiteralValue(valueToken.value);
+            long long value = parseIntegerLiteralValue(std::string(valueToken.value));
             nextValue = negative ? -value : value;
         }
-        enumNode->members.emplace_back(memberToken.value, nextValue);
+        enumNode->members.emplace_back(std::string(memberToken.value), nextValue);
         nextValue++;
         if (peek().type == TOK_COMMA) advance();
     }
@@ -517,11 +558,11 @@ std::unique_ptr<StatementNode> Parser::parseThrowStatement()
 std::unique_ptr<TypeAliasNode> Parser::parseTypeAliasStatement() {
     consume(TOK_TYPE, "Expected 'type' keyword");
     const Token &nameToken = consume(TOK_IDENTIFIER, "Expected alias name after 'type'");
-    auto typeAlias = std::make_unique<TypeAliasNode>(nameToken.value, "");
+    auto typeAlias = std::make_unique<TypeAliasNode>(std::string(nameToken.value), "");
     if (peek().type == TOK_LESS) {
         advance();
         while (peek().type != TOK_GREATER) {
-            typeAlias->genericParams.push_back(consume(TOK_IDENTIFIER, "Expected generic parameter name").value);
+            typeAlias->genericParams.push_back(std::string(consume(TOK_IDENTIFIER, "Expected generic parameter name").value));
             if (peek().type == TOK_COMMA) advance();
         }
         consume(TOK_GREATER, "Expected '>' after generic parameters");
@@ -542,7 +583,7 @@ std::unique_ptr<VariableDeclarationNode> Parser::parseVariableDeclarationStateme
         consume(TOK_LET, "Expected 'let' keyword");
     }
     const Token &varNameToken = consume(TOK_IDENTIFIER, "Expected variable name");
-    std::string varName = varNameToken.value;
+    std::string varName(varNameToken.value);
     std::string typeName = "auto";
     if (peek().type == TOK_COLON) {
         consume(TOK_COLON, "Expected ':'");
@@ -603,13 +644,13 @@ std::unique_ptr<StatementNode> Parser::parseAssignmentStatement()
     consume(TOK_EQUAL, "Expected '='");
     std::unique_ptr<ExpressionNode> value = parseExpression();
     consume(TOK_SEMICOLON, "Expected ';'");
-    return std::make_unique<AssignmentStatementNode>(varNameToken.value, std::move(value));
+    return std::make_unique<AssignmentStatementNode>(std::string(varNameToken.value), std::move(value));
 }
 
 std::unique_ptr<StatementNode> Parser::parseArrayAssignmentStatement()
 {
     const Token &arrayNameToken = consume(TOK_IDENTIFIER, "Expected array name");
-    std::unique_ptr<ExpressionNode> arrayExpr = std::make_unique<VariableExpressionNode>(arrayNameToken.value);
+    std::unique_ptr<ExpressionNode> arrayExpr = std::make_unique<VariableExpressionNode>(std::string(arrayNameToken.value));
     consume(TOK_LBRACKET, "Expected '['");
     std::unique_ptr<ExpressionNode> indexExpr = parseExpression();
     consume(TOK_RBRACKET, "Expected ']'");
@@ -637,7 +678,7 @@ std::unique_ptr<StatementNode> Parser::parseForStatement()
         bool isConst = (peek().type == TOK_CONST);
         advance(); // consume let/const
         const Token &varNameToken = consume(TOK_IDENTIFIER, "Expected variable name");
-        auto iterVar = std::make_unique<VariableDeclarationNode>(varNameToken.value, "auto", nullptr, isConst);
+        auto iterVar = std::make_unique<VariableDeclarationNode>(std::string(varNameToken.value), "auto", nullptr, isConst);
         consume(TOK_OF, "Expected 'of'");
         auto iterable = parseExpression();
         consume(TOK_RPAREN, "Expected ')'");
@@ -660,7 +701,7 @@ std::unique_ptr<StatementNode> Parser::parseForStatement()
         if (peek().type == TOK_COLON) { consume(TOK_COLON, "Expected ':'"); typeName = parseType(); }
         consume(TOK_EQUAL, "Expected '='");
         auto initExpr = parseExpression();
-        initialization = std::make_unique<VariableDeclarationNode>(varNameToken.value, typeName, std::move(initExpr), isConst);
+        initialization = std::make_unique<VariableDeclarationNode>(std::string(varNameToken.value), typeName, std::move(initExpr), isConst);
     } else if (peek().type == TOK_IDENTIFIER || peek().type == TOK_THIS) {
         // Parse assignment/expression inline (without consuming semicolon)
         initialization = parseExpressionOrAssignmentStatement(false);
@@ -700,7 +741,7 @@ std::unique_ptr<DoWhileStatementNode> Parser::parseDoWhileStatement()
 std::unique_ptr<FunctionCallNode> Parser::parseFunctionCallStatement()
 {
     const Token &funcNameToken = consume(TOK_IDENTIFIER, "Expected function name");
-    auto callNode = std::make_unique<FunctionCallNode>(funcNameToken.value);
+    auto callNode = std::make_unique<FunctionCallNode>(std::string(funcNameToken.value));
     consume(TOK_LPAREN, "Expected '('");
     if (peek().type != TOK_RPAREN) callNode->arguments.push_back(parseExpression());
     consume(TOK_RPAREN, "Expected ')'");
@@ -865,7 +906,7 @@ std::unique_ptr<ExpressionNode> Parser::parsePrimaryExpression()
     if (peek().type == TOK_STRING_LITERAL) expr = parseStringLiteral();
     else if (peek().type == TOK_INT_LITERAL) expr = parseIntegerLiteral();
     else if (peek().type == TOK_FLOAT_LITERAL) {
-        expr = std::make_unique<FloatLiteralNode>(std::stod(advance().value));
+        expr = std::make_unique<FloatLiteralNode>(std::stod(std::string(advance().value)));
     }
     else if (peek().type == TOK_TRUE || peek().type == TOK_FALSE) expr = parseBooleanLiteral();
     else if (peek().type == TOK_NULL || peek().type == TOK_UNDEFINED) {
@@ -894,7 +935,7 @@ std::unique_ptr<ExpressionNode> Parser::parsePrimaryExpression()
     else if (peek().type == TOK_LBRACKET) expr = parseArrayLiteral();
     else if (peek().type == TOK_LBRACE) expr = parseObjectLiteral();
     else throw std::runtime_error("Parsing failed: Expected an expression, found " +
-                                  std::string(tokenTypeToString(peek().type)) + " ('" + peek().value + "')" +
+                                  std::string(tokenTypeToString(peek().type)) + " ('" + std::string(peek().value) + "')" +
                                   tokenPosition(peek()));
     // Anything can be followed by `.prop`, `[i]` or `.method()`. Chaining here
     // rather than in each producer means it works uniformly for call results,
@@ -960,7 +1001,7 @@ std::unique_ptr<ExpressionNode> Parser::parseArrowFunction()
 
     if (peek().type == TOK_IDENTIFIER) {
         // Single untyped parameter: x => ...   (untyped params default to i32)
-        arrowNode->parameters.emplace_back(advance().value, "i32");
+        arrowNode->parameters.emplace_back(std::string(advance().value), "i32");
     } else {
         consume(TOK_LPAREN, "Expected '(' in arrow function");
         while (peek().type != TOK_RPAREN && !isAtEnd()) {
@@ -970,7 +1011,7 @@ std::unique_ptr<ExpressionNode> Parser::parseArrowFunction()
                 advance();
                 paramType = parseType();
             }
-            arrowNode->parameters.emplace_back(paramName.value, paramType);
+            arrowNode->parameters.emplace_back(std::string(paramName.value), paramType);
             if (peek().type == TOK_COMMA) advance();
             else break;
         }
@@ -997,7 +1038,7 @@ std::unique_ptr<ExpressionNode> Parser::parseArrowFunction()
     return arrowNode;
 }
 
-std::unique_ptr<StringLiteralNode> Parser::parseStringLiteral() { return std::make_unique<StringLiteralNode>(consume(TOK_STRING_LITERAL, "Expected string literal").value); }
+std::unique_ptr<StringLiteralNode> Parser::parseStringLiteral() { return std::make_unique<StringLiteralNode>(std::string(consume(TOK_STRING_LITERAL, "Expected string literal").value)); }
 
 // Parses the literal forms the lexer accepts: 255, 0xFF, 0b1010, 0755.
 // (std::stoll defaults to base 10, which silently truncated "0xFF" to 0.)
@@ -1014,7 +1055,7 @@ static long long parseIntegerLiteralValue(const std::string &text) {
 
 std::unique_ptr<IntegerLiteralNode> Parser::parseIntegerLiteral() {
     return std::make_unique<IntegerLiteralNode>(
-        parseIntegerLiteralValue(consume(TOK_INT_LITERAL, "Expected integer literal").value));
+        parseIntegerLiteralValue(std::string(consume(TOK_INT_LITERAL, "Expected integer literal").value)));
 }
 
 std::unique_ptr<BooleanLiteralNode> Parser::parseBooleanLiteral() {
@@ -1047,7 +1088,7 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
         if (isGeneric && peek().type == TOK_GREATER) {
             consume(TOK_GREATER, "Expected '>'");
             if (peek().type == TOK_LPAREN) {
-                auto callNode = std::make_unique<FunctionCallNode>(varToken.value);
+                auto callNode = std::make_unique<FunctionCallNode>(std::string(varToken.value));
                 consume(TOK_LPAREN, "Expected '('");
                 while (peek().type != TOK_RPAREN && !isAtEnd()) {
                     callNode->arguments.push_back(parseExpression());
@@ -1069,9 +1110,9 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
         const Token &methodToken = consume(TOK_IDENTIFIER, "Expected console method");
         if (methodToken.value != "log" && methodToken.value != "error" &&
             methodToken.value != "warn" && methodToken.value != "info") {
-            throw std::runtime_error("Parse Error: Unsupported console method 'console." + methodToken.value + "'");
+            throw std::runtime_error("Parse Error: Unsupported console method 'console." + std::string(methodToken.value) + "'");
         }
-        consume(TOK_LPAREN, "Expected '(' after console." + methodToken.value);
+        consume(TOK_LPAREN, "Expected '(' after console." + std::string(methodToken.value));
         std::vector<std::unique_ptr<ExpressionNode>> args;
         while (peek().type != TOK_RPAREN && !isAtEnd()) {
             args.push_back(parseExpression());
@@ -1102,9 +1143,9 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
     // An enum member is a compile-time integer: Color.Red becomes 0, so an enum
     // costs nothing at runtime and needs no codegen support at all.
     if (peek().type == TOK_DOT) {
-        auto enumIt = m_enums.find(varToken.value);
+        auto enumIt = m_enums.find(std::string(varToken.value));
         if (enumIt != m_enums.end() && peek(1).type == TOK_IDENTIFIER) {
-            auto memberIt = enumIt->second.find(peek(1).value);
+            auto memberIt = enumIt->second.find(std::string(peek(1).value));
             if (memberIt != enumIt->second.end()) {
                 advance();  // '.'
                 advance();  // member
@@ -1113,8 +1154,8 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
                 literal->column = varToken.column;
                 return literal;
             }
-            throw std::runtime_error("Parse Error: Enum '" + varToken.value +
-                "' has no member '" + peek(1).value + "'" + tokenPosition(peek(1)));
+            throw std::runtime_error("Parse Error: Enum '" + std::string(varToken.value) +
+                "' has no member '" + std::string(peek(1).value) + "'" + tokenPosition(peek(1)));
         }
     }
 
@@ -1171,10 +1212,10 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
         else if (methodToken.value == "ceil") target = "math_ceil";
         else if (methodToken.value == "atan2") target = "math_atan2";
         else if (methodToken.value == "random") target = "math_random";
-        else throw std::runtime_error("Parse Error: Unsupported Math method 'Math." + methodToken.value + "'");
+        else throw std::runtime_error("Parse Error: Unsupported Math method 'Math." + std::string(methodToken.value) + "'");
 
         auto callNode = std::make_unique<FunctionCallNode>(target);
-        consume(TOK_LPAREN, "Expected '(' after Math." + methodToken.value);
+        consume(TOK_LPAREN, "Expected '(' after Math." + std::string(methodToken.value));
         while (peek().type != TOK_RPAREN && !isAtEnd()) {
             callNode->arguments.push_back(parseExpression());
             if (peek().type == TOK_COMMA) advance();
@@ -1187,7 +1228,7 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
     if (varToken.value == "JSON" && peek().type == TOK_DOT) {
         advance();
         const Token &methodToken = consume(TOK_IDENTIFIER, "Expected method");
-        auto callNode = std::make_unique<FunctionCallNode>("JSON." + methodToken.value);
+        auto callNode = std::make_unique<FunctionCallNode>("JSON." + std::string(methodToken.value));
         consume(TOK_LPAREN, "Expected '('");
         if (peek().type != TOK_RPAREN) {
             do {
@@ -1199,7 +1240,7 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
         return callNode;
     }
     if (peek().type == TOK_LPAREN) {
-        auto callNode = std::make_unique<FunctionCallNode>(varToken.value);
+        auto callNode = std::make_unique<FunctionCallNode>(std::string(varToken.value));
         callNode->line = varToken.line;
         callNode->column = varToken.column;
         consume(TOK_LPAREN, "Expected '('");
@@ -1212,7 +1253,7 @@ std::unique_ptr<ExpressionNode> Parser::parseVariableExpression()
         return callNode;
     }
  else {
-        auto varNode = std::make_unique<VariableExpressionNode>(varToken.value);
+        auto varNode = std::make_unique<VariableExpressionNode>(std::string(varToken.value));
         varNode->line = varToken.line;
         varNode->column = varToken.column;
         return parseArrayOrObjectAccess(std::move(varNode));
@@ -1244,7 +1285,7 @@ std::string Parser::parseType() {
         return typeName + ")=>" + retType;
     }
 
-    std::string typeName = advance().value;
+    std::string typeName(advance().value);
     if (peek().type == TOK_LESS) {
         advance(); typeName += "<";
         while (peek().type != TOK_GREATER && !isAtEnd()) {
@@ -1268,7 +1309,7 @@ std::string Parser::parseType() {
 std::unique_ptr<NewExpressionNode> Parser::parseNewExpression() {
     consume(TOK_NEW, "Expected 'new'");
     const Token &nameToken = consume(TOK_IDENTIFIER, "Expected class name");
-    auto newNode = std::make_unique<NewExpressionNode>(nameToken.value);
+    auto newNode = std::make_unique<NewExpressionNode>(std::string(nameToken.value));
     if (peek().type == TOK_LESS) {
         advance();
         while (peek().type != TOK_GREATER) {
@@ -1288,7 +1329,7 @@ std::unique_ptr<NewExpressionNode> Parser::parseNewExpression() {
     return newNode;
 }
 
-std::unique_ptr<ProgramNode> Parser::parse() { try { return parseProgram(); } catch (const std::runtime_error &e) { std::cerr << "Parser Error: " << e.what() << std::endl; return nullptr; } }
+std::unique_ptr<ProgramNode> Parser::parse() { try { return parseProgram(); } catch (const std::runtime_error &e) { m_error = e.what(); return nullptr; } }
 
 std::unique_ptr<ArrayLiteralNode> Parser::parseArrayLiteral()
 {
@@ -1296,8 +1337,8 @@ std::unique_ptr<ArrayLiteralNode> Parser::parseArrayLiteral()
     if (peek().type == TOK_RBRACKET) { advance(); return std::make_unique<ArrayLiteralNode>("i32"); }
     auto firstElement = parseExpression();
     std::string elementType = "i32";
-    if (dynamic_cast<StringLiteralNode*>(firstElement.get())) elementType = "string";
-    else if (dynamic_cast<FloatLiteralNode*>(firstElement.get())) elementType = "f64";
+    if (nodeCast<StringLiteralNode>(firstElement.get())) elementType = "string";
+    else if (nodeCast<FloatLiteralNode>(firstElement.get())) elementType = "f64";
     auto arrayNode = std::make_unique<ArrayLiteralNode>(elementType);
     arrayNode->elements.push_back(std::move(firstElement));
     while (peek().type == TOK_COMMA) { advance(); if (peek().type == TOK_RBRACKET) break; arrayNode->elements.push_back(parseExpression()); }
@@ -1342,7 +1383,7 @@ std::unique_ptr<ExpressionNode> Parser::parseArrayOrObjectAccess(std::unique_ptr
             base = std::make_unique<ArrayAccessNode>(std::move(base), std::move(index));
         } else {
             advance(); if (peek().type != TOK_IDENTIFIER) throw std::runtime_error("Expected property name");
-            std::string property = peek().value; advance();
+            std::string property = std::string(peek().value); advance();
             if (peek().type == TOK_LPAREN) {
                 auto methodCall = std::make_unique<MethodCallNode>(std::move(base), property);
                 advance();
@@ -1367,7 +1408,7 @@ std::unique_ptr<FunctionDeclarationNode> Parser::parseFunctionRest(const std::st
         do {
             const Token &paramName = consume(TOK_IDENTIFIER, "Expected param name");
             consume(TOK_COLON, "Expected ':'");
-            funcNode->parameters.emplace_back(paramName.value, parseType());
+            funcNode->parameters.emplace_back(std::string(paramName.value), parseType());
             if (peek().type == TOK_COMMA) advance();
         } while (peek().type != TOK_RPAREN);
     }
@@ -1396,7 +1437,7 @@ bool Parser::isLinkDirectiveAhead() const
     if (peek(1).type == TOK_STRING_LITERAL) return true;
     if (peek(1).type != TOK_IDENTIFIER) return false;
 
-    auto isQualifier = [](const std::string &word) {
+    auto isQualifier = [](std::string_view word) {
         return word == "framework" || word == "path" || word == "source" ||
                word == "include" ||
                word == "macos" || word == "linux" || word == "windows";
@@ -1417,13 +1458,13 @@ std::unique_ptr<StatementNode> Parser::parseExternDeclaration()
     consume(TOK_FUNCTION, "Expected 'function' after 'declare'");
     const Token &nameToken = consume(TOK_IDENTIFIER, "Expected function name in declare");
 
-    auto node = std::make_unique<ExternDeclarationNode>(nameToken.value, "void");
+    auto node = std::make_unique<ExternDeclarationNode>(std::string(nameToken.value), "void");
     consume(TOK_LPAREN, "Expected '(' in declare");
     if (peek().type != TOK_RPAREN) {
         do {
             const Token &paramName = consume(TOK_IDENTIFIER, "Expected parameter name in declare");
             consume(TOK_COLON, "Expected ':' — declared parameters need explicit types");
-            node->parameters.emplace_back(paramName.value, parseType());
+            node->parameters.emplace_back(std::string(paramName.value), parseType());
             if (peek().type == TOK_COMMA) advance();
         } while (peek().type != TOK_RPAREN && !isAtEnd());
     }
@@ -1454,7 +1495,7 @@ std::unique_ptr<StatementNode> Parser::parseLinkDirective()
 
     // Qualifiers may appear in either order, and either may be omitted
     while (peek().type == TOK_IDENTIFIER) {
-        const std::string &word = peek().value;
+        std::string_view word = peek().value;
         if (word == "framework")      kind = LinkDirectiveNode::Kind::Framework;
         else if (word == "path")      kind = LinkDirectiveNode::Kind::SearchPath;
         else if (word == "source")    kind = LinkDirectiveNode::Kind::Source;
@@ -1468,7 +1509,7 @@ std::unique_ptr<StatementNode> Parser::parseLinkDirective()
 
     const Token &valueToken = consume(TOK_STRING_LITERAL, "Expected a string after 'link'");
     consume(TOK_SEMICOLON, "Expected ';' after link directive");
-    return std::make_unique<LinkDirectiveNode>(kind, valueToken.value, platform);
+    return std::make_unique<LinkDirectiveNode>(kind, std::string(valueToken.value), platform);
 }
 
 std::unique_ptr<FunctionDeclarationNode> Parser::parseFunctionDeclaration()
@@ -1479,12 +1520,12 @@ std::unique_ptr<FunctionDeclarationNode> Parser::parseFunctionDeclaration()
     if (peek().type == TOK_LESS) {
         advance();
         while (peek().type != TOK_GREATER) {
-            genericParams.push_back(consume(TOK_IDENTIFIER, "Expected generic parameter name").value);
+            genericParams.push_back(std::string(consume(TOK_IDENTIFIER, "Expected generic parameter name").value));
             if (peek().type == TOK_COMMA) advance();
         }
         consume(TOK_GREATER, "Expected '>'");
     }
-    auto funcNode = parseFunctionRest(nameToken.value);
+    auto funcNode = parseFunctionRest(std::string(nameToken.value));
     funcNode->genericParams = std::move(genericParams);
     return funcNode;
 }
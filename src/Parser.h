@@ -3,24 +3,39 @@
 #define PARSER_H
 
 #include "Token.h"
+#include "Lexer.h"
 #include "AST.h" // Include our AST node definitions
 #include <vector>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory> // For unique_ptr
 
 class Parser
 {
 private:
-    const std::vector<Token> &m_tokens; // Reference to the token vector from Lexer
+    // Tokens are pulled from the lexer only as far as the parser looks ahead.
+    // The window holds those not yet released: everything from the start of
+    // the current top-level statement, which is as far back as it backtracks.
+    Lexer &m_lexer;
+    std::function<void(const Token &)> m_onToken;
+    mutable std::deque<Token> m_window;
+    mutable size_t m_windowStart = 0;   // Token index of m_window.front()
+    mutable bool m_lexedEof = false;
     // Enum members seen so far, so `Color.Red` can be folded to its value.
     // Enums must therefore be declared before use, like a C enum.
     std::map<std::string, std::map<std::string, long long>> m_enums;
-    size_t m_currentPos = 0;            // Current position in the token vector
+    size_t m_currentPos = 0;            // Index of the current token in the stream
+    // Top-level declarations marked `export`, handed to ProgramNode::exported
+    std::vector<const StatementNode *> m_exported;
+    std::string m_error;                // why parse() gave up, if it did
 
     // Helper methods (private)
     const Token &peek(int offset = 0) const; // Look ahead/behind
     const Token &advance();                  // Consume current token and return it
     bool isAtEnd() const;
+    // Drops tokens before the current one (keeping one, for peek(-1))
+    void releaseConsumedTokens();
     // Tries to consume the next token if it matches the expected type.
     // Returns true on success, false otherwise. Optionally reports error.
     bool match(TokenType expectedType);
@@ -105,12 +120,34 @@ private:
     std::unique_ptr<NewExpressionNode> parseNewExpression();
 
 public:
-    // Constructor takes the vector of tokens
-    explicit Parser(const std::vector<Token> &tokens);
+    // Parses straight from the lexer. onToken, if set, sees every token as it
+    // is lexed (--print-tokens).
+    explicit Parser(Lexer &lexer, std::function<void(const Token &)> onToken = nullptr);
 
     // The main method that initiates parsing
-    // Returns the root of the AST (a ProgramNode)
+    // Returns the root of the AST (a ProgramNode), or nullptr after a syntax
+    // error, which error() then describes
     std::unique_ptr<ProgramNode> parse();
+    const std::string &error() const { return m_error; }
+
+    // Enums declared by modules parsed earlier, so `Color.Red` folds in a module
+    // that imports Color. knownEnums() is what this parse adds to them.
+    void addKnownEnums(const std::map<std::string, std::map<std::string, long long>> &enums);
+    const std::map<std::string, std::map<std::string, long long>> &knownEnums() const { return m_enums; }
+
+    // Statement-at-a-time parsing, for a caller that reuses some top-level
+    // statements instead of parsing them again (IncrementalParser).
+    // nextToken() is where the next statement starts and previousToken() the
+    // last token of the one before. parseNextStatement()
+    // sets `exported` if it was marked `export`, and throws std::runtime_error
+    // on a syntax error.
+    bool atEnd() const { return isAtEnd(); }
+    const Token &nextToken() const { return peek(); }
+    const Token &previousToken() const { return peek(-1); }
+    std::unique_ptr<StatementNode> parseNextStatement(bool &exported);
+
+    // Tokens lexed so far, end-of-file included
+    size_t tokenCount() const { return m_windowStart + m_window.size(); }
 };
 
 #endif // PARSER_H
\ No newline at end of file
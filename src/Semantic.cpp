@@ -9,25 +9,22 @@ void SemanticAnalyzer::fail(const ASTNode *node, const std::string &message) con
     if (node && node->line > 0) {
         position = " at line " + std::to_string(node->line) +
                    ", column " + std::to_string(node->column);
+        if (!m_currentOrigin.empty()) position += " of " + m_currentOrigin;
     }
     throw std::runtime_error("Semantic Error: " + message + position);
 }
 
-void SemanticAnalyzer::pushScope() { m_scopes.emplace_back(); }
-void SemanticAnalyzer::popScope() { m_scopes.pop_back(); }
+void SemanticAnalyzer::pushScope() { m_scopes.pushScope(); }
+void SemanticAnalyzer::popScope() { m_scopes.popScope(); }
 
 void SemanticAnalyzer::declare(const std::string &name, bool isConst, const std::string &type)
 {
-    if (m_scopes.empty()) pushScope();
-    m_scopes.back()[name] = Binding{isConst, type};
+    m_scopes[name] = Binding{isConst, type};
 }
 
 const SemanticAnalyzer::Binding *SemanticAnalyzer::lookup(const std::string &name) const
 {
-    for (auto it = m_scopes.rbegin(); it != m_scopes.rend(); ++it) {
-        auto found = it->find(name);
-        if (found != it->end()) return &found->second;
-    }
+    if (const Binding *local = m_scopes.lookup(name)) return local;
     // Module-level variables remain in scope inside functions
     auto global = m_globals.find(name);
     if (global != m_globals.end()) return &global->second;
@@ -37,7 +34,7 @@ const SemanticAnalyzer::Binding *SemanticAnalyzer::lookup(const std::string &nam
 void SemanticAnalyzer::hoistDeclarations(const std::vector<std::unique_ptr<StatementNode>> &statements)
 {
     for (const auto &stmt : statements) {
-        if (auto *funcDecl = dynamic_cast<FunctionDeclarationNode*>(stmt.get())) {
+        if (auto *funcDecl = nodeCast<FunctionDeclarationNode>(stmt.get())) {
             FunctionSignature signature;
             for (const auto &param : funcDecl->parameters) {
                 signature.parameterTypes.push_back(param.type);
@@ -51,7 +48,8 @@ void SemanticAnalyzer::hoistDeclarations(const std::vector<std::unique_ptr<State
                 signature.returnType = funcDecl->returnType;
             }
             m_functions[funcDecl->functionName] = signature;
-        } else if (auto *externDecl = dynamic_cast<ExternDeclarationNode*>(stmt.get())) {
+            if (funcDecl->isConst) m_constFunctions.insert(funcDecl->functionName);
+        } else if (auto *externDecl = nodeCast<ExternDeclarationNode>(stmt.get())) {
             // Foreign functions are arity- and type-checked just like local ones
             FunctionSignature signature;
             for (const auto &param : externDecl->parameters) {
@@ -59,7 +57,7 @@ void SemanticAnalyzer::hoistDeclarations(const std::vector<std::unique_ptr<State
             }
             signature.returnType = externDecl->returnType;
             m_functions[externDecl->functionName] = signature;
-        } else if (auto *classDecl = dynamic_cast<ClassDeclarationNode*>(stmt.get())) {
+        } else if (auto *classDecl = nodeCast<ClassDeclarationNode>(stmt.get())) {
             m_types.insert(classDecl->className);
             m_classNames.insert(classDecl->className);
             if (!classDecl->parentClass.empty()) {
@@ -74,9 +72,9 @@ void SemanticAnalyzer::hoistDeclarations(const std::vector<std::unique_ptr<State
                     fields[prop.key] = prop.declaredType;
                 }
             }
-        } else if (auto *enumDecl = dynamic_cast<EnumDeclarationNode*>(stmt.get())) {
+        } else if (auto *enumDecl = nodeCast<EnumDeclarationNode>(stmt.get())) {
             m_enumTypes.insert(enumDecl->enumName);
-        } else if (auto *interfaceDecl = dynamic_cast<InterfaceDeclarationNode*>(stmt.get())) {
+        } else if (auto *interfaceDecl = nodeCast<InterfaceDeclarationNode>(stmt.get())) {
             m_types.insert(interfaceDecl->interfaceName);
             auto &members = m_interfaceMembers[interfaceDecl->interfaceName];
             for (const auto &member : interfaceDecl->members) {
@@ -85,11 +83,11 @@ void SemanticAnalyzer::hoistDeclarations(const std::vector<std::unique_ptr<State
             if (!interfaceDecl->parentInterface.empty()) {
                 m_classParents[interfaceDecl->interfaceName] = interfaceDecl->parentInterface;
             }
-        } else if (auto *varDecl = dynamic_cast<VariableDeclarationNode*>(stmt.get())) {
+        } else if (auto *varDecl = nodeCast<VariableDeclarationNode>(stmt.get())) {
             // Module-level variables are visible inside function bodies
             m_globals[varDecl->variableName] =
                 Binding{varDecl->isConst, varDecl->typeName == "auto" ? "" : varDecl->typeName};
-        } else if (auto *destructure = dynamic_cast<DestructuringDeclarationNode*>(stmt.get())) {
+        } else if (auto *destructure = nodeCast<DestructuringDeclarationNode>(stmt.get())) {
             for (const auto &name : destructure->bindings) {
                 m_globals[name] = Binding{destructure->isConst, ""};
             }
@@ -173,6 +171,31 @@ bool SemanticAnalyzer::isClassOrSubclassOf(const std::string &candidate,
     return false;
 }
 
+std::string SemanticAnalyzer::arrayElementOf(const std::string &arrayType)
+{
+    if (arrayType.size() > 2 && arrayType.compare(arrayType.size() - 2, 2, "[]") == 0) {
+        return arrayType.substr(0, arrayType.size() - 2);
+    }
+    return "";
+}
+
+// Mirrors CodeGen::arrayLaneFor, which is what decides the storage
+std::string SemanticAnalyzer::arrayLaneOf(const std::string &elementType) const
+{
+    if (isUnionType(elementType)) return "";
+    if (m_types.count(elementType) || elementType == "ptr" || !arrayElementOf(elementType).empty()) {
+        return "object";
+    }
+    TypeCategory category = categoryOf(elementType);
+    if (category == TypeCategory::Unknown) return "";   // a type parameter, json
+    if (elementType == "string" || elementType.find('<') != std::string::npos) return "string";
+    if (elementType == "number") return "f64";
+    if (elementType == "i8") return "u8";
+    if (m_enumTypes.count(elementType)) return "i32";
+    if (category == TypeCategory::Numeric) return elementType;
+    return "";
+}
+
 bool SemanticAnalyzer::isAssignable(const std::string &target, const std::string &source) const
 {
     if (target.empty() || source.empty()) return true;   // unknown: stay quiet
@@ -203,6 +226,19 @@ bool SemanticAnalyzer::isAssignable(const std::string &target, const std::string
         return ct != TypeCategory::Numeric && ct != TypeCategory::Void;
     }
 
+    // An array is indexed in place at its element type's width, so it only
+    // fits a slot whose elements are stored the same way: an i32[] read as an
+    // f64[] runs eight bytes at a time off the end of its storage
+    std::string targetElement = arrayElementOf(target);
+    std::string sourceElement = arrayElementOf(source);
+    if (!targetElement.empty() && !sourceElement.empty()) {
+        std::string targetLane = arrayLaneOf(targetElement);
+        std::string sourceLane = arrayLaneOf(sourceElement);
+        if (targetLane.empty() || sourceLane.empty()) return true;
+        if (targetLane != sourceLane) return false;
+        return targetLane != "object" || isAssignable(targetElement, sourceElement);
+    }
+
     TypeCategory ct = categoryOf(target);
     TypeCategory cs = categoryOf(source);
     if (ct == TypeCategory::Unknown || cs == TypeCategory::Unknown) return true;
@@ -233,42 +269,70 @@ void SemanticAnalyzer::checkAssignable(const ASTNode *node, const std::string &t
                "', got '" + source + "'");
 }
 
+void SemanticAnalyzer::fitArrayLiteral(ExpressionNode *expr, const std::string &target)
+{
+    auto *arrLit = nodeCast<ArrayLiteralNode>(expr);
+    if (!arrLit || target.size() < 3 || target.compare(target.size() - 2, 2, "[]") != 0) return;
+    std::string elementType = target.substr(0, target.size() - 2);
+    if (arrLit->elementType == elementType) return;
+    for (const auto &element : arrLit->elements) {
+        fitArrayLiteral(element.get(), elementType);
+        if (!isAssignable(elementType, typeOf(element.get()))) return;
+    }
+    // The parser guessed from the first element; the slot knows. Every
+    // operation on the array picks its storage from this type, so the
+    // literal has to be built as one.
+    arrLit->elementType = elementType;
+    arrLit->typeResolved = false;
+}
+
 std::string SemanticAnalyzer::typeOf(ExpressionNode *expr)
 {
     if (!expr) return "";
+    if (expr->typeResolved) return expr->resolvedType.str();
+    std::string type = inferTypeOf(expr);
+    expr->resolvedType = internTypeName(type);
+    expr->typeResolved = true;
+    return type;
+}
 
-    if (dynamic_cast<IntegerLiteralNode*>(expr))  return "i32";
-    if (dynamic_cast<FloatLiteralNode*>(expr))    return "f64";
-    if (dynamic_cast<StringLiteralNode*>(expr))   return "string";
-    if (dynamic_cast<BooleanLiteralNode*>(expr))  return "boolean";
-    if (dynamic_cast<NullLiteralNode*>(expr))     return "null";
+std::string SemanticAnalyzer::inferTypeOf(ExpressionNode *expr)
+{
+    if (nodeCast<IntegerLiteralNode>(expr))  return "i32";
+    if (nodeCast<FloatLiteralNode>(expr))    return "f64";
+    if (nodeCast<StringLiteralNode>(expr))   return "string";
+    if (nodeCast<BooleanLiteralNode>(expr))  return "boolean";
+    if (nodeCast<NullLiteralNode>(expr))     return "null";
 
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
-        if (varExpr->name == "this") return "";
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
+        if (varExpr->name == "this") return m_currentClass;   // "" in object literals
         const Binding *binding = lookup(varExpr->name);
         return binding ? binding->type : "";
     }
-    if (auto *newExpr = dynamic_cast<NewExpressionNode*>(expr)) {
+    if (auto *newExpr = nodeCast<NewExpressionNode>(expr)) {
         // Map/Set and other generics stay unknown; a class instance is its class
         if (m_types.count(newExpr->className)) return newExpr->className;
         if (newExpr->className == "Buffer" && !newExpr->genericTypes.empty()) {
             return "Buffer<" + newExpr->genericTypes[0] + ">";
         }
+        if (newExpr->className == "Array" && newExpr->genericTypes.size() == 1) {
+            return newExpr->genericTypes[0] + "[]";
+        }
         return "";
     }
-    if (auto *call = dynamic_cast<FunctionCallNode*>(expr)) {
+    if (auto *call = nodeCast<FunctionCallNode>(expr)) {
         auto it = m_functions.find(call->functionName);
         if (it != m_functions.end()) return it->second.returnType;
         return "";
     }
-    if (auto *unary = dynamic_cast<UnaryExpressionNode*>(expr)) {
+    if (auto *unary = nodeCast<UnaryExpressionNode>(expr)) {
         if (unary->op == UnaryExpressionNode::NOT) return "boolean";
         return typeOf(unary->operand.get());
     }
-    if (auto *update = dynamic_cast<UpdateExpressionNode*>(expr)) {
+    if (auto *update = nodeCast<UpdateExpressionNode>(expr)) {
         return typeOf(update->target.get());   // `i++` has the type of `i`
     }
-    if (auto *binary = dynamic_cast<BinaryExpressionNode*>(expr)) {
+    if (auto *binary = nodeCast<BinaryExpressionNode>(expr)) {
         switch (binary->op) {
             case BinaryExpressionNode::EQUAL:
             case BinaryExpressionNode::NOT_EQUAL:
@@ -301,14 +365,14 @@ std::string SemanticAnalyzer::typeOf(ExpressionNode *expr)
         if (left == "i32" && right == "i32") return "i32";
         return "";
     }
-    if (auto *arrLit = dynamic_cast<ArrayLiteralNode*>(expr)) {
+    if (auto *arrLit = nodeCast<ArrayLiteralNode>(expr)) {
         if (!arrLit->elementType.empty()) return arrLit->elementType + "[]";
         return "";
     }
-    if (auto *arrAccess = dynamic_cast<ArrayAccessNode*>(expr)) {
+    if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr)) {
         return elementTypeOf(typeOf(arrAccess->array.get()));
     }
-    if (auto *objAccess = dynamic_cast<ObjectAccessNode*>(expr)) {
+    if (auto *objAccess = nodeCast<ObjectAccessNode>(expr)) {
         if (objAccess->property == "length") return "i32";
         // A class field's declared type is known; anything else is not
         std::string objectType = typeOf(objAccess->object.get());
@@ -320,9 +384,23 @@ std::string SemanticAnalyzer::typeOf(ExpressionNode *expr)
         return "";
     }
 
-    if (auto *methodCall = dynamic_cast<MethodCallNode*>(expr)) {
-        // Only class methods; array/Map/Set methods are the runtime's, not ours
+    if (auto *methodCall = nodeCast<MethodCallNode>(expr)) {
+        // Class methods, and the array methods whose result type follows from
+        // the array's own; Map/Set and the rest stay unknown
         std::string objectType = typeOf(methodCall->object.get());
+        std::string elementType = elementTypeOf(objectType);
+        if (!elementType.empty()) {
+            const std::string &method = methodCall->methodName;
+            if (method == "filter") return objectType;
+            if (method == "pop" || method == "shift") return elementType;
+            if ((method == "map" || method == "reduce") && !methodCall->arguments.empty()) {
+                // Only a declared callback return type; the body is analyzed later
+                auto *callback = nodeCast<ArrowFunctionNode>(methodCall->arguments[0].get());
+                if (!callback || callback->returnType.empty() || callback->returnType == "auto") return "";
+                return method == "map" ? callback->returnType + "[]" : callback->returnType;
+            }
+            return "";
+        }
         auto classIt = m_classMethods.find(objectType);
         if (classIt != m_classMethods.end()) {
             auto methodIt = classIt->second.find(methodCall->methodName);
@@ -376,14 +454,14 @@ const std::map<std::string, std::string> *SemanticAnalyzer::membersOf(Expression
     if (!expr) return nullptr;
 
     // A variable initialized from an object literal keeps that literal's shape
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
         auto shapeIt = m_variableShapes.find(varExpr->name);
         if (shapeIt != m_variableShapes.end()) {
             auto literalIt = m_literalShapes.find(shapeIt->second);
             if (literalIt != m_literalShapes.end()) return &literalIt->second;
         }
     }
-    if (auto *literal = dynamic_cast<ObjectLiteralNode*>(expr)) {
+    if (auto *literal = nodeCast<ObjectLiteralNode>(expr)) {
         auto literalIt = m_literalShapes.find(literal);
         if (literalIt != m_literalShapes.end()) return &literalIt->second;
     }
@@ -403,7 +481,7 @@ void SemanticAnalyzer::checkImplementsClauses(
     const std::vector<std::unique_ptr<StatementNode>> &statements)
 {
     for (const auto &stmt : statements) {
-        auto *classDecl = dynamic_cast<ClassDeclarationNode*>(stmt.get());
+        auto *classDecl = nodeCast<ClassDeclarationNode>(stmt.get());
         if (!classDecl || classDecl->implementsInterfaces.empty()) continue;
 
         const auto &fields = m_classFields[classDecl->className];
@@ -439,8 +517,9 @@ void SemanticAnalyzer::checkImplementsClauses(
 void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
 {
     if (!expr) return;
+    typeOf(expr);   // resolve it now, in this scope, for codegen to reuse
 
-    if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(expr)) {
+    if (auto *varExpr = nodeCast<VariableExpressionNode>(expr)) {
         if (varExpr->name == "this") {
             if (!m_inMethod) fail(varExpr, "'this' can only be used inside a method");
             return;
@@ -448,16 +527,16 @@ void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
         if (!lookup(varExpr->name) && !m_functions.count(varExpr->name)) {
             fail(varExpr, "Use of undefined variable '" + varExpr->name + "'");
         }
-    } else if (auto *binOp = dynamic_cast<BinaryExpressionNode*>(expr)) {
+    } else if (auto *binOp = nodeCast<BinaryExpressionNode>(expr)) {
         analyzeExpression(binOp->left.get());
         analyzeExpression(binOp->right.get());
-    } else if (auto *unaryOp = dynamic_cast<UnaryExpressionNode*>(expr)) {
+    } else if (auto *unaryOp = nodeCast<UnaryExpressionNode>(expr)) {
         analyzeExpression(unaryOp->operand.get());
-    } else if (auto *update = dynamic_cast<UpdateExpressionNode*>(expr)) {
+    } else if (auto *update = nodeCast<UpdateExpressionNode>(expr)) {
         // `i++` writes to its target, so it has to respect const the same way
         // `i = i + 1` does — the statement-level check never sees it now that
         // this is an expression.
-        if (auto *varExpr = dynamic_cast<VariableExpressionNode*>(update->target.get())) {
+        if (auto *varExpr = nodeCast<VariableExpressionNode>(update->target.get())) {
             const Binding *binding = lookup(varExpr->name);
             if (binding && binding->isConst) {
                 fail(update, "Cannot reassign const variable '" + varExpr->name + "'");
@@ -470,7 +549,7 @@ void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
                          "' requires a numeric operand, got '" + targetType + "'");
         }
         analyzeExpression(update->target.get());
-    } else if (auto *call = dynamic_cast<FunctionCallNode*>(expr)) {
+    } else if (auto *call = nodeCast<FunctionCallNode>(expr)) {
         auto fnIt = m_functions.find(call->functionName);
         if (fnIt != m_functions.end() &&
             call->arguments.size() != fnIt->second.parameterTypes.size()) {
@@ -485,14 +564,15 @@ void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
         if (fnIt != m_functions.end()) {
             const auto &parameterTypes = fnIt->second.parameterTypes;
             for (size_t i = 0; i < call->arguments.size() && i < parameterTypes.size(); ++i) {
+                fitArrayLiteral(call->arguments[i].get(), parameterTypes[i]);
                 checkAssignable(call->arguments[i].get(), parameterTypes[i],
                                 typeOf(call->arguments[i].get()),
                                 "in argument " + std::to_string(i + 1) + " of '" +
                                 call->functionName + "'");
             }
         }
-    } else if (auto *method = dynamic_cast<MethodCallNode*>(expr)) {
-        if (dynamic_cast<SuperExpressionNode*>(method->object.get())) {
+    } else if (auto *method = nodeCast<MethodCallNode>(expr)) {
+        if (nodeCast<SuperExpressionNode>(method->object.get())) {
             if (!m_inMethod || m_currentClass.empty()) {
                 fail(method, "'super' can only be used inside a class method");
             }
@@ -504,10 +584,10 @@ void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
         }
         analyzeExpression(method->object.get());
         for (const auto &arg : method->arguments) analyzeExpression(arg.get());
-    } else if (auto *arrAccess = dynamic_cast<ArrayAccessNode*>(expr)) {
+    } else if (auto *arrAccess = nodeCast<ArrayAccessNode>(expr)) {
         analyzeExpression(arrAccess->array.get());
         analyzeExpression(arrAccess->index.get());
-    } else if (auto *objAccess = dynamic_cast<ObjectAccessNode*>(expr)) {
+    } else if (auto *objAccess = nodeCast<ObjectAccessNode>(expr)) {
         analyzeExpression(objAccess->object.get());
 
         // `.length` is valid on arrays and strings, never a declared member
@@ -540,9 +620,9 @@ void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
                 }
             }
         }
-    } else if (auto *arrLit = dynamic_cast<ArrayLiteralNode*>(expr)) {
+    } else if (auto *arrLit = nodeCast<ArrayLiteralNode>(expr)) {
         for (const auto &element : arrLit->elements) analyzeExpression(element.get());
-    } else if (auto *objLit = dynamic_cast<ObjectLiteralNode*>(expr)) {
+    } else if (auto *objLit = nodeCast<ObjectLiteralNode>(expr)) {
         recordLiteralShape(objLit);
         for (const auto &prop : objLit->properties) {
             if (prop.method) {
@@ -552,9 +632,9 @@ void SemanticAnalyzer::analyzeExpression(ExpressionNode *expr)
                 analyzeExpression(prop.value.get());
             }
         }
-    } else if (auto *newExpr = dynamic_cast<NewExpressionNode*>(expr)) {
+    } else if (auto *newExpr = nodeCast<NewExpressionNode>(expr)) {
         for (const auto &arg : newExpr->arguments) analyzeExpression(arg.get());
-    } else if (auto *arrowFn = dynamic_cast<ArrowFunctionNode*>(expr)) {
+    } else if (auto *arrowFn = nodeCast<ArrowFunctionNode>(expr)) {
         // Arrows capture the enclosing scope, so analyze inside the current scopes
         pushScope();
         for (const auto &param : arrowFn->parameters) declare(param.name, false);
@@ -575,9 +655,7 @@ void SemanticAnalyzer::analyzeFunctionBody(
     const std::string &returnType, const std::string &className)
 {
     // Function/method bodies do NOT see enclosing local scopes
-    std::vector<std::map<std::string, Binding>> savedScopes;
-    savedScopes.swap(m_scopes);
-    pushScope();
+    m_scopes.pushScope(/*isolated=*/true);
 
     bool savedInMethod = m_inMethod;
     int savedLoopDepth = m_loopDepth;
@@ -601,16 +679,17 @@ void SemanticAnalyzer::analyzeFunctionBody(
     m_currentReturnType = savedReturnType;
     m_inFunction = savedInFunction;
     m_currentClass = savedClass;
-    m_scopes.swap(savedScopes);
+    m_scopes.popScope();
 }
 
 void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
 {
     if (!stmt) return;
 
-    if (auto *varDecl = dynamic_cast<VariableDeclarationNode*>(stmt)) {
+    if (auto *varDecl = nodeCast<VariableDeclarationNode>(stmt)) {
         analyzeExpression(varDecl->initializer.get());
         std::string declaredType = (varDecl->typeName == "auto") ? "" : varDecl->typeName;
+        fitArrayLiteral(varDecl->initializer.get(), declaredType);
         std::string initializerType = typeOf(varDecl->initializer.get());
         if (!declaredType.empty() && varDecl->initializer) {
             checkAssignable(varDecl->initializer.get(), declaredType, initializerType,
@@ -621,15 +700,15 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
                 declaredType.empty() ? initializerType : declaredType);
 
         // Remember which literal shaped this variable, so `o.missing` is caught
-        if (auto *literal = dynamic_cast<ObjectLiteralNode*>(varDecl->initializer.get())) {
+        if (auto *literal = nodeCast<ObjectLiteralNode>(varDecl->initializer.get())) {
             m_variableShapes[varDecl->variableName] = literal;
         } else {
             m_variableShapes.erase(varDecl->variableName);
         }
-    } else if (auto *destruct = dynamic_cast<DestructuringDeclarationNode*>(stmt)) {
+    } else if (auto *destruct = nodeCast<DestructuringDeclarationNode>(stmt)) {
         analyzeExpression(destruct->initializer.get());
         for (const auto &name : destruct->bindings) declare(name, destruct->isConst, "");
-    } else if (auto *assign = dynamic_cast<AssignmentStatementNode*>(stmt)) {
+    } else if (auto *assign = nodeCast<AssignmentStatementNode>(stmt)) {
         const Binding *binding = lookup(assign->variableName);
         if (!binding) {
             fail(assign, "Assignment to undefined variable '" + assign->variableName + "'");
@@ -638,18 +717,24 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
             fail(assign, "Cannot reassign const variable '" + assign->variableName + "'");
         }
         analyzeExpression(assign->value.get());
+        fitArrayLiteral(assign->value.get(), binding->type);
         checkAssignable(assign->value.get(), binding->type, typeOf(assign->value.get()),
                         "in assignment to '" + assign->variableName + "'");
-    } else if (auto *arrAssign = dynamic_cast<ArrayAssignmentStatementNode*>(stmt)) {
+    } else if (auto *arrAssign = nodeCast<ArrayAssignmentStatementNode>(stmt)) {
         analyzeExpression(arrAssign->array.get());
         analyzeExpression(arrAssign->index.get());
         analyzeExpression(arrAssign->value.get());
-    } else if (auto *propAssign = dynamic_cast<ObjectPropertyAssignmentNode*>(stmt)) {
+    } else if (auto *propAssign = nodeCast<ObjectPropertyAssignmentNode>(stmt)) {
         analyzeExpression(propAssign->object.get());
         analyzeExpression(propAssign->value.get());
-    } else if (auto *exprStmt = dynamic_cast<ExpressionStatementNode*>(stmt)) {
+        auto classIt = m_classFields.find(typeOf(propAssign->object.get()));
+        if (classIt != m_classFields.end()) {
+            auto fieldIt = classIt->second.find(propAssign->property);
+            if (fieldIt != classIt->second.end()) fitArrayLiteral(propAssign->value.get(), fieldIt->second);
+        }
+    } else if (auto *exprStmt = nodeCast<ExpressionStatementNode>(stmt)) {
         analyzeExpression(exprStmt->expression.get());
-    } else if (auto *ifStmt = dynamic_cast<IfStatementNode*>(stmt)) {
+    } else if (auto *ifStmt = nodeCast<IfStatementNode>(stmt)) {
         analyzeExpression(ifStmt->condition.get());
         pushScope();
         analyzeStatementList(ifStmt->thenStatements);
@@ -657,21 +742,21 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
         pushScope();
         analyzeStatementList(ifStmt->elseStatements);
         popScope();
-    } else if (auto *whileStmt = dynamic_cast<WhileStatementNode*>(stmt)) {
+    } else if (auto *whileStmt = nodeCast<WhileStatementNode>(stmt)) {
         analyzeExpression(whileStmt->condition.get());
         pushScope();
         m_loopDepth++;
         analyzeStatementList(whileStmt->bodyStatements);
         m_loopDepth--;
         popScope();
-    } else if (auto *doWhile = dynamic_cast<DoWhileStatementNode*>(stmt)) {
+    } else if (auto *doWhile = nodeCast<DoWhileStatementNode>(stmt)) {
         pushScope();
         m_loopDepth++;
         analyzeStatementList(doWhile->bodyStatements);
         m_loopDepth--;
         popScope();
         analyzeExpression(doWhile->condition.get());
-    } else if (auto *forStmt = dynamic_cast<ForStatementNode*>(stmt)) {
+    } else if (auto *forStmt = nodeCast<ForStatementNode>(stmt)) {
         pushScope();
         if (forStmt->initialization) analyzeStatement(forStmt->initialization.get());
         analyzeExpression(forStmt->condition.get());
@@ -680,7 +765,7 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
         analyzeStatementList(forStmt->bodyStatements);
         m_loopDepth--;
         popScope();
-    } else if (auto *forOf = dynamic_cast<ForOfStatementNode*>(stmt)) {
+    } else if (auto *forOf = nodeCast<ForOfStatementNode>(stmt)) {
         analyzeExpression(forOf->iterable.get());
         pushScope();
         declare(forOf->iteratorVariable->variableName, forOf->iteratorVariable->isConst);
@@ -688,7 +773,7 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
         analyzeStatementList(forOf->bodyStatements);
         m_loopDepth--;
         popScope();
-    } else if (auto *switchStmt = dynamic_cast<SwitchStatementNode*>(stmt)) {
+    } else if (auto *switchStmt = nodeCast<SwitchStatementNode>(stmt)) {
         analyzeExpression(switchStmt->condition.get());
         pushScope();
         m_switchDepth++;
@@ -698,7 +783,7 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
         }
         m_switchDepth--;
         popScope();
-    } else if (auto *tryStmt = dynamic_cast<TryCatchStatementNode*>(stmt)) {
+    } else if (auto *tryStmt = nodeCast<TryCatchStatementNode>(stmt)) {
         pushScope();
         analyzeStatementList(tryStmt->tryStatements);
         popScope();
@@ -709,27 +794,33 @@ void SemanticAnalyzer::analyzeStatement(StatementNode *stmt)
         pushScope();
         analyzeStatementList(tryStmt->finallyStatements);
         popScope();
-    } else if (auto *retStmt = dynamic_cast<ReturnStatementNode*>(stmt)) {
+    } else if (auto *retStmt = nodeCast<ReturnStatementNode>(stmt)) {
         analyzeExpression(retStmt->expression.get());
         if (m_inFunction && retStmt->expression && m_currentReturnType != "void") {
+            fitArrayLiteral(retStmt->expression.get(), m_currentReturnType);
             checkAssignable(retStmt->expression.get(), m_currentReturnType,
                             typeOf(retStmt->expression.get()), "in return value");
         }
-    } else if (auto *throwStmt = dynamic_cast<ThrowStatementNode*>(stmt)) {
+    } else if (auto *throwStmt = nodeCast<ThrowStatementNode>(stmt)) {
         analyzeExpression(throwStmt->expression.get());
-    } else if (dynamic_cast<BreakStatementNode*>(stmt)) {
+    } else if (nodeCast<BreakStatementNode>(stmt)) {
         if (m_loopDepth == 0 && m_switchDepth == 0) {
             fail(stmt, "'break' used outside of a loop or switch");
         }
-    } else if (dynamic_cast<ContinueStatementNode*>(stmt)) {
+    } else if (nodeCast<ContinueStatementNode>(stmt)) {
         if (m_loopDepth == 0) {
             fail(stmt, "'continue' used outside of a loop");
         }
-    } else if (auto *funcDecl = dynamic_cast<FunctionDeclarationNode*>(stmt)) {
+    } else if (auto *funcDecl = nodeCast<FunctionDeclarationNode>(stmt)) {
         // A generic function's annotations are type variables, so nothing to check
         std::string returnType = funcDecl->genericParams.empty() ? funcDecl->returnType : "";
+        if (funcDecl->isConst && m_inFunction) {
+            fail(funcDecl, "const function '" + funcDecl->functionName +
+                           "' must be declared at module level");
+        }
         analyzeFunctionBody(funcDecl->parameters, funcDecl->bodyStatements, false, returnType);
-    } else if (auto *classDecl = dynamic_cast<ClassDeclarationNode*>(stmt)) {
+        if (funcDecl->isConst) checkConstFunction(funcDecl);
+    } else if (auto *classDecl = nodeCast<ClassDeclarationNode>(stmt)) {
         m_types.insert(classDecl->className);
         for (const auto &prop : classDecl->objectTemplate->properties) {
             if (prop.method) {
@@ -765,6 +856,7 @@ void SemanticAnalyzer::analyze(ProgramNode *program)
     m_variableShapes.clear();
     m_currentReturnType.clear();
     m_inFunction = false;
+    m_currentOrigin.clear();
     m_loopDepth = 0;
     m_switchDepth = 0;
     m_inMethod = false;
@@ -785,6 +877,172 @@ void SemanticAnalyzer::analyze(ProgramNode *program)
         }
     }
     checkImplementsClauses(program->statements);
-    analyzeStatementList(program->statements);
+    if (program->statementOrigins.size() == program->statements.size()) {
+        for (size_t i = 0; i < program->statements.size(); ++i) {
+            m_currentOrigin = program->statementOrigins[i];
+            analyzeStatement(program->statements[i].get());
+        }
+        m_currentOrigin.clear();
+    } else {
+        analyzeStatementList(program->statements);
+    }
     popScope();
 }
+
+// --- Const functions ---
+
+namespace {
+
+// What a const function's parameters and result may be: numbers, booleans,
+// and arrays and Buffers of them
+bool isConstEvaluableType(const std::string &type)
+{
+    static const std::set<std::string> scalars = {"i32", "i64", "i8", "u8", "f32", "f64", "number",
+                                                  "boolean"};
+    if (scalars.count(type)) return true;
+    if (type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0) {
+        return scalars.count(type.substr(0, type.size() - 2)) > 0;
+    }
+    if (type.rfind("Buffer<", 0) == 0 && type.back() == '>') {
+        return scalars.count(type.substr(7, type.size() - 8)) > 0;
+    }
+    return false;
+}
+
+} // namespace
+
+void SemanticAnalyzer::checkConstFunction(const FunctionDeclarationNode *func)
+{
+    const std::string &name = func->functionName;
+    if (!func->genericParams.empty()) {
+        fail(func, "const function '" + name + "' cannot be generic");
+    }
+    if (!isConstEvaluableType(func->returnType)) {
+        fail(func, "const function '" + name + "' cannot return '" + func->returnType +
+                   "'; a const function returns a number, a boolean, or an array or "
+                   "Buffer of them");
+    }
+    std::set<std::string> locals;
+    for (const auto &param : func->parameters) {
+        if (!isConstEvaluableType(param.type)) {
+            fail(func, "const function '" + name + "' cannot take parameter '" + param.name +
+                       "' of type '" + param.type + "'");
+        }
+        locals.insert(param.name);
+    }
+    for (const auto &stmt : func->bodyStatements) checkConstStatement(stmt.get(), func, locals);
+}
+
+void SemanticAnalyzer::checkConstStatement(const StatementNode *stmt,
+                                           const FunctionDeclarationNode *func,
+                                           std::set<std::string> &locals)
+{
+    if (!stmt) return;
+    auto checkBody = [&](const std::vector<std::unique_ptr<StatementNode>> &body) {
+        for (const auto &inner : body) checkConstStatement(inner.get(), func, locals);
+    };
+
+    if (auto *varDecl = nodeCast<const VariableDeclarationNode>(stmt)) {
+        checkConstExpression(varDecl->initializer.get(), func, locals);
+        locals.insert(varDecl->variableName);
+    } else if (auto *assign = nodeCast<const AssignmentStatementNode>(stmt)) {
+        if (!locals.count(assign->variableName)) {
+            fail(stmt, "const function '" + func->functionName + "' assigns '" +
+                       assign->variableName + "', which is not one of its locals");
+        }
+        checkConstExpression(assign->value.get(), func, locals);
+    } else if (auto *arrAssign = nodeCast<const ArrayAssignmentStatementNode>(stmt)) {
+        checkConstExpression(arrAssign->array.get(), func, locals);
+        checkConstExpression(arrAssign->index.get(), func, locals);
+        checkConstExpression(arrAssign->value.get(), func, locals);
+    } else if (auto *exprStmt = nodeCast<const ExpressionStatementNode>(stmt)) {
+        checkConstExpression(exprStmt->expression.get(), func, locals);
+    } else if (auto *ifStmt = nodeCast<const IfStatementNode>(stmt)) {
+        checkConstExpression(ifStmt->condition.get(), func, locals);
+        checkBody(ifStmt->thenStatements);
+        checkBody(ifStmt->elseStatements);
+    } else if (auto *whileStmt = nodeCast<const WhileStatementNode>(stmt)) {
+        checkConstExpression(whileStmt->condition.get(), func, locals);
+        checkBody(whileStmt->bodyStatements);
+    } else if (auto *doWhileStmt = nodeCast<const DoWhileStatementNode>(stmt)) {
+        checkBody(doWhileStmt->bodyStatements);
+        checkConstExpression(doWhileStmt->condition.get(), func, locals);
+    } else if (auto *forStmt = nodeCast<const ForStatementNode>(stmt)) {
+        checkConstStatement(forStmt->initialization.get(), func, locals);
+        checkConstExpression(forStmt->condition.get(), func, locals);
+        checkConstStatement(forStmt->increment.get(), func, locals);
+        checkBody(forStmt->bodyStatements);
+    } else if (auto *forOfStmt = nodeCast<const ForOfStatementNode>(stmt)) {
+        checkConstExpression(forOfStmt->iterable.get(), func, locals);
+        locals.insert(forOfStmt->iteratorVariable->variableName);
+        checkBody(forOfStmt->bodyStatements);
+    } else if (auto *retStmt = nodeCast<const ReturnStatementNode>(stmt)) {
+        checkConstExpression(retStmt->expression.get(), func, locals);
+    } else if (!nodeCast<const BreakStatementNode>(stmt) && !nodeCast<const ContinueStatementNode>(stmt)) {
+        std::string what = nodeCast<const SwitchStatementNode>(stmt) ? "'switch'"
+                         : nodeCast<const TryCatchStatementNode>(stmt) ? "'try'"
+                         : nodeCast<const ThrowStatementNode>(stmt) ? "'throw'"
+                         : nodeCast<const FunctionDeclarationNode>(stmt) ? "a nested function"
+                         : nodeCast<const ObjectPropertyAssignmentNode>(stmt) ? "assigning a property"
+                         : "this statement";
+        fail(stmt, what + " is not allowed in const function '" + func->functionName + "'");
+    }
+}
+
+void SemanticAnalyzer::checkConstExpression(const ExpressionNode *expr,
+                                            const FunctionDeclarationNode *func,
+                                            const std::set<std::string> &locals)
+{
+    if (!expr) return;
+    const std::string &name = func->functionName;
+    auto notAllowed = [&](const std::string &what) {
+        fail(expr, what + " is not allowed in const function '" + name + "'");
+    };
+
+    if (nodeCast<const IntegerLiteralNode>(expr) || nodeCast<const FloatLiteralNode>(expr) ||
+        nodeCast<const BooleanLiteralNode>(expr)) {
+        return;
+    }
+    if (auto *varExpr = nodeCast<const VariableExpressionNode>(expr)) {
+        if (!locals.count(varExpr->name)) {
+            fail(expr, "const function '" + name + "' reads '" + varExpr->name +
+                       "', which is not one of its parameters or locals");
+        }
+    } else if (auto *binOp = nodeCast<const BinaryExpressionNode>(expr)) {
+        checkConstExpression(binOp->left.get(), func, locals);
+        checkConstExpression(binOp->right.get(), func, locals);
+    } else if (auto *unaryOp = nodeCast<const UnaryExpressionNode>(expr)) {
+        checkConstExpression(unaryOp->operand.get(), func, locals);
+    } else if (auto *updateExpr = nodeCast<const UpdateExpressionNode>(expr)) {
+        checkConstExpression(updateExpr->target.get(), func, locals);
+    } else if (auto *call = nodeCast<const FunctionCallNode>(expr)) {
+        bool pureMath = call->functionName.rfind("math_", 0) == 0 && call->functionName != "math_random";
+        if (!m_constFunctions.count(call->functionName) && !pureMath) {
+            std::string callee = call->functionName == "math_random" ? "Math.random" : call->functionName;
+            fail(expr, "const function '" + name + "' calls '" + callee +
+                       "', which is not a const function");
+        }
+        for (const auto &arg : call->arguments) checkConstExpression(arg.get(), func, locals);
+    } else if (auto *arrLit = nodeCast<const ArrayLiteralNode>(expr)) {
+        for (const auto &element : arrLit->elements) checkConstExpression(element.get(), func, locals);
+    } else if (auto *access = nodeCast<const ArrayAccessNode>(expr)) {
+        checkConstExpression(access->array.get(), func, locals);
+        checkConstExpression(access->index.get(), func, locals);
+    } else if (auto *objAccess = nodeCast<const ObjectAccessNode>(expr)) {
+        if (objAccess->property != "length") notAllowed("property '." + objAccess->property + "'");
+        checkConstExpression(objAccess->object.get(), func, locals);
+    } else if (auto *methodCall = nodeCast<const MethodCallNode>(expr)) {
+        if (methodCall->methodName != "push") notAllowed("'." + methodCall->methodName + "()'");
+        checkConstExpression(methodCall->object.get(), func, locals);
+        for (const auto &arg : methodCall->arguments) checkConstExpression(arg.get(), func, locals);
+    } else if (auto *newExpr = nodeCast<const NewExpressionNode>(expr)) {
+        if (newExpr->className != "Buffer") notAllowed("'new " + newExpr->className + "'");
+        for (const auto &arg : newExpr->arguments) checkConstExpression(arg.get(), func, locals);
+    } else {
+        notAllowed(nodeCast<const StringLiteralNode>(expr) ? "a string"
+                 : nodeCast<const NullLiteralNode>(expr) ? "'null'"
+                 : nodeCast<const ArrowFunctionNode>(expr) ? "a closure"
+                 : nodeCast<const ObjectLiteralNode>(expr) ? "an object literal"
+                 : "this expression");
+    }
+}
@@ -5,6 +5,7 @@
 //   - break/continue outside loops/switch
 //   - wrong argument counts for user-defined functions
 //   - type mismatches at declarations, assignments, returns and call arguments
+//   - anything in a `const function` that compile-time evaluation cannot run
 //
 // TYPE CHECKING POLICY: report an error only when both sides are confidently
 // known and definitely incompatible. Cypescript has plenty of places where a
@@ -16,6 +17,7 @@
 #define SEMANTIC_H
 
 #include "AST.h"
+#include "SymbolTable.h"
 #include <map>
 #include <set>
 #include <string>
@@ -43,8 +45,9 @@ private:
     // already coerces (i32<->f64, boolean as i32, string and ptr both being i8*).
     enum class TypeCategory { Unknown, Numeric, Text, Handle, Void };
 
-    std::vector<std::map<std::string, Binding>> m_scopes;
+    ScopedSymbolTable<Binding> m_scopes; // block-scoped locals
     std::map<std::string, FunctionSignature> m_functions; // user + declared foreign
+    std::set<std::string> m_constFunctions;    // `const function`s, callable from const code
     std::set<std::string> m_types;             // class/interface names (not values)
     std::set<std::string> m_enumTypes;         // enum names, which mean i32
     // Class names specifically. Testing membership of m_classFields would be
@@ -75,6 +78,9 @@ private:
     // Declared return type of the function being analyzed ("" outside one)
     std::string m_currentReturnType;
     bool m_inFunction = false;
+    // Module the top-level statement being analyzed came from, when the
+    // program was linked from several (ProgramNode::statementOrigins)
+    std::string m_currentOrigin;
 
     void pushScope();
     void popScope();
@@ -82,8 +88,11 @@ private:
     const Binding *lookup(const std::string &name) const;
 
     // --- Types ---
-    // Best-effort static type of an expression; "" when not confidently known
+    // Best-effort static type of an expression; "" when not confidently known.
+    // Computed once per node and recorded on it (ExpressionNode::resolvedType),
+    // which is where codegen picks it up.
     std::string typeOf(ExpressionNode *expr);
+    std::string inferTypeOf(ExpressionNode *expr);
     TypeCategory categoryOf(const std::string &type) const;
     // Would assigning a `source`-typed value to a `target`-typed slot be wrong?
     bool isAssignable(const std::string &target, const std::string &source) const;
@@ -96,6 +105,15 @@ private:
     // Reports a mismatch at `node` unless the two types are compatible
     void checkAssignable(const ASTNode *node, const std::string &target,
                          const std::string &source, const std::string &context);
+    // Retypes an array literal headed for a `target` slot (`T[]`) to hold T,
+    // when its elements fit; nested literals are fitted to the inner type
+    void fitArrayLiteral(ExpressionNode *expr, const std::string &target);
+    // Element type of a `T[]` ("i32[]" -> "i32"), or "" for anything else
+    static std::string arrayElementOf(const std::string &arrayType);
+    // How a `T[]` stores its elements ("i32", "f64", "u8", "string", "object",
+    // ...); two array types are interchangeable only when these agree. "" when
+    // the element type is not known well enough to say.
+    std::string arrayLaneOf(const std::string &elementType) const;
     // Element type of an array type ("i32[]" -> "i32"), or "" if not an array
     static std::string elementTypeOf(const std::string &arrayType);
 
@@ -116,6 +134,15 @@ private:
                              bool isMethod, const std::string &returnType = "",
                              const std::string &className = "");
 
+    // A const function may only compute: numbers, booleans, arrays and
+    // Buffers of them, its own locals, and calls to const functions and Math.
+    // No output, no strings or objects, no module-level variables.
+    void checkConstFunction(const FunctionDeclarationNode *func);
+    void checkConstStatement(const StatementNode *stmt, const FunctionDeclarationNode *func,
+                             std::set<std::string> &locals);
+    void checkConstExpression(const ExpressionNode *expr, const FunctionDeclarationNode *func,
+                              const std::set<std::string> &locals);
+
     [[noreturn]] void fail(const ASTNode *node, const std::string &message) const;
 };
 
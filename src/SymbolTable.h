@@ -0,0 +1,130 @@
+// src/SymbolTable.h - Lexically scoped symbol table shared by Semantic and CodeGen
+//
+// One flat StringMap holds the innermost visible binding of every name, so a
+// lookup is a single hash probe no matter how deeply scopes nest. Each name is
+// stored once, in its map entry; scopes refer to entries by pointer and never
+// copy keys. Writing a name that belongs to an enclosing scope first records the
+// entry's previous state in an undo log, and popping a scope replays that log
+// back to the scope's mark. Pushing is O(1) and popping costs only the bindings
+// the scope actually changed — unlike snapshotting whole maps per block, which
+// is quadratic in deeply nested code.
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+template <typename V>
+class ScopedSymbolTable
+{
+public:
+    // Opens a scope. An isolated scope also hides every enclosing binding until
+    // it is popped: a function body does not see its caller's locals.
+    void pushScope(bool isolated = false)
+    {
+        m_scopes.push_back({m_undo.size(), m_floor});
+        if (isolated) m_floor = depth();
+    }
+
+    // Closes the innermost scope, restoring everything it bound or overwrote
+    void popScope()
+    {
+        Scope scope = m_scopes.back();
+        m_scopes.pop_back();
+        while (m_undo.size() > scope.undoMark) {
+            Undo &undo = m_undo.back();
+            undo.entry->second = std::move(undo.previous);
+            m_undo.pop_back();
+        }
+        m_floor = scope.floor;
+    }
+
+    // The visible binding of `name`, or null
+    V *lookup(llvm::StringRef name)
+    {
+        auto it = m_bindings.find(name);
+        return it != m_bindings.end() && visible(it->second) ? &it->second.value : nullptr;
+    }
+    const V *lookup(llvm::StringRef name) const
+    {
+        auto it = m_bindings.find(name);
+        return it != m_bindings.end() && visible(it->second) ? &it->second.value : nullptr;
+    }
+
+    bool contains(llvm::StringRef name) const { return lookup(name) != nullptr; }
+
+    // The binding of `name` in the innermost scope, like std::map::operator[]:
+    // a name not yet visible starts out value-initialized. Writing through the
+    // reference to an enclosing scope's binding is undone when this scope pops.
+    V &operator[](llvm::StringRef name)
+    {
+        auto &entry = *m_bindings.try_emplace(name).first;
+        Slot &slot = entry.second;
+        bool wasVisible = visible(slot);
+        claim(entry);
+        if (!wasVisible) {
+            slot.value = V();
+            slot.bound = true;
+        }
+        return slot.value;
+    }
+
+    void erase(llvm::StringRef name)
+    {
+        auto it = m_bindings.find(name);
+        if (it == m_bindings.end() || !visible(it->second)) return;
+        claim(*it);
+        it->second.bound = false;
+    }
+
+    void clear()
+    {
+        m_bindings.clear();
+        m_undo.clear();
+        m_scopes.clear();
+        m_floor = 0;
+    }
+
+private:
+    struct Slot {
+        V value{};
+        unsigned depth = 0; // scope depth that last wrote this slot
+        bool bound = false;
+    };
+    using Entry = llvm::StringMapEntry<Slot>;
+
+    struct Undo {
+        Entry *entry;
+        Slot previous;
+    };
+    struct Scope {
+        size_t undoMark;
+        unsigned floor; // m_floor to restore on pop
+    };
+
+    unsigned depth() const { return static_cast<unsigned>(m_scopes.size()); }
+    bool visible(const Slot &slot) const { return slot.bound && slot.depth >= m_floor; }
+
+    // Makes the innermost scope the owner of `entry`, logging the state it
+    // replaces the first time this scope touches it. The outermost scope is
+    // never popped, so it needs no log.
+    void claim(Entry &entry)
+    {
+        Slot &slot = entry.second;
+        if (slot.depth == depth() && slot.bound) return;
+        if (!m_scopes.empty()) m_undo.push_back({&entry, slot});
+        slot.depth = depth();
+    }
+
+    // Entries are never removed while scopes are open, so the undo log's
+    // pointers stay valid: StringMap does not move entries when it rehashes.
+    llvm::StringMap<Slot> m_bindings;
+    std::vector<Undo> m_undo;
+    std::vector<Scope> m_scopes;
+    unsigned m_floor = 0; // bindings written below this depth are hidden
+};
+
+#endif // SYMBOL_TABLE_H
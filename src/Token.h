@@ -207,15 +207,18 @@ inline const char* tokenTypeToString(TokenType type) {
     }
 }
 
-// Structure to represent a Token
+// Structure to represent a Token. `value` is a view, usually straight into the
+// source buffer; text the lexer had to build (unescaped strings, template
+// pieces) lives in the Lexer. Either way a token is only valid while the
+// Lexer that produced it and its source are.
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     int line = 0;   // 1-based; 0 means "unknown"
     int column = 0; // 1-based; 0 means "unknown"
 
     // Constructors
-    Token(TokenType t, std::string v) : type(t), value(std::move(v)) {}
+    Token(TokenType t, std::string_view v) : type(t), value(v) {}
     Token() : type(TOK_UNKNOWN) {}
     
     // Utility methods
@@ -0,0 +1,81 @@
+// src/cscript_client.cpp - Thin client for the compile server (`cscript --server`)
+//
+//   cscript-client [cscript options] <input-file>
+//
+// Takes exactly the arguments cscript does and hands them, with the working
+// directory, environment and terminal, to the server on $CSCRIPT_SERVER (see
+// CompileServer::defaultSocketPath); exits with the compile's status. It links
+// nothing of LLVM, so a short compile costs the client about a millisecond of
+// startup instead of cscript's own. With no server listening it runs the cscript
+// installed beside it instead, so scripts and editors can call it either way.
+#include "CompileServer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace {
+
+// The cscript next to this binary, else whichever one is on PATH
+std::string localCompiler()
+{
+    std::string self;
+#ifdef __APPLE__
+    char buffer[4096];
+    uint32_t size = sizeof(buffer);
+    if (_NSGetExecutablePath(buffer, &size) == 0) self = buffer;
+#elif !defined(_WIN32)
+    char buffer[4096];
+    ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (length > 0) self.assign(buffer, static_cast<size_t>(length));
+#endif
+    size_t slash = self.rfind('/');
+    if (slash != std::string::npos) {
+        std::string sibling = self.substr(0, slash + 1) + "cscript";
+#ifndef _WIN32
+        if (access(sibling.c_str(), X_OK) == 0) return sibling;
+#endif
+    }
+    return "cscript";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string socketPath = CompileServer::defaultSocketPath();
+    try {
+        if (!socketPath.empty()) {
+            int status = CompileServer::forward(socketPath, argc, argv);
+            if (status >= 0) return status;
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "cscript-client: %s\n", e.what());
+        return 1;
+    }
+
+#ifdef _WIN32
+    std::fprintf(stderr, "cscript-client: no compile server on this platform; run cscript\n");
+    return 1;
+#else
+    // No server: compile in this process's place, exactly as cscript would
+    std::string compiler = localCompiler();
+    std::vector<char *> args(argv, argv + argc);
+    args.push_back(nullptr);
+    args[0] = const_cast<char *>(compiler.c_str());
+    execvp(compiler.c_str(), args.data());
+    std::fprintf(stderr, "cscript-client: no server on %s, and cannot run %s: %s\n",
+                 socketPath.c_str(), compiler.c_str(), std::strerror(errno));
+    return 1;
+#endif
+}
@@ -14,6 +14,9 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
 #include <cctype>
 #include <csetjmp>
 #include <setjmp.h> // for _setjmp/_longjmp pairing with generated code
@@ -40,8 +43,8 @@
 // game loop stops calling the allocator at all.
 //
 // The blast radius is deliberately small: every other string function keeps its
-// permanent allocation, so file_read, string_upper, array_get_string and friends
-// behave exactly as before whether or not the arena is on.
+// permanent allocation, so file_read, string_upper and friends behave exactly
+// as before whether or not the arena is on.
 //
 // CONTRACT: an arena string only lives until the next frame. A string that must
 // outlive the frame that built it — stored in an object field, pushed to an
@@ -147,105 +150,266 @@ unsigned long long cyps_arena_frames() { return g_arena.framesReset; }
 
 } // extern "C"
 
-// One storage lane of a dynamic array.
+// The storage of a dynamic array.
 //
 // `head` is the index of the first live element. shift() advances it instead of
 // erasing from the front, which used to move every remaining element on every
 // call — O(n) per shift and quadratic across a drain, which is the whole reason
 // benchmark_bfs lost to Node by 10x.
 //
-// The dead prefix is reclaimed in one bulk erase once it has grown to at least
+// The dead prefix is reclaimed in one bulk move once it has grown to at least
 // the size of the live region. That bounds the waste at roughly twice what is
-// live, and pays for the copy with the shifts that created it: the erase moves
+// live, and pays for the copy with the shifts that created it: the move touches
 // `live` elements and only runs when `head >= live`, so each shift carries O(1)
 // amortised. A drain of n elements costs O(n) in total rather than O(n^2).
 //
-// All indices crossing this boundary are element positions, not vector
+// All indices crossing this boundary are element positions, not storage
 // positions; the offset is added here and nowhere else, so no caller can
 // forget it.
+//
+// The four fields are also read and written by generated code, which indexes
+// i32, f64 and object arrays inline and only calls in here to grow
+// (CodeGen::arrayType). They are its ABI: their order, types and meaning
+// must not change without it. Slots [head, head + length) hold constructed
+// elements; the rest of [0, capacity) is raw storage.
 template <typename T>
 class Lane {
 public:
-    std::vector<T> data;
-    size_t head = 0;
+    T* data = nullptr;
+    int64_t length = 0;     // live elements, starting at data[head]
+    int64_t capacity = 0;   // slots allocated at data
+    int64_t head = 0;       // dead slots before the first live one
+
+    Lane() = default;
+    Lane(const Lane&) = delete;
+    Lane& operator=(const Lane&) = delete;
+    ~Lane() { clear(); }
 
-    size_t size() const { return data.size() - head; }
-    bool empty() const { return data.size() == head; }
+    size_t size() const { return static_cast<size_t>(length); }
+    bool empty() const { return length == 0; }
 
     // Null rather than a reference, so out-of-range keeps returning the
     // callers' documented defaults (0 / nullptr) instead of reading past the end
     T* at(int32_t index) {
-        if (index < 0) return nullptr;
-        size_t real = head + static_cast<size_t>(index);
-        if (real >= data.size()) return nullptr;
-        return &data[real];
+        if (index < 0 || index >= length) return nullptr;
+        return &data[head + index];
+    }
+
+    void push(const T& value) {
+        grow(length + 1);
+        new (&data[head + length]) T(value);
+        ++length;
     }
 
-    void push(const T& value) { data.push_back(value); }
+    void assign(const T* values, size_t count) {
+        clear();
+        grow(static_cast<int64_t>(count));
+        std::uninitialized_copy(values, values + count, data);
+        length = static_cast<int64_t>(count);
+    }
 
     // Growing on write is the existing behaviour of array_set_*: assigning past
     // the end extends the array rather than failing
     void set(int32_t index, const T& value) {
         if (index < 0) return;
-        size_t real = head + static_cast<size_t>(index);
-        if (real >= data.size()) data.resize(real + 1);
-        data[real] = value;
+        if (index >= length) {
+            grow(int64_t(index) + 1);
+            std::uninitialized_value_construct(data + head + length, data + head + index + 1);
+            length = int64_t(index) + 1;
+        }
+        data[head + index] = value;
     }
 
     bool pop(T& out) {
         if (empty()) return false;
-        out = data.back();
-        data.pop_back();
+        T* last = &data[head + length - 1];
+        out = std::move(*last);
+        last->~T();
+        --length;
         return true;
     }
 
     bool shift(T& out) {
         if (empty()) return false;
-        out = data[head];
+        out = std::move(data[head]);
+        data[head].~T();
         ++head;
+        --length;
         reclaim();
         return true;
     }
 
     void removeAt(int32_t index) {
-        if (index < 0 || static_cast<size_t>(index) >= size()) return;
-        data.erase(data.begin() + head + index);
+        if (index < 0 || index >= length) return;
+        T* live = data + head;
+        std::move(live + index + 1, live + length, live + index);
+        live[length - 1].~T();
+        --length;
     }
 
     void clear() {
-        std::vector<T>().swap(data);
-        head = 0;
+        std::destroy(data + head, data + head + length);
+        std::free(data);
+        data = nullptr;
+        length = capacity = head = 0;
+    }
+
+    // Room for `count` live elements, allocated to exactly that: the caller
+    // knows the final size, so filling up to it never moves the array
+    void reserve(int64_t count) {
+        if (head + count <= capacity) return;
+        reallocate(count);
+    }
+
+    // Exactly `count` live elements; new ones are 0 / null, as a write past
+    // the end fills the gap
+    void resize(int64_t count) {
+        if (count < length) {
+            std::destroy(data + head + count, data + head + length);
+            length = count;
+            return;
+        }
+        reserve(count);
+        std::uninitialized_value_construct(data + head + length, data + head + count);
+        length = count;
+    }
+
+    // Gives back the slots past the last element and the dead prefix
+    void shrinkToFit() {
+        if (length == 0) {
+            clear();
+        } else if (head != 0 || length != capacity) {
+            reallocate(length);
+        }
     }
 
 private:
+    // Room for `count` live elements without moving what is there, doubling
+    // so that pushes cost O(1) amortised
+    void grow(int64_t count) {
+        if (head + count <= capacity) return;
+        reallocate(std::max<int64_t>({count, capacity * 2, 8}));
+    }
+
+    // Moves the live elements to the front of `slots` fresh ones
+    void reallocate(int64_t slots) {
+        T* fresh = static_cast<T*>(std::malloc(sizeof(T) * static_cast<size_t>(slots)));
+        if (!fresh) {
+            std::fprintf(stderr, "Runtime Error: out of memory allocating %lld array elements\n",
+                         static_cast<long long>(slots));
+            std::abort();
+        }
+        std::uninitialized_move(data + head, data + head + length, fresh);
+        std::destroy(data + head, data + head + length);
+        std::free(data);
+        data = fresh;
+        capacity = slots;
+        head = 0;
+    }
+
     void reclaim() {
+        if (length == 0) {
+            head = 0;
+            return;
+        }
         // The floor keeps short-lived queues from copying at all; past it, the
-        // prefix is only dropped once it is no smaller than what remains.
-        if (head >= 32 && head >= data.size() - head) {
-            data.erase(data.begin(), data.begin() + head);
+        // prefix is only dropped once it is no smaller than what remains, so
+        // the two ranges cannot overlap.
+        if (head >= 32 && head >= length) {
+            std::uninitialized_move(data + head, data + head + length, data);
+            std::destroy(data + head, data + head + length);
             head = 0;
         }
     }
 };
 
-class DynamicArray {
-public:
-    enum class Type { I32, F64, String, Object };
-    Type type;
-    Lane<int32_t> i32_data;
-    Lane<double> f64_data;
-    Lane<std::string> string_data;
-    Lane<void*> object_data;
-
-    DynamicArray(Type t) : type(t) {}
+// Which element type an array holds. Each array is one TypedArray<T>, sized
+// for its own elements only; the tag says which T, for the few entry points
+// (array_length, array_clear, array_remove_at) that take any array.
+enum class ArrayKind : int32_t { I32, F64, String, Object, I64, U8, F32 };
+
+template <typename T> struct ArrayKindOf;
+template <> struct ArrayKindOf<int32_t> { static constexpr ArrayKind value = ArrayKind::I32; };
+template <> struct ArrayKindOf<double> { static constexpr ArrayKind value = ArrayKind::F64; };
+template <> struct ArrayKindOf<const char*> { static constexpr ArrayKind value = ArrayKind::String; };
+template <> struct ArrayKindOf<void*> { static constexpr ArrayKind value = ArrayKind::Object; };
+template <> struct ArrayKindOf<int64_t> { static constexpr ArrayKind value = ArrayKind::I64; };
+template <> struct ArrayKindOf<uint8_t> { static constexpr ArrayKind value = ArrayKind::U8; };
+template <> struct ArrayKindOf<float> { static constexpr ArrayKind value = ArrayKind::F32; };
+
+// Standard layout, so the lane sits where CodeGen::arrayType says it does
+template <typename T>
+struct TypedArray {
+    Lane<T> items;
+    ArrayKind kind = ArrayKindOf<T>::value;
 };
 
+using I32Array = TypedArray<int32_t>;
+using F64Array = TypedArray<double>;
+using StrArray = TypedArray<const char*>;
+using PtrArray = TypedArray<void*>;
+using I64Array = TypedArray<int64_t>;
+using U8Array = TypedArray<uint8_t>;    // u8[], i8[] and boolean[], a byte each
+using F32Array = TypedArray<float>;
+
+static_assert(offsetof(I32Array, items) == 0 && sizeof(Lane<void*>) == 32 &&
+                  offsetof(I32Array, kind) == 32 && offsetof(F64Array, kind) == 32 &&
+                  offsetof(StrArray, kind) == 32 && offsetof(PtrArray, kind) == 32 &&
+                  offsetof(I64Array, kind) == 32 && offsetof(U8Array, kind) == 32 &&
+                  offsetof(F32Array, kind) == 32,
+              "generated code indexes an array's lane at offset 0 (CodeGen::arrayType)");
+static_assert(sizeof(I32Array) == sizeof(StrArray) && sizeof(F64Array) == sizeof(PtrArray) &&
+                  sizeof(I32Array) == sizeof(PtrArray) && sizeof(I64Array) == sizeof(PtrArray) &&
+                  sizeof(U8Array) == sizeof(PtrArray) && sizeof(F32Array) == sizeof(PtrArray),
+              "an empty array is retagged in place (writableArray)");
+
+static ArrayKind arrayKind(const void* arr_ptr) {
+    ArrayKind kind;
+    std::memcpy(&kind, static_cast<const char*>(arr_ptr) + offsetof(I32Array, kind), sizeof kind);
+    return kind;
+}
+
+// Calls `fn` with the array as the TypedArray it is
+template <typename Fn>
+static void visitArray(void* arr_ptr, Fn&& fn) {
+    switch (arrayKind(arr_ptr)) {
+    case ArrayKind::I32: fn(*static_cast<I32Array*>(arr_ptr)); break;
+    case ArrayKind::F64: fn(*static_cast<F64Array*>(arr_ptr)); break;
+    case ArrayKind::String: fn(*static_cast<StrArray*>(arr_ptr)); break;
+    case ArrayKind::Object: fn(*static_cast<PtrArray*>(arr_ptr)); break;
+    case ArrayKind::I64: fn(*static_cast<I64Array*>(arr_ptr)); break;
+    case ArrayKind::U8: fn(*static_cast<U8Array*>(arr_ptr)); break;
+    case ArrayKind::F32: fn(*static_cast<F32Array*>(arr_ptr)); break;
+    }
+}
+
+// The array as T elements to read; null (so the reader's default) when it is
+// null or holds something else
+template <typename T>
+static TypedArray<T>* readableArray(void* arr_ptr) {
+    if (!arr_ptr || arrayKind(arr_ptr) != ArrayKindOf<T>::value) return nullptr;
+    return static_cast<TypedArray<T>*>(arr_ptr);
+}
+
+// The array as T elements to write. An empty array of another kind becomes
+// one of T, as the element type of `[]` is only known once something goes in;
+// one that already holds other elements is left alone.
+template <typename T>
+static TypedArray<T>* writableArray(void* arr_ptr) {
+    if (!arr_ptr) return nullptr;
+    if (arrayKind(arr_ptr) == ArrayKindOf<T>::value) return static_cast<TypedArray<T>*>(arr_ptr);
+    bool empty = false;
+    visitArray(arr_ptr, [&](auto& arr) {
+        empty = arr.items.empty();
+        if (empty) std::destroy_at(&arr);
+    });
+    return empty ? new (arr_ptr) TypedArray<T>() : nullptr;
+}
+
 #include <set>
 #include <unordered_set>
 #include <unordered_map>
 
-// ... DynamicArray implementation ...
-
 // Set implementation
 class DynamicSet {
 public:
@@ -309,193 +473,281 @@ extern "C" {
     // ===================
     // DYNAMIC ARRAY FUNCTIONS
     // ===================
-    void* array_create_i32() { return new DynamicArray(DynamicArray::Type::I32); }
-    void* array_create_f64() { return new DynamicArray(DynamicArray::Type::F64); }
-    void* array_create_string() { return new DynamicArray(DynamicArray::Type::String); }
-    void* array_create_object() { return new DynamicArray(DynamicArray::Type::Object); }
+    void* array_create_i32() { return new I32Array(); }
+    void* array_create_f64() { return new F64Array(); }
+    void* array_create_string() { return new StrArray(); }
+    void* array_create_object() { return new PtrArray(); }
+
+    // An array whose contents the compiler already knew: a literal of numbers,
+    // or the result of a const function. One copy out of the constant image.
+    void* array_from_i32(const int32_t* values, int32_t count) {
+        auto* arr = new I32Array();
+        if (values && count > 0) arr->items.assign(values, static_cast<size_t>(count));
+        return arr;
+    }
+
+    void* array_from_f64(const double* values, int32_t count) {
+        auto* arr = new F64Array();
+        if (values && count > 0) arr->items.assign(values, static_cast<size_t>(count));
+        return arr;
+    }
 
     int32_t array_length(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return 0;
-        // Live counts: a lane's dead prefix is not part of the array
-        return std::max({arr->i32_data.size(), arr->f64_data.size(),
-                         arr->string_data.size(), arr->object_data.size()});
+        if (!arr_ptr) return 0;
+        // The live count: a lane's dead prefix is not part of the array
+        int32_t length = 0;
+        visitArray(arr_ptr, [&](auto& arr) { length = static_cast<int32_t>(arr.items.size()); });
+        return length;
     }
 
     // --- f64 arrays ---
     void array_push_f64(void* arr_ptr, double val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr) arr->f64_data.push(val);
+        if (auto* arr = writableArray<double>(arr_ptr)) arr->items.push(val);
     }
 
     double array_get_f64(void* arr_ptr, int32_t index) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return 0.0;
-        double* slot = arr->f64_data.at(index);
+        auto* arr = readableArray<double>(arr_ptr);
+        double* slot = arr ? arr->items.at(index) : nullptr;
         return slot ? *slot : 0.0;
     }
 
     void array_set_f64(void* arr_ptr, int32_t index, double val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr) arr->f64_data.set(index, val);
+        if (auto* arr = writableArray<double>(arr_ptr)) arr->items.set(index, val);
     }
 
     double array_shift_f64(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
         double val = 0.0;
-        if (arr) arr->f64_data.shift(val);
+        if (auto* arr = readableArray<double>(arr_ptr)) arr->items.shift(val);
         return val;
     }
 
     double array_pop_f64(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
         double val = 0.0;
-        if (arr) arr->f64_data.pop(val);
+        if (auto* arr = readableArray<double>(arr_ptr)) arr->items.pop(val);
         return val;
     }
 
+    // --- i32 arrays (integers, booleans, enums) ---
     void array_push_i32(void* arr_ptr, int32_t val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr) {
-            if (arr->i32_data.empty() && arr->string_data.empty() && arr->object_data.empty()) {
-                arr->type = DynamicArray::Type::I32;
-            }
-            arr->i32_data.push(val);
-        }
+        if (auto* arr = writableArray<int32_t>(arr_ptr)) arr->items.push(val);
     }
 
-    int32_t array_pop_i32(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        int32_t val = 0;
-        if (arr) arr->i32_data.pop(val);
-        return val;
+    int32_t array_get_i32(void* arr_ptr, int32_t index) {
+        auto* arr = readableArray<int32_t>(arr_ptr);
+        int32_t* slot = arr ? arr->items.at(index) : nullptr;
+        return slot ? *slot : 0;
     }
 
-    // Text is handed back as a fresh copy the caller owns, here and in
-    // array_get_string / array_shift_string: the lane's own std::string can be
-    // moved or freed by a later reclaim, so returning a pointer into it would
-    // dangle.
-    const char* array_pop_string(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return nullptr;
-        std::string val;
-        if (!arr->string_data.pop(val)) return nullptr;
-        return (new std::string(val))->c_str();
+    void array_set_i32(void* arr_ptr, int32_t index, int32_t val) {
+        if (auto* arr = writableArray<int32_t>(arr_ptr)) arr->items.set(index, val);
     }
 
-    void array_push_string(void* arr_ptr, const char* val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr && val) {
-            if (arr->i32_data.empty() && arr->string_data.empty() && arr->object_data.empty()) {
-                arr->type = DynamicArray::Type::String;
-            }
-            arr->string_data.push(val);
-        }
+    int32_t array_pop_i32(void* arr_ptr) {
+        int32_t val = 0;
+        if (auto* arr = readableArray<int32_t>(arr_ptr)) arr->items.pop(val);
+        return val;
     }
 
     int32_t array_shift_i32(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
         int32_t val = 0;
-        if (arr) arr->i32_data.shift(val);
+        if (auto* arr = readableArray<int32_t>(arr_ptr)) arr->items.shift(val);
         return val;
     }
 
-    const char* array_shift_string(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return nullptr;
-        std::string val;
-        if (!arr->string_data.shift(val)) return nullptr;
-        return (new std::string(val))->c_str();
+    // --- string arrays ---
+    // Elements are the program's own string handles, stored and handed back
+    // as they are. Strings are immutable and never freed, so an element can
+    // share its text with whatever else refers to it; reading one costs no
+    // copy. (A frame-arena string is the exception the arena's contract
+    // covers: one kept in an array past its frame must be persisted first.)
+    void array_push_string(void* arr_ptr, const char* val) {
+        if (auto* arr = writableArray<const char*>(arr_ptr)) arr->items.push(val);
     }
 
-    int32_t array_get_i32(void* arr_ptr, int32_t index) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return 0;
-        int32_t* slot = arr->i32_data.at(index);
-        return slot ? *slot : 0;
+    const char* array_get_string(void* arr_ptr, int32_t index) {
+        auto* arr = readableArray<const char*>(arr_ptr);
+        const char** slot = arr ? arr->items.at(index) : nullptr;
+        return slot ? *slot : nullptr;
     }
 
-    const char* array_get_string(void* arr_ptr, int32_t index) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return nullptr;
-        std::string* slot = arr->string_data.at(index);
-        return slot ? (new std::string(*slot))->c_str() : nullptr;
+    void array_set_string(void* arr_ptr, int32_t index, const char* val) {
+        if (auto* arr = writableArray<const char*>(arr_ptr)) arr->items.set(index, val);
     }
 
-    void array_set_i32(void* arr_ptr, int32_t index, int32_t val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr) arr->i32_data.set(index, val);
+    const char* array_pop_string(void* arr_ptr) {
+        const char* val = nullptr;
+        if (auto* arr = readableArray<const char*>(arr_ptr)) arr->items.pop(val);
+        return val;
     }
 
-    void array_set_string(void* arr_ptr, int32_t index, const char* val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr && val) arr->string_data.set(index, val);
+    const char* array_shift_string(void* arr_ptr) {
+        const char* val = nullptr;
+        if (auto* arr = readableArray<const char*>(arr_ptr)) arr->items.shift(val);
+        return val;
     }
 
     // --- Object arrays -------------------------------------------------------
-    // Elements are raw pointers to heap objects. Unlike the string vector these
-    // are stored and returned verbatim: copying them (as array_get_string does
-    // for text) would corrupt the object.
+    // Elements are raw pointers to heap objects, stored and returned verbatim.
 
     void array_push_object(void* arr_ptr, void* val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return;
-        if (arr->i32_data.empty() && arr->string_data.empty() && arr->object_data.empty()) {
-            arr->type = DynamicArray::Type::Object;
-        }
-        arr->object_data.push(val);
+        if (auto* arr = writableArray<void*>(arr_ptr)) arr->items.push(val);
     }
 
     void* array_get_object(void* arr_ptr, int32_t index) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return nullptr;
-        void** slot = arr->object_data.at(index);
+        auto* arr = readableArray<void*>(arr_ptr);
+        void** slot = arr ? arr->items.at(index) : nullptr;
         return slot ? *slot : nullptr;
     }
 
     void array_set_object(void* arr_ptr, int32_t index, void* val) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (arr) arr->object_data.set(index, val);
+        if (auto* arr = writableArray<void*>(arr_ptr)) arr->items.set(index, val);
     }
 
     void* array_pop_object(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
         void* val = nullptr;
-        if (arr) arr->object_data.pop(val);
+        if (auto* arr = readableArray<void*>(arr_ptr)) arr->items.pop(val);
         return val;
     }
 
     void* array_shift_object(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
         void* val = nullptr;
-        if (arr) arr->object_data.shift(val);
+        if (auto* arr = readableArray<void*>(arr_ptr)) arr->items.shift(val);
+        return val;
+    }
+
+    // --- i64 arrays ---
+    void* array_create_i64() { return new I64Array(); }
+
+    void* array_from_i64(const int64_t* values, int32_t count) {
+        auto* arr = new I64Array();
+        if (values && count > 0) arr->items.assign(values, static_cast<size_t>(count));
+        return arr;
+    }
+
+    void array_push_i64(void* arr_ptr, int64_t val) {
+        if (auto* arr = writableArray<int64_t>(arr_ptr)) arr->items.push(val);
+    }
+
+    int64_t array_get_i64(void* arr_ptr, int32_t index) {
+        auto* arr = readableArray<int64_t>(arr_ptr);
+        int64_t* slot = arr ? arr->items.at(index) : nullptr;
+        return slot ? *slot : 0;
+    }
+
+    void array_set_i64(void* arr_ptr, int32_t index, int64_t val) {
+        if (auto* arr = writableArray<int64_t>(arr_ptr)) arr->items.set(index, val);
+    }
+
+    int64_t array_pop_i64(void* arr_ptr) {
+        int64_t val = 0;
+        if (auto* arr = readableArray<int64_t>(arr_ptr)) arr->items.pop(val);
+        return val;
+    }
+
+    int64_t array_shift_i64(void* arr_ptr) {
+        int64_t val = 0;
+        if (auto* arr = readableArray<int64_t>(arr_ptr)) arr->items.shift(val);
+        return val;
+    }
+
+    // --- u8 arrays (u8, i8 and boolean elements, one byte each) ---
+    // A byte crosses this boundary widened to an int32_t: how the upper bits
+    // of a narrower argument are filled is left to each compiler, and
+    // generated code and this file need not come from the same one.
+    void* array_create_u8() { return new U8Array(); }
+
+    void* array_from_u8(const uint8_t* values, int32_t count) {
+        auto* arr = new U8Array();
+        if (values && count > 0) arr->items.assign(values, static_cast<size_t>(count));
+        return arr;
+    }
+
+    void array_push_u8(void* arr_ptr, int32_t val) {
+        if (auto* arr = writableArray<uint8_t>(arr_ptr)) arr->items.push(static_cast<uint8_t>(val));
+    }
+
+    int32_t array_get_u8(void* arr_ptr, int32_t index) {
+        auto* arr = readableArray<uint8_t>(arr_ptr);
+        uint8_t* slot = arr ? arr->items.at(index) : nullptr;
+        return slot ? *slot : 0;
+    }
+
+    void array_set_u8(void* arr_ptr, int32_t index, int32_t val) {
+        if (auto* arr = writableArray<uint8_t>(arr_ptr)) arr->items.set(index, static_cast<uint8_t>(val));
+    }
+
+    int32_t array_pop_u8(void* arr_ptr) {
+        uint8_t val = 0;
+        if (auto* arr = readableArray<uint8_t>(arr_ptr)) arr->items.pop(val);
+        return val;
+    }
+
+    int32_t array_shift_u8(void* arr_ptr) {
+        uint8_t val = 0;
+        if (auto* arr = readableArray<uint8_t>(arr_ptr)) arr->items.shift(val);
         return val;
     }
 
-    // Drops every element and releases the vector's storage. Object elements are
+    // --- f32 arrays ---
+    void* array_create_f32() { return new F32Array(); }
+
+    void* array_from_f32(const float* values, int32_t count) {
+        auto* arr = new F32Array();
+        if (values && count > 0) arr->items.assign(values, static_cast<size_t>(count));
+        return arr;
+    }
+
+    void array_push_f32(void* arr_ptr, float val) {
+        if (auto* arr = writableArray<float>(arr_ptr)) arr->items.push(val);
+    }
+
+    float array_get_f32(void* arr_ptr, int32_t index) {
+        auto* arr = readableArray<float>(arr_ptr);
+        float* slot = arr ? arr->items.at(index) : nullptr;
+        return slot ? *slot : 0.0f;
+    }
+
+    void array_set_f32(void* arr_ptr, int32_t index, float val) {
+        if (auto* arr = writableArray<float>(arr_ptr)) arr->items.set(index, val);
+    }
+
+    float array_pop_f32(void* arr_ptr) {
+        float val = 0.0f;
+        if (auto* arr = readableArray<float>(arr_ptr)) arr->items.pop(val);
+        return val;
+    }
+
+    float array_shift_f32(void* arr_ptr) {
+        float val = 0.0f;
+        if (auto* arr = readableArray<float>(arr_ptr)) arr->items.shift(val);
+        return val;
+    }
+
+    // Drops every element and releases the lane's storage. Object elements are
     // pointers the program still owns — clearing the array does not free them,
     // because other references may exist. Pool and reuse instead.
     void array_clear(void* arr_ptr) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr) return;
-        arr->i32_data.clear();
-        arr->f64_data.clear();
-        arr->string_data.clear();
-        arr->object_data.clear();
+        if (arr_ptr) visitArray(arr_ptr, [](auto& arr) { arr.items.clear(); });
     }
 
     // Removing an element is what makes despawning possible in a game loop.
     void array_remove_at(void* arr_ptr, int32_t index) {
-        auto* arr = static_cast<DynamicArray*>(arr_ptr);
-        if (!arr || index < 0) return;
-        if (index < static_cast<int32_t>(arr->object_data.size()))
-            arr->object_data.removeAt(index);
-        else if (index < static_cast<int32_t>(arr->i32_data.size()))
-            arr->i32_data.removeAt(index);
-        else if (index < static_cast<int32_t>(arr->f64_data.size()))
-            arr->f64_data.removeAt(index);
-        else if (index < static_cast<int32_t>(arr->string_data.size()))
-            arr->string_data.removeAt(index);
+        if (arr_ptr) visitArray(arr_ptr, [&](auto& arr) { arr.items.removeAt(index); });
+    }
+
+    // Capacity control, for loaders that know their sizes up front: room for
+    // `count` elements in one allocation (arr.reserve), a length to start at
+    // (new Array<T>(n)), and giving back what is unused (arr.shrinkToFit).
+    void array_reserve(void* arr_ptr, int32_t count) {
+        if (arr_ptr && count > 0) visitArray(arr_ptr, [&](auto& arr) { arr.items.reserve(count); });
+    }
+
+    void array_resize(void* arr_ptr, int32_t count) {
+        if (arr_ptr && count >= 0) visitArray(arr_ptr, [&](auto& arr) { arr.items.resize(count); });
+    }
+
+    void array_shrink_to_fit(void* arr_ptr) {
+        if (arr_ptr) visitArray(arr_ptr, [](auto& arr) { arr.items.shrinkToFit(); });
     }
 
     // ===================
@@ -624,7 +876,7 @@ extern "C" {
     // ===================
     // VALUE -> STRING CONVERSION (used by `+` concatenation and template literals)
     // ===================
-    // These three are what a template literal desugars into, and so account for
+    // These are what a template literal desugars into, and so account for
     // essentially all per-frame string churn. They allocate from the frame arena
     // when it is enabled — see the note at the top of this file.
     const char* cyps_i32_to_string(int32_t value) {
@@ -632,6 +884,11 @@ extern "C" {
         return allocString(s);
     }
 
+    const char* cyps_i64_to_string(int64_t value) {
+        std::string s = std::to_string(value);
+        return allocString(s);
+    }
+
     const char* cyps_f64_to_string(double value) {
         char buf[64];
         std::snprintf(buf, sizeof(buf), "%g", value);
@@ -8,12 +8,23 @@
 #include <chrono>
 #include <cctype>
 
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <regex>
 #include <set>
+#include <thread>
 
 #include "Lexer.h"
 #include "Token.h"
@@ -22,6 +33,13 @@
 #include "CodeGen.h"
 #include "Optimizer.h"
 #include "Semantic.h"
+#include "Backend.h"
+#include "JIT.h"
+#include "CompileCache.h"
+#include "CompileServer.h"
+#include "IncrementalParser.h"
+#include "LanguageServer.h"
+#include "ModuleGraph.h"
 
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
@@ -36,6 +54,9 @@
 #elif defined(__linux__)
 #include <unistd.h>
 #endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -110,6 +131,22 @@ std::string findRuntimeLibrary(const char* argv0) {
         "Set CYPESCRIPT_HOME to the installation prefix or rebuild with ./build.sh");
 }
 
+// The runtime as LLVM bitcode (libcypescript.bc), which CMake builds beside
+// libcypescript.a when it finds a clang this LLVM can read. Empty if there is
+// none: the program then calls into the archive without inlining anything.
+std::string findRuntimeBitcode(const char* argv0) {
+    fs::path library;
+    try {
+        library = findRuntimeLibrary(argv0);
+    } catch (const std::runtime_error&) {
+        return "";   // reported by whichever stage actually needs the archive
+    }
+    if (library.extension() != ".a") return "";
+    fs::path bitcode = library.replace_extension(".bc");
+    std::error_code ec;
+    return fs::exists(bitcode, ec) ? bitcode.string() : "";
+}
+
 // Directory holding the bundled Cypescript modules (game.csc and friends), so
 // that `import { } from "game";` works from anywhere. Search order mirrors
 // findRuntimeLibrary: $CYPESCRIPT_HOME, then paths relative to the binary.
@@ -161,6 +198,8 @@ bool starts_with(const std::string& str, const std::string& prefix) {
 class CompilerOptions {
 public:
     std::string inputFile;
+    // Every input file named; more than one only with --check
+    std::vector<std::string> inputFiles;
     std::string outputFile = "";
     bool verbose = false;
     bool printTokens = false;
@@ -168,7 +207,36 @@ public:
     bool help = false;
     bool version = false;
     bool run = false;
+    // Concurrent `link source` compiles (-j N); 0 means one per core
+    unsigned jobs = 0;
+    // Run in process through ORC instead of linking an executable (implies run)
+    bool jit = false;
     bool noFold = false;
+    // Always compile, neither reading nor filling the compile cache
+    bool noCache = false;
+    // LLVM optimization level for the in-process pipeline (-O0..-O3)
+    int optLevel = 2;
+    // Target CPU (--march/--mcpu, "native" for this machine) and extra
+    // LLVM subtarget features (--target-features=+avx2,...)
+    std::string cpu;
+    std::string targetFeatures;
+    // Compile `link source` files to bitcode and optimize them together with
+    // the program, so calls into them can be inlined
+    bool lto = false;
+    // Profile-guided optimization: --pgo-gen[=FILE] builds an instrumented
+    // executable that writes a .profraw; --pgo-use FILE optimizes with the
+    // merged .profdata
+    bool pgoGen = false;
+    std::string pgoGenFile;
+    std::string pgoUseFile;
+    // --time-trace[=FILE]: write a Chrome trace-event JSON of where compile
+    // time went; events shorter than the granularity (µs) are dropped
+    bool timeTrace = false;
+    std::string timeTraceFile;
+    unsigned timeTraceGranularity = 500;
+    // --emit=obj|bc|ll|asm writes that artifact instead of linking an executable
+    bool hasEmitKind = false;
+    Backend::EmitKind emitKind = Backend::EmitKind::Object;
     // Package the result for distribution: a .app on macOS, a self-contained
     // directory elsewhere. Assets travel with the binary either way.
     bool bundle = false;
@@ -176,6 +244,15 @@ public:
     // Extra flags appended to the final clang++ link line. Programs can add to
     // these from source with `link "raylib";` — see LinkDirectiveNode.
     std::vector<std::string> linkFlags;
+    // --check: parse and analyze only, each input file on a worker thread;
+    // --message-format=json reports the results as one JSON document
+    bool check = false;
+    bool jsonMessages = false;
+    // --server[=SOCKET]: stay resident and compile on behalf of cscript-client
+    bool server = false;
+    std::string serverSocket;
+    // --lsp: answer an editor's language client on stdin/stdout
+    bool lsp = false;
 
     static CompilerOptions parseArgs(int argc, char** argv) {
         CompilerOptions opts;
@@ -191,8 +268,80 @@ public:
                 opts.verbose = true;
             } else if (arg == "-r" || arg == "--run") {
                 opts.run = true;
+            } else if (arg == "--jit") {
+                opts.jit = true;
+                opts.run = true;
             } else if (arg == "--no-fold") {
                 opts.noFold = true;
+            } else if (arg == "-j" || (starts_with(arg, "-j") && arg.size() > 2)) {
+                std::string count = arg.size() > 2 ? arg.substr(2)
+                                  : (i + 1 < argc ? argv[++i] : "");
+                if (count.empty() || count.find_first_not_of("0123456789") != std::string::npos ||
+                    std::stoul(count) == 0) {
+                    throw std::runtime_error("Option -j requires a positive job count");
+                }
+                opts.jobs = static_cast<unsigned>(std::stoul(count));
+            } else if (arg == "--lto") {
+                opts.lto = true;
+            } else if (arg == "--pgo-gen" || starts_with(arg, "--pgo-gen=")) {
+                opts.pgoGen = true;
+                if (arg.size() > 10) opts.pgoGenFile = arg.substr(10);
+            } else if (arg == "--pgo-use" || starts_with(arg, "--pgo-use=")) {
+                if (arg.size() > 10) {
+                    opts.pgoUseFile = arg.substr(10);
+                } else if (i + 1 < argc) {
+                    opts.pgoUseFile = argv[++i];
+                } else {
+                    throw std::runtime_error("Option " + arg + " requires a .profdata file");
+                }
+            } else if (arg == "--time-trace" || starts_with(arg, "--time-trace=")) {
+                opts.timeTrace = true;
+                if (arg.size() > 13) opts.timeTraceFile = arg.substr(13);
+            } else if (starts_with(arg, "--time-trace-granularity=")) {
+                std::string micros = arg.substr(25);
+                if (micros.empty() || micros.find_first_not_of("0123456789") != std::string::npos) {
+                    throw std::runtime_error("--time-trace-granularity expects microseconds, got '" +
+                                             micros + "'");
+                }
+                opts.timeTraceGranularity = static_cast<unsigned>(std::stoul(micros));
+            } else if (arg == "--server" || starts_with(arg, "--server=")) {
+                opts.server = true;
+                if (arg.size() > 9) opts.serverSocket = arg.substr(9);
+            } else if (arg == "--lsp") {
+                opts.lsp = true;
+            } else if (arg == "--check") {
+                opts.check = true;
+            } else if (starts_with(arg, "--message-format=")) {
+                std::string format = arg.substr(17);
+                if (format != "text" && format != "json") {
+                    throw std::runtime_error("--message-format expects text or json, got '" + format + "'");
+                }
+                opts.jsonMessages = format == "json";
+            } else if (arg == "--no-cache") {
+                opts.noCache = true;
+            } else if (arg.size() == 3 && starts_with(arg, "-O") &&
+                       arg[2] >= '0' && arg[2] <= '3') {
+                opts.optLevel = arg[2] - '0';
+            } else if (starts_with(arg, "--opt-level=")) {
+                std::string level = arg.substr(12);
+                if (level.size() != 1 || level[0] < '0' || level[0] > '3') {
+                    throw std::runtime_error("--opt-level expects 0, 1, 2 or 3, got '" + level + "'");
+                }
+                opts.optLevel = level[0] - '0';
+            } else if (starts_with(arg, "--march=") || starts_with(arg, "--mcpu=")) {
+                // One CPU either way: LLVM has no separate architecture
+                // setting, and clang's -march on x86 is this same name
+                opts.cpu = arg.substr(arg.find('=') + 1);
+                if (opts.cpu.empty()) throw std::runtime_error("Option " + arg + " needs a CPU name");
+            } else if (starts_with(arg, "--target-features=")) {
+                opts.targetFeatures = arg.substr(18);
+            } else if (starts_with(arg, "--emit=")) {
+                std::string kind = arg.substr(7);
+                if (!Backend::parseEmitKind(kind, opts.emitKind)) {
+                    throw std::runtime_error("Unknown --emit kind '" + kind +
+                                             "' (expected obj, bc, ll or asm)");
+                }
+                opts.hasEmitKind = true;
             } else if (arg == "--bundle") {
                 opts.bundle = true;
             } else if (arg == "--assets") {
@@ -230,12 +379,14 @@ public:
                 }
             } else if (starts_with(arg, "-")) {
                 throw std::runtime_error("Unknown option: " + arg);
-            } else if (opts.inputFile.empty()) {
-                opts.inputFile = arg;
             } else {
-                throw std::runtime_error("Multiple input files not supported");
+                opts.inputFiles.push_back(arg);
             }
         }
+        if (!opts.inputFiles.empty()) opts.inputFile = opts.inputFiles.front();
+        if (opts.inputFiles.size() > 1 && !opts.check) {
+            throw std::runtime_error("Multiple input files are only supported with --check");
+        }
         
         return opts;
     }
@@ -244,14 +395,45 @@ public:
         std::cout << Colors::BOLD << "Cypescript Compiler" << Colors::RESET << "\n";
         std::cout << "A TypeScript-style language compiler built with C++ and LLVM\n\n";
         std::cout << Colors::BOLD << "USAGE:" << Colors::RESET << "\n";
-        std::cout << "    cscript [OPTIONS] <input-file>\n\n";
+        std::cout << "    cscript [OPTIONS] <input-file>\n";
+        std::cout << "    cscript --check [--message-format=json] <input-file>...\n";
+        std::cout << "    cscript --lsp\n\n";
         std::cout << Colors::BOLD << "OPTIONS:" << Colors::RESET << "\n";
         std::cout << "    -h, --help          Show this help message\n";
         std::cout << "    -V, --version       Print compiler version\n";
         std::cout << "    -v, --verbose       Enable verbose output\n";
         std::cout << "    -r, --run           Compile and run the program immediately\n";
+        std::cout << "    --jit               Run in process via the JIT: no executable, no temp\n";
+        std::cout << "                        files; exits with the program's own status\n";
         std::cout << "    -o, --output FILE   Specify output executable name\n";
+        std::cout << "    -O0 .. -O3          LLVM optimization level (default: -O2;\n";
+        std::cout << "                        --opt-level=N is the same)\n";
+        std::cout << "    --march=CPU         Generate code for CPU; `native` means this machine,\n";
+        std::cout << "                        with all its extensions (--mcpu=CPU is the same)\n";
+        std::cout << "    --target-features=F Enable or disable CPU features, e.g. +avx2,-avx512f\n";
+        std::cout << "    --emit=KIND         Write obj, bc, ll or asm instead of an executable\n";
+        std::cout << "    --lto               Optimize `link source` files together with the program\n";
+        std::cout << "                        (compiled to bitcode, so their functions can inline)\n";
+        std::cout << "    --pgo-gen[=FILE]    Build an instrumented executable that records a .profraw\n";
+        std::cout << "                        profile when run (to FILE, else LLVM_PROFILE_FILE)\n";
+        std::cout << "    --pgo-use FILE      Optimize with a profile merged by `llvm-profdata merge`\n";
+        std::cout << "    --check             Only parse and analyze: report errors, generate nothing.\n";
+        std::cout << "                        Takes any number of files, checked on -j threads\n";
+        std::cout << "    --message-format=json\n";
+        std::cout << "                        --check results as JSON, for editors and hooks\n";
+        std::cout << "    --lsp               Serve diagnostics to an editor over the Language Server\n";
+        std::cout << "                        Protocol on stdin/stdout; edits reparse only what changed\n";
         std::cout << "    --no-fold           Disable AST constant folding / dead-branch elimination\n";
+        std::cout << "    --no-cache          Ignore the compile cache ($XDG_CACHE_HOME/cypescript)\n";
+        std::cout << "    -j N                Compile up to N `link source` files, or --check up to\n";
+        std::cout << "                        N inputs, at once (default: cores)\n";
+        std::cout << "    --time-trace[=FILE] Write a Chrome/Perfetto trace of the compile to FILE\n";
+        std::cout << "                        (default: <input>.time-trace.json)\n";
+        std::cout << "    --time-trace-granularity=N\n";
+        std::cout << "                        Drop trace events shorter than N µs (default: 500)\n";
+        std::cout << "    --server[=SOCKET]   Stay resident with warm caches and compile for\n";
+        std::cout << "                        cscript-client (default: $CSCRIPT_SERVER, else\n";
+        std::cout << "                        $XDG_RUNTIME_DIR/cscript.sock)\n";
         std::cout << "    --print-tokens      Print lexer tokens\n";
         std::cout << "    --print-ast         Print abstract syntax tree\n\n";
         std::cout << Colors::BOLD << "PACKAGING:" << Colors::RESET << "\n";
@@ -267,8 +449,14 @@ public:
         std::cout << Colors::BOLD << "EXAMPLES:" << Colors::RESET << "\n";
         std::cout << "    cscript hello.csc\n";
         std::cout << "    cscript -r hello.csc\n";
+        std::cout << "    cscript --jit script.csc\n";
         std::cout << "    cscript -o my_app hello.csc\n";
+        std::cout << "    cscript --emit=asm -O3 -o hello.s hello.csc\n";
+        std::cout << "    cscript --check --message-format=json src/*.csc\n";
+        std::cout << "    cscript --march=native -O3 -o server server.csc\n";
+        std::cout << "    cscript --time-trace big.csc    # then open big.time-trace.json in ui.perfetto.dev\n";
         std::cout << "    cscript -r game.csc -lraylib -L/opt/homebrew/lib\n";
+        std::cout << "    cscript --server &  cscript-client -o app app.csc\n";
     }
 };
 
@@ -314,7 +502,7 @@ std::vector<std::string> collectLinkFlags(const ProgramNode* astRoot,
 #endif
 
     for (const auto& stmt : astRoot->statements) {
-        auto* link = dynamic_cast<const LinkDirectiveNode*>(stmt.get());
+        auto* link = nodeCast<const LinkDirectiveNode>(stmt.get());
         if (!link) continue;
         if (link->platform != LinkDirectiveNode::Platform::Any &&
             link->platform != thisPlatform) {
@@ -441,13 +629,106 @@ fs::path createBundle(const fs::path& executable, const fs::path& sourceFile,
     return bundle;
 }
 
-// Compiles one C/C++/Objective-C file to an object file. Each source gets its
+// Runs a shell command, collecting everything it writes to stdout and stderr
+// instead of letting it reach the terminal. Returns the exit status.
+int runCapturing(const std::string& command, std::string& output) {
+    std::string redirected = command + " 2>&1";
+#ifdef _WIN32
+    FILE* pipe = _popen(redirected.c_str(), "r");
+#else
+    FILE* pipe = popen(redirected.c_str(), "r");
+#endif
+    if (!pipe) return -1;
+    char buffer[4096];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, count);
+    }
+#ifdef _WIN32
+    return _pclose(pipe);
+#else
+    return pclose(pipe);
+#endif
+}
+
+// First line of `<driver> --version`, so a compiler upgrade invalidates the
+// native objects it built. Asked once per driver per run, from any thread.
+std::string compilerIdentity(const std::string& driver) {
+    static std::mutex mutex;
+    static std::map<std::string, std::string> identities;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = identities.find(driver);
+    if (found != identities.end()) return found->second;
+
+    std::string output;
+    runCapturing(driver + " --version", output);
+    return identities[driver] = output.substr(0, output.find('\n'));
+}
+
+// Headers a native source can see: everything under the include directories,
+// plus those sitting next to the source itself. Sorted, so the cache key does
+// not depend on directory iteration order.
+std::vector<fs::path> visibleHeaders(const fs::path& source,
+                                     const std::vector<std::string>& includeDirs) {
+    auto isHeader = [](const fs::path& path) {
+        std::string extension = path.extension().string();
+        return extension == ".h" || extension == ".hpp" || extension == ".hh" ||
+               extension == ".hxx" || extension == ".inc";
+    };
+    std::vector<fs::path> headers;
+    std::error_code ec;
+    for (const std::string& directory : includeDirs) {
+        for (fs::recursive_directory_iterator it(directory, ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->is_regular_file(ec) && isHeader(it->path())) headers.push_back(it->path());
+        }
+        ec.clear();
+    }
+    fs::path sourceDir = source.parent_path().empty() ? fs::path(".") : source.parent_path();
+    for (fs::directory_iterator it(sourceDir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && isHeader(it->path())) headers.push_back(it->path());
+    }
+    std::sort(headers.begin(), headers.end());
+    return headers;
+}
+
+// A new, empty file in the temp directory, `<stem>-XXXXXX.<extension>`, for an
+// object on its way to the linker or the compile cache. Unique per call: two
+// builds of the same program at once must not write, link or store each
+// other's object.
+fs::path scratchFile(const std::string& stem, const char* extension) {
+    llvm::SmallString<256> path;
+    if (std::error_code ec = llvm::sys::fs::createTemporaryFile(stem, extension, path)) {
+        throw std::runtime_error("Could not create a temporary file: " + ec.message());
+    }
+    return fs::path(path.str().str());
+}
+
+// One `link source` compile, as reported back to the driver
+struct NativeObject {
+    std::string source;
+    std::string object;     // empty if the compile failed
+    std::string command;    // what was run; empty on a cache hit
+    std::string output;     // the compiler's own diagnostics
+};
+
+// Compiles one C/C++/Objective-C file to an object file, or with `bitcode` to an
+// LLVM bitcode file for Backend::linkBitcode (--lto). `targetFlag` is the
+// clang spelling of --march, if any. Each source gets its
 // own invocation because a single clang++ command cannot give a .c file C rules
 // and a .cpp file C++17 at the same time — mixing them is how `link source` used
 // to fail on ordinary C like `char *p = malloc(n);`.
-std::string compileNativeSource(const std::string& source,
-                                const std::vector<std::string>& includeDirs,
-                                bool verbose) {
+// The object comes from the compile cache when the source, the headers it can
+// see, the flags and the compiler are all unchanged; the returned path is then
+// owned by the cache (see CompileCache::owns) and must not be deleted.
+// Prints nothing, so it can run on any thread: see reportNativeObject().
+NativeObject compileNativeSource(const std::string& source,
+                                 const std::vector<std::string>& includeDirs,
+                                 CompileCache& cache, bool bitcode = false,
+                                 const std::string& targetFlag = "") {
+    NativeObject result;
+    result.source = source;
+
     fs::path path(source);
     std::string extension = path.extension().string();
     for (char& c : extension) c = static_cast<char>(std::tolower(c));
@@ -456,26 +737,205 @@ std::string compileNativeSource(const std::string& source,
                   extension == ".cxx" || extension == ".mm");
     std::string driver = isCxx ? "clang++" : "clang";
     std::string standard = isCxx ? " -std=c++17" : " -std=c11";
+    std::string mode = bitcode ? "-O2 -c -emit-llvm" : "-O2 -c";
+    if (!targetFlag.empty()) mode += " " + shellQuote(targetFlag);
+
+    llvm::TimeTraceScope scope("Compile native source", source);
+    std::string digest;
+    if (cache.enabled()) {
+        CompileCache::Key key;
+        key.add("kind", "native")
+           .add("compiler", compilerIdentity(driver))
+           .add("flags", mode + standard)
+           .add("extension", extension)
+           .addFile("source", path);
+        for (const std::string& directory : includeDirs) key.add("include", directory);
+        for (const fs::path& header : visibleHeaders(path, includeDirs)) {
+            key.addFile(header.string(), header);
+        }
+        digest = key.digest();
 
-    fs::path object = fs::temp_directory_path() /
-                      (path.stem().string() + "_" +
-                       std::to_string(std::hash<std::string>{}(source)) + ".o");
+        if (cache.lookup(digest, result.object)) return result;
+    }
+
+    fs::path object = scratchFile(path.stem().string(), bitcode ? "bc" : "o");
 
-    std::string command = driver + " -O2 -c " + shellQuote(source) + standard;
+    result.command = driver + " " + mode + " " + shellQuote(source) + standard;
     for (const std::string& directory : includeDirs) {
-        command += " " + shellQuote("-I" + directory);
+        result.command += " " + shellQuote("-I" + directory);
     }
-    command += " -o " + shellQuote(object.string());
-    if (verbose) {
-        llvm::outs() << "Compiling native source: " << Colors::CYAN << command
-                     << Colors::RESET << "\n";
+    result.command += " -o " + shellQuote(object.string());
+    if (runCapturing(result.command, result.output) != 0) {
+        std::error_code ec;
+        fs::remove(object, ec);
+        return result;
     }
-    if (std::system(command.c_str()) != 0) {
-        throw std::runtime_error("Failed to compile native source: " + source);
+    result.object = cache.enabled() ? cache.store(digest, object.string()) : object.string();
+    return result;
+}
+
+// Replays one compile on the terminal: the command (or cache hit) under
+// --verbose, then whatever the compiler said. Returns false if it failed.
+bool reportNativeObject(const NativeObject& native, bool verbose) {
+    if (verbose) {
+        if (native.command.empty()) {
+            llvm::outs() << "Native source " << native.source << ": cache hit\n";
+        } else {
+            llvm::outs() << "Compiling native source: " << Colors::CYAN << native.command
+                         << Colors::RESET << "\n";
+        }
+        llvm::outs().flush();
     }
-    return object.string();
+    if (!native.output.empty()) llvm::errs() << native.output;
+    return !native.object.empty();
+}
+
+// Deletes an object that was only scratch space for one link or JIT load;
+// anything the compile cache handed out stays for the next build
+void discardObject(const CompileCache& cache, const std::string& object) {
+    if (cache.owns(object)) return;
+    std::error_code ec;
+    fs::remove(object, ec);
 }
 
+void printWarning(const std::string& message);
+
+// --time-trace: LLVM's time profiler, written out as one Chrome trace-event JSON
+// file (chrome://tracing, ui.perfetto.dev) when main() is left, however it is
+// left. The profiler buffers per thread, so a worker thread that should appear
+// in the trace holds a TimeTrace::Thread for as long as it runs.
+class TimeTrace {
+public:
+    TimeTrace(std::string path, unsigned granularity) : m_path(std::move(path)) {
+        if (m_path.empty()) return;
+        s_granularity = granularity;
+        s_active = true;
+        llvm::timeTraceProfilerInitialize(granularity, "cscript");
+    }
+
+    // Every traced thread must have finished by now: the NativeBuild that
+    // owns them is always destroyed first
+    ~TimeTrace() {
+        if (m_path.empty()) return;
+        std::error_code ec;
+        llvm::raw_fd_ostream out(m_path, ec, llvm::sys::fs::OF_Text);
+        if (ec) {
+            printWarning("Could not write time trace '" + m_path + "': " + ec.message());
+        } else {
+            llvm::timeTraceProfilerWrite(out);
+        }
+        llvm::timeTraceProfilerCleanup();
+        s_active = false;
+    }
+
+    // A no-op on a thread already traced, such as the one that owns the
+    // TimeTrace when it joins its workers: finishing that thread would drop
+    // the profiler the trace is written from
+    class Thread {
+    public:
+        Thread() : m_traced(s_active && !llvm::timeTraceProfilerEnabled()) {
+            if (m_traced) llvm::timeTraceProfilerInitialize(s_granularity, "cscript");
+        }
+        ~Thread() {
+            if (m_traced) llvm::timeTraceProfilerFinishThread();
+        }
+
+    private:
+        bool m_traced;
+    };
+
+private:
+    std::string m_path;
+    static inline std::atomic<bool> s_active{false};
+    static inline unsigned s_granularity = 0;
+};
+
+// Compiles every `link source` file on a pool of `jobs` worker threads, started
+// as soon as the AST says what they are, so the C compiler runs while the main
+// thread does semantic analysis, codegen and LLVM optimization. Each compile's
+// output is held back and replayed in source order by wait(): diagnostics from
+// different files never interleave, and every failure is reported, not only
+// the first one to finish.
+class NativeBuild {
+public:
+    NativeBuild(std::vector<std::string> sources, std::vector<std::string> includeDirs,
+                unsigned jobs, CompileCache& cache, bool bitcode = false,
+                std::string targetFlag = "")
+        : m_sources(std::move(sources)), m_includeDirs(std::move(includeDirs)),
+          m_results(m_sources.size()), m_cache(cache), m_bitcode(bitcode),
+          m_targetFlag(std::move(targetFlag)) {
+        if (jobs == 0) jobs = std::thread::hardware_concurrency();
+        jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(m_sources.size())));
+        for (unsigned i = 0; i < jobs && !m_sources.empty(); ++i) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    // Leaving early (a semantic error, say) stops queued compiles from
+    // starting and waits for the running ones, so no thread outlives main()
+    ~NativeBuild() {
+        m_cancelled = true;
+        join();
+        for (const NativeObject& native : m_results) {
+            if (!native.object.empty()) discardObject(m_cache, native.object);
+        }
+    }
+
+    // Blocks until every compile is done and returns the objects in source
+    // order. Throws std::runtime_error naming every source that failed.
+    // Only the first call returns anything: the objects are then the caller's.
+    std::vector<std::string> wait(bool verbose) {
+        {
+            // Time the main thread spends blocked on the workers
+            llvm::TimeTraceScope scope("Wait for native sources");
+            join();
+        }
+        if (m_collected) return {};
+        m_collected = true;
+        std::vector<std::string> objects;
+        std::string failed;
+        for (NativeObject& native : m_results) {
+            if (reportNativeObject(native, verbose)) {
+                objects.push_back(native.object);
+            } else {
+                failed += (failed.empty() ? "" : ", ") + native.source;
+            }
+        }
+        if (!failed.empty()) {
+            throw std::runtime_error("Failed to compile native source: " + failed);
+        }
+        // Ownership passes to the caller, who discards them after the link
+        for (NativeObject& native : m_results) native.object.clear();
+        return objects;
+    }
+
+private:
+    void work() {
+        TimeTrace::Thread trace;
+        for (size_t i = m_next++; i < m_sources.size() && !m_cancelled; i = m_next++) {
+            m_results[i] = compileNativeSource(m_sources[i], m_includeDirs, m_cache, m_bitcode,
+                                               m_targetFlag);
+        }
+    }
+
+    void join() {
+        for (std::thread& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    std::vector<std::string> m_sources;
+    std::vector<std::string> m_includeDirs;
+    std::vector<NativeObject> m_results;   // one slot per source: no locking needed
+    CompileCache& m_cache;
+    bool m_bitcode;
+    std::string m_targetFlag;
+    bool m_collected = false;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_next{0};
+    std::atomic<bool> m_cancelled{false};
+};
+
 class Timer {
 private:
     std::chrono::high_resolution_clock::time_point start_time;
@@ -490,113 +950,111 @@ public:
     }
 };
 
-std::string readFile(const std::string& filename) {
-    if (!fs::exists(filename)) {
-        throw std::runtime_error("File does not exist: " + filename);
+// Size and modification time of the cscript binary, so a rebuilt compiler never
+// reuses objects from the old one, even when the version string is the same.
+// Taken once per process: a compile server (--server) must go on naming the
+// build it is running, not one installed over it since.
+const std::string& compilerBuild(const char* argv0) {
+    static const std::string build = [argv0] {
+        fs::path exePath = getExecutablePath(argv0);
+        if (exePath.empty()) return std::string();
+        std::error_code ec;
+        return std::to_string(fs::file_size(exePath, ec)) + ":" +
+               std::to_string(fs::last_write_time(exePath, ec).time_since_epoch().count());
+    }();
+    return build;
+}
+
+// Peak resident set size of this process so far, in KB (0 where unsupported)
+size_t peakMemoryKB() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss);        // KB on Linux
+#endif
+#endif
+}
+
+void printStageHeader(const std::string& stage, bool verbose);
+
+// `cscript --jit`: everything the link line would have named is resolved in
+// this process instead — the runtime archive, `link source` objects (compiled,
+// loaded into memory and deleted straight away) and `link`/-l libraries. The
+// program itself is either `module`, or, when the compile cache is in use, the
+// object at `programObject`. Returns the program's own exit status.
+int runWithJIT(const CompilerOptions& opts, const std::vector<std::string>& sourceLinkFlags,
+               NativeBuild& nativeBuild, std::unique_ptr<llvm::LLVMContext> context,
+               std::unique_ptr<llvm::Module> module, const std::string& programObject,
+               CompileCache& cache, const char* argv0) {
+    Timer setupTimer;
+    std::optional<llvm::TimeTraceScope> setupScope(std::in_place, "JIT setup");
+    JITRunner runner;
+
+    for (const std::string& object : nativeBuild.wait(opts.verbose)) {
+        runner.addObjectFile(object);
+        discardObject(cache, object);
     }
-    
-    std::ifstream file(filename);
-    if (!file) {
-        throw std::runtime_error("Could not open file: " + filename);
+
+    // -l flags, searched like the linker would: -L dirs in order, then our own
+    // runtime dir so `link "cypescript_game";` resolves, then the loader's path
+    std::string stdlibPath = findRuntimeLibrary(argv0);
+    std::vector<std::string> allFlags = sourceLinkFlags;
+    allFlags.insert(allFlags.end(), opts.linkFlags.begin(), opts.linkFlags.end());
+    std::vector<std::string> searchDirs;
+    for (const std::string& flag : allFlags) {
+        if (starts_with(flag, "-L")) searchDirs.push_back(flag.substr(2));
     }
-    
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
-
-// --- Module resolution -------------------------------------------------------
-// Cypescript modules are inlined at compile time: every
-//   import { name, ... } from "./file";
-// line is replaced by the (recursively resolved) source of the referenced
-// file, once per file. `export` markers are handled by the parser.
-
-std::string resolveImportsImpl(const std::string& source, const fs::path& baseDir,
-                               std::set<std::string>& visited);
-
-// Where bare imports like `from "game"` are looked up. Set once from main().
-fs::path g_moduleSearchDir;
-
-std::string loadModule(const fs::path& modulePath, std::set<std::string>& visited,
-                       const std::string& requestedAs = "") {
-    fs::path resolved = modulePath;
-    if (resolved.extension().empty()) {
-        resolved += ".csc";
-    }
-    if (!fs::exists(resolved)) {
-        std::string message = "Imported module not found: " + resolved.string();
-        // A bare name like "game" is meant to come from the compiler's own
-        // bundled modules. Say where we looked — the usual cause is a cscript
-        // on PATH that is older than the modules the program expects.
-        if (!requestedAs.empty() && requestedAs.find('/') == std::string::npos) {
-            message += "\n  '" + requestedAs + "' looks like a bundled module. Searched: ";
-            message += g_moduleSearchDir.empty()
-                ? "(no bundled module directory found next to this compiler)"
-                : g_moduleSearchDir.string();
-            message += "\n  This cscript is " + std::string(CYPESCRIPT_VERSION) +
-                       ". If it predates the module you want, rebuild or reinstall it.";
-        }
-        throw std::runtime_error(message);
-    }
-    std::string canonical = fs::canonical(resolved).string();
-    if (visited.count(canonical)) {
-        return ""; // already inlined (also breaks import cycles)
-    }
-    visited.insert(canonical);
-
-    std::ifstream file(resolved);
-    if (!file) {
-        throw std::runtime_error("Could not open imported module: " + resolved.string());
-    }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return resolveImportsImpl(buffer.str(), resolved.parent_path(), visited);
-}
-
-std::string resolveImportsImpl(const std::string& source, const fs::path& baseDir,
-                               std::set<std::string>& visited) {
-    std::stringstream output;
-    std::stringstream input(source);
-    std::string line;
-
-    while (std::getline(input, line)) {
-        std::string trimmed = line;
-        size_t firstChar = trimmed.find_first_not_of(" \t");
-        trimmed = (firstChar == std::string::npos) ? "" : trimmed.substr(firstChar);
-
-        if (starts_with(trimmed, "import ") || starts_with(trimmed, "import{")) {
-            size_t firstQuote = line.find('"');
-            size_t lastQuote = line.rfind('"');
-            if (firstQuote == std::string::npos || lastQuote <= firstQuote) {
-                throw std::runtime_error("Malformed import statement: " + line);
-            }
-            std::string modulePath = line.substr(firstQuote + 1, lastQuote - firstQuote - 1);
-            // A bare name like "game" resolves against the modules bundled with
-            // the compiler; anything relative or absolute resolves as written.
-            bool isRelative = starts_with(modulePath, "./") || starts_with(modulePath, "../") ||
-                              starts_with(modulePath, "/");
-            fs::path resolved = baseDir / modulePath;
-            if (!isRelative && !g_moduleSearchDir.empty()) {
-                fs::path bundled = g_moduleSearchDir / modulePath;
-                if (!fs::exists(resolved) && !fs::exists(resolved.string() + ".csc")) {
-                    resolved = bundled;
-                }
+    searchDirs.push_back(fs::path(stdlibPath).parent_path().string());
+    for (size_t i = 0; i < allFlags.size(); ++i) {
+        const std::string& flag = allFlags[i];
+        if (starts_with(flag, "-l")) {
+            if (!runner.addLibraryByName(flag.substr(2), searchDirs)) {
+                throw std::runtime_error("--jit: could not find library '" + flag.substr(2) +
+                                         "' (add -L<dir>, or drop --jit to link normally)");
             }
-            output << loadModule(resolved, visited, modulePath) << "\n";
-        } else {
-            output << line << "\n";
+        } else if (flag == "-framework" && i + 1 < allFlags.size()) {
+            const std::string& name = allFlags[++i];
+            runner.addSharedLibrary("/System/Library/Frameworks/" + name + ".framework/" + name);
+        } else if (!starts_with(flag, "-L")) {
+            printWarning("--jit ignores link flag " + flag);
         }
     }
-    return output.str();
-}
 
-std::string resolveImports(const std::string& source, const std::string& inputFile) {
-    std::set<std::string> visited;
-    fs::path inputPath(inputFile);
-    if (fs::exists(inputPath)) {
-        visited.insert(fs::canonical(inputPath).string());
+    // The runtime goes last, mirroring the link line. The repo-source fallback
+    // has no archive to load, so compile it like a `link source` file.
+    if (fs::path(stdlibPath).extension() == ".cpp") {
+        NativeObject runtime = compileNativeSource(stdlibPath, {}, cache);
+        if (!reportNativeObject(runtime, opts.verbose)) {
+            throw std::runtime_error("Failed to compile the runtime: " + stdlibPath);
+        }
+        runner.addObjectFile(runtime.object);
+        discardObject(cache, runtime.object);
+    } else {
+        runner.addStaticLibrary(stdlibPath);
+    }
+
+    if (!programObject.empty()) {
+        runner.addObjectFile(programObject);
     }
-    return resolveImportsImpl(source, inputPath.parent_path(), visited);
+
+    if (opts.verbose) {
+        llvm::outs() << "JIT ready (" << setupTimer.elapsed() << "ms)\n";
+        llvm::outs() << "----------------------------------------\n";
+    }
+    setupScope.reset();
+    // The program writes through C stdio; flush ours first so output interleaves
+    llvm::outs().flush();
+    int status = runner.runMain(std::move(context), std::move(module));
+    if (opts.verbose) {
+        llvm::outs() << "----------------------------------------\n";
+        llvm::outs() << "Program exited with code " << status << "\n";
+    }
+    return status;
 }
 
 void printStageHeader(const std::string& stage, bool verbose) {
@@ -619,7 +1077,160 @@ void printWarning(const std::string& message) {
     llvm::errs() << Colors::YELLOW << "⚠ Warning: " << message << Colors::RESET << "\n";
 }
 
-int main(int argc, char** argv) {
+// Bundled modules the compile server has parsed ahead of time, one graph per
+// file so that none sees another's enums, with the arena their ASTs live in.
+// Every forked request hands them to its own ModuleGraph (reuseParsed).
+struct PreparedModules {
+    ASTArena arena;
+    std::vector<std::unique_ptr<ModuleGraph>> graphs;
+    std::map<std::string, fs::file_time_type> stamps;   // what they were parsed from
+};
+std::unique_ptr<PreparedModules> preparedModules;
+bool servingCompiles = false;
+
+int serveCompiles(const CompilerOptions& opts, const char* self);
+int serveLanguageClient(const CompilerOptions& opts, const char* self);
+
+// --check: one input file's verdict
+struct CheckResult {
+    std::string file;
+    std::string error;      // empty if the file is clean
+    double milliseconds = 0;
+};
+
+// Where a diagnostic points, as far as its message says. Semantic errors end in
+// "at line L, column C", plus "of FILE" when they are in an imported module;
+// parse errors lead with "FILE: ". Anything else is placed on the checked file.
+struct DiagnosticLocation {
+    std::string file;
+    int line = 0;
+    int column = 0;
+};
+
+DiagnosticLocation locateDiagnostic(const std::string& message, const std::string& checkedFile) {
+    static const std::regex position(R"(at line (\d+)(?:, column (\d+))?(?: of (\S+))?)");
+    static const std::regex leadingFile(R"(^(\S+\.csc): )");
+    DiagnosticLocation location;
+    location.file = checkedFile;
+    std::smatch match;
+    if (std::regex_search(message, match, position)) {
+        location.line = std::stoi(match[1].str());
+        if (match[2].matched) location.column = std::stoi(match[2].str());
+        if (match[3].matched) {
+            location.file = match[3].str();
+            while (!location.file.empty() && (location.file.back() == '.' || location.file.back() == ')')) {
+                location.file.pop_back();
+            }
+        }
+    }
+    if (std::regex_search(message, match, leadingFile)) location.file = match[1].str();
+    return location;
+}
+
+// Lexes, parses and analyzes one file as the entry point of its own program.
+// Nothing is generated, so nothing here touches LLVM.
+CheckResult checkFile(const std::string& file, const fs::path& moduleDirectory) {
+    CheckResult result;
+    result.file = file;
+    Timer timer;
+    llvm::TimeTraceScope scope("Check", file);
+    try {
+        ASTArena arena;
+        ModuleGraph graph(moduleDirectory);
+        if (preparedModules) {
+            // The server's parsed bundled modules go to whichever check asks first
+            static std::mutex preparedMutex;
+            std::lock_guard<std::mutex> lock(preparedMutex);
+            for (auto& prepared : preparedModules->graphs) graph.reuseParsed(*prepared);
+        }
+        graph.load(file);
+        std::unique_ptr<ProgramNode> program = graph.link();
+        SemanticAnalyzer analyzer;
+        analyzer.analyze(program.get());
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    result.milliseconds = timer.elapsed();
+    return result;
+}
+
+// `cscript --check a.csc b.csc ...`: every file is its own program, so they
+// are checked independently, on up to -j threads, and every broken file is
+// reported rather than only the first. Exits 1 if any file has an error.
+int checkFiles(const CompilerOptions& opts, const char* self) {
+    Timer totalTimer;
+    fs::path moduleDirectory = findModuleDirectory(self);
+    std::vector<CheckResult> results(opts.inputFiles.size());
+    unsigned jobs = opts.jobs ? opts.jobs : std::thread::hardware_concurrency();
+    jobs = std::max(1u, std::min<unsigned>(jobs, static_cast<unsigned>(results.size())));
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        TimeTrace::Thread trace;
+        for (size_t i = next++; i < results.size(); i = next++) {
+            results[i] = checkFile(opts.inputFiles[i], moduleDirectory);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < jobs; ++i) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+
+    size_t failed = 0;
+    for (const CheckResult& result : results) failed += !result.error.empty();
+
+    if (opts.jsonMessages) {
+        // {"files": [{"file", "ok", "ms", "diagnostics": [...]}], "errors", "ms"}
+        llvm::json::OStream json(llvm::outs());
+        json.object([&] {
+            json.attributeArray("files", [&] {
+                for (const CheckResult& result : results) {
+                    json.object([&] {
+                        json.attribute("file", result.file);
+                        json.attribute("ok", result.error.empty());
+                        json.attribute("ms", result.milliseconds);
+                        json.attributeArray("diagnostics", [&] {
+                            if (result.error.empty()) return;
+                            DiagnosticLocation location = locateDiagnostic(result.error, result.file);
+                            json.object([&] {
+                                json.attribute("severity", "error");
+                                json.attribute("message", result.error);
+                                json.attribute("file", location.file);
+                                if (location.line) json.attribute("line", location.line);
+                                if (location.column) json.attribute("column", location.column);
+                            });
+                        });
+                    });
+                }
+            });
+            json.attribute("errors", static_cast<int64_t>(failed));
+            json.attribute("ms", totalTimer.elapsed());
+        });
+        llvm::outs() << "\n";
+    } else {
+        for (const CheckResult& result : results) {
+            if (result.error.empty()) {
+                printSuccess(result.file + " (" + std::to_string(result.milliseconds) + "ms)", opts.verbose);
+            } else if (starts_with(result.error, result.file + ": ")) {
+                printError(result.error);
+            } else {
+                printError(result.file + ": " + result.error);
+            }
+        }
+        std::string summary = "Checked " + std::to_string(results.size()) + " file(s) in " +
+                              std::to_string(totalTimer.elapsed()) + "ms";
+        if (failed == 0) {
+            llvm::outs() << Colors::GREEN << "✓ " << summary << ", no errors" << Colors::RESET << "\n";
+        } else {
+            llvm::errs() << Colors::RED << summary << ": " << failed << " with errors" << Colors::RESET << "\n";
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+// One cscript invocation. `self` is the running binary's argv[0]; for a request
+// to the compile server, argv is the client's and its argv[0] means nothing.
+int runCompiler(int argc, char** argv, const char* self) {
     Timer totalTimer;
     
     try {
@@ -635,138 +1246,294 @@ int main(int argc, char** argv) {
             std::cout << "cypescript " << CYPESCRIPT_VERSION << "\n";
             return 0;
         }
+
+        if (opts.server) {
+            if (servingCompiles) {
+                throw std::runtime_error("--server cannot be requested from a compile server");
+            }
+            return serveCompiles(opts, self);
+        }
         
+        if (opts.lsp) return serveLanguageClient(opts, self);
+
         if (opts.inputFile.empty()) {
             printError("No input file provided");
             std::cout << "Use --help for usage information\n";
             return 1;
         }
         
+        // Declared before anything that traces, so it is the last thing destroyed
+        std::string timeTracePath;
+        if (opts.timeTrace) {
+            timeTracePath = !opts.timeTraceFile.empty()
+                                ? opts.timeTraceFile
+                                : fs::path(opts.inputFile).stem().string() + ".time-trace.json";
+        }
+        TimeTrace timeTrace(timeTracePath, opts.timeTraceGranularity);
+
+        if (opts.check) return checkFiles(opts, self);
+
+        // Every AST node of this compilation is allocated here. Declared ahead
+        // of the module graph and the linked program, so it outlives both.
+        ASTArena astArena;
+
         if (opts.verbose) {
             llvm::outs() << Colors::BOLD << "Cypescript Compiler v1.0.0" << Colors::RESET << "\n";
             llvm::outs() << "Input file: " << opts.inputFile << "\n";
             llvm::outs() << "Output file: " << opts.outputFile << "\n\n";
         }
         
-        // Read source code
-        printStageHeader("Reading Source", opts.verbose);
-        Timer readTimer;
-        std::string sourceCode = readFile(opts.inputFile);
-        printSuccess("Source code read (" + std::to_string(readTimer.elapsed()) + "ms)", opts.verbose);
-
-        // Module Resolution (import/export inlining)
-        printStageHeader("Module Resolution", opts.verbose);
-        Timer importTimer;
-        g_moduleSearchDir = findModuleDirectory(argv[0]);
-        sourceCode = resolveImports(sourceCode, opts.inputFile);
-        printSuccess("Imports resolved (" + std::to_string(importTimer.elapsed()) + "ms)", opts.verbose);
-        
-        // Lexical Analysis
-        printStageHeader("Lexical Analysis", opts.verbose);
-        Timer lexTimer;
-        Lexer lexer(sourceCode);
-        std::vector<Token> tokens;
-        Token token;
-        
-        do {
-            token = lexer.getNextToken();
-            tokens.push_back(token);
-            
-            if (opts.printTokens) {
-                llvm::outs() << "Token { Type: " << Colors::YELLOW << tokenTypeToString(token.type) 
-                           << Colors::RESET << ", Value: \"" << Colors::GREEN << token.value 
+        // Module graph: the entry file and everything it imports, each read,
+        // lexed and parsed exactly once, with its exports checked
+        printStageHeader("Module Graph", opts.verbose);
+        Timer moduleTimer;
+        ModuleGraph graph(findModuleDirectory(self));
+        if (preparedModules) {
+            for (auto& prepared : preparedModules->graphs) graph.reuseParsed(*prepared);
+        }
+        std::function<void(const Token&)> printToken;
+        if (opts.printTokens) {
+            printToken = [](const Token& token) {
+                llvm::outs() << "Token { Type: " << Colors::YELLOW << tokenTypeToString(token.type)
+                           << Colors::RESET << ", Value: \"" << Colors::GREEN << token.value
                            << Colors::RESET << "\" }\n";
+            };
+        }
+        {
+            llvm::TimeTraceScope scope("Module graph", opts.inputFile);
+            graph.load(opts.inputFile, printToken);
+        }
+        size_t tokenCount = 0;
+        size_t sourceBytes = 0;
+        for (const auto& module : graph.modules()) {
+            tokenCount += module->tokenCount;
+            sourceBytes += module->source.size();
+            if (opts.verbose) {
+                llvm::outs() << "  " << module->displayName << " (" << module->tokenCount
+                             << " tokens, " << module->imports.size() << " import(s))\n";
             }
-        } while (token.type != TOK_EOF);
-        
-        printSuccess("Lexical analysis complete (" + std::to_string(lexTimer.elapsed()) + "ms, " 
-                    + std::to_string(tokens.size()) + " tokens)", opts.verbose);
-        
-        // Syntax Analysis (Parsing)
-        printStageHeader("Syntax Analysis", opts.verbose);
-        Timer parseTimer;
-        Parser parser(tokens);
-        std::unique_ptr<ProgramNode> astRoot = parser.parse();
-        
-        if (!astRoot) {
-            printError("Parsing failed");
-            return 1;
         }
-        
-        printSuccess("Syntax analysis complete (" + std::to_string(parseTimer.elapsed()) + "ms)", opts.verbose);
+        printSuccess("Loaded " + std::to_string(graph.modules().size()) + " module(s) (" +
+                     std::to_string(moduleTimer.elapsed()) + "ms, " + std::to_string(tokenCount) +
+                     " tokens)", opts.verbose);
+
+        // What gets written: an object to link (the default), or, with --emit or
+        // an output name ending in .ll, the requested artifact itself
+        bool isExecutable = !opts.hasEmitKind;
+        Backend::EmitKind emitKind = opts.emitKind;
+        if (!opts.hasEmitKind && opts.outputFile.size() > 3 &&
+            opts.outputFile.substr(opts.outputFile.size() - 3) == ".ll") {
+            isExecutable = false;
+            emitKind = Backend::EmitKind::IR;
+        }
 
-        // Semantic Analysis (undefined variables, const reassignment, break/continue
-        // placement, function arity) — errors carry line/column positions
-        printStageHeader("Semantic Analysis", opts.verbose);
-        Timer semanticTimer;
-        try {
-            SemanticAnalyzer analyzer;
-            analyzer.analyze(astRoot.get());
-        } catch (const std::runtime_error& e) {
-            printError(e.what());
-            return 1;
+        // The profile runtime an instrumented build calls into comes from the
+        // link line, which --jit does not have
+        if (opts.pgoGen && opts.jit) {
+            throw std::runtime_error("--pgo-gen builds an executable to train; it cannot be "
+                                     "combined with --jit");
+        }
+        Backend::Options backendOptions;
+        backendOptions.optLevel = opts.optLevel;
+        backendOptions.cpu = opts.cpu;
+        backendOptions.features = opts.targetFeatures;
+        backendOptions.lto = opts.lto;
+        backendOptions.pgoGenerate = opts.pgoGen;
+        backendOptions.pgoUse = !opts.pgoUseFile.empty();
+        backendOptions.pgoProfile = opts.pgoGen ? opts.pgoGenFile : opts.pgoUseFile;
+        Backend backend(backendOptions);
+        if (opts.verbose) {
+            llvm::outs() << "Target: " << backend.triple() << ", CPU " << backend.cpu()
+                         << ", -O" << opts.optLevel << "\n";
+            if (!backend.features().empty()) {
+                llvm::outs() << "Features: " << backend.features() << "\n";
+            }
         }
-        printSuccess("Semantic analysis complete (" + std::to_string(semanticTimer.elapsed()) + "ms)", opts.verbose);
 
-        // AST Optimization (constant folding + dead-branch elimination)
-        if (!opts.noFold) {
-            printStageHeader("AST Optimization", opts.verbose);
-            Timer optTimer;
-            ASTOptimizer optimizer;
-            ASTOptimizer::Stats optStats = optimizer.optimize(astRoot.get());
-            printSuccess("Constant folding complete (" + std::to_string(optTimer.elapsed()) + "ms, "
-                        + std::to_string(optStats.foldedExpressions) + " expressions folded, "
-                        + std::to_string(optStats.eliminatedBranches) + " dead branches removed)", opts.verbose);
+        // Compile cache. The program's object depends on its modules' source,
+        // on this exact compiler build and on the flags that shape codegen —
+        // nothing else — plus, under --lto, the bitcode merged into it. Only
+        // objects are cached (what linking and --jit consume); --emit
+        // artifacts and --print-ast, which wants the AST passes to run, always
+        // compile.
+        CompileCache cache(CompileCache::defaultDirectory(), !opts.noCache);
+        // Nothing inlines at -O0, so there is no point reading it there
+        std::string runtimeBitcode = opts.optLevel > 0 ? findRuntimeBitcode(self) : "";
+        bool cacheableProgram = cache.enabled() && !opts.printAST && (opts.jit || isExecutable);
+        CompileCache::Key programKey;
+        if (cacheableProgram) {
+            programKey
+                .add("kind", "program")
+                .add("version", CYPESCRIPT_VERSION)
+                .add("llvm", LLVM_VERSION_STRING)
+                .add("build", compilerBuild(self))
+                .add("triple", backend.triple())
+                .add("cpu", backend.cpu())
+                .add("features", backend.features())
+                .add("opt-level", std::to_string(opts.optLevel))
+                .add("fold", opts.noFold ? "off" : "on")
+                .add("lto", opts.lto ? "on" : "off")
+                .add("pgo-gen", opts.pgoGen ? "on:" + opts.pgoGenFile : "off")
+                .add("modules", graph.digest());
+            if (!opts.pgoUseFile.empty()) programKey.addFile("pgo-use", opts.pgoUseFile);
+            if (!runtimeBitcode.empty()) programKey.addFile("runtime-bitcode", runtimeBitcode);
         }
 
-        if (opts.printAST || opts.verbose) {
-            llvm::outs() << "\n" << Colors::MAGENTA << "=== Abstract Syntax Tree ===" << Colors::RESET << "\n";
-            astRoot->printNode(llvm::outs());
-            llvm::outs() << Colors::MAGENTA << "=== End of AST ===" << Colors::RESET << "\n\n";
+        // One program from the modules, dependencies first
+        std::unique_ptr<ProgramNode> astRoot;
+        {
+            llvm::TimeTraceScope scope("Link modules");
+            astRoot = graph.link();
         }
-        
-        // Code Generation
-        printStageHeader("Code Generation", opts.verbose);
-        Timer codegenTimer;
-        llvm::LLVMContext context;
-        CodeGen codeGenerator(context);
-        llvm::Module* module = codeGenerator.generate(astRoot.get());
-        
-        if (!module) {
-            printError("Code generation failed");
-            return 1;
+
+        // `link source` files start compiling now, on worker threads, while
+        // this thread gets on with analysis, codegen and optimization. Only a
+        // run that links or JITs needs them — or, under --lto, any run, since
+        // their bitcode becomes part of the program's own module.
+        std::vector<std::string> nativeSources;
+        std::vector<std::string> includeDirs;
+        std::vector<std::string> sourceLinkFlags =
+            collectLinkFlags(astRoot.get(), fs::path(opts.inputFile).parent_path(),
+                             &nativeSources, &includeDirs);
+        if (!opts.jit && !isExecutable && !opts.lto) nativeSources.clear();
+        // The native sources target the same CPU as the program. clang spells
+        // that -march on x86 and -mcpu elsewhere; --target-features has no
+        // portable clang spelling, so it applies to Cypescript code only.
+        std::string nativeTargetFlag;
+        if (!opts.cpu.empty()) {
+            bool isX86 = starts_with(backend.triple(), "x86_64") || starts_with(backend.triple(), "i386") ||
+                         starts_with(backend.triple(), "i686");
+            nativeTargetFlag = (isX86 ? "-march=" : "-mcpu=") + opts.cpu;
         }
-        
-        printSuccess("Code generation complete (" + std::to_string(codegenTimer.elapsed()) + "ms)", opts.verbose);
-        
-        // Write LLVM IR
-        printStageHeader("Writing Output", opts.verbose);
-        Timer writeTimer;
-        
-        std::string irFile = opts.outputFile;
-        bool isExecutable = true;
-        
-        if (irFile.empty()) {
-            irFile = "temp_output.ll";
-        } else if (irFile.size() > 3 && irFile.substr(irFile.size() - 3) == ".ll") {
-            isExecutable = false;
-        } else {
-            // Specified an executable name, use a temp .ll file
-            irFile += ".ll";
+        NativeBuild nativeBuild(nativeSources, includeDirs, opts.jobs, cache, opts.lto,
+                                nativeTargetFlag);
+
+        // Under --lto the bitcode is an input to the program's object, so it
+        // has to exist before the cache can be asked for that object
+        std::vector<std::string> ltoBitcode;
+        if (opts.lto) {
+            ltoBitcode = nativeBuild.wait(opts.verbose);
+            for (const std::string& bitcode : ltoBitcode) programKey.addFile("bitcode", bitcode);
         }
+        std::string programDigest = cacheableProgram ? programKey.digest() : "";
 
-        std::error_code EC;
-        llvm::raw_fd_ostream dest(irFile, EC, llvm::sys::fs::OF_None);
-        
-        if (EC) {
-            printError("Could not open IR file '" + irFile + "': " + EC.message());
-            return 1;
+        // The AST is still needed on a hit: `link` directives live in it
+        std::string cachedProgram;
+        bool cacheHit = cacheableProgram && cache.lookup(programDigest, cachedProgram);
+        if (cacheHit) {
+            printSuccess("Compile cache hit: " + cachedProgram, opts.verbose);
         }
-        
-        module->print(dest, nullptr);
-        dest.flush();
-        printSuccess("LLVM IR written to " + irFile + " (" + std::to_string(writeTimer.elapsed()) + "ms)", opts.verbose);
-        
+
+        // Heap-allocated so --jit can hand it to ORC along with the module
+        auto context = std::make_unique<llvm::LLVMContext>();
+#if LLVM_VERSION_MAJOR < 15
+        // CodeGen emits opaque-pointer IR (`ptr`), the default from LLVM 15 on.
+        // LLVM 14 has them too, but only when asked.
+        context->enableOpaquePointers();
+#endif
+        std::unique_ptr<llvm::Module> module;
+
+        if (!cacheHit) {
+            // Semantic Analysis (undefined variables, const reassignment, break/continue
+            // placement, function arity) — errors carry line/column positions
+            printStageHeader("Semantic Analysis", opts.verbose);
+            Timer semanticTimer;
+            try {
+                llvm::TimeTraceScope scope("Semantic analysis");
+                SemanticAnalyzer analyzer;
+                analyzer.analyze(astRoot.get());
+            } catch (const std::runtime_error& e) {
+                printError(e.what());
+                return 1;
+            }
+            printSuccess("Semantic analysis complete (" + std::to_string(semanticTimer.elapsed()) + "ms)", opts.verbose);
+
+            // AST Optimization (constant folding + dead-branch elimination)
+            if (!opts.noFold) {
+                printStageHeader("AST Optimization", opts.verbose);
+                Timer optTimer;
+                ASTOptimizer::Stats optStats;
+                {
+                    llvm::TimeTraceScope scope("AST optimization");
+                    ASTOptimizer optimizer;
+                    optStats = optimizer.optimize(astRoot.get());
+                }
+                printSuccess("AST optimization complete (" + std::to_string(optTimer.elapsed()) + "ms, "
+                            + std::to_string(optStats.foldedExpressions) + " expressions folded, "
+                            + std::to_string(optStats.eliminatedBranches) + " dead branches removed, "
+                            + std::to_string(optStats.propagatedConstants) + " constants propagated, "
+                            + std::to_string(optStats.inlinedCalls) + " calls inlined, "
+                            + std::to_string(optStats.hoistedInvariants) + " loop invariants hoisted, "
+                            + std::to_string(optStats.evaluatedCalls) + " const calls evaluated)", opts.verbose);
+            }
+
+            if (opts.printAST || opts.verbose) {
+                llvm::outs() << "\n" << Colors::MAGENTA << "=== Abstract Syntax Tree ===" << Colors::RESET << "\n";
+                astRoot->printNode(llvm::outs());
+                llvm::outs() << Colors::MAGENTA << "=== End of AST ===" << Colors::RESET << "\n\n";
+            }
+
+            // Code Generation
+            printStageHeader("Code Generation", opts.verbose);
+            Timer codegenTimer;
+            {
+                llvm::TimeTraceScope scope("Code generation");
+                CodeGen codeGenerator(*context);
+                if (!codeGenerator.generate(astRoot.get())) {
+                    printError("Code generation failed");
+                    return 1;
+                }
+                module = codeGenerator.takeModule();
+            }
+
+            printSuccess("Code generation complete (" + std::to_string(codegenTimer.elapsed()) + "ms)", opts.verbose);
+
+            if (!ltoBitcode.empty()) {
+                printStageHeader("Linking Native Bitcode", opts.verbose);
+                Timer ltoTimer;
+                for (const std::string& bitcode : ltoBitcode) backend.linkBitcode(*module, bitcode);
+                printSuccess("Merged " + std::to_string(ltoBitcode.size()) + " native source(s) (" +
+                             std::to_string(ltoTimer.elapsed()) + "ms)", opts.verbose);
+            }
+
+            // The runtime functions the program calls, as inlinable bodies
+            if (!runtimeBitcode.empty()) {
+                Timer runtimeTimer;
+                backend.linkRuntimeBitcode(*module, runtimeBitcode);
+                printSuccess("Runtime bitcode linked from " + runtimeBitcode + " (" +
+                             std::to_string(runtimeTimer.elapsed()) + "ms)", opts.verbose);
+            }
+
+            // Optimization: LLVM's new pass manager, in process. This used to be
+            // left to a `clang++ -O2` subprocess that had to re-parse textual IR.
+            printStageHeader("Optimization", opts.verbose);
+            Timer optimizeTimer;
+            {
+                llvm::TimeTraceScope scope("LLVM optimization");
+                backend.optimize(*module);
+            }
+            printSuccess("Optimization complete (-O" + std::to_string(opts.optLevel) +
+                         (opts.lto ? " + LTO, " : ", ") + std::to_string(optimizeTimer.elapsed()) +
+                         "ms)", opts.verbose);
+        }
+        for (const std::string& bitcode : ltoBitcode) discardObject(cache, bitcode);
+
+        if (opts.jit) {
+            // With the cache on, a miss is emitted and stored like any other
+            // build, and the JIT loads that object — next run is a hit
+            if (cacheableProgram && !cacheHit) {
+                fs::path objectPath = scratchFile(fs::path(opts.inputFile).stem().string(), "o");
+                backend.emit(*module, Backend::EmitKind::Object, objectPath.string());
+                cachedProgram = cache.store(programDigest, objectPath.string());
+                module.reset();
+            }
+            printStageHeader("Running Program (JIT)", opts.verbose);
+            int status = runWithJIT(opts, sourceLinkFlags, nativeBuild, std::move(context),
+                                    std::move(module), cachedProgram, cache, self);
+            discardObject(cache, cachedProgram);
+            return status;
+        }
+
         std::string executableName = opts.outputFile;
         if (executableName.empty()) {
             // Default executable name: input filename without extension
@@ -774,29 +1541,56 @@ int main(int argc, char** argv) {
             executableName = p.stem().string();
         }
 
+        std::string artifactFile;
+        if (isExecutable) {
+            // Scratch object for the link
+            artifactFile = scratchFile(fs::path(executableName).filename().string(), "o").string();
+        } else if (!opts.outputFile.empty()) {
+            artifactFile = opts.outputFile;
+        } else {
+            artifactFile = fs::path(opts.inputFile).stem().string() + Backend::extensionFor(emitKind);
+        }
+
+        if (cacheHit) {
+            artifactFile = cachedProgram;
+        } else {
+            printStageHeader("Writing Output", opts.verbose);
+            Timer writeTimer;
+            backend.emit(*module, emitKind, artifactFile);
+            if (cacheableProgram) {
+                artifactFile = cache.store(programDigest, artifactFile);
+            }
+            printSuccess("Wrote " + artifactFile + " (" + std::to_string(writeTimer.elapsed()) + "ms)",
+                         opts.verbose);
+        }
+
         if (isExecutable) {
             printStageHeader("Compiling to Executable", opts.verbose);
             Timer compileTimer;
             
             // Locate the runtime: precompiled libcypescript.a next to the binary
             // (or CYPESCRIPT_HOME), falling back to the stdlib source in the repo
-            std::string stdlibPath = findRuntimeLibrary(argv[0]);
-
-            std::string compileCmd = "clang++ -O2 " + irFile + " -o " + executableName + " -std=c++17";
-
-            // Libraries the program asked for itself via `link "raylib";`, followed
-            // by anything passed on the command line (which therefore wins).
-            std::vector<std::string> nativeSources;
-            std::vector<std::string> includeDirs;
-            std::vector<std::string> sourceLinkFlags =
-                collectLinkFlags(astRoot.get(), fs::path(opts.inputFile).parent_path(),
-                                 &nativeSources, &includeDirs);
-
-            // `link source "x.c";` — compile each one first, then link the objects
-            std::vector<std::string> nativeObjects;
-            for (const std::string& source : nativeSources) {
-                nativeObjects.push_back(compileNativeSource(source, includeDirs, opts.verbose));
+            std::string stdlibPath = findRuntimeLibrary(self);
+
+            // clang++ is only the link driver now — it pulls in the C++ standard
+            // library the runtime needs. Optimization already happened above.
+            std::string compileCmd = "clang++ " + shellQuote(artifactFile) + " -o " +
+                                     shellQuote(executableName);
+            if (fs::path(stdlibPath).extension() == ".cpp") {
+                // Repo-source fallback: the runtime itself still needs compiling
+                compileCmd += " -O2 -std=c++17";
+                if (!nativeTargetFlag.empty()) compileCmd += " " + shellQuote(nativeTargetFlag);
             }
+            if (opts.pgoGen) {
+                // Links the profile runtime the instrumentation writes through
+                compileCmd += " -fprofile-generate";
+            }
+
+            // `link source "x.c";` — the objects the native build has been
+            // compiling in the background all along. Then libraries the program
+            // asked for itself via `link "raylib";`, followed by anything passed
+            // on the command line (which therefore wins).
+            std::vector<std::string> nativeObjects = nativeBuild.wait(opts.verbose);
             for (const std::string& object : nativeObjects) {
                 compileCmd += " " + shellQuote(object);
             }
@@ -864,24 +1658,24 @@ int main(int argc, char** argv) {
                 llvm::outs() << "Running: " << Colors::CYAN << compileCmd << Colors::RESET << "\n";
             }
             
-            int result = std::system(compileCmd.c_str());
+            int result;
+            {
+                llvm::TimeTraceScope scope("Link executable", executableName);
+                result = std::system(compileCmd.c_str());
+            }
 
-            // The objects were only ever scratch space for this link
+            // The objects were only ever scratch space for this link, unless
+            // the cache is keeping them for the next one
             for (const std::string& object : nativeObjects) {
-                std::error_code ec;
-                fs::remove(object, ec);
+                discardObject(cache, object);
             }
+            discardObject(cache, artifactFile);
 
             if (result != 0) {
                 printError("Failed to compile executable");
                 return 1;
             }
-            
-            // Clean up temp IR file if it wasn't requested
-            if (opts.outputFile != irFile) {
-                fs::remove(irFile);
-            }
-            
+
             printSuccess("Executable created: " + executableName + " (" + std::to_string(compileTimer.elapsed()) + "ms)", opts.verbose);
 
             if (opts.bundle) {
@@ -897,18 +1691,26 @@ int main(int argc, char** argv) {
         if (opts.verbose) {
             llvm::outs() << "\n" << Colors::BOLD << "=== Compilation Summary ===" << Colors::RESET << "\n";
             llvm::outs() << "Total time: " << Colors::GREEN << totalTimer.elapsed() << "ms" << Colors::RESET << "\n";
-            llvm::outs() << "Input: " << opts.inputFile << " (" << sourceCode.size() << " bytes)\n";
+            llvm::outs() << "Input: " << opts.inputFile << " (" << graph.modules().size() << " module(s), "
+                         << sourceBytes << " bytes)\n";
+            llvm::outs() << "AST arena: " << (astArena.bytesAllocated() + 1023) / 1024 << " KB\n";
+            if (size_t peak = peakMemoryKB()) llvm::outs() << "Peak memory: " << peak << " KB\n";
+            if (cache.enabled()) {
+                llvm::outs() << "Cache: " << cache.stats().hits << " hit(s), "
+                             << cache.stats().misses << " miss(es) in "
+                             << cache.directory().string() << "\n";
+            }
             if (isExecutable) {
                 llvm::outs() << "Executable: " << executableName << "\n";
             } else {
-                llvm::outs() << "Output IR: " << irFile << "\n";
+                llvm::outs() << "Output: " << artifactFile << "\n";
             }
             llvm::outs() << "Status: " << Colors::GREEN << "SUCCESS" << Colors::RESET << "\n\n";
         } else {
             if (isExecutable) {
                 llvm::outs() << Colors::GREEN << "✓ Compiled to: " << Colors::BOLD << executableName << Colors::RESET << "\n";
             } else {
-                llvm::outs() << Colors::GREEN << "✓ IR written to: " << irFile << Colors::RESET << "\n";
+                llvm::outs() << Colors::GREEN << "✓ Written to: " << artifactFile << Colors::RESET << "\n";
             }
         }
         
@@ -939,12 +1741,13 @@ int main(int argc, char** argv) {
             
             // Optional: remove executable after running if it was just a temporary run
             // fs::remove(executableName);
-        } else if (!opts.verbose && !isExecutable) {
-            // Print next steps for IR mode only if not verbose
+        } else if (!opts.verbose && !isExecutable && emitKind != Backend::EmitKind::Assembly) {
+            // Print next steps for artifact mode only if not verbose
+            std::string programName = fs::path(artifactFile).stem().string();
             llvm::outs() << Colors::BOLD << "Next steps:" << Colors::RESET << "\n";
-            llvm::outs() << "1. Compile to executable: " << Colors::CYAN << "clang++ " << irFile 
-                       << " src/cypescript_stdlib.cpp -o " << executableName << Colors::RESET << "\n";
-            llvm::outs() << "2. Run program:           " << Colors::CYAN << "./" << executableName << Colors::RESET << "\n";
+            llvm::outs() << "1. Link an executable:    " << Colors::CYAN << "clang++ " << artifactFile
+                       << " build/libcypescript.a -o " << programName << Colors::RESET << "\n";
+            llvm::outs() << "2. Run program:           " << Colors::CYAN << "./" << programName << Colors::RESET << "\n";
         }
         
         return 0;
@@ -954,3 +1757,134 @@ int main(int argc, char** argv) {
         return 1;
     }
 }
+
+// Every bundled module file and when it last changed, to notice an edit
+std::map<std::string, fs::file_time_type> bundledModuleStamps(const fs::path& directory) {
+    std::map<std::string, fs::file_time_type> stamps;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".csc") {
+            stamps[it->path().string()] = it->last_write_time(ec);
+        }
+    }
+    return stamps;
+}
+
+// Parses the bundled modules again if any of them changed since last time
+void refreshPreparedModules(const fs::path& directory) {
+    auto stamps = bundledModuleStamps(directory);
+    if (preparedModules && preparedModules->stamps == stamps) return;
+    preparedModules.reset();
+    auto prepared = std::make_unique<PreparedModules>();
+    for (const auto& [path, stamp] : stamps) {
+        auto graph = std::make_unique<ModuleGraph>(directory);
+        try {
+            graph->load(path);
+        } catch (const std::runtime_error& e) {
+            // Each request will parse it, and report the error, itself
+            printWarning("--server: " + std::string(e.what()));
+            continue;
+        }
+        prepared->graphs.push_back(std::move(graph));
+    }
+    prepared->stamps = std::move(stamps);
+    preparedModules = std::move(prepared);
+}
+
+// `cscript --server`: warms up everything a compile would otherwise start from
+// cold — LLVM's target registry, the bundled modules, the compiler's build
+// identity and the C compilers' versions for cache keys — and then serves
+// requests, each in a child forked from that state (see CompileServer.h).
+int serveCompiles(const CompilerOptions& opts, const char* self) {
+    std::string socketPath = !opts.serverSocket.empty() ? opts.serverSocket
+                                                        : CompileServer::defaultSocketPath();
+    Timer warmTimer;
+    Backend::Options backendOptions;
+    backendOptions.optLevel = opts.optLevel;
+    Backend warmBackend(backendOptions);
+    compilerBuild(self);
+    compilerIdentity("clang");
+    compilerIdentity("clang++");
+    fs::path moduleDirectory = findModuleDirectory(self);
+    refreshPreparedModules(moduleDirectory);
+
+    llvm::outs() << Colors::GREEN << "✓ Compile server on " << socketPath << " (" << warmBackend.triple()
+                 << ", warm in " << std::to_string(warmTimer.elapsed()) << "ms)" << Colors::RESET << "\n";
+    llvm::outs() << "Send compiles with: CSCRIPT_SERVER=" << socketPath
+                 << " cscript-client <args>\n";
+    llvm::outs().flush();
+
+    servingCompiles = true;
+    return CompileServer::serve(
+        socketPath,
+        [&moduleDirectory] { refreshPreparedModules(moduleDirectory); },
+        [self](const CompileServer::Request& request) {
+            std::vector<char*> args{const_cast<char*>(self)};
+            for (const std::string& arg : request.args) args.push_back(const_cast<char*>(arg.c_str()));
+            args.push_back(nullptr);
+            int status = runCompiler(static_cast<int>(args.size() - 1), args.data(), self);
+            std::cout.flush();
+            llvm::outs().flush();
+            llvm::errs().flush();
+            return status;
+        },
+        opts.verbose);
+}
+
+// `cscript --lsp`: checks each open document as an editor changes it. Every
+// document keeps an IncrementalParser, so a check after an edit lexes and
+// parses only the declarations the edit touched; imported modules are read
+// from disk, or from the editor if they are open too. Nothing may be written
+// to stdout but the protocol, so -v reports each check on stderr.
+int serveLanguageClient(const CompilerOptions& opts, const char* self) {
+    fs::path moduleDirectory = findModuleDirectory(self);
+    std::map<std::string, std::unique_ptr<IncrementalParser>> parsers;   // by path
+    std::map<std::string, std::string> openTexts;
+
+    auto check = [&](const std::string& path, const std::string& text) {
+        std::vector<LanguageServer::Diagnostic> diagnostics;
+        std::unique_ptr<IncrementalParser>& parser = parsers[path];
+        if (!parser) parser = std::make_unique<IncrementalParser>();
+        openTexts[path] = text;
+
+        Timer timer;
+        std::unique_ptr<ProgramNode> program;
+        try {
+            ModuleGraph graph(moduleDirectory);
+            // Open documents are checked as the editor has them, saved or not
+            for (const auto& [openPath, openText] : openTexts) graph.overlay(openPath, openText);
+            graph.parseEntryWith(*parser);
+            graph.load(path);
+            program = graph.link();
+            SemanticAnalyzer analyzer;
+            analyzer.analyze(program.get());
+        } catch (const std::exception& e) {
+            DiagnosticLocation location = locateDiagnostic(e.what(), path);
+            LanguageServer::Diagnostic diagnostic;
+            diagnostic.message = e.what();
+            if (location.file == path) {
+                diagnostic.line = location.line;
+                diagnostic.column = location.column;
+            }
+            diagnostics.push_back(std::move(diagnostic));
+        }
+        if (program) parser->reclaim(*program);
+
+        if (opts.verbose) {
+            const IncrementalParser::Stats& stats = parser->stats();
+            llvm::errs() << "cscript --lsp: " << path << ": " << stats.parsed << " statement(s) parsed, "
+                         << stats.reused << " reused, " << diagnostics.size() << " diagnostic(s) in "
+                         << std::to_string(timer.elapsed()) << "ms\n";
+        }
+        return diagnostics;
+    };
+    auto closed = [&](const std::string& path) {
+        parsers.erase(path);
+        openTexts.erase(path);
+    };
+    return LanguageServer::serve(std::cin, std::cout, check, closed);
+}
+
+int main(int argc, char** argv) {
+    return runCompiler(argc, argv, argv[0]);
+}
@@ -0,0 +1,11 @@
+// Helper module for test_modules.csc (not run directly by the test suite)
+// Imports math_utils too, so the graph has a shared dependency: it must still be
+// loaded — and its top-level code run — exactly once.
+
+import { square } from "./math_utils";
+
+export enum Shape { Point, Square = 4, Cube = 6 }
+
+export function area(side: i32): i32 {
+    return square(side);
+}
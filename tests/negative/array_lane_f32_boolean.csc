@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in argument 1 of 'first': expected 'boolean[]', got 'f32[]'
+// An f32[] stores four bytes an element and a boolean[] one byte
+function first(xs: boolean[]): i32 {
+    return xs.length;
+}
+let source: f32[] = [0.5, 1.5];
+println(first(source));
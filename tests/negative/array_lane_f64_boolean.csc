@@ -0,0 +1,6 @@
+// EXPECT: Type mismatch in assignment to 'target': expected 'boolean[]', got 'f64[]'
+// An f64[] stores eight bytes an element and a boolean[] one byte
+let target: boolean[] = [];
+let source: f64[] = [1.5, 2.5];
+target = source;
+println(target.length);
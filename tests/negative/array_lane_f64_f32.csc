@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in return value: expected 'f32[]', got 'f64[]'
+// An f64[] stores eight bytes an element and an f32[] four bytes
+function widen(): f32[] {
+    let source: f64[] = [1.5, 2.5];
+    return source;
+}
+println(widen().length);
@@ -0,0 +1,5 @@
+// EXPECT: Type mismatch in declaration of 'target': expected 'i64[]', got 'f64[]'
+// f64 and i64 elements are both eight bytes wide but encoded differently
+let source: f64[] = [1.5, 2.5];
+let target: i64[] = source;
+println(target.length);
@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in argument 1 of 'first': expected 'u8[]', got 'f64[]'
+// An f64[] stores eight bytes an element and a u8[] one byte
+function first(xs: u8[]): i32 {
+    return xs.length;
+}
+let source: f64[] = [1.5, 2.5];
+println(first(source));
@@ -0,0 +1,6 @@
+// EXPECT: Type mismatch in assignment to 'target': expected 'boolean[]', got 'i32[]'
+// An i32[] stores four bytes an element and a boolean[] one byte
+let target: boolean[] = [];
+let source: i32[] = [1, 2];
+target = source;
+println(target.length);
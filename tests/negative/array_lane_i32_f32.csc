@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in return value: expected 'f32[]', got 'i32[]'
+// i32 and f32 elements are both four bytes wide but encoded differently
+function widen(): f32[] {
+    let source: i32[] = [1, 2];
+    return source;
+}
+println(widen().length);
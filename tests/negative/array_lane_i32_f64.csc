@@ -0,0 +1,12 @@
+// EXPECT: Type mismatch in argument 1 of 'total': expected 'f64[]', got 'i32[]'
+// Each array is indexed in place at its element width; an i32[] read as an
+// f64[] would run off the end of its storage
+function total(xs: f64[]): f64 {
+    let t: f64 = 0.0;
+    for (let i = 0; i < xs.length; i++) {
+        t = t + xs[i];
+    }
+    return t;
+}
+let counts: i32[] = [1, 2, 3];
+println(total(counts));
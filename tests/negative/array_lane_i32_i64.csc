@@ -0,0 +1,5 @@
+// EXPECT: Type mismatch in declaration of 'target': expected 'i64[]', got 'i32[]'
+// An i32[] stores four bytes an element and an i64[] eight bytes
+let source: i32[] = [1, 2];
+let target: i64[] = source;
+println(target.length);
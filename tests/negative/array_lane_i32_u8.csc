@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in argument 1 of 'first': expected 'u8[]', got 'i32[]'
+// An i32[] stores four bytes an element and a u8[] one byte
+function first(xs: u8[]): i32 {
+    return xs.length;
+}
+let source: i32[] = [1, 2];
+println(first(source));
@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in return value: expected 'boolean[]', got 'i64[]'
+// An i64[] stores eight bytes an element and a boolean[] one byte
+function widen(): boolean[] {
+    let source: i64[] = [5000000000, 2];
+    return source;
+}
+println(widen().length);
@@ -0,0 +1,7 @@
+// EXPECT: Type mismatch in argument 1 of 'first': expected 'f32[]', got 'i64[]'
+// An i64[] stores eight bytes an element and an f32[] four bytes
+function first(xs: f32[]): i32 {
+    return xs.length;
+}
+let source: i64[] = [5000000000, 2];
+println(first(source));
@@ -0,0 +1,5 @@
+// EXPECT: Type mismatch in declaration of 'target': expected 'u8[]', got 'i64[]'
+// An i64[] stores eight bytes an element and a u8[] one byte
+let source: i64[] = [5000000000, 2];
+let target: u8[] = source;
+println(target.length);
@@ -0,0 +1,6 @@
+// EXPECT: Type mismatch in return value: expected 'f64[][]', got 'i32[][]'
+function grid(): f64[][] {
+    let rows: i32[][] = [[1, 2], [3, 4]];
+    return rows;
+}
+println(grid().length);
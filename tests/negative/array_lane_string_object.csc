@@ -0,0 +1,3 @@
+// EXPECT: Type mismatch in declaration of 'handles': expected 'ptr[]', got 'string[]'
+let names: string[] = ["a", "b"];
+let handles: ptr[] = names;
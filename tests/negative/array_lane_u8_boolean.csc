@@ -0,0 +1,5 @@
+// EXPECT: Type mismatch in declaration of 'target': expected 'boolean[]', got 'u8[]'
+// u8 and boolean elements are both one byte wide but encoded differently
+let source: u8[] = [1, 2];
+let target: boolean[] = source;
+println(target.length);
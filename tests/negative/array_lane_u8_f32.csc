@@ -0,0 +1,6 @@
+// EXPECT: Type mismatch in assignment to 'target': expected 'f32[]', got 'u8[]'
+// A u8[] stores one byte an element and an f32[] four bytes
+let target: f32[] = [];
+let source: u8[] = [1, 2];
+target = source;
+println(target.length);
@@ -0,0 +1,6 @@
+// EXPECT: Type mismatch in assignment to 'cats'
+class Cat { lives: i32 = 9; }
+class Car { wheels: f64 = 4.0; }
+let cats: Cat[] = [];
+let cars: Car[] = [new Car()];
+cats = cars;
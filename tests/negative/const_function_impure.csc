@@ -0,0 +1,6 @@
+// EXPECT: calls 'println', which is not a const function
+const function noisy(x: i32): i32 {
+    println(x);
+    return x * 2;
+}
+println(noisy(3));
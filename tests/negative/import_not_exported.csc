@@ -0,0 +1,6 @@
+// EXPECT: has no export named 'hidden'
+// A module that uses `export` declares its interface; anything else in it is
+// private, and importing it by name is an error rather than silently working.
+import { visible, hidden } from "./modules/private_helper";
+
+println(visible());
@@ -0,0 +1,6 @@
+// EXPECT: Use of undefined variable 'missing' at line 3, column 12 of
+// The error is in an imported module, and its position must name that module:
+// line 3 is only meaningful in the file it came from.
+import { broken } from "./modules/broken_module";
+
+println(broken());
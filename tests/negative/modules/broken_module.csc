@@ -0,0 +1,4 @@
+// Helper module for negative/module_error_names_file.csc
+export function broken(): i32 {
+    return missing;
+}
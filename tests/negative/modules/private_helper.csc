@@ -0,0 +1,8 @@
+// Helper module for negative/import_not_exported.csc
+export function visible(): i32 {
+    return 1;
+}
+
+function hidden(): i32 {
+    return 2;
+}
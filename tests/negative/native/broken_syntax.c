@@ -0,0 +1,2 @@
+// Deliberately invalid C for negative/native_compile_errors.csc
+int broken_syntax(int x) { return x + ; }
@@ -0,0 +1,9 @@
+// EXPECT: broken_syntax.c,
+// Both files fail to compile, on different worker threads. Every failure is
+// reported, in the order the program lists them — not just whichever finished
+// first.
+link source "native/broken_syntax.c";
+link source "native/broken_undeclared.c";
+
+declare function broken_syntax(x: i32): i32;
+println(broken_syntax(1));
@@ -27,6 +27,11 @@ if [[ -z "$COMPILER" ]]; then
     exit 1
 fi
 
+# A private compile cache: the suite starts cold, and never reads or fills the
+# developer's own ~/.cache/cypescript
+export XDG_CACHE_HOME="$(mktemp -d)"
+trap 'rm -rf "$XDG_CACHE_HOME"' EXIT
+
 echo -e "${CYAN}🧪 Cypescript Test Suite${NC}"
 echo "============================================"
 
@@ -69,6 +74,372 @@ for test_file in "$SCRIPT_DIR"/test_*.csc; do
     fi
 done
 
+# --- JIT run mode -------------------------------------------------------------
+# The same fixtures again through `cscript --jit`, which never links: the runtime
+# archive and `link source` objects are resolved inside the compiler's process.
+# It runs in a scratch directory that must still be empty afterwards — leaving
+# no executable or temp files behind is half the point of the mode. --no-cache,
+# or every fixture would just load the object the section above cached.
+echo ""
+echo -e "${CYAN}JIT run mode (--jit)${NC}"
+echo "--------------------------------------------"
+JIT_DIR=$(mktemp -d)
+for test_file in "$SCRIPT_DIR"/test_*.csc; do
+    test_name=$(basename "$test_file" .csc)
+    expected_file="$SCRIPT_DIR/expected/$test_name.out"
+    [[ -f "$expected_file" ]] || continue
+    printf "  %-25s" "$test_name"
+
+    status="ok"
+    if actual=$(cd "$JIT_DIR" && "$COMPILER" --jit --no-cache "$test_file" 2>/dev/null); then
+        if [[ "$actual" != "$(cat "$expected_file")" ]]; then
+            status="output mismatch"
+        elif [[ -n "$(ls -A "$JIT_DIR")" ]]; then
+            status="left files behind: $(ls -A "$JIT_DIR" | head -3 | tr '\n' ' ')"
+            rm -rf "${JIT_DIR:?}"/*
+        fi
+    else
+        status="exit code $?"
+    fi
+
+    if [[ "$status" == "ok" ]]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}❌ FAIL ($status)${NC}"
+        FAIL=$((FAIL + 1))
+        ERRORS="$ERRORS\n  - $test_name --jit ($status)"
+    fi
+done
+rmdir "$JIT_DIR" 2>/dev/null || true
+
+# --- Compile cache ------------------------------------------------------------
+# Every fixture above was compiled once, so a rebuild must come straight from
+# the cache — the program object and its `link source` objects — and still
+# produce the same output, linked or under --jit.
+echo ""
+echo -e "${CYAN}Compile cache${NC}"
+echo "--------------------------------------------"
+CACHE_TEST="$SCRIPT_DIR/test_c_interop.csc"
+CACHE_EXPECTED="$(cat "$SCRIPT_DIR/expected/test_c_interop.out")"
+for mode in build jit; do
+    printf "  %-25s" "cached $mode"
+    bin="$SCRIPT_DIR/.bin_cache"
+    if [[ "$mode" == "build" ]]; then
+        log=$("$COMPILER" -v -o "$bin" "$CACHE_TEST" 2>&1) && actual=$("$bin" 2>/dev/null) || actual=""
+    else
+        log=$("$COMPILER" -v --jit "$CACHE_TEST" 2>&1) || true
+        actual=$("$COMPILER" --jit "$CACHE_TEST" 2>/dev/null) || actual=""
+    fi
+    rm -f "$bin"
+
+    if ! grep -q "Compile cache hit" <<< "$log"; then
+        status="program was recompiled"
+    elif grep -q "Compiling native source" <<< "$log"; then
+        status="native source was recompiled"
+    elif [[ "$actual" != "$CACHE_EXPECTED" ]]; then
+        status="output mismatch"
+    else
+        status="ok"
+    fi
+
+    if [[ "$status" == "ok" ]]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}❌ FAIL ($status)${NC}"
+        FAIL=$((FAIL + 1))
+        ERRORS="$ERRORS
+  - cached $mode ($status)"
+    fi
+done
+
+# Builds of the same program sharing one cold cache, as on a build farm: each
+# writes its own scratch objects, and all of them succeed.
+printf "  %-25s" "cached concurrent"
+CONCURRENT_DIR="$(mktemp -d)"
+for i in 1 2 3 4 5 6 7 8; do
+    if (( i % 2 )); then
+        XDG_CACHE_HOME="$CONCURRENT_DIR/cache" "$COMPILER" --jit "$CACHE_TEST" > "$CONCURRENT_DIR/$i.out" 2>&1 &
+    else
+        { XDG_CACHE_HOME="$CONCURRENT_DIR/cache" "$COMPILER" -o "$CONCURRENT_DIR/$i.bin" "$CACHE_TEST" >/dev/null 2>&1 &&
+          "$CONCURRENT_DIR/$i.bin" > "$CONCURRENT_DIR/$i.out" 2>&1; } &
+    fi
+done
+wait
+status="ok"
+for i in 1 2 3 4 5 6 7 8; do
+    if [[ "$(cat "$CONCURRENT_DIR/$i.out" 2>/dev/null)" != "$CACHE_EXPECTED" ]]; then
+        status="build $i: $(head -1 "$CONCURRENT_DIR/$i.out" 2>/dev/null)"
+        break
+    fi
+done
+rm -rf "$CONCURRENT_DIR"
+if [[ "$status" == "ok" ]]; then
+    echo -e "${GREEN}✅ PASS${NC}"
+    PASS=$((PASS + 1))
+else
+    echo -e "${RED}❌ FAIL ($status)${NC}"
+    FAIL=$((FAIL + 1))
+    ERRORS="$ERRORS
+  - cached concurrent ($status)"
+fi
+
+# --- Cross-language LTO -------------------------------------------------------
+# Under --lto the `link source` files become bitcode and are optimized together
+# with the program. The fixture must behave exactly as it does linked normally,
+# and c_triple — a one-line C helper — must be inlined away entirely rather
+# than survive as a call across the language boundary.
+echo ""
+echo -e "${CYAN}Cross-language LTO (--lto)${NC}"
+echo "--------------------------------------------"
+LTO_TEST="$SCRIPT_DIR/test_c_interop.csc"
+LTO_EXPECTED="$(cat "$SCRIPT_DIR/expected/test_c_interop.out")"
+for mode in build jit inlined; do
+    printf "  %-25s" "lto $mode"
+    bin="$SCRIPT_DIR/.bin_lto"
+    status="ok"
+    if [[ "$mode" == "build" ]]; then
+        "$COMPILER" --lto --no-cache -o "$bin" "$LTO_TEST" >/dev/null 2>&1 &&
+            actual=$("$bin" 2>/dev/null) || actual=""
+        [[ "$actual" == "$LTO_EXPECTED" ]] || status="output mismatch"
+    elif [[ "$mode" == "jit" ]]; then
+        actual=$("$COMPILER" --lto --no-cache --jit "$LTO_TEST" 2>/dev/null) || actual=""
+        [[ "$actual" == "$LTO_EXPECTED" ]] || status="output mismatch"
+    else
+        if ! "$COMPILER" --lto --no-cache --emit=ll -o "$bin.ll" "$LTO_TEST" >/dev/null 2>&1; then
+            status="compile failed"
+        elif grep -q "call.*@c_triple" "$bin.ll"; then
+            status="c_triple was not inlined"
+        fi
+    fi
+    rm -f "$bin" "$bin.ll"
+
+    if [[ "$status" == "ok" ]]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}❌ FAIL ($status)${NC}"
+        FAIL=$((FAIL + 1))
+        ERRORS="$ERRORS
+  - lto $mode ($status)"
+    fi
+done
+
+# --- Compile time trace -------------------------------------------------------
+# --time-trace must write a Chrome trace that accounts for every stage, including
+# the `link source` compile on its worker thread, and still produce a program
+# that behaves like any other build.
+echo ""
+echo -e "${CYAN}Compile time trace (--time-trace)${NC}"
+echo "--------------------------------------------"
+printf "  %-25s" "time trace"
+bin="$SCRIPT_DIR/.bin_trace"
+status="ok"
+if ! "$COMPILER" --no-cache --time-trace="$bin.json" --time-trace-granularity=0 -o "$bin" \
+        "$LTO_TEST" >/dev/null 2>&1; then
+    status="compile failed"
+elif [[ "$("$bin" 2>/dev/null)" != "$LTO_EXPECTED" ]]; then
+    status="output mismatch"
+else
+    for event in "Parse" "Semantic analysis" "AST optimization" "Class layout" \
+                 "Generate main" "Function bodies" "InstCombinePass" "Compile native source" \
+                 "Emit" "Link executable"; do
+        if ! grep -q "\"name\":\"$event\"" "$bin.json" 2>/dev/null; then
+            status="no \"$event\" event"
+            break
+        fi
+    done
+fi
+rm -f "$bin" "$bin.json"
+
+if [[ "$status" == "ok" ]]; then
+    echo -e "${GREEN}✅ PASS${NC}"
+    PASS=$((PASS + 1))
+else
+    echo -e "${RED}❌ FAIL ($status)${NC}"
+    FAIL=$((FAIL + 1))
+    ERRORS="$ERRORS
+  - time trace ($status)"
+fi
+
+# --- Check mode ---------------------------------------------------------------
+# --check must accept every positive test, and report broken files in JSON with
+# the position each message names, including a file other than the one checked.
+# Under --time-trace every file checked, on whichever thread, is in the trace.
+echo ""
+echo -e "${CYAN}Check mode (--check)${NC}"
+echo "--------------------------------------------"
+for check in positive json time-trace; do
+    printf "  %-25s" "check $check"
+    status="ok"
+    if [[ "$check" == "positive" ]]; then
+        output=$("$COMPILER" --check "$SCRIPT_DIR"/test_*.csc 2>&1) || status="rejected: $(echo "$output" | head -1)"
+    elif [[ "$check" == "time-trace" ]]; then
+        trace="$(mktemp)"
+        if ! output=$("$COMPILER" --check -j 2 --time-trace="$trace" --time-trace-granularity=0 \
+                      "$SCRIPT_DIR/test_scopes.csc" "$SCRIPT_DIR/test_math.csc" 2>&1); then
+            status="failed: $(echo "$output" | head -1)"
+        elif [[ $(grep -o '"name":"Check"' "$trace" | wc -l) != 2 ]]; then
+            status="expected 2 Check events"
+        fi
+        rm -f "$trace"
+    else
+        if output=$("$COMPILER" --check --message-format=json "$SCRIPT_DIR/negative/undefined_variable.csc" \
+                    "$SCRIPT_DIR/negative/module_error_names_file.csc" "$SCRIPT_DIR/test_scopes.csc" 2>&1); then
+            status="accepted"
+        elif [[ "$output" != *'"errors":2'* ]]; then
+            status="wrong error count"
+        elif [[ "$output" != *'"line":2,"column":9'* || "$output" != *'broken_module.csc","line":3,"column":12'* ]]; then
+            status="wrong positions"
+        fi
+    fi
+
+    if [[ "$status" == "ok" ]]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}❌ FAIL ($status)${NC}"
+        FAIL=$((FAIL + 1))
+        ERRORS="$ERRORS
+  - check $check ($status)"
+    fi
+done
+
+# --- Compile server -----------------------------------------------------------
+# Requests sent through cscript-client to a `cscript --server` must behave like
+# cscript run directly: same output on the client's terminal, same exit status,
+# same diagnostics. The bundled modules must come from the server's warm copy,
+# not be parsed again for each request. Unix only, like the server itself.
+CLIENT="$(dirname "$COMPILER")/cscript-client"
+if [[ -x "$CLIENT" ]]; then
+    echo ""
+    echo -e "${CYAN}Compile server (--server)${NC}"
+    echo "--------------------------------------------"
+    SERVER_DIR="$(mktemp -d)"
+    export CSCRIPT_SERVER="$SERVER_DIR/cscript.sock"
+    "$COMPILER" --server >/dev/null 2>&1 &
+    SERVER_PID=$!
+    for _ in $(seq 50); do [[ -S "$CSCRIPT_SERVER" ]] && break; sleep 0.1; done
+
+    for check in jit diagnostics "warm modules"; do
+        printf "  %-25s" "server $check"
+        status="ok"
+        if [[ ! -S "$CSCRIPT_SERVER" ]]; then
+            status="server did not start"
+        elif [[ "$check" == "jit" ]]; then
+            actual=$("$CLIENT" --jit "$SCRIPT_DIR/test_scopes.csc" 2>/dev/null) || status="exit status $?"
+            [[ "$status" != "ok" || "$actual" == "$(cat "$SCRIPT_DIR/expected/test_scopes.out")" ]] ||
+                status="output mismatch"
+        elif [[ "$check" == "diagnostics" ]]; then
+            neg_file="$SCRIPT_DIR/negative/undefined_variable.csc"
+            expected_msg=$(grep -m1 '// EXPECT:' "$neg_file" | sed 's|.*// EXPECT: *||')
+            if output=$("$CLIENT" --jit "$neg_file" 2>&1); then
+                status="accepted"
+            elif [[ "$output" != *"$expected_msg"* ]]; then
+                status="wrong message"
+            fi
+        else
+            printf 'import { } from "game";\nprintln("warm");\n' > "$SERVER_DIR/warm.csc"
+            if ! "$CLIENT" --no-cache --emit=bc -o "$SERVER_DIR/warm.bc" --time-trace="$SERVER_DIR/warm.json" \
+                    --time-trace-granularity=0 "$SERVER_DIR/warm.csc" >/dev/null 2>&1; then
+                status="compile failed"
+            elif grep -q '"detail":"[^"]*game.csc"' "$SERVER_DIR/warm.json"; then
+                status="game.csc parsed again"
+            fi
+        fi
+
+        if [[ "$status" == "ok" ]]; then
+            echo -e "${GREEN}✅ PASS${NC}"
+            PASS=$((PASS + 1))
+        else
+            echo -e "${RED}❌ FAIL ($status)${NC}"
+            FAIL=$((FAIL + 1))
+            ERRORS="$ERRORS
+  - server $check ($status)"
+        fi
+    done
+
+    kill "$SERVER_PID" 2>/dev/null
+    wait "$SERVER_PID" 2>/dev/null || true
+    unset CSCRIPT_SERVER
+    rm -rf "$SERVER_DIR"
+fi
+
+# --- Language server ----------------------------------------------------------
+# An editor session over `cscript --lsp`: the document is checked as the editor
+# has it, not as it is on disk; an edit that moves code down reports the error
+# at its new line, parsing only the function that changed; fixing it clears the
+# diagnostics, and a shutdown before exit ends with status 0. A document opened
+# before it was ever saved is checked too, importing from the directory it will
+# be saved in.
+echo ""
+echo -e "${CYAN}Language server (--lsp)${NC}"
+echo "--------------------------------------------"
+LSP_DIR="$(mktemp -d)"
+LSP_DOC="$LSP_DIR/doc.csc"
+printf 'println(1);\n' > "$LSP_DOC"
+lsp_message() { printf 'Content-Length: %d\r\n\r\n%s' "${#1}" "$1"; }
+lsp_change() {
+    lsp_message '{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file://'"$LSP_DOC"'","version":'"$1"'},"contentChanges":[{"text":"'"$2"'"}]}}'
+}
+LSP_CLEAN='function a(): i32 {\n    return 1;\n}\nfunction b(): i32 {\n    return 2;\n}\nprintln(a() + b());\n'
+LSP_BROKEN='\n\nfunction a(): i32 {\n    return 1;\n}\nfunction b(): i32 {\n    return missing;\n}\nprintln(a() + b());\n'
+{
+    lsp_message '{"jsonrpc":"2.0","id":1,"method":"initialize","params":{}}'
+    lsp_message '{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file://'"$LSP_DOC"'","languageId":"cypescript","version":1,"text":"'"$LSP_CLEAN"'"}}}'
+    lsp_change 2 "$LSP_BROKEN"
+    lsp_change 3 "$LSP_CLEAN"
+    lsp_message '{"jsonrpc":"2.0","id":2,"method":"shutdown"}'
+    lsp_message '{"jsonrpc":"2.0","method":"exit"}'
+} > "$LSP_DIR/session"
+lsp_status=0
+lsp_output=$("$COMPILER" --lsp -v < "$LSP_DIR/session" 2> "$LSP_DIR/stderr") || lsp_status=$?
+lsp_log=$(cat "$LSP_DIR/stderr")
+printf 'export function seven(): i32 {\n    return 7;\n}\n' > "$LSP_DIR/helper.csc"
+LSP_UNSAVED='import { seven } from \"./helper\";\nprintln(seven() + missing);\n'
+{
+    lsp_message '{"jsonrpc":"2.0","id":1,"method":"initialize","params":{}}'
+    lsp_message '{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file://'"$LSP_DIR/unsaved.csc"'","languageId":"cypescript","version":1,"text":"'"$LSP_UNSAVED"'"}}}'
+    lsp_message '{"jsonrpc":"2.0","id":2,"method":"shutdown"}'
+    lsp_message '{"jsonrpc":"2.0","method":"exit"}'
+} > "$LSP_DIR/unsaved_session"
+lsp_unsaved=$("$COMPILER" --lsp < "$LSP_DIR/unsaved_session" 2>&1 | grep -o '"diagnostics":\[[^]]*\]')
+for check in diagnostics incremental unsaved; do
+    printf "  %-25s" "lsp $check"
+    status="ok"
+    if [[ "$check" == "diagnostics" ]]; then
+        published=$(echo "$lsp_output" | grep -o '"diagnostics":\[[^]]*\]')
+        if [[ "$lsp_status" != 0 ]]; then
+            status="exit status $lsp_status"
+        elif [[ $(echo "$published" | wc -l) != 3 ]]; then
+            status="expected 3 publishes"
+        elif [[ "$(echo "$published" | sed -n 1p)" != '"diagnostics":[]' ||
+                "$(echo "$published" | sed -n 3p)" != '"diagnostics":[]' ]]; then
+            status="clean text not clean"
+        elif [[ "$(echo "$published" | sed -n 2p)" != *"'missing' at line 7"*'"start":{"character":11,"line":6}'* ]]; then
+            status="wrong diagnostic: $(echo "$published" | sed -n 2p)"
+        fi
+    elif [[ "$check" == "incremental" ]]; then
+        if [[ "$(echo "$lsp_log" | sed -n 2p)" != *"1 statement(s) parsed, 2 reused"* ]]; then
+            status="edit reparsed: $(echo "$lsp_log" | sed -n 2p)"
+        fi
+    elif [[ "$lsp_unsaved" != *"'missing' at line 2"*'"line":1'* ]]; then
+        status="wrong diagnostic: $lsp_unsaved"
+    fi
+
+    if [[ "$status" == "ok" ]]; then
+        echo -e "${GREEN}✅ PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}❌ FAIL ($status)${NC}"
+        FAIL=$((FAIL + 1))
+        ERRORS="$ERRORS
+  - lsp $check ($status)"
+    fi
+done
+rm -rf "$LSP_DIR"
+
 # --- Negative tests -----------------------------------------------------------
 # Programs that MUST be rejected, with the message they must be rejected with.
 # Without these nothing verifies that errors are actually reported — the whole
@@ -0,0 +1,134 @@
+// Tests: i32, f64 and object arrays are indexed in place through the lane
+// header (data, length, capacity, head) with a bounds check, and pushed in
+// place while there is room. Out of range still reads 0 / null and a write
+// past the end still grows the array, as the runtime calls always did.
+class Point {
+    x: i32;
+    y: f64;
+    constructor(x: i32, y: f64) {
+        this.x = x;
+        this.y = y;
+    }
+}
+
+// Pushes across several capacity doublings, then reads every element back
+let xs: i32[] = [];
+for (let i = 0; i < 1000; i++) {
+    xs.push(i * 3);
+}
+let total = 0;
+for (let i = 0; i < xs.length; i++) {
+    total += xs[i];
+}
+println(xs.length);
+println(total);
+
+// Out of range, either side, reads 0 and writes nothing
+println(xs[1000]);
+println(xs[-1]);
+println(xs.length);
+
+// A write past the end grows the array, filling the gap with zeros
+let sparse: i32[] = [1];
+sparse[4] = 5;
+println(sparse.length);
+println(sparse[2]);
+println(sparse[4]);
+sparse.push(6);
+println(sparse[5]);
+
+// f64 elements, updated in place in a loop
+let ys: f64[] = [0.5, 1.5, 2.5];
+for (let pass = 0; pass < 4; pass++) {
+    for (let i = 0; i < ys.length; i++) {
+        ys[i] = ys[i] * 2.0;
+    }
+}
+println(ys[0]);
+println(ys[2]);
+println(ys[3]);
+
+// Object elements, from a literal and from push
+let points: Point[] = [new Point(1, 0.25), new Point(2, 0.5)];
+points.push(new Point(3, 0.75));
+println(points.length);
+println(points[2].x);
+println(points[1].y);
+let sumX = 0;
+for (const p of points) {
+    sumX += p.x;
+}
+println(sumX);
+points.forEach((p: Point) => {
+    println(p.x * 10);
+});
+println(points.filter((p: Point) => p.x > 1).length);
+
+// Nested arrays hold array handles in the object lane
+let grid: i32[][] = [[1, 2], [3, 4, 5]];
+println(grid.length);
+println(grid[1].length);
+println(grid[1][2]);
+grid[0][1] = 20;
+println(grid[0][1]);
+
+// Two arrays in one loop: a copy, element by element
+let copy: i32[] = [];
+for (let i = 0; i < 10; i++) {
+    copy.push(0);
+}
+for (let i = 0; i < copy.length; i++) {
+    copy[i] = xs[i] + sparse[i % 6];
+}
+println(copy[0]);
+println(copy[9]);
+
+// Shifted-off elements are behind the head offset, not gone from the data
+let queue: i32[] = [7, 8, 9];
+println(queue.shift());
+queue.push(10);
+println(queue[0]);
+println(queue[2]);
+println(queue.length);
+
+// Strings are held as the program's own handles, read in place like numbers
+let names: string[] = ["ada", "brian"];
+names.push("cy");
+names[1] = "bo" + "b";
+let joined: string = "";
+for (const name of names) {
+    joined = joined + name + ",";
+}
+println(joined);
+println(names.length);
+println(names.shift());
+println(names.pop());
+println(names[0]);
+println(names.length);
+
+// Capacity control: a preallocated length, reserve ahead of a fill, and
+// shrinkToFit after draining; none of them changes what the array holds
+let slots = new Array<i32>(4);
+println(slots.length);
+println(slots[3]);
+slots[3] = 12;
+slots.push(13);
+println(slots[4]);
+let samples: f64[] = [];
+samples.reserve(500);
+for (let i = 0; i < 500; i++) {
+    samples.push(i * 0.25);
+}
+println(samples.length);
+println(samples[499]);
+for (let i = 0; i < 490; i++) {
+    samples.shift();
+}
+samples.shrinkToFit();
+println(samples.length);
+println(samples[0]);
+samples.push(1.0);
+println(samples[10]);
+let labels = new Array<string>(2);
+labels[1] = "two";
+println(labels[1]);
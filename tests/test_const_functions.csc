@@ -0,0 +1,204 @@
+// Tests: `const function` calls with constant arguments are evaluated at
+// compile time — output must match an unoptimized (--no-fold) build, where
+// every call runs as compiled code
+const function sineTable(size: i32): Buffer<f64> {
+    let table = new Buffer<f64>(size);
+    for (let i = 0; i < size; i++) {
+        table[i] = Math.sin(i * 2 * Math.PI / size);
+    }
+    return table;
+}
+
+const function crcTable(): i32[] {
+    let table: i32[] = [];
+    for (let n = 0; n < 256; n++) {
+        let c = n;
+        for (let k = 0; k < 8; k++) {
+            if ((c & 1) != 0) {
+                c = 0xEDB88320 ^ ((c >> 1) & 0x7FFFFFFF);
+            } else {
+                c = (c >> 1) & 0x7FFFFFFF;
+            }
+        }
+        table.push(c);
+    }
+    return table;
+}
+
+const function fib(n: i32): i32 {
+    let a = 0;
+    let b = 1;
+    let i = 0;
+    while (i < n) {
+        let t = a + b;
+        a = b;
+        b = t;
+        i++;
+    }
+    return a;
+}
+
+const function sumTo(n: i32): i32 {
+    return n * (n + 1) / 2;
+}
+
+// Nested const calls, evaluated as one
+const function fibSum(n: i32): i32 {
+    let total = 0;
+    for (let i = 0; i <= n; i++) {
+        total += fib(i);
+    }
+    return total + sumTo(0);
+}
+
+const function isPrime(n: i32): boolean {
+    if (n < 2) {
+        return false;
+    }
+    for (let d = 2; d * d <= n; d++) {
+        if (n % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const function squares(n: i32): f64[] {
+    let out: f64[] = [];
+    for (let i = 0; i < n; i++) {
+        out.push(i * 0.5 * i);
+    }
+    return out;
+}
+
+const function tiles(w: i32, h: i32): Buffer<i32> {
+    let map = new Buffer<i32>(w * h);
+    for (let y = 0; y < h; y++) {
+        for (let x = 0; x < w; x++) {
+            if (x == 0 || y == 0 || x == w - 1 || y == h - 1) {
+                map[y * w + x] = 1;
+            }
+        }
+    }
+    return map;
+}
+
+// Division by zero is left to run as compiled code
+const function ratio(a: i32, b: i32): i32 {
+    return a / b;
+}
+
+const SINE = sineTable(64);
+println(SINE.length);
+println(SINE[0]);
+println(SINE[16]);
+println(SINE[32] < 0.000001);
+println(SINE[48]);
+
+const CRC = crcTable();
+println(CRC.length);
+println(CRC[0]);
+println(CRC[1]);
+println(CRC[255]);
+
+println(fib(10));
+println(fib(46));
+println(fibSum(10));
+println(isPrime(97));
+println(isPrime(91));
+
+const SQ = squares(5);
+for (const v of SQ) {
+    println(v);
+}
+
+// Every evaluation is a fresh array or buffer: mutating one result leaves
+// the next one untouched
+let first = squares(3);
+first[0] = 99;
+first.push(7);
+let second = squares(3);
+println(first[0]);
+println(first.length);
+println(second[0]);
+println(second.length);
+
+const MAP = tiles(5, 4);
+for (let y = 0; y < 4; y++) {
+    let row = "";
+    for (let x = 0; x < 5; x++) {
+        if (MAP[y * 5 + x] == 1) {
+            row = row + "#";
+        } else {
+            row = row + ".";
+        }
+    }
+    println(row);
+}
+MAP[6] = 7;
+println(tiles(5, 4)[6]);
+
+// A non-constant argument calls the compiled function
+let n = 12;
+println(fib(n));
+println(sumTo(n + 1));
+
+// Compile-time evaluation gives up on a division by zero; at run time the
+// call is only made with a divisor that is not zero
+let divisor = 0;
+if (divisor != 0) {
+    println(ratio(1, 0));
+}
+println(ratio(17, 5));
+
+// Arrays of the narrower and wider lanes are built at their own width too
+const function ramp(n: i32): u8[] {
+    let out: u8[] = [];
+    for (let i = 0; i < n; i++) {
+        out.push(i * 3);
+    }
+    return out;
+}
+const function doubling(): i64[] {
+    let out: i64[] = [1];
+    for (let i = 0; i < 40; i++) {
+        out[0] = out[0] + out[0];
+    }
+    return out;
+}
+const function weights(): f32[] {
+    return [0.5, 0.25];
+}
+const function mask(): boolean[] {
+    let out: boolean[] = [];
+    out.push(5);
+    out.push(0);
+    return out;
+}
+const RAMP = ramp(42);
+println(RAMP[41]);
+println(RAMP.length);
+const BIG = doubling();
+let kilo: i64 = 1024;
+let big: i64 = BIG[0];
+println(big / kilo / kilo / kilo == kilo);
+let weight: f64 = weights()[1];
+println(weight);
+const MASK = mask();
+println(MASK[0]);
+println(MASK[1]);
+
+// number is f64, as a parameter, a result and an element
+const function halve(x: number): number {
+    return x / 2;
+}
+const function halves(n: i32): number[] {
+    let out: number[] = [];
+    for (let i = 0; i < n; i++) {
+        out.push(halve(i));
+    }
+    return out;
+}
+println(halve(5));
+const HALVES = halves(4);
+println(HALVES[3]);
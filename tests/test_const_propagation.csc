@@ -0,0 +1,111 @@
+// Tests: AST const propagation, inlining of small pure functions and
+// loop-invariant hoisting — output must match an unoptimized (--no-fold) build
+const N = 1000;
+const SCALE: f64 = 2.5;
+const WIDE: f64 = 2;
+const DEBUG = false;
+const LIMIT = N * 2 + 1;
+let counter = 0;
+
+function square(x: i32): i32 {
+    return x * x;
+}
+
+function area(r: f64): f64 {
+    return SCALE * r * r;
+}
+
+function half(x: i32): f64 {
+    return x / 2;
+}
+
+function isBig(x: i32): boolean {
+    return x > N;
+}
+
+function bump(): i32 {
+    counter = counter + 1;
+    return counter;
+}
+
+function sumTo(n: i32, k: i32): i32 {
+    let total = 0;
+    for (let i = 0; i < n * k; i++) {
+        total = total + i % 7 + n * k * 3;
+    }
+    return total;
+}
+
+function mixed(n: i32, f: f64): f64 {
+    let acc = 0.0;
+    let i = 0;
+    while (i < n) {
+        acc = acc + f * 0.5 + (n - 1);
+        i++;
+    }
+    return acc;
+}
+
+function shadow(N: i32): i32 {
+    return N + 1;
+}
+
+function localShadow(): i32 {
+    const N = 3;
+    return N * 2;
+}
+
+function nested(rows: i32, cols: i32): i32 {
+    let hits = 0;
+    for (let r = 0; r < rows; r++) {
+        for (let c = 0; c < cols; c++) {
+            if (c < cols / 2 + rows * 3) {
+                hits = hits + rows * cols;
+            }
+        }
+    }
+    return hits;
+}
+
+println(N);
+println(WIDE / 4);
+println(LIMIT);
+println(square(7));
+println(square(N));
+println(square(3 + 4));
+let y = 5;
+println(square(y + 1));
+println(area(2.0));
+println(half(7));
+println(isBig(1001));
+println(shadow(41));
+if (DEBUG) {
+    println("debug is on");
+} else {
+    println("debug is off");
+}
+println(localShadow());
+println(N + 1);
+println(sumTo(10, 2));
+println(mixed(4, 3.0));
+println(nested(4, 6));
+
+// Top-level loop whose body calls a function that writes a global
+let g = 2;
+let total = 0;
+for (let i = 0; i < 3; i++) {
+    total = total + g * 10;
+    g = g + bump();
+}
+println(total);
+println(counter);
+
+const flags = { on: DEBUG, n: N };
+println(flags.n);
+let sq = (v: i32): i32 => v * N;
+println(sq(3));
+let k = 0;
+do {
+    k = k + N / 100;
+} while (k < LIMIT / 10);
+println(k);
@@ -0,0 +1,31 @@
+// Tests: expression types resolved once by semantic analysis — elements read
+// through class fields and call results keep their array's element type
+
+class Bag {
+    names: string[] = ["ann", "bob"];
+    weights: f64[] = [1.5, 2.25];
+}
+function pick(): string[] { return ["x", "y"]; }
+let bag: Bag = new Bag();
+println(bag.names[1]);
+println(bag.weights[0] + bag.weights[1]);
+let w = bag.weights[1];
+println(w * 2.0);
+let first = bag.names[0];
+println(first + "!");
+let p = pick();
+println(p[0]);
+let kept = bag.weights.filter((x: f64): boolean => x > 2.0);
+println(kept[0]);
+let doubled = (n: f64) => n * bag.weights[0];
+println(doubled(2.0));
+class Stack {
+    items: string[] = [];
+    add(s: string): void { this.items.push(s); }
+    top(): string { return this.items[this.items.length - 1]; }
+}
+let st: Stack = new Stack();
+st.add("a");
+st.add("b");
+println(st.top());
+println(st.items.length);
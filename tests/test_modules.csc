@@ -1,6 +1,7 @@
-// Tests: import/export module system (compile-time inlining)
+// Tests: import/export module system (one parse per module, linked in dependency order)
 
 import { square, cube, MODULE_GREETING } from "./modules/math_utils";
+import { Shape, area } from "./modules/shapes";
 
 println(MODULE_GREETING); // hello from math_utils
 println(square(7));       // 49
@@ -8,3 +9,7 @@ println(cube(3));         // 27
 
 let combined: i32 = square(2) + cube(2);
 println(combined);        // 12
+
+// An enum from another module still folds to its value
+println(Shape.Cube);      // 6
+println(area(Shape.Square)); // 16
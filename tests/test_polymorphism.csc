@@ -57,3 +57,17 @@ println(asShape.area());
 class Silent extends Shape { }
 let quiet: Shape = new Silent();
 println(quiet.area());
+
+// i32 fields after the vtable pointer, set only by their initializers: the
+// pointer slot must be pointer-sized or it overlaps the first field
+class Counter {
+    start: i32 = 5;
+    step: i32 = 1;
+    next(): i32 { return this.start + this.step; }
+}
+class Doubler extends Counter {
+    next(): i32 { return this.start * 2; }
+}
+let counter: Counter = new Doubler();
+println(counter.next());
+println(counter.start);
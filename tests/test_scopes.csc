@@ -0,0 +1,52 @@
+// Tests: block scopes — bindings made inside a scope vanish when it closes and
+// the names they shadowed come back with their original values and types
+
+let item: string = "outer";
+let total: i32 = 0;
+const nums: i32[] = [1, 2, 3];
+
+// The for-of iterator shadows a module-level name of a different type
+for (const item of nums) {
+    total = total + item;
+}
+println(item);
+println(total);
+
+// Nested loops, each with its own iterator
+const words: string[] = ["a", "b"];
+for (const w of words) {
+    for (const n of nums) {
+        print(w);
+        println(n);
+    }
+}
+
+// A catch variable shadows, then the outer binding is visible again
+let e: i32 = 42;
+try {
+    throw "boom";
+} catch (e) {
+    println("caught: " + e);
+}
+println(e + 1);
+
+// Parameters shadow module-level names inside the body only
+function twice(total: i32): i32 {
+    return total * 2;
+}
+println(twice(5));
+println(total);
+
+// A function declares its own locals; main's stay untouched
+let count: i32 = 7;
+function countdown(): i32 {
+    let count: i32 = 3;
+    let steps: i32 = 0;
+    while (count > 0) {
+        count = count - 1;
+        steps = steps + 1;
+    }
+    return steps;
+}
+println(countdown());
+println(count);
@@ -0,0 +1,95 @@
+// Tests: i64, u8, f32 and boolean arrays store their elements at their own
+// width (a byte each for u8 and boolean) through push, index, assignment,
+// pop/shift and for-of, and array literals take the element type of the slot
+// they are written to: a declaration, an argument, a return value.
+
+// i64 keeps values past the i32 range
+let big: i64[] = [];
+big.push(5000000000);
+big.push(7);
+big[1] = big[0] + 1;
+let wide: i64 = big[1] - big[0];
+println(big.length);
+println(wide == 1);
+println(big.pop() == 5000000001);
+println(big.length);
+
+// u8 stores one byte per element and keeps only the low byte
+let bytes: u8[] = [];
+for (let i = 0; i < 260; i++) {
+    bytes.push(i);
+}
+println(bytes.length);
+println(bytes[100]);
+println(bytes[258]);
+bytes[0] = 42;
+println(bytes.shift());
+println(bytes[0]);
+
+// f32 elements, read back and widened to f64
+let weights: f32[] = [0.5, 1.25];
+weights.push(2.0);
+let sum: f64 = 0.0;
+for (const w of weights) {
+    sum = sum + w;
+}
+println(sum);
+weights[1] = 4.5;
+let second: f64 = weights[1];
+println(second);
+
+// boolean elements are 0 or 1, whatever was stored
+let flags: boolean[] = [true, false];
+flags.push(3 > 2);
+flags[1] = 1 == 1;
+let set = 0;
+for (const f of flags) {
+    if (f) {
+        set += 1;
+    }
+}
+println(set);
+println(flags.pop());
+println(flags[5]);
+
+// number is f64
+let ratios: number[] = [1, 2, 3];
+println(ratios[2] / 2);
+
+// Literals take the element type of the parameter, return value or
+// variable they are written to
+function total(xs: u8[]): i32 {
+    let t = 0;
+    for (const x of xs) {
+        t += x;
+    }
+    return t;
+}
+println(total([10, 20, 30]));
+
+function powers(): i64[] {
+    return [1, 1024, 1048576];
+}
+let p = powers();
+p.push(p[2] * p[2]);
+println(p[3] == 1099511627776);
+
+let grid: u8[][] = [[1, 2], [3, 4, 5]];
+println(grid[1][2]);
+let mask: boolean[] = [];
+mask = [true, true, false];
+println(mask.length);
+
+// Elements turn into text at their own width: a u8 as 0..255, an i8 with its
+// sign, an i64 whole
+let levels: u8[] = [250, 5];
+console.log("level " + levels[0]);
+console.log(levels[0], levels[1]);
+println(levels.pop());
+let deltas: i8[] = [-7, 100];
+console.log("delta " + deltas[0]);
+console.log(deltas[0], deltas[1]);
+let ticks: i64[] = [5000000000];
+console.log("ticks " + ticks[0]);
+console.log(ticks[0], 1);
+println(ticks[0]);